@@ -1,45 +1,95 @@
 #pragma once
+#include <stdint.h>
+
+/*  Compile-time settings only: everything here is constexpr (inline where it
+    has storage), so each translation unit shares one copy and values fold
+    into the code. Settings that change at runtime live in Settings
+    (settings_blob.h), and these are their defaults.  */
 
 /********** WIFI **********/
-static const char* WIFI_SSID = "YOUR_WIFI";
-static const char* WIFI_PASS = "YOUR_PASS";
-static const char* AP_SSID   = "Winder-Setup";
-static const char* AP_PASS   = "";  // open AP
+inline constexpr char WIFI_SSID[] = "YOUR_WIFI";
+inline constexpr char WIFI_PASS[] = "YOUR_PASS";
+inline constexpr char AP_SSID[]   = "Winder-Setup";
+inline constexpr char AP_PASS[]   = "";  // open AP
+// Modem sleep between DTIM beacons once only the STA is up (the setup AP
+// keeps the radio awake while it runs). Adds up to ~100 ms request latency.
+constexpr bool WIFI_MODEM_SLEEP = true;
+// Wall clock for burst-program windows, synced once the STA is up (POSIX TZ string)
+inline constexpr char NTP_SERVER[] = "pool.ntp.org";
+inline constexpr char TIME_ZONE[]  = "UTC0";
 
 /********** HARDWARE **********/
 // 28BYJ-48 math
-static const long STEPS_PER_REV = 4096;
+constexpr long STEPS_PER_REV = 4096;
 
-/*  ULN2003 IN1..IN4  →  ESP32 GPIOs (safe choices for common DevKit/NodeMCU-32S)
-    Avoid input-only (34–39) and tricky boot strap pins (0, 2, 12, 15).  */
+enum DirectionPlan : int { DIR_CW = +1, DIR_CCW = -1, DIR_ALT = 0 };
 
-/// Motor 1 (left)
-static const int M1_IN1 = 13;
-static const int M1_IN2 = 12;
-static const int M1_IN3 = 14;
-static const int M1_IN4 = 27;
+/*  Watch positions. One row per motor; everything else (scheduler, turbo,
+    persistence, /status, /config, UI) sizes itself from this table.
+    ULN2003 IN1..IN4  →  ESP32 GPIOs (safe choices for common DevKit/NodeMCU-32S)
+    Avoid input-only (34–39) and tricky boot strap pins (0, 2, 12, 15).  */
+struct MotorDesc {
+  int in[4];         // IN1..IN4 GPIOs (unused with COILS_SHIFT_REGISTER)
+  int tpd;           // default TPD
+  int dirPlan;       // default DirectionPlan
+};
+inline constexpr MotorDesc MOTOR_TABLE[] = {
+  { { 13, 12, 14, 27 }, 650, DIR_ALT },   // Motor 1 (left)
+  { { 26, 25, 33, 32 }, 650, DIR_ALT },   // Motor 2 (right)
+};
+constexpr uint8_t MOTOR_COUNT = sizeof(MOTOR_TABLE) / sizeof(MOTOR_TABLE[0]);
 
-/// Motor 2 (right)
-static const int M2_IN1 = 26;
-static const int M2_IN2 = 25;
-static const int M2_IN3 = 33;
-static const int M2_IN4 = 32;
+/*  4–16 positions: drive the ULN2003 boards from daisy-chained 74HC595s
+    instead (two motors per chip, motor 1 on the chip next to the ESP32,
+    Q0..Q3 = IN1..IN4, Q4..Q7 = next motor). All coils go out in one SPI
+    burst per step tick. Set to 1 and fill MOTOR_TABLE (pins ignored).  */
+#define COILS_SHIFT_REGISTER 0
+constexpr int SR_DATA  = 23;   // VSPI MOSI -> 595 SER
+constexpr int SR_CLOCK = 18;   // VSPI SCK  -> 595 SRCLK
+constexpr int SR_LATCH = 5;    //           -> 595 RCLK
 
 /// 3-position DPDT selector (to GND; INPUT_PULLUP on pins)
-static const int MODE_PIN_A = 16;
-static const int MODE_PIN_B = 17;
+constexpr int MODE_PIN_A = 16;
+constexpr int MODE_PIN_B = 17;
 
 /// Status LED (optional). GPIO4 avoids boot issues on some boards.
-static const int LED_PIN = 4;   // set to -1 to disable
+constexpr int LED_PIN = 4;   // set to -1 to disable
 
 /********** BEHAVIOR (UI controls only TPD + direction) **********/
-static int STEP_RPM = 15;   // internal motor speed; tweak if chatter
+constexpr int STEP_RPM = 15;   // internal motor speed; tweak if chatter (Settings::rpm at runtime)
 
-static int TPD_M1 = 650;    // per-motor TPD default
-static int TPD_M2 = 650;
+constexpr unsigned long MODE_DEBOUNCE_MS = 40;
 
-enum DirectionPlan : int { DIR_CW = +1, DIR_CCW = -1, DIR_ALT = 0 };
-static int DIRPLAN_M1 = DIR_ALT;  // CW / CCW / Alternate
-static int DIRPLAN_M2 = DIR_ALT;
+// Default winding program (wind_program.h): a burst every PROGRAM_EVERY_MIN
+// minutes inside [PROGRAM_START_MIN, PROGRAM_END_MIN) minutes since midnight
+// (equal = all day). PROGRAM_EVERY_MIN 0 spreads the TPD evenly.
+constexpr uint16_t PROGRAM_EVERY_MIN = 0;
+constexpr uint16_t PROGRAM_START_MIN = 0;
+constexpr uint16_t PROGRAM_END_MIN   = 0;
+// De-energize coils after each move; the gearbox holds the drum
+constexpr bool COILS_RELEASE_IDLE = true;
+// Coil-current budget (power_budget.h): a motor's start waits while it would
+// ramp alongside another and push the estimated coil draw over the cap, so
+// the ramps of all motors plus Wi-Fi TX bursts stay clear of a brownout.
+// 0 = no cap (every motor starts when it is due).
+constexpr uint16_t POWER_BUDGET_MA = 360;
+constexpr uint16_t COIL_MA     = 100;   // one 28BYJ-48 coil at 5 V (~50 ohm)
+constexpr uint16_t COIL_TAU_US = 700;   // coil L/R time constant
+
+// Binary trace ring (/trace, tools/trace_decode.py): 16 bytes per record,
+// power of two. The serial console prints the same records as UART room allows.
+constexpr uint16_t TRACE_RECORDS = 512;
+
+// Fleet beacon (fleet_beacon.h): UDP multicast status for tools/fleet, sent
+// this often and within a second of a change. 0 = no beacon.
+constexpr uint32_t FLEET_BEACON_MS = 5000;
+
+// Binary control (ctl_frame.h): UDP on CTL_PORT, and WebSockets on GET /ctl,
+// this many open at once (each keeps the web task on its 2 ms pass).
+constexpr uint8_t CTL_WS_MAX = 2;
 
-static const unsigned long MODE_DEBOUNCE_MS = 40;
+// Odometer history (/history): hourly buckets, delta-encoded, in RTC memory
+// (kept across warm resets, 8 KB there in all). Steady winding averages about
+// 3 bytes per motor-hour (a rotation across the hour shifts steps into the
+// next), so 4.5 KB holds a month of two motors; the oldest hours go first.
+constexpr uint16_t HISTORY_BYTES = 4608;
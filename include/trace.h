@@ -0,0 +1,10 @@
+#pragma once
+#include <stdint.h>
+#include "trace_ring.h"
+
+/********** Trace **********
+  Events go into a RAM ring (trace_ring.h) instead of straight to Serial;
+  GET /trace downloads it and the web task echoes it to the serial console
+  only as fast as the UART takes it without blocking.                 */
+
+void trace(TraceEvent id, uint8_t a = 0, uint32_t b = 0);   // any task, either core, or an ISR
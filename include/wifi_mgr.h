@@ -0,0 +1,52 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "scan_cache.h"
+
+/********** Wi-Fi manager **********
+  Event-driven, non-blocking bring-up. The SoftAP and the STA join come up
+  together (APSTA); the AP lingers for a while after STA gets an IP so a
+  phone on the setup AP can read the result, then drops. Nothing here waits:
+  onWiFiEvent records events, netPoll() (web task) advances the state.   */
+
+enum NetState : uint8_t {
+  NET_OFF,
+  NET_STA_CONNECTING,   // join in progress (AP is up alongside)
+  NET_STA_UP,           // STA has an IP
+  NET_STA_FAILED,       // join timed out / rejected; AP only
+  NET_AP_ONLY,          // no STA credentials
+};
+
+struct NetProgress {
+  NetState state;
+  uint8_t  reason;       // last STA disconnect reason (esp_wifi wifi_err_reason_t)
+  uint8_t  attempts;     // joins since the last credential change
+  bool     apUp;
+  uint32_t elapsedMs;    // since the current join attempt began
+};
+
+void netBegin(const char* ssid, const char* pass);     // call once from setup()
+void netConnect(const char* ssid, const char* pass);   // new credentials, returns at once
+void netPoll();                                        // web task, every pass
+
+NetProgress netProgress();
+const char* netStateName(NetState s);
+const char* netSsid();
+void netIp(char* out, size_t n);                       // STA IP, or AP IP when STA is down
+void netDescribe(char* out, size_t n);                 // one-line summary for the UI pill
+
+// Background scan. Runs at boot and every minute while the setup AP is the
+// only link, or on request; results are cached so readers never wait.
+void netScanRequest();                     // start one soon; no-op while one runs
+bool netScanning();                        // running or queued
+const ScanCache& netScanResults();         // strongest first
+int32_t netScanAgeMs();                    // -1 before the first scan completes
+
+// Fleet identity: node id is the low 24 bits of the MAC, the hostname (DHCP
+// and mDNS) is "winder-" and its hex, so a rack of units never collide.
+const char* netHostname();
+uint32_t netNodeId();
+bool netBeacon(const uint8_t* p, size_t n);   // one UDP datagram to the fleet group; false while STA is down
+
+// Boot timing (ms since reset, 0 until reached)
+uint32_t netHttpReadyMs();
@@ -0,0 +1,74 @@
+#pragma once
+#include <stdint.h>
+#include "step_engine.h"
+
+// ===================== Coil map =====================
+// Compile-time table from (motor, 4-bit coil pattern) to GPIO set/clear
+// masks, per ESP32 output bank (0: GPIO0-31, 1: GPIO32-39). A tick's worth
+// of motor steps folds into one set and one clear mask per bank, so the
+// ISR updates every motor with at most four register stores.
+
+struct CoilMasks {
+  uint32_t set[2], clr[2];
+};
+
+// D is any motor descriptor with `in[4]` = IN1..IN4 GPIO numbers
+template <uint8_t N>
+class CoilMap {
+public:
+  template <class D>
+  constexpr explicit CoilMap(const D (&motors)[N]) : lut_{} {
+    for (uint8_t m = 0; m < N; m++)
+      for (uint8_t p = 0; p < 16; p++)
+        for (uint8_t i = 0; i < 4; i++){
+          int pin = motors[m].in[i];
+          uint8_t bank = pin >= 32;
+          uint32_t bit = 1u << (pin & 31);
+          if (p & (1u << i)) lut_[m][p].set[bank] |= bit;
+          else               lut_[m][p].clr[bank] |= bit;
+        }
+  }
+
+  // Masks for the motors in `changed` (bit m) at patterns coils[m]
+  CoilMasks IRAM_ATTR combine(MotorMask changed, const uint8_t* coils) const {
+    CoilMasks c{};
+    for (uint8_t m = 0; m < N; m++){
+      if (!(changed & (1u << m))) continue;
+      const CoilMasks& e = lut_[m][coils[m] & 15];
+      c.set[0] |= e.set[0]; c.clr[0] |= e.clr[0];
+      c.set[1] |= e.set[1]; c.clr[1] |= e.clr[1];
+    }
+    return c;
+  }
+
+  const CoilMasks& entry(uint8_t m, uint8_t coils) const { return lut_[m][coils & 15]; }
+
+private:
+  CoilMasks lut_[N][16];
+};
+
+// ===================== 74HC595 frame =====================
+// Coil states for a daisy chain of 74HC595s, two motors per chip: motor m
+// drives chip m/2, Q0..Q3 (even m) or Q4..Q7 (odd m) = IN1..IN4. Bytes are
+// kept in wire order (farthest chip first), so the whole chain goes out as
+// one SPI burst, MSB first, followed by a latch pulse.
+
+template <uint8_t N>
+class ShiftFrame {
+public:
+  static const uint8_t BYTES = (N + 1) / 2;
+
+  void IRAM_ATTR update(MotorMask changed, const uint8_t* coils){
+    for (uint8_t m = 0; m < N; m++){
+      if (!(changed & (1u << m))) continue;
+      uint8_t& b = bytes_[BYTES - 1 - m / 2];
+      b = (m & 1) ? (uint8_t)((b & 0x0F) | (coils[m] << 4)) : (uint8_t)((b & 0xF0) | (coils[m] & 0x0F));
+    }
+  }
+  const uint8_t* data() const { return bytes_; }
+  // Pattern motor m is latched at (for checks)
+  uint8_t coils(uint8_t m) const { uint8_t b = bytes_[BYTES - 1 - m / 2]; return (m & 1) ? b >> 4 : b & 0x0F; }
+
+private:
+  uint8_t bytes_[BYTES] = {};
+};
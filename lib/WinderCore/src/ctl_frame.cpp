@@ -0,0 +1,81 @@
+#include "ctl_frame.h"
+
+static uint8_t* put16(uint8_t* p, uint16_t v){ p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); return p + 2; }
+static uint8_t* put32(uint8_t* p, uint32_t v){ return put16(put16(p, (uint16_t)v), (uint16_t)(v >> 16)); }
+static uint16_t get16(const uint8_t* p){ return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t get32(const uint8_t* p){ return get16(p) | (uint32_t)get16(p + 2) << 16; }
+static uint8_t motorsIn(uint16_t mask){ uint8_t k = 0; for (; mask; mask &= mask - 1) k++; return k; }
+
+uint16_t ctlCrc(const uint8_t* p, size_t n){
+  uint16_t c = 0xFFFF;
+  while (n--){
+    c ^= (uint16_t)(*p++ << 8);
+    for (int b = 0; b < 8; b++) c = c & 0x8000 ? (uint16_t)(c << 1 ^ 0x1021) : (uint16_t)(c << 1);
+  }
+  return c;
+}
+
+size_t ctlEncode(uint8_t op, uint16_t seq, uint16_t mask, const uint8_t* payload, uint8_t len, uint8_t* out, size_t cap){
+  if (cap < CTL_OVERHEAD + len) return 0;
+  uint8_t* p = out;
+  *p++ = 'W'; *p++ = 'C'; *p++ = CTL_VERSION; *p++ = op;
+  p = put16(p, seq); p = put16(p, mask); *p++ = len;
+  for (uint8_t i = 0; i < len; i++) *p++ = payload[i];
+  p = put16(p, ctlCrc(out, (size_t)(p - out)));
+  return (size_t)(p - out);
+}
+
+bool ctlDecode(const uint8_t* p, size_t n, CtlFrame& f){
+  if (n < CTL_OVERHEAD || p[0] != 'W' || p[1] != 'C' || n != CTL_OVERHEAD + p[8]) return false;
+  if (ctlCrc(p, n - 2) != get16(p + n - 2)) return false;
+  f.version = p[2]; f.op = p[3]; f.seq = get16(p + 4); f.mask = get16(p + 6); f.len = p[8]; f.payload = p + CTL_HEAD;
+  return true;
+}
+
+size_t ctlConfigPut(const CtlConfig& c, uint16_t mask, uint8_t* out, size_t cap){
+  size_t n = CTL_CONFIG_FIXED + 3 * (size_t)motorsIn(mask);
+  if (n > cap || n > 0xFF) return 0;
+  uint8_t* p = out;
+  *p++ = c.set; *p++ = c.profile;
+  p = put16(p, c.everyMin); p = put16(p, c.startMin); p = put16(p, c.endMin);
+  for (uint8_t m = 0; m < CTL_MAX_MOTORS; m++){
+    if (!(mask & (1u << m))) continue;
+    p = put16(p, (uint16_t)c.tpd[m]); *p++ = (uint8_t)c.dir[m];
+  }
+  return n;
+}
+
+bool ctlConfigGet(const uint8_t* p, size_t n, uint16_t mask, CtlConfig& c){
+  if (n != CTL_CONFIG_FIXED + 3 * (size_t)motorsIn(mask)) return false;
+  c.set = p[0]; c.profile = p[1];
+  c.everyMin = get16(p + 2); c.startMin = get16(p + 4); c.endMin = get16(p + 6);
+  p += CTL_CONFIG_FIXED;
+  for (uint8_t m = 0; m < CTL_MAX_MOTORS; m++){
+    if (!(mask & (1u << m))) continue;
+    c.tpd[m] = (int16_t)get16(p); c.dir[m] = (int8_t)p[2]; p += 3;
+  }
+  return true;
+}
+
+size_t ctlStatusPut(const CtlStatus& s, uint8_t* out, size_t cap){
+  size_t n = CTL_STATUS_FIXED + CTL_STATUS_MOTOR * (size_t)s.motors;
+  if (s.motors > CTL_MAX_MOTORS || n > cap) return 0;
+  uint8_t* p = out;
+  *p++ = s.flags; *p++ = s.switchMode; p = put16(p, s.turboLeftS); *p++ = s.profile; *p++ = s.motors;
+  for (uint8_t m = 0; m < s.motors; m++){
+    const CtlMotor& e = s.m[m];
+    p = put16(p, (uint16_t)e.tpd); *p++ = (uint8_t)e.dir; *p++ = e.turbo; p = put16(p, e.nextS); p = put32(p, e.turns);
+  }
+  return n;
+}
+
+bool ctlStatusGet(const uint8_t* p, size_t n, CtlStatus& s){
+  if (n < CTL_STATUS_FIXED || p[5] > CTL_MAX_MOTORS || n != CTL_STATUS_FIXED + CTL_STATUS_MOTOR * (size_t)p[5]) return false;
+  s.flags = p[0]; s.switchMode = p[1]; s.turboLeftS = get16(p + 2); s.profile = p[4]; s.motors = p[5];
+  p += CTL_STATUS_FIXED;
+  for (uint8_t m = 0; m < s.motors; m++, p += CTL_STATUS_MOTOR){
+    CtlMotor& e = s.m[m];
+    e.tpd = (int16_t)get16(p); e.dir = (int8_t)p[2]; e.turbo = p[3]; e.nextS = get16(p + 4); e.turns = get32(p + 6);
+  }
+  return true;
+}
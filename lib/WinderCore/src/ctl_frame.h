@@ -0,0 +1,70 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ===================== Control frames =====================
+// Compact binary commands alongside the JSON routes, for clients that want
+// a round trip in one datagram (UDP, CTL_PORT) or one frame on a WebSocket
+// that stays open (GET /ctl). Little-endian, fixed 9-byte header and a
+// CRC-16/CCITT over everything before it:
+//   'W' 'C' version op | seq u16 | motor mask u16 | payload length u8
+//   payload | crc u16
+// Requests (payload):
+//   STATUS  -
+//   START   -
+//   STOP    -
+//   CONFIG  set u8 (CTL_SET_*) | profile u8 | every_min u16 | window start,
+//           end u16 | per motor in the mask, lowest first: tpd i16 | dir i8
+//           (motors outside the mask, and fields not in `set`, keep theirs)
+//   TURBO   minutes u8 (the mask picks the motors)
+// A reply has op | CTL_REPLY, the request's seq and mask, and starts with a
+// result byte (CTL_OK, ...). STATUS adds flags u8 | switch u8 | turbo left
+// s u16 | profile u8 | motors u8, then per motor tpd i16 | dir i8 | turbo u8
+// | next rotation s u16 (0xFFFF: none) | turns u32 (mask = all motors).
+// A client retries with the same seq; a repeat of a command the node
+// already took gets the same answer without being applied again.
+
+static const uint16_t CTL_PORT = 47078;
+static const uint8_t  CTL_VERSION = 1;
+static const uint8_t  CTL_MAX_MOTORS = 16;
+static const size_t   CTL_HEAD = 9, CTL_OVERHEAD = CTL_HEAD + 2;
+static const size_t   CTL_CONFIG_FIXED = 8, CTL_STATUS_FIXED = 6, CTL_STATUS_MOTOR = 10;
+static const size_t   CTL_FRAME_MAX = CTL_OVERHEAD + 1 + CTL_STATUS_FIXED + CTL_STATUS_MOTOR * CTL_MAX_MOTORS;
+
+enum CtlOp : uint8_t { CTL_STATUS = 1, CTL_START, CTL_STOP, CTL_CONFIG, CTL_TURBO, CTL_REPLY = 0x80 };
+enum CtlResult : uint8_t { CTL_OK, CTL_BUSY, CTL_BAD, CTL_BAD_VERSION };
+enum : uint8_t { CTL_SET_PROFILE = 1, CTL_SET_PROGRAM = 2 };
+enum : uint8_t { CTL_F_ENABLED = 1, CTL_F_TURBO = 2, CTL_F_CLOCK_SET = 4 };
+
+struct CtlFrame {
+  uint8_t  version, op;
+  uint16_t seq, mask;
+  uint8_t  len;
+  const uint8_t* payload;   // into the decoded buffer
+};
+
+uint16_t ctlCrc(const uint8_t* p, size_t n);
+// Header + payload + CRC into out; 0 if it doesn't fit
+size_t ctlEncode(uint8_t op, uint16_t seq, uint16_t mask, const uint8_t* payload, uint8_t len, uint8_t* out, size_t cap);
+// False: not a control frame (short, wrong magic, length or CRC). The
+// version is not checked here, so a server can answer CTL_BAD_VERSION.
+bool ctlDecode(const uint8_t* p, size_t n, CtlFrame& f);
+
+// Payload builders and readers shared by the node and tools/ctl
+struct CtlConfig {
+  uint8_t  set, profile;
+  uint16_t everyMin, startMin, endMin;
+  int16_t  tpd[CTL_MAX_MOTORS];     // indexed by motor, only masked ones are sent
+  int8_t   dir[CTL_MAX_MOTORS];
+};
+struct CtlMotor { int16_t tpd; int8_t dir; uint8_t turbo; uint16_t nextS; uint32_t turns; };
+struct CtlStatus {
+  uint8_t  flags, switchMode, profile, motors;
+  uint16_t turboLeftS;
+  CtlMotor m[CTL_MAX_MOTORS];
+};
+
+size_t ctlConfigPut(const CtlConfig& c, uint16_t mask, uint8_t* out, size_t cap);
+bool   ctlConfigGet(const uint8_t* p, size_t n, uint16_t mask, CtlConfig& c);
+size_t ctlStatusPut(const CtlStatus& s, uint8_t* out, size_t cap);       // after the result byte
+bool   ctlStatusGet(const uint8_t* p, size_t n, CtlStatus& s);
@@ -0,0 +1,123 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "ctl_frame.h"
+#include "motion_link.h"
+#include "ramp_profile.h"
+#include "web_routes.h"
+#include "wind_program.h"
+
+// ===================== Control server =====================
+// Answers ctl_frame.h requests with the same hooks and status snapshot as
+// WebRoutes, so a command means the same thing on either side. Transport
+// agnostic: the caller hands in a datagram or a WebSocket message and
+// sends back what handle() writes. The last command of each of PEERS
+// recent clients is remembered (seq and CRC), so a retry of one that was
+// queued is answered again instead of applied twice; a busy answer is not
+// remembered, so its retry gets another try.
+
+template <uint8_t N>
+class CtlServer {
+  static_assert(N <= CTL_MAX_MOTORS, "control frames carry 16 motors");
+public:
+  static const uint8_t PEERS = 8;
+  static constexpr uint16_t ALL = (uint16_t)((1u << N) - 1);
+
+  CtlServer(MotionStatusLock<N>& status, const WebHooks<N>& hooks) : status_(status), hooks_(hooks) {}
+
+  // `peer` is anything stable per client (address and port, socket slot).
+  // Returns the reply length; 0 when `in` isn't a control frame.
+  size_t handle(uint64_t peer, const uint8_t* in, size_t n, uint8_t* out, size_t cap){
+    CtlFrame f;
+    if (!ctlDecode(in, n, f)){ bad_++; return 0; }
+    uint8_t op = (uint8_t)(f.op | CTL_REPLY);
+    if (f.version != CTL_VERSION) return result(op, f, CTL_BAD_VERSION, out, cap);
+    if (f.op == CTL_STATUS) return status(f, out, cap);
+    uint16_t crc = (uint16_t)(in[n - 2] | in[n - 1] << 8);
+    Seen* s = find(peer);
+    if (s && s->seq == f.seq && s->crc == crc){ repeats_++; s->at = ++clock_; return result(op, f, s->result, out, cap); }
+    MotionCmd<N> c{};
+    if (!command(f, c)) return result(op, f, CTL_BAD, out, cap);
+    if (!hooks_.queue(c)) return result(op, f, CTL_BUSY, out, cap);
+    if (!s) s = oldest();
+    *s = Seen{ peer, ++clock_, f.seq, crc, CTL_OK, 1 };
+    return result(op, f, CTL_OK, out, cap);
+  }
+
+  uint32_t repeats() const { return repeats_; }   // retries answered from memory
+  uint32_t bad() const { return bad_; }           // not control frames
+
+private:
+  struct Seen { uint64_t peer; uint32_t at; uint16_t seq, crc; uint8_t result, used; };
+
+  // The frame as a motion command; false when it doesn't make one
+  bool command(const CtlFrame& f, MotionCmd<N>& c){
+    if (f.mask & ~ALL) return false;
+    switch (f.op){
+      case CTL_START: c.op = CMD_START; return f.len == 0;
+      case CTL_STOP:  c.op = CMD_STOP;  return f.len == 0;
+      case CTL_TURBO:
+        if (f.len != 1 || !f.mask) return false;
+        c.op = CMD_TURBO; c.mask = f.mask; c.minutes = (int16_t)webClamp(f.payload[0], 1, 15);
+        return true;
+      case CTL_CONFIG: {
+        CtlConfig in;
+        if (!ctlConfigGet(f.payload, f.len, f.mask, in)) return false;
+        MotionStatus<N> st; status_.read(st);
+        c.op = CMD_CONFIG; c.profile = st.profile; c.program = st.program;
+        if (in.set & CTL_SET_PROFILE){ if (in.profile >= RAMP_PROFILES) return false; c.profile = in.profile; }
+        if (in.set & CTL_SET_PROGRAM){
+          c.program.everyMin = in.everyMin; c.program.startMin = in.startMin; c.program.endMin = in.endMin;
+          if (!programValid(c.program)) return false;
+        }
+        for (uint8_t m = 0; m < N; m++){
+          bool set = f.mask & (1u << m);
+          int d = set ? in.dir[m] : st.dir[m];
+          if (d < -1 || d > +1) return false;
+          c.tpd[m] = set ? (int16_t)webClamp(in.tpd[m], 0, 1200) : st.tpd[m];
+          c.dir[m] = (int8_t)d;
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  size_t status(const CtlFrame& f, uint8_t* out, size_t cap){
+    MotionStatus<N> st; status_.read(st); statusAge(st, hooks_.millis());
+    CtlStatus s{};
+    s.flags = (st.enabled ? CTL_F_ENABLED : 0) | (st.turboActive ? CTL_F_TURBO : 0) | (st.clockSet ? CTL_F_CLOCK_SET : 0);
+    s.switchMode = st.switchMode; s.profile = st.profile; s.motors = N;
+    s.turboLeftS = st.turboActive ? (uint16_t)(st.turboLeftMs / 1000 > 0xFFFE ? 0xFFFE : st.turboLeftMs / 1000) : 0;
+    for (uint8_t m = 0; m < N; m++){
+      CtlMotor& e = s.m[m];
+      e.tpd = st.tpd[m]; e.dir = st.dir[m]; e.turbo = (st.turboMask >> m) & 1;
+      int32_t t = st.nextMs[m] < 0 ? -1 : st.nextMs[m] / 1000;
+      e.nextS = t < 0 || t > 0xFFFE ? 0xFFFF : (uint16_t)t;
+      e.turns = st.odo[m].v[ODO_CW] + st.odo[m].v[ODO_CCW];
+    }
+    uint8_t p[1 + CTL_STATUS_FIXED + CTL_STATUS_MOTOR * N];
+    p[0] = CTL_OK;
+    size_t k = ctlStatusPut(s, p + 1, sizeof(p) - 1);
+    return ctlEncode(CTL_STATUS | CTL_REPLY, f.seq, ALL, p, (uint8_t)(k + 1), out, cap);
+  }
+
+  static size_t result(uint8_t op, const CtlFrame& f, uint8_t r, uint8_t* out, size_t cap){
+    return ctlEncode(op, f.seq, f.mask, &r, 1, out, cap);
+  }
+
+  Seen* find(uint64_t peer){
+    for (Seen& s : seen_) if (s.used && s.peer == peer) return &s;
+    return nullptr;
+  }
+  Seen* oldest(){
+    Seen* o = &seen_[0];
+    for (Seen& s : seen_){ if (!s.used) return &s; if (s.at < o->at) o = &s; }
+    return o;
+  }
+
+  MotionStatusLock<N>& status_;
+  const WebHooks<N>& hooks_;
+  Seen seen_[PEERS] = {};
+  uint32_t clock_ = 0, repeats_ = 0, bad_ = 0;
+};
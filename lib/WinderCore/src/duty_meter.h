@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+
+// ===================== Duty meter =====================
+// Motion-core accounting over fixed windows: time spent in scheduler passes,
+// time the step timer was running (the core can't sleep then), and task
+// wakeups. Turned into an idle share and a rough CPU current figure.
+// The currents are datasheet ballpark numbers: good for comparing settings,
+// not a measurement.
+
+static const uint32_t DUTY_WINDOW_MS      = 10000;
+static const uint16_t DUTY_MA_ACTIVE      = 50;   // 240 MHz, radio quiet
+static const uint16_t DUTY_MA_IDLE        = 20;   // idle at 80 MHz (DFS), no sleep
+static const uint16_t DUTY_MA_LIGHT_SLEEP = 1;
+
+struct DutyWindow { uint32_t spanMs, busyUs, stepUs, wakeups; };
+
+class DutyMeter {
+public:
+  void wake(){ wakes_++; }
+  void busy(uint32_t us){ busyUs_ += us; }
+  void stepping(bool on, uint64_t nowUs){
+    if (on == stepOn_) return;
+    if (stepOn_) stepUs_ += nowUs - stepAt_;
+    stepOn_ = on; stepAt_ = nowUs;
+  }
+  // Call once per pass; closes the window every DUTY_WINDOW_MS
+  void roll(uint64_t nowUs){
+    if (!started_){ started_ = true; startUs_ = stepAt_ = nowUs; return; }
+    if (nowUs - startUs_ < DUTY_WINDOW_MS * 1000ULL) return;
+    if (stepOn_){ stepUs_ += nowUs - stepAt_; stepAt_ = nowUs; }
+    last_ = DutyWindow{ (uint32_t)((nowUs - startUs_) / 1000), (uint32_t)busyUs_, (uint32_t)stepUs_, wakes_ };
+    startUs_ = nowUs; busyUs_ = stepUs_ = 0; wakes_ = 0;
+  }
+
+  const DutyWindow& last() const { return last_; }
+  // Share of the last window the core could have slept, 0..1000
+  uint16_t idlePermille() const {
+    if (!last_.spanMs) return 0;
+    uint64_t awake = (uint64_t)last_.busyUs + last_.stepUs, span = (uint64_t)last_.spanMs * 1000;
+    return awake >= span ? 0 : (uint16_t)(1000 - awake * 1000 / span);
+  }
+  uint16_t wakeupsPerSec() const { return last_.spanMs ? (uint16_t)((uint64_t)last_.wakeups * 1000 / last_.spanMs) : 0; }
+  // Awake at DUTY_MA_ACTIVE, the rest at idleMa (light sleep or plain idle)
+  uint16_t currentMa(uint16_t idleMa) const {
+    uint32_t idle = idlePermille();
+    return (uint16_t)((DUTY_MA_ACTIVE * (1000 - idle) + idleMa * idle + 500) / 1000);
+  }
+
+private:
+  bool started_ = false, stepOn_ = false;
+  uint64_t startUs_ = 0, stepAt_ = 0, busyUs_ = 0, stepUs_ = 0;
+  uint32_t wakes_ = 0;
+  DutyWindow last_{};
+};
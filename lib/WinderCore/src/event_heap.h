@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+
+// ===================== Event heap =====================
+// Indexed binary min-heap of due times with one slot per event id, so an
+// event can be armed, moved or disarmed in O(log n) and the earliest one is
+// read in O(1). Ids are small fixed numbers chosen by the owner.
+
+template <uint8_t IDS>
+class EventHeap {
+public:
+  static const uint64_t NEVER = UINT64_MAX;
+
+  EventHeap(){ for (uint8_t i = 0; i < IDS; i++){ pos_[i] = NONE; at_[i] = NEVER; } }
+
+  bool     empty() const { return n_ == 0; }
+  uint8_t  size() const { return n_; }
+  uint8_t  top() const { return heap_[0]; }                    // valid when !empty()
+  uint64_t topAt() const { return n_ ? at_[heap_[0]] : NEVER; }
+  bool     armed(uint8_t id) const { return pos_[id] != NONE; }
+  uint64_t at(uint8_t id) const { return armed(id) ? at_[id] : NEVER; }
+
+  void set(uint8_t id, uint64_t t){
+    if (pos_[id] == NONE){ at_[id] = t; pos_[id] = n_; heap_[n_++] = id; up(n_ - 1); return; }
+    uint64_t old = at_[id]; at_[id] = t;
+    if (t < old) up(pos_[id]); else down(pos_[id]);
+  }
+  void clear(uint8_t id){
+    uint8_t i = pos_[id];
+    if (i == NONE) return;
+    pos_[id] = NONE;
+    if (i == --n_) return;
+    heap_[i] = heap_[n_]; pos_[heap_[i]] = i;
+    up(i); down(pos_[heap_[i]]);
+  }
+
+private:
+  static const uint8_t NONE = 0xFF;
+  static_assert(IDS < NONE, "too many event ids");
+
+  void place(uint8_t i, uint8_t id){ heap_[i] = id; pos_[id] = i; }
+  void up(uint8_t i){
+    uint8_t id = heap_[i];
+    while (i){
+      uint8_t p = (uint8_t)((i - 1) / 2);
+      if (at_[heap_[p]] <= at_[id]) break;
+      place(i, heap_[p]); i = p;
+    }
+    place(i, id);
+  }
+  void down(uint8_t i){
+    uint8_t id = heap_[i];
+    for (;;){
+      uint8_t c = (uint8_t)(2 * i + 1);
+      if (c >= n_) break;
+      if (c + 1 < n_ && at_[heap_[c + 1]] < at_[heap_[c]]) c++;
+      if (at_[id] <= at_[heap_[c]]) break;
+      place(i, heap_[c]); i = c;
+    }
+    place(i, id);
+  }
+
+  uint64_t at_[IDS] = {};
+  uint8_t  heap_[IDS] = {};
+  uint8_t  pos_[IDS];
+  uint8_t  n_ = 0;
+};
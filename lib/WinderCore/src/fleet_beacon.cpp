@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include "fleet_beacon.h"
+
+static uint8_t* put16(uint8_t* p, uint16_t v){ p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); return p + 2; }
+static uint8_t* put32(uint8_t* p, uint32_t v){ return put16(put16(p, (uint16_t)v), (uint16_t)(v >> 16)); }
+static uint16_t get16(const uint8_t* p){ return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t get32(const uint8_t* p){ return get16(p) | (uint32_t)get16(p + 2) << 16; }
+
+size_t fleetEncode(const FleetBeacon& b, uint8_t* out, size_t cap){
+  if (b.motors > FLEET_MAX_MOTORS || cap < fleetBeaconSize(b.motors)) return 0;
+  uint8_t* p = out;
+  *p++ = 'W'; *p++ = 'B'; *p++ = FLEET_VERSION; *p++ = b.motors;
+  p = put32(p, b.node); p = put16(p, b.seq); p = put16(p, b.httpPort); p = put32(p, b.uptimeS);
+  *p++ = b.flags; *p++ = b.switchMode; p = put16(p, b.turboLeftS);
+  for (uint8_t m = 0; m < b.motors; m++){
+    p = put16(p, (uint16_t)b.m[m].tpd); *p++ = (uint8_t)b.m[m].dir; *p++ = b.m[m].turbo; p = put16(p, b.m[m].nextS);
+  }
+  return (size_t)(p - out);
+}
+
+bool fleetDecode(const uint8_t* p, size_t n, FleetBeacon& b){
+  if (n < fleetBeaconSize(0) || p[0] != 'W' || p[1] != 'B' || p[2] != FLEET_VERSION) return false;
+  if (p[3] > FLEET_MAX_MOTORS || n != fleetBeaconSize(p[3])) return false;
+  b.motors = p[3];
+  b.node = get32(p + 4); b.seq = get16(p + 8); b.httpPort = get16(p + 10); b.uptimeS = get32(p + 12);
+  b.flags = p[16]; b.switchMode = p[17]; b.turboLeftS = get16(p + 18);
+  p += fleetBeaconSize(0);
+  for (uint8_t m = 0; m < b.motors; m++, p += 6){
+    b.m[m].tpd = (int16_t)get16(p); b.m[m].dir = (int8_t)p[2]; b.m[m].turbo = p[3]; b.m[m].nextS = get16(p + 4);
+  }
+  return true;
+}
+
+void fleetName(uint32_t node, char* out, size_t n){ snprintf(out, n, "winder-%06lx", (unsigned long)(node & 0xFFFFFF)); }
+
+bool fleetChanged(const FleetBeacon& a, const FleetBeacon& b){
+  if (a.flags != b.flags || a.switchMode != b.switchMode || a.motors != b.motors) return true;
+  for (uint8_t m = 0; m < a.motors; m++)
+    if (a.m[m].tpd != b.m[m].tpd || a.m[m].dir != b.m[m].dir || a.m[m].turbo != b.m[m].turbo) return true;
+  return false;
+}
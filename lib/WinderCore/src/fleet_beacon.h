@@ -0,0 +1,61 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "motion_link.h"
+
+// ===================== Fleet beacon =====================
+// Compact status every node multicasts, so an aggregator (tools/fleet) can
+// keep a live table of a rack of winders without polling each /status.
+// Little-endian on the wire, fixed 20-byte header plus 6 bytes per motor:
+//   'W' 'B' version motors | node u32 | seq u16 | http port u16 | uptime s u32
+//   flags u8 | switch position u8 | turbo left s u16
+//   per motor: tpd i16 | dir i8 | turbo u8 | next rotation s u16 (saturates)
+// The node id is the low 24 bits of the MAC; the node's mDNS name is
+// fleetName() of it, so names never collide on one network.
+
+static const uint16_t FLEET_PORT = 47077;
+inline constexpr uint8_t FLEET_GROUP[4] = { 239, 255, 77, 77 };   // site-local multicast
+static const uint8_t  FLEET_VERSION = 1;
+static const uint8_t  FLEET_MAX_MOTORS = 16;
+static const size_t   FLEET_NAME_MAX = 16;                      // "winder-xxxxxx" + NUL
+
+enum : uint8_t { FLEET_ENABLED = 1, FLEET_TURBO = 2, FLEET_CLOCK_SET = 4 };
+
+struct FleetMotor {
+  int16_t  tpd;
+  int8_t   dir;
+  uint8_t  turbo;
+  uint16_t nextS;          // 0xFFFF: none, or further out
+};
+
+struct FleetBeacon {
+  uint32_t node;
+  uint16_t seq, httpPort;
+  uint32_t uptimeS;
+  uint8_t  flags, switchMode, motors;
+  uint16_t turboLeftS;
+  FleetMotor m[FLEET_MAX_MOTORS];
+};
+
+constexpr size_t fleetBeaconSize(uint8_t motors){ return 20 + 6 * (size_t)motors; }
+static const size_t FLEET_BEACON_MAX = fleetBeaconSize(FLEET_MAX_MOTORS);
+
+size_t fleetEncode(const FleetBeacon& b, uint8_t* out, size_t cap);    // 0 if it doesn't fit
+bool   fleetDecode(const uint8_t* p, size_t n, FleetBeacon& b);         // false: not a beacon
+void   fleetName(uint32_t node, char* out, size_t n);                   // "winder-1a2b3c"
+// Anything an operator would see change, i.e. worth a beacon before the period is up
+bool   fleetChanged(const FleetBeacon& a, const FleetBeacon& b);
+
+template <uint8_t N>
+void fleetFromStatus(const MotionStatus<N>& st, FleetBeacon& b){
+  static_assert(N <= FLEET_MAX_MOTORS, "beacon holds 16 motors");
+  b.flags = (st.enabled ? FLEET_ENABLED : 0) | (st.turboActive ? FLEET_TURBO : 0) | (st.clockSet ? FLEET_CLOCK_SET : 0);
+  b.switchMode = st.switchMode; b.motors = N;
+  b.turboLeftS = st.turboActive ? (uint16_t)(st.turboLeftMs / 1000 > 0xFFFE ? 0xFFFE : st.turboLeftMs / 1000) : 0;
+  for (uint8_t m = 0; m < N; m++){
+    b.m[m].tpd = st.tpd[m]; b.m[m].dir = st.dir[m];
+    b.m[m].turbo = (st.turboMask >> m) & 1;
+    int32_t s = st.nextMs[m] < 0 ? -1 : st.nextMs[m] / 1000;
+    b.m[m].nextS = s < 0 || s > 0xFFFE ? 0xFFFF : (uint16_t)s;
+  }
+}
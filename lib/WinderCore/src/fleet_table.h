@@ -0,0 +1,53 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "fleet_beacon.h"
+
+// ===================== Fleet table =====================
+// What an aggregator knows about each node: its last beacon, where it came
+// from and when. Fixed capacity, no allocation, so the same table can run
+// on a designated node or in the host tool. Nodes that miss a few beacons
+// are dropped by expire().
+
+struct FleetNode {
+  FleetBeacon b;
+  uint32_t ip;             // sender, network byte order
+  uint64_t seenMs;
+  uint32_t beacons;        // received since it joined the table
+};
+
+template <uint16_t CAP>
+class FleetTable {
+public:
+  // Returns the node's slot, or -1 when the table is full
+  int update(const FleetBeacon& b, uint32_t ip, uint64_t nowMs){
+    int i = find(b.node);
+    if (i < 0){
+      if (n_ == CAP) return -1;
+      i = n_++;
+      nodes_[i].beacons = 0;
+    }
+    FleetNode& e = nodes_[i];
+    e.b = b; e.ip = ip; e.seenMs = nowMs; e.beacons++;
+    return i;
+  }
+  // Drop nodes not heard from for maxAgeMs; returns how many went
+  uint16_t expire(uint64_t nowMs, uint32_t maxAgeMs){
+    uint16_t gone = 0;
+    for (uint16_t i = 0; i < n_;){
+      if (nowMs - nodes_[i].seenMs > maxAgeMs){ nodes_[i] = nodes_[--n_]; gone++; } else i++;
+    }
+    return gone;
+  }
+  int find(uint32_t node) const {
+    for (uint16_t i = 0; i < n_; i++) if (nodes_[i].b.node == node) return i;
+    return -1;
+  }
+  uint16_t size() const { return n_; }
+  const FleetNode& operator[](uint16_t i) const { return nodes_[i]; }
+  void clear(){ n_ = 0; }
+
+private:
+  FleetNode nodes_[CAP];
+  uint16_t n_ = 0;
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+
+// ===================== Hardware abstraction =====================
+// The scheduler only sees these three interfaces. The firmware backs them
+// with esp_timer/digitalRead()/StepEngine; the host simulator with mocks.
+
+// Monotonic 64-bit milliseconds: never wraps (32-bit millis() does after 49.7 days)
+class Clock {
+public:
+  virtual uint64_t millis() = 0;
+};
+
+class Gpio {
+public:
+  virtual int  read(int pin) = 0;
+  virtual void write(int pin, int level) = 0;
+};
+
+class MotorDriver {
+public:
+  virtual void    move(uint8_t m, int32_t steps) = 0;   // relative, adds to any queued move
+  virtual void    stop(uint8_t m) = 0;                  // decelerate to rest
+  virtual int32_t distanceToGo(uint8_t m) = 0;
+  virtual uint32_t moveMs(uint32_t steps) = 0;          // a move from rest, ramps included
+  virtual uint32_t stepsMade(uint8_t m) = 0;            // steps taken since boot (wraps)
+};
@@ -0,0 +1,152 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ===================== JsonIn =====================
+// Reads top-level fields of a flat JSON object in place: no DOM, no
+// allocation. Nested objects/arrays are validated and skipped. Sized for the
+// small request bodies the routes accept.
+
+class JsonIn {
+public:
+  JsonIn(const char* s, size_t n) : s_(s), e_(s + n) { ok_ = scan(nullptr) != nullptr; }
+
+  bool ok() const { return ok_; }
+  bool has(const char* k) const { return find(k) != nullptr; }
+
+  // Integer field; `def` when missing, not an integer or out of range
+  long num(const char* k, long def) const {
+    const char* p = find(k);
+    if (!p) return def;
+    bool neg = *p == '-';
+    if (neg) p++;
+    if (p >= e_ || *p < '0' || *p > '9') return def;
+    long v = 0;
+    for (; p < e_ && *p >= '0' && *p <= '9'; p++){
+      if (v > (0x7fffffffL - (*p - '0')) / 10) return def;
+      v = v * 10 + (*p - '0');
+    }
+    if (p < e_ && (*p == '.' || *p == 'e' || *p == 'E')) return def;
+    return neg ? -v : v;
+  }
+
+  bool boolean(const char* k, bool def) const {
+    const char* p = find(k);
+    if (p && lit(p, "true")) return true;
+    if (p && lit(p, "false")) return false;
+    return def;
+  }
+
+  // String field, unescaped into out (NUL-terminated). False when missing,
+  // not a string, or longer than cap - 1.
+  bool str(const char* k, char* out, size_t cap) const {
+    const char* p = find(k);
+    if (!p || *p != '"' || !cap) return false;
+    size_t n = 0;
+    for (p++; p < e_ && *p != '"'; p++){
+      uint32_t c = (uint8_t)*p;
+      bool esc = c == '\\';
+      if (esc){
+        if (++p >= e_) return false;
+        switch (*p){
+          case 'b': c = '\b'; break;  case 'f': c = '\f'; break;
+          case 'n': c = '\n'; break;  case 'r': c = '\r'; break;
+          case 't': c = '\t'; break;
+          case 'u': if (e_ - p <= 4 || !hex4(p + 1, c)) return false; p += 4; break;
+          default:  c = (uint8_t)*p;  // \" \\ \/
+        }
+      }
+      // \u escapes become UTF-8; surrogate halves are not paired up
+      uint8_t u[3]; size_t m = 0;
+      if (!esc || c < 0x80) u[m++] = (uint8_t)c;
+      else if (c < 0x800){ u[m++] = 0xC0 | (c >> 6); u[m++] = 0x80 | (c & 0x3F); }
+      else { u[m++] = 0xE0 | (c >> 12); u[m++] = 0x80 | ((c >> 6) & 0x3F); u[m++] = 0x80 | (c & 0x3F); }
+      if (n + m >= cap) return false;
+      memcpy(out + n, u, m); n += m;
+    }
+    if (p >= e_) return false;
+    out[n] = 0;
+    return true;
+  }
+
+private:
+  static bool ws(char c){ return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+  const char* skipWs(const char* p) const { while (p < e_ && ws(*p)) p++; return p; }
+
+  bool lit(const char* p, const char* w) const {
+    size_t n = strlen(w);
+    return (size_t)(e_ - p) >= n && !memcmp(p, w, n);
+  }
+
+  static bool hex4(const char* p, uint32_t& v){
+    v = 0;
+    for (int i = 0; i < 4; i++){
+      char c = p[i]; v <<= 4;
+      if (c >= '0' && c <= '9') v |= c - '0';
+      else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+      else return false;
+    }
+    return true;
+  }
+
+  // Past the end of the value at p, or nullptr if malformed
+  const char* skipValue(const char* p, int depth = 0) const {
+    if (p >= e_ || depth > 8) return nullptr;
+    if (*p == '"'){
+      for (p++; p < e_ && *p != '"'; p++) if (*p == '\\' && ++p >= e_) return nullptr;
+      return p < e_ ? p + 1 : nullptr;
+    }
+    if (*p == '{' || *p == '['){
+      char close = *p == '{' ? '}' : ']';
+      p = skipWs(p + 1);
+      if (p < e_ && *p == close) return p + 1;
+      for (;;){
+        if (close == '}'){
+          if (p >= e_ || *p != '"' || !(p = skipValue(p, depth + 1))) return nullptr;
+          p = skipWs(p);
+          if (p >= e_ || *p != ':') return nullptr;
+          p = skipWs(p + 1);
+        }
+        if (!(p = skipValue(p, depth + 1))) return nullptr;
+        p = skipWs(p);
+        if (p < e_ && *p == close) return p + 1;
+        if (p >= e_ || *p != ',') return nullptr;
+        p = skipWs(p + 1);
+      }
+    }
+    const char* q = p;
+    while (q < e_ && !ws(*q) && *q != ',' && *q != '}' && *q != ']') q++;
+    return q > p ? q : nullptr;
+  }
+
+  // Walk the top-level object. With a key: start of its value (or nullptr).
+  // Without: end of the object when well-formed.
+  const char* scan(const char* want) const {
+    const char* p = skipWs(s_);
+    if (p >= e_ || *p != '{') return nullptr;
+    p = skipWs(p + 1);
+    if (p < e_ && *p == '}') return want ? nullptr : p + 1;
+    for (;;){
+      if (p >= e_ || *p != '"') return nullptr;
+      const char* k = p + 1;
+      if (!(p = skipValue(p))) return nullptr;
+      bool hit = want && (size_t)(p - 1 - k) == strlen(want) && !memcmp(k, want, p - 1 - k);
+      p = skipWs(p);
+      if (p >= e_ || *p != ':') return nullptr;
+      p = skipWs(p + 1);
+      if (hit) return p;
+      if (!(p = skipValue(p))) return nullptr;
+      p = skipWs(p);
+      if (p < e_ && *p == '}') return want ? nullptr : p + 1;
+      if (p >= e_ || *p != ',') return nullptr;
+      p = skipWs(p + 1);
+    }
+  }
+
+  const char* find(const char* k) const { return ok_ ? scan(k) : nullptr; }
+
+  const char* s_; const char* e_;
+  bool ok_ = false;
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// ===================== JsonOut =====================
+// Appends a flat JSON object into a caller-owned buffer. Never allocates;
+// on overflow it stops writing and ok() turns false.
+
+class JsonOut {
+public:
+  JsonOut(char* buf, size_t cap) : buf_(buf), cap_(cap) { if (cap_) buf_[0] = 0; }
+
+  JsonOut& begin(){ raw("{"); first_ = true; return *this; }
+  JsonOut& end(){ raw("}"); return *this; }
+
+  JsonOut& num(const char* k, long v){ key(k); return fmt("%ld", v); }
+  JsonOut& unum(const char* k, unsigned long v){ key(k); return fmt("%lu", v); }
+  JsonOut& boolean(const char* k, bool v){ key(k); return raw(v ? "true" : "false"); }
+  JsonOut& str(const char* k, const char* v){ key(k); return quoted(v); }
+  // key with a 1-based index suffix: "tpd" + 2 -> "tpd2"
+  JsonOut& numN(const char* k, int i, const char* suffix, long v){ keyN(k, i, suffix); return fmt("%ld", v); }
+
+  // Raw fragments for arrays/nesting
+  JsonOut& key(const char* k){ sep(); raw("\""); raw(k); return raw("\":"); }
+  JsonOut& keyN(const char* k, int i, const char* suffix){ sep(); return fmt("\"%s%d%s\":", k, i, suffix ? suffix : ""); }
+  JsonOut& quoted(const char* v){
+    raw("\"");
+    for (const char* p = v ? v : ""; *p; p++){
+      unsigned char c = (unsigned char)*p;
+      if (c == '"' || c == '\\'){ char e[3] = { '\\', (char)c, 0 }; raw(e); }
+      else if (c < 0x20) fmt("\\u%04x", c);
+      else { char e[2] = { (char)c, 0 }; raw(e); }
+    }
+    return raw("\"");
+  }
+  JsonOut& raw(const char* s){
+    while (*s){
+      if (len_ + 1 >= cap_){ ok_ = false; return *this; }
+      buf_[len_++] = *s++;
+    }
+    buf_[len_] = 0;
+    return *this;
+  }
+  JsonOut& fmt(const char* f, ...) __attribute__((format(printf, 2, 3)));
+
+  const char* c_str() const { return buf_; }
+  size_t length() const { return len_; }
+  bool ok() const { return ok_; }
+  bool empty() const { return first_; }   // no member written since begin()
+
+private:
+  void sep(){ if (!first_) raw(","); first_ = false; }
+
+  char* buf_; size_t cap_; size_t len_ = 0;
+  bool first_ = true, ok_ = true;
+};
+
+// ----- Worst-case sizes, for static_assert on response buffers -----
+static const size_t JSON_I32_MAX  = 11;   // -2147483648
+static const size_t JSON_U32_MAX  = 10;   // 4294967295
+static const size_t JSON_BOOL_MAX = 5;    // false
+
+constexpr size_t jsonLen(const char* s){ return *s ? 1 + jsonLen(s + 1) : 0; }
+constexpr size_t jsonDigits(unsigned v){ return v < 10 ? 1 : 1 + jsonDigits(v / 10); }
+// quoted() of n source bytes: every byte may become \u00XX
+constexpr size_t jsonQuotedMax(size_t n){ return 2 + 6 * n; }
+// ,"key":value
+constexpr size_t jsonFieldMax(size_t keyLen, size_t valMax){ return 4 + keyLen + valMax; }
+constexpr size_t jsonFieldMax(const char* k, size_t valMax){ return jsonFieldMax(jsonLen(k), valMax); }
+
+inline JsonOut& JsonOut::fmt(const char* f, ...){
+  if (!ok_) return *this;
+  va_list ap; va_start(ap, f);
+  int n = vsnprintf(buf_ + len_, cap_ - len_, f, ap);
+  va_end(ap);
+  if (n < 0 || len_ + (size_t)n >= cap_){ ok_ = false; buf_[len_] = 0; return *this; }
+  len_ += (size_t)n;
+  return *this;
+}
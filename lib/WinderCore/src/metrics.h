@@ -0,0 +1,144 @@
+#pragma once
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "json_out.h"
+#include "step_engine.h"
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+// ===================== Metrics =====================
+// Fixed-bucket histograms in static memory for /metrics. Buckets are powers
+// of two, so record() is a count-leading-zeros and two adds: cheap enough
+// for the step ISR. Bucket k holds values in [2^(k-1), 2^k), bucket 0 holds
+// 0, the last one everything larger. Each histogram has a single writer
+// (one task or the ISR); readers take a copy and may see a sum a sample
+// off from the buckets, which is fine for monitoring.
+
+static const uint8_t METRIC_BUCKETS = 16;   // 0 .. 2^14-1, then +Inf
+
+class Histogram {
+public:
+  void IRAM_ATTR record(uint32_t v){
+    uint8_t k = v ? (uint8_t)(32 - __builtin_clz(v)) : 0;
+    if (k >= METRIC_BUCKETS) k = METRIC_BUCKETS - 1;
+    counts_[k]++;
+    sum_ += v;
+    if (v > max_) max_ = v;
+  }
+  uint32_t bucket(uint8_t k) const { return counts_[k]; }
+  uint64_t sum() const { return sum_; }
+  uint32_t max() const { return max_; }
+  uint32_t count() const { uint32_t n = 0; for (uint32_t c : counts_) n += c; return n; }
+  // Inclusive upper bound of bucket k (Prometheus "le"); the last is +Inf
+  static uint32_t le(uint8_t k){ return k ? (1u << k) - 1 : 0; }
+
+private:
+  uint32_t counts_[METRIC_BUCKETS] = {};
+  uint64_t sum_ = 0;
+  uint32_t max_ = 0;
+};
+
+// ----- Step timing -----
+// Each step's actual interval (CPU cycles between coil writes) against the
+// interval the engine planned for it. Fed from the coil writer, i.e. the
+// step ISR; the cycle counter is the caller's (the CPU's on the board, a
+// virtual one in the sim).
+template <uint8_t N>
+class StepTiming {
+public:
+  Histogram errUs[N];
+
+  template <class Engine>
+  void IRAM_ATTR record(MotorMask changed, uint32_t nowCyc, uint32_t cpuMhz, const Engine& e){
+    for (MotorMask b = changed; b; b &= (MotorMask)(b - 1)){
+      uint8_t m = (uint8_t)__builtin_ctz(b);
+      if (planQ_[m]){                          // 0: first step of a move, or a coil release
+        uint32_t actual = (nowCyc - atCyc_[m]) / cpuMhz, plan = (uint32_t)(((uint64_t)planQ_[m] * STEP_TICK_US) >> 16);
+        errUs[m].record(actual > plan ? actual - plan : plan - actual);
+      }
+      atCyc_[m] = nowCyc; planQ_[m] = e.intervalQ(m);
+    }
+  }
+  // Forget the last step of every motor (a new engine); the histograms stay
+  void restart(){ memset(planQ_, 0, sizeof(planQ_)); }
+
+private:
+  uint32_t atCyc_[N] = {}, planQ_[N] = {};
+};
+
+// ===================== ChunkOut =====================
+// Text appender for responses larger than the response buffer: when the
+// next line doesn't fit, the buffer is handed to the sink and reused. Lines
+// never straddle a chunk; one longer than the buffer is cut.
+class ChunkOut {
+public:
+  typedef void (*Sink)(const char* p, size_t n, void* ctx);
+  ChunkOut(char* buf, size_t cap, Sink sink, void* ctx) : buf_(buf), cap_(cap), sink_(sink), ctx_(ctx) {}
+
+  ChunkOut& line(const char* f, ...) __attribute__((format(printf, 2, 3)));
+  void flush(){ if (len_){ sink_(buf_, len_, ctx_); sent_ += len_; len_ = 0; } }
+  size_t total() const { return sent_ + len_; }
+
+private:
+  char* buf_; size_t cap_, len_ = 0, sent_ = 0;
+  Sink sink_; void* ctx_;
+};
+
+inline ChunkOut& ChunkOut::line(const char* f, ...){
+  for (int pass = 0; pass < 2; pass++){
+    va_list ap; va_start(ap, f);
+    int n = vsnprintf(buf_ + len_, cap_ - len_, f, ap);
+    va_end(ap);
+    if (n < 0) return *this;
+    if (len_ + (size_t)n < cap_){ len_ += (size_t)n; return *this; }
+    if (len_ == 0){ len_ = cap_ - 1; return *this; }   // longer than the buffer: cut
+    flush();
+  }
+  return *this;
+}
+
+// ----- Prometheus text format -----
+// One # TYPE line per family, then a series per label set ("" for none)
+inline void promType(ChunkOut& o, const char* name, const char* type, const char* help){
+  o.line("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+inline void promHistogram(ChunkOut& o, const char* name, const char* labels, const Histogram& live){
+  Histogram h = live;
+  const char* sep = labels[0] ? "," : "";
+  uint32_t cum = 0;
+  for (uint8_t k = 0; k < METRIC_BUCKETS - 1; k++){
+    cum += h.bucket(k);
+    o.line("%s_bucket{%s%sle=\"%lu\"} %lu\n", name, labels, sep, (unsigned long)Histogram::le(k), (unsigned long)cum);
+  }
+  cum += h.bucket(METRIC_BUCKETS - 1);
+  o.line("%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, sep, (unsigned long)cum);
+  const char* l = labels[0] ? "{" : "";
+  const char* r = labels[0] ? "}" : "";
+  o.line("%s_sum%s%s%s %llu\n%s_count%s%s%s %lu\n", name, l, labels, r, (unsigned long long)h.sum(),
+         name, l, labels, r, (unsigned long)cum);
+}
+inline void promValue(ChunkOut& o, const char* name, const char* labels, unsigned long v){
+  if (labels[0]) o.line("%s{%s} %lu\n", name, labels, v);
+  else o.line("%s %lu\n", name, v);
+}
+
+// ----- JSON -----
+// "key":{"count":n,"sum":s,"max":m,"buckets":[per-bucket counts]}
+inline JsonOut& jsonHistogram(JsonOut& j, const char* key, const Histogram& live){
+  Histogram h = live;
+  j.key(key).raw("{");
+  j.fmt("\"count\":%lu,\"sum\":%llu,\"max\":%lu,\"buckets\":[", (unsigned long)h.count(),
+        (unsigned long long)h.sum(), (unsigned long)h.max());
+  for (uint8_t k = 0; k < METRIC_BUCKETS; k++) j.fmt(k ? ",%lu" : "%lu", (unsigned long)h.bucket(k));
+  return j.raw("]}");
+}
+// Largest jsonHistogram() output for a key of keyLen bytes
+constexpr size_t jsonHistogramMax(size_t keyLen){
+  return 4 + keyLen + 1 + jsonLen("\"count\":,\"sum\":,\"max\":,\"buckets\":[") + 2 * JSON_U32_MAX + 20
+         + METRIC_BUCKETS * (JSON_U32_MAX + 1) + 2;
+}
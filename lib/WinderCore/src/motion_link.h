@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include "odometer.h"
+#include "seqlock.h"
+#include "spsc_ring.h"
+#include "step_engine.h"
+#include "wind_program.h"
+
+// ===================== Web <-> motion link =====================
+// The web task (core 0) only ever pushes MotionCmd; the motion task (core 1)
+// owns all scheduler state and publishes MotionStatus after each pass.
+
+enum MotionOp : uint8_t { CMD_START, CMD_STOP, CMD_CONFIG, CMD_TURBO, CMD_CLOCK, CMD_PRESET };
+
+template <uint8_t N>
+struct MotionCmd {
+  uint8_t   op;
+  int16_t   minutes;            // CMD_TURBO
+  MotorMask mask;               // CMD_TURBO: bit per motor
+  int16_t   tpd[N];             // CMD_CONFIG, CMD_PRESET
+  int8_t    dir[N];             // CMD_CONFIG, CMD_PRESET
+  uint8_t   profile;            // CMD_CONFIG: RampProfile
+  WindProgram program;          // CMD_CONFIG
+  uint32_t  todOffsetMs;        // CMD_CLOCK: time of day = (clock + offset) mod 24 h
+  uint8_t   preset;             // CMD_PRESET: switch position
+  uint8_t   manual;             // CMD_PRESET: position leaves settings alone
+};
+
+template <uint8_t N>
+struct MotionStatus {
+  uint32_t  stampMs;            // low 32 bits of the clock when filled; countdowns are relative to it
+  uint8_t   enabled;
+  uint8_t   switchMode;
+  uint8_t   turboActive;
+  MotorMask turboMask;
+  int32_t   turboLeftMs;
+  uint8_t   profile;            // RampProfile, filled in by the motion task
+  WindProgram program;
+  uint8_t   clockSet;           // time of day known (else the day starts at boot)
+  uint16_t  idlePermille;       // motion core, last DutyMeter window
+  uint16_t  wakeupsPerSec;
+  uint16_t  currentMa;          // CPU current proxy
+  uint8_t   lightSleep;         // automatic light sleep is active
+  int16_t   tpd[N];
+  int8_t    dir[N];
+  int32_t   nextMs[N];          // -1 when the motor has no schedule
+  uint16_t  turboTurns[N];      // last turbo session: rotations planned
+  uint16_t  turboDone[N];       //   and finished
+  OdoCounters odo[N];           // odometer totals; ODO_TPD is the plan now
+};
+
+// The motion task may sleep for a long time between snapshots, so readers
+// re-base countdowns to their own now (same clock, 32-bit wrap-safe).
+template <uint8_t N>
+void statusAge(MotionStatus<N>& st, uint32_t nowMs){
+  int32_t age = (int32_t)(nowMs - st.stampMs);
+  if (age <= 0) return;
+  for (uint8_t m = 0; m < N; m++) if (st.nextMs[m] > 0) st.nextMs[m] = st.nextMs[m] > age ? st.nextMs[m] - age : 0;
+  if (st.turboLeftMs > 0) st.turboLeftMs = st.turboLeftMs > age ? st.turboLeftMs - age : 0;
+  st.stampMs = nowMs;
+}
+
+template <uint8_t N> using MotionCmdRing    = SpscRing<MotionCmd<N>, 16>;
+template <uint8_t N> using MotionStatusLock = Seqlock<MotionStatus<N>>;
@@ -0,0 +1,156 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ===================== Odometer =====================
+// What each motor actually did, as opposed to what its TPD asked for.
+// The scheduler keeps running totals: scheduled rotations by direction,
+// whole turbo rotations, slots skipped rather than replayed (catch-up after
+// a stop or a busy motor), rotations started LATE_SLOT_MS or more after
+// their due time, and steps made. ODO_TPD is not a count: it carries the
+// plan at the time, so a history bucket says what the target was.
+
+enum OdoField : uint8_t { ODO_CW, ODO_CCW, ODO_TURBO, ODO_MISSED, ODO_LATE, ODO_STEPS, ODO_TPD, ODO_FIELDS };
+inline constexpr const char* ODO_NAMES[ODO_FIELDS] = { "cw", "ccw", "turbo", "missed", "late", "steps", "tpd" };
+
+struct OdoCounters { uint32_t v[ODO_FIELDS]; };
+
+// ===================== Odometer history =====================
+// Hourly buckets (counts within the hour, TPD at its end) in a fixed byte
+// ring, oldest evicted first. Each bucket is delta-encoded against the one
+// before, per motor: a byte with one bit per field that changed, then the
+// zigzag varint of each change. A steady hour costs one byte per motor.
+// So that steady winding stays steady, the fields are coded as turns
+// (cw + ccw), cw of this hour plus the hour before (an alternating motor
+// flips cw by one every odd hour; the pair stays put), turbo, missed, late,
+// steps beyond the whole rotations, and TPD.
+// Trivially constructible (no initialisers), so the firmware can keep it in
+// RTC memory across warm resets; call reset() on a cold start.
+
+template <uint8_t N, uint16_t BYTES>
+class OdoHistory {
+public:
+  static const uint8_t MOTORS = N;
+  typedef uint32_t Bucket[N][ODO_FIELDS];
+
+  void reset(const OdoCounters* totals, uint32_t stepsPerRev){
+    memset(this, 0, sizeof(*this));
+    spr_ = stepsPerRev;
+    for (uint8_t m = 0; m < N; m++) for (uint8_t f = 0; f < ODO_FIELDS; f++) last_[m][f] = totals[m].v[f];
+  }
+  // Close the hour: counts since the last close (and the TPD now) become a bucket
+  void close(const OdoCounters* totals){
+    Bucket b;
+    for (uint8_t m = 0; m < N; m++){
+      for (uint8_t f = 0; f < ODO_FIELDS; f++) b[m][f] = f == ODO_TPD ? totals[m].v[f] : totals[m].v[f] - last_[m][f];
+      for (uint8_t f = 0; f < ODO_FIELDS; f++) last_[m][f] = totals[m].v[f];
+    }
+    append(b);
+  }
+  // Totals carry on from the last close (false after they were lost or reset)
+  bool follows(const OdoCounters* totals) const {
+    for (uint8_t m = 0; m < N; m++)
+      for (uint8_t f = 0; f < ODO_TPD; f++) if ((int32_t)(totals[m].v[f] - last_[m][f]) < 0) return false;
+    return true;
+  }
+  uint16_t hours() const { return hours_; }
+  uint16_t bytes() const { return used_; }
+  static uint16_t capacity(){ return BYTES; }
+  // Counts accrued since the last close (the hour in progress)
+  void open(const OdoCounters* totals, Bucket& b) const {
+    for (uint8_t m = 0; m < N; m++)
+      for (uint8_t f = 0; f < ODO_FIELDS; f++) b[m][f] = f == ODO_TPD ? totals[m].v[f] : totals[m].v[f] - last_[m][f];
+  }
+  // Buckets oldest first: fn(index, const Bucket&)
+  template <class F> void each(F fn) const {
+    uint32_t cur[N][ODO_FIELDS];
+    uint32_t cw[N];
+    memcpy(cur, base_, sizeof(cur));
+    memcpy(cw, baseCw_, sizeof(cw));
+    uint16_t at = head_;
+    for (uint16_t h = 0; h < hours_; h++){
+      at = decode(at, cur);
+      Bucket b;
+      fromCoded(cur, cw, b, spr_);
+      fn(h, b);
+    }
+  }
+
+private:
+  // Largest encoded bucket: mask byte + 5-byte varint per field, per motor
+  static const uint16_t REC_MAX = N * (1 + 5 * ODO_FIELDS);
+  static_assert(BYTES >= REC_MAX, "history ring smaller than one bucket");
+
+  void toCoded(const Bucket& b, uint32_t (&c)[N][ODO_FIELDS]) const {
+    for (uint8_t m = 0; m < N; m++){
+      const uint32_t* v = b[m];
+      uint32_t turns = v[ODO_CW] + v[ODO_CCW];
+      c[m][0] = turns; c[m][1] = v[ODO_CW] + prevCw_[m]; c[m][2] = v[ODO_TURBO]; c[m][3] = v[ODO_MISSED]; c[m][4] = v[ODO_LATE];
+      c[m][5] = v[ODO_STEPS] - (turns + v[ODO_TURBO]) * spr_; c[m][6] = v[ODO_TPD];
+    }
+  }
+  // `cw`: the previous hour's cw in, this hour's out
+  static void fromCoded(const uint32_t (&c)[N][ODO_FIELDS], uint32_t (&cw)[N], Bucket& b, uint32_t spr){
+    for (uint8_t m = 0; m < N; m++){
+      uint32_t* v = b[m];
+      v[ODO_CW] = cw[m] = c[m][1] - cw[m]; v[ODO_CCW] = c[m][0] - cw[m]; v[ODO_TURBO] = c[m][2]; v[ODO_MISSED] = c[m][3];
+      v[ODO_LATE] = c[m][4]; v[ODO_STEPS] = c[m][5] + (c[m][0] + c[m][2]) * spr; v[ODO_TPD] = c[m][6];
+    }
+  }
+  // One bucket from ring offset `pos` applied onto `cur`; returns the next offset
+  uint16_t decode(uint16_t pos, uint32_t (&cur)[N][ODO_FIELDS]) const {
+    for (uint8_t m = 0; m < N; m++){
+      uint8_t mask = buf_[pos]; pos = (uint16_t)((pos + 1) % BYTES);
+      for (uint8_t f = 0; f < ODO_FIELDS; f++){
+        if (!(mask & (1u << f))) continue;
+        uint32_t z = 0;
+        for (uint8_t s = 0;; s += 7){
+          uint8_t c = buf_[pos]; pos = (uint16_t)((pos + 1) % BYTES);
+          z |= (uint32_t)(c & 0x7F) << s;
+          if (!(c & 0x80)) break;
+        }
+        cur[m][f] += (z >> 1) ^ (0u - (z & 1));
+      }
+    }
+    return pos;
+  }
+  void append(const Bucket& b){
+    uint32_t c[N][ODO_FIELDS];
+    toCoded(b, c);
+    uint8_t rec[REC_MAX];
+    uint16_t n = 0;
+    for (uint8_t m = 0; m < N; m++){
+      uint16_t maskAt = n++;
+      uint8_t mask = 0;
+      for (uint8_t f = 0; f < ODO_FIELDS; f++){
+        int32_t d = (int32_t)(c[m][f] - prev_[m][f]);
+        if (!d) continue;
+        mask |= (uint8_t)(1u << f);
+        uint32_t z = ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+        do { rec[n++] = (uint8_t)((z & 0x7F) | (z > 0x7F ? 0x80 : 0)); z >>= 7; } while (z);
+      }
+      rec[maskAt] = mask;
+    }
+    // Evict the oldest buckets into the base until this one fits
+    while (used_ + n > BYTES){
+      uint16_t next = decode(head_, base_);
+      Bucket gone;
+      fromCoded(base_, baseCw_, gone, spr_);
+      used_ = (uint16_t)(used_ - (uint16_t)((next + BYTES - head_) % BYTES));
+      head_ = next; hours_--;
+    }
+    for (uint16_t i = 0; i < n; i++) buf_[(head_ + used_ + i) % BYTES] = rec[i];
+    used_ = (uint16_t)(used_ + n); hours_++;
+    memcpy(prev_, c, sizeof(prev_));
+    for (uint8_t m = 0; m < N; m++) prevCw_[m] = b[m][ODO_CW];
+  }
+
+  uint8_t  buf_[BYTES];
+  uint16_t head_, used_, hours_;
+  uint32_t spr_;
+  uint32_t base_[N][ODO_FIELDS];       // coded bucket before the oldest kept
+  uint32_t prev_[N][ODO_FIELDS];       // coded newest bucket
+  uint32_t last_[N][ODO_FIELDS];       // totals at the last close
+  uint32_t baseCw_[N], prevCw_[N];     // cw of the base and of the newest bucket
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <math.h>
+#include <stdint.h>
+#include "ramp_profile.h"
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+// ===================== Power budget =====================
+// Coil-current model for 28BYJ-48 / ULN2003 motors, and the numbers the
+// step engine uses to keep motors from ramping at the same time when the
+// estimated draw of both would exceed a cap.
+//   - An energised coil draws coilMa at DC (5 V over the winding).
+//   - Half-stepping energises one or two coils; each is on for three step
+//     intervals, and with an L/R time constant tau its current only rises
+//     towards coilMa: the mean over the on-time is coilMa * powerFill().
+//   - On the ramp the steps are slow enough that coils reach full current,
+//     so a ramping motor is counted as two coils at coilMa. At cruise the
+//     steps are short and the draw drops by the fill factor.
+//   - A motor at rest draws its energised coils in full (holding), or
+//     nothing once they are released.
+
+// Mean coil current over an on-time of onUs, as a fraction of the DC value
+inline float powerFill(float onUs, float tauUs){
+  if (tauUs <= 0 || onUs <= 0) return 1.0f;
+  float x = onUs / tauUs;
+  return 1.0f - (1.0f - expf(-x)) / x;
+}
+
+// Coils energised in a pattern (the step ISR calls this)
+inline uint8_t IRAM_ATTR powerCoilsOn(uint8_t coils){ return (uint8_t)((0x4332322132212110ULL >> ((coils & 0xF) * 4)) & 0xF); }
+
+// Estimated draw of one motor now: its coil pattern and the interval it is
+// stepping at (Q16 ticks, 0 = at rest)
+inline float powerMotorMa(uint8_t coils, uint32_t intervalQ, uint32_t tickUs, uint16_t coilMa, uint16_t tauUs){
+  float ma = (float)powerCoilsOn(coils) * coilMa;
+  if (!intervalQ) return ma;
+  return ma * powerFill(3.0f * intervalQ * tickUs / 65536.0f, (float)tauUs);
+}
+
+// What the engine checks a start against, derived once per ramp table
+struct PowerPlan {
+  uint16_t capMa;      // combined coil current allowed
+  uint16_t coilMa;     // one coil at DC (holding motors)
+  uint16_t rampMa;     // a motor on its ramp
+  uint16_t cruiseMa;   // a motor at cruise speed
+  uint32_t rampSpan;   // duration of one ramp, in cruise steps
+};
+
+inline PowerPlan powerPlan(const RampTable& r, uint32_t tickUs, uint16_t capMa, uint16_t coilMa, uint16_t tauUs){
+  PowerPlan p{};
+  uint64_t q = 0;
+  for (uint16_t k = 0; k < r.steps; k++) q += r.q[k];
+  p.capMa = capMa; p.coilMa = coilMa;
+  p.rampMa = (uint16_t)(2 * coilMa);
+  p.cruiseMa = (uint16_t)(2 * coilMa * powerFill(3.0f * r.q[r.steps] * tickUs / 65536.0f, (float)tauUs) + 0.5f);
+  p.rampSpan = (uint32_t)((q + r.q[r.steps] - 1) / r.q[r.steps]);
+  return p;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+// ===================== Ramp profiles =====================
+// Step-interval tables for the acceleration ramp, Q16 timer ticks per step,
+// all integer math. A table is built once per speed setting (at compile
+// time for the boot default), so the step ISR only indexes an array.
+//   RAMP_TRAPEZOID  constant acceleration: v^2 linear in steps, the shape
+//                   AccelStepper produced
+//   RAMP_SCURVE     speed follows smoothstep over the ramp: acceleration
+//                   starts and ends at zero and peaks at 1.5x the trapezoid's
+
+enum RampProfile : uint8_t { RAMP_TRAPEZOID = 0, RAMP_SCURVE = 1, RAMP_PROFILES };
+
+static const uint16_t RAMP_MAX_STEPS = 512;
+
+struct RampTable {
+  uint32_t maxSps, startSps;
+  uint16_t steps;                      // ramp length; q[steps] is the cruise interval
+  uint8_t  profile;
+  uint32_t q[RAMP_MAX_STEPS + 1];      // Q16 ticks per step, indexed by steps into the ramp
+};
+
+inline const char* rampProfileName(uint8_t p){ return p == RAMP_SCURVE ? "scurve" : "trapezoid"; }
+inline int rampProfileParse(const char* s){
+  for (uint8_t p = 0; p < RAMP_PROFILES; p++) if (!strcmp(s, rampProfileName(p))) return p;
+  return -1;
+}
+
+constexpr uint32_t rampIsqrt(uint64_t x){
+  uint64_t r = 0, b = 1ULL << 62;
+  while (b > x) b >>= 2;
+  while (b){
+    if (x >= r + b){ x -= r + b; r = (r >> 1) + b; } else r >>= 1;
+    b >>= 2;
+  }
+  return (uint32_t)r;
+}
+
+// Speed k steps into an n-step ramp from v0 to v1, Q8 steps/s
+constexpr uint32_t rampSpeedQ8(uint8_t profile, uint32_t v0, uint32_t v1, uint32_t n, uint32_t k){
+  if (k >= n) return v1 << 8;
+  if (profile == RAMP_SCURVE){
+    uint64_t u = ((uint64_t)k << 16) / n;                           // Q16
+    uint64_t s = ((u * u) >> 16) * ((3ULL << 16) - 2 * u) >> 16;    // 3u^2 - 2u^3, Q16
+    return (v0 << 8) + (uint32_t)((((uint64_t)(v1 - v0) << 8) * s) >> 16);
+  }
+  uint64_t a = ((uint64_t)v0 * v0) << 16, b = ((uint64_t)v1 * v1) << 16;
+  return rampIsqrt(a + (b - a) * k / n);
+}
+
+// Same clamping StepEngine::setSpeed() always applied
+constexpr void rampNormalize(uint32_t& maxSps, uint32_t& startSps, uint32_t& steps){
+  if (maxSps < 1) maxSps = 1;
+  if (startSps < 1 || startSps > maxSps) startSps = maxSps;
+  if (steps > RAMP_MAX_STEPS) steps = RAMP_MAX_STEPS;
+}
+
+constexpr void rampFill(RampTable& t, uint8_t profile, uint32_t tickHz, uint32_t maxSps, uint32_t startSps, uint32_t steps){
+  rampNormalize(maxSps, startSps, steps);
+  t.maxSps = maxSps; t.startSps = startSps; t.steps = (uint16_t)steps; t.profile = profile;
+  for (uint32_t k = 0; k <= steps; k++)
+    t.q[k] = (uint32_t)(((uint64_t)tickHz << 24) / rampSpeedQ8(profile, startSps, maxSps, steps, k));
+}
+
+constexpr RampTable rampTable(uint8_t profile, uint32_t tickHz, uint32_t maxSps, uint32_t startSps, uint32_t steps){
+  RampTable t{};
+  rampFill(t, profile, tickHz, maxSps, startSps, steps);
+  return t;
+}
+
+// Two tables built on demand for runtime speed/profile changes. A miss
+// rebuilds the slot that was not handed out last, so the table the ISR is
+// stepping from is never overwritten. Single caller (the motion task).
+class RampCache {
+public:
+  const RampTable& get(uint8_t profile, uint32_t tickHz, uint32_t maxSps, uint32_t startSps, uint32_t steps){
+    rampNormalize(maxSps, startSps, steps);
+    for (uint8_t i = 0; i < 2; i++){
+      const RampTable& t = slot_[i];
+      if (used_[i] && t.profile == profile && t.maxSps == maxSps && t.startSps == startSps && t.steps == steps){ next_ = i ^ 1; return t; }
+    }
+    uint8_t i = next_; next_ ^= 1;
+    rampFill(slot_[i], profile, tickHz, maxSps, startSps, steps);
+    used_[i] = true; builds_++;
+    return slot_[i];
+  }
+  uint32_t builds() const { return builds_; }
+
+private:
+  RampTable slot_[2];
+  bool used_[2] = { false, false };
+  uint8_t next_ = 0;
+  uint32_t builds_ = 0;
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include "odometer.h"
+#include "step_engine.h"
+
+// ===================== Resume state =====================
+// Everything the scheduler needs to carry on after a reset, as absolute
+// times on the clock it was captured with. The firmware mirrors it into
+// RTC slow memory; on a warm reset the new clock is related to the old one
+// and every deadline is shifted across (WinderScheduler::resume()).
+
+template <uint8_t N>
+struct ResumeState {
+  uint64_t  nextDue[N];          // 0 = no schedule
+  uint64_t  slotDue[N];
+  uint64_t  turboEndMs;
+  uint32_t  turns[N];            // scheduled rotations started since first boot
+  OdoCounters odo[N];            // odometer totals (odometer.h)
+  int32_t   turboSteps[N];       // steps towards the next whole turbo rotation
+  uint32_t  todOffsetMs;
+  uint16_t  turboTurns[N];       // turbo session: whole rotations planned per motor
+  uint16_t  burstLeft[N];
+  uint8_t   slot[N];
+  int8_t    lastDir[N];          // Alternate plan: direction of the last rotation
+  MotorMask turboMask;
+  MotorMask turboCount;          // motors whose turbo rotations are still being counted
+  uint8_t   enabled, turboActive, clockSet;
+};
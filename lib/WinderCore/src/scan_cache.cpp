@@ -0,0 +1,75 @@
+#include "scan_cache.h"
+#include <string.h>
+
+static uint32_t fnv1a(const char* s){
+  uint32_t h = 2166136261u;
+  while (*s){ h ^= (uint8_t)*s++; h *= 16777619u; }
+  return h;
+}
+
+static bool blank(char c){ return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+void ScanCache::clear(){
+  n_ = 0;
+  memset(slot_, 0, sizeof(slot_));
+}
+
+int ScanCache::find(const char* ssid, uint32_t h) const {
+  for (uint8_t i = h & (SLOTS - 1);; i = (i + 1) & (SLOTS - 1)){
+    uint8_t s = slot_[i];
+    if (!s) return -1;
+    if (hash_[s - 1] == h && !strcmp(nets_[s - 1].ssid, ssid)) return s - 1;
+  }
+}
+
+void ScanCache::insertSlot(uint8_t idx){
+  uint8_t i = hash_[idx] & (SLOTS - 1);
+  while (slot_[i]) i = (i + 1) & (SLOTS - 1);
+  slot_[i] = idx + 1;
+}
+
+void ScanCache::rebuild(){
+  memset(slot_, 0, sizeof(slot_));
+  for (uint8_t i = 0; i < n_; i++) insertSlot(i);
+}
+
+void ScanCache::add(const char* ssid, int8_t rssi, uint8_t channel, uint8_t auth){
+  // Trim like the UI does; an all-blank name is a hidden network
+  size_t len = strnlen(ssid, sizeof(ScanNet::ssid) - 1);   // driver field may lack a NUL at 32
+  while (len && blank(*ssid)){ ssid++; len--; }
+  while (len && blank(ssid[len - 1])) len--;
+  if (!len) return;
+  char name[sizeof(ScanNet::ssid)];
+  memcpy(name, ssid, len); name[len] = 0;
+
+  uint32_t h = fnv1a(name);
+  int at = find(name, h);
+  if (at >= 0){
+    ScanNet& e = nets_[at];
+    if (rssi > e.rssi){ e.rssi = rssi; e.channel = channel; e.auth = auth; }
+    return;
+  }
+  uint8_t idx = n_;
+  if (n_ == MAX_NETS){
+    idx = 0;
+    for (uint8_t i = 1; i < n_; i++) if (nets_[i].rssi < nets_[idx].rssi) idx = i;
+    if (rssi <= nets_[idx].rssi) return;
+  }
+  ScanNet& e = nets_[idx];
+  memcpy(e.ssid, name, len + 1);
+  e.rssi = rssi; e.channel = channel; e.auth = auth;
+  hash_[idx] = h;
+  if (idx == n_){ n_++; insertSlot(idx); }
+  else rebuild();   // evicted entry's slot can't simply be cleared under linear probing
+}
+
+void ScanCache::finish(){
+  // Insertion sort: n is small and the driver list is often nearly sorted
+  for (uint8_t i = 1; i < n_; i++){
+    ScanNet e = nets_[i]; uint32_t h = hash_[i];
+    uint8_t j = i;
+    for (; j && nets_[j - 1].rssi < e.rssi; j--){ nets_[j] = nets_[j - 1]; hash_[j] = hash_[j - 1]; }
+    nets_[j] = e; hash_[j] = h;
+  }
+  rebuild();
+}
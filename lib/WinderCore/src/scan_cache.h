@@ -0,0 +1,42 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ===================== Scan cache =====================
+// Compact result of one Wi-Fi scan: one entry per SSID (strongest BSS wins),
+// sorted by signal. Dedup goes through a small open-addressing hash set, so
+// filling it is linear in the number of scan records.
+
+struct ScanNet {
+  char    ssid[33];
+  int8_t  rssi;
+  uint8_t channel;
+  uint8_t auth;      // wifi_auth_mode_t
+};
+
+class ScanCache {
+public:
+  static const uint8_t MAX_NETS = 24;
+
+  ScanCache(){ clear(); }
+  void clear();
+  // Hidden/blank SSIDs are skipped. When full, a new SSID only gets in by
+  // replacing the weakest entry.
+  void add(const char* ssid, int8_t rssi, uint8_t channel, uint8_t auth);
+  void finish();     // sort strongest first; call once after the last add()
+
+  uint8_t size() const { return n_; }
+  const ScanNet& operator[](uint8_t i) const { return nets_[i]; }
+
+private:
+  static const uint8_t SLOTS = 64;   // power of two, > 2 * MAX_NETS
+
+  int  find(const char* ssid, uint32_t h) const;   // index into nets_, or -1
+  void insertSlot(uint8_t idx);
+  void rebuild();
+
+  ScanNet  nets_[MAX_NETS];
+  uint32_t hash_[MAX_NETS];
+  uint8_t  slot_[SLOTS];    // nets_ index + 1, 0 = empty
+  uint8_t  n_ = 0;
+};
@@ -0,0 +1,467 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include "hal.h"
+#include "odometer.h"
+#include "event_heap.h"
+#include "motion_link.h"
+#include "resume_state.h"
+#include "switch_presets.h"
+#include "wind_program.h"
+
+// ===================== Winder scheduler =====================
+// TPD spacing, direction plans, DPDT presets and turbo, lifted out of loop()
+// so the same code runs in the motion task and in the host simulator.
+// Direction plans use config.h's values: +1 CW, -1 CCW, 0 alternate.
+// Every per-motor path iterates 0..N-1; nothing is written per motor by hand.
+// Time is the 64-bit Clock. Everything that can come due (rotations, switch
+// debounce expiry) sits in an event heap, so the caller can sleep until
+// nextEventMs() instead of polling. A turbo session is one planned move per
+// motor (whole rotations sized to the requested time); it ends when they do.
+// The selector isn't sampled: the caller reports pin edges (GPIO interrupt)
+// with switchEdge(), each one restarting the debounce expiry; when it
+// expires the pins are read once and a new position applies its preset.
+// With a burst program (wind_program.h) a motor's event is its next burst
+// slot; inside a burst it stays due and turns back to back.
+// The odometer (odometer.h) counts what was actually done: rotations by
+// direction, whole turbo rotations, skipped and late slots, steps made.
+
+struct SchedulerPins {
+  int modeA, modeB;   // DPDT selector (INPUT_PULLUP, to GND)
+  int led;            // -1 = none
+};
+
+template <uint8_t N>
+class WinderScheduler {
+public:
+  static const uint8_t MOTORS = N;
+
+  WinderScheduler(Clock& clk, Gpio& io, MotorDriver& mot, const SchedulerPins& pins,
+                  long stepsPerRev, uint32_t debounceMs)
+    : clk_(clk), io_(io), mot_(mot), pins_(pins), stepsPerRev_(stepsPerRev),
+      debounceMs_(debounceMs), presets_(switchPresetsDefault<N>()) {
+    for (uint8_t m = 0; m < N; m++) lastDir_[m] = +1;
+  }
+
+  // first rotation one interval from now; a switch position other than
+  // setSwitchApplied()'s applies its preset
+  void begin();
+  // Warm start instead of begin(): state captured before a reset, its times
+  // moved by shiftMs (new clock = old clock + shiftMs). Due times that passed
+  // while the chip was down fire at once; later slots keep their grid.
+  void resume(const ResumeState<N>& r, int64_t shiftMs);
+  void capture(ResumeState<N>& r) const;
+  void apply(const MotionCmd<N>& c);           // command from the web task
+  void poll();                                 // one scheduler pass
+  void switchEdge();                           // a selector pin changed level
+  void fillStatus(MotionStatus<N>& st);
+  // Earliest time poll() has work to do. A motor in motion counts as due
+  // now: its completion is polled, not timed.
+  uint64_t nextEventMs();
+
+  void setPlan(uint8_t m, int tpd, int dir){ tpd_[m] = tpd; dirPlan_[m] = dir; }
+  void setProgram(const WindProgram& p){ if (programValid(p)) program_ = p; }   // before begin()
+  // Before begin()/resume(): the preset table, and the position whose preset
+  // the plan already reflects (SWITCH_UNKNOWN: apply whatever is selected)
+  void setPresets(const SwitchPresets<N>& t){ presets_ = t; }
+  void setSwitchApplied(uint8_t pos){ applied_ = pos; }
+  const SwitchPreset<N>& preset(uint8_t pos) const { return presets_.pos[pos]; }
+  const WindProgram& program() const { return program_; }
+  int  tpd(uint8_t m) const { return tpd_[m]; }
+  int  dirPlan(uint8_t m) const { return dirPlan_[m]; }
+  uint32_t turns(uint8_t m) const { return turns_[m]; }
+  const OdoCounters& odometer(uint8_t m) const { return odo_[m]; }
+  // How late the motor's last rotation started against its due time
+  uint32_t lateMs(uint8_t m) const { return late_[m]; }
+  int  lastDir(uint8_t m) const { return lastDir_[m]; }
+  bool enabled() const { return enabled_; }
+  bool turboActive() const { return turboActive_; }
+  MotorMask turboMask() const { return turboMask_; }
+  // Turbo session: whole rotations planned for the motor, and finished so far
+  uint16_t turboTurns(uint8_t m) const { return turboTurns_[m]; }
+  uint16_t turboDone(uint8_t m);
+  int  mode() const { return stableMode_; }
+
+  static uint32_t intervalFromTPD(int tpd){ return tpd <= 0 ? 0 : 86400000UL / (uint32_t)tpd; }
+  static const uint32_t LATE_SLOT_MS = 1000;   // a rotation this late counts as late
+
+private:
+  // Event ids: 0..N-1 = rotation due for motor m
+  enum : uint8_t { EV_DEBOUNCE = N, EV_COUNT };
+
+  int  readModeRaw();
+  void switchSettled(uint64_t now);
+  void applyPreset(uint8_t pos, uint64_t now);
+  int  pickDir(uint8_t m);
+  void rotate(uint8_t m){
+    int dir = pickDir(m);
+    mot_.move(m, (long)dir * stepsPerRev_); turns_[m]++;
+    odo_[m].v[dir > 0 ? ODO_CW : ODO_CCW]++;
+  }
+  void countSteps();
+  void reschedule(uint8_t m, uint64_t now);
+  bool bursty(uint8_t m) const { return table_[m].slots() != 0; }
+  uint32_t timeOfDay(uint64_t t) const { return (uint32_t)((t + todOffsetMs_) % PROGRAM_DAY_MS); }
+  void planSlot(uint8_t m, uint64_t from);
+  void fireBurst(uint8_t m, uint64_t now);
+  // The heap holds a motor's rotation only while it can fire
+  void arm(uint8_t m){
+    if (enabled_ && !turboActive_ && tpd_[m] > 0 && (nextDue_[m] || bursty(m))) events_.set(m, nextDue_[m]); else events_.clear(m);
+  }
+  void armAll(){ for (uint8_t m = 0; m < N; m++) arm(m); }
+  bool moving(){ for (uint8_t m = 0; m < N; m++) if (mot_.distanceToGo(m) != 0) return true; return false; }
+  void startTurbo(MotorMask mask, uint32_t minutes);
+  uint16_t turboTurnsFor(uint32_t partial, uint32_t ms);
+  void updateTurbo();
+  void indicate(bool on);
+
+  Clock& clk_; Gpio& io_; MotorDriver& mot_;
+  SchedulerPins pins_;
+  long stepsPerRev_;
+  uint32_t debounceMs_;
+
+  bool enabled_ = true;
+  int tpd_[N] = {0}, dirPlan_[N] = {0}, lastDir_[N];
+  uint32_t turns_[N] = {0}, late_[N] = {0};
+  uint64_t nextDue_[N] = {0};
+  uint32_t behind_[N] = {0};   // overdue slot resumed onto a fresh clock: how far before nextDue_ it fell
+  WindProgram program_{};
+  BurstTable table_[N];
+  uint64_t slotDue_[N] = {0};
+  uint8_t  slot_[N] = {0};
+  uint16_t burstLeft_[N] = {0};        // turns still owed by the current burst(s)
+  uint32_t todOffsetMs_ = 0;
+  bool clockSet_ = false;
+  EventHeap<EV_COUNT> events_;
+
+  int stableMode_ = 0;
+  uint8_t applied_ = SWITCH_UNKNOWN;   // position whose preset was applied last
+  SwitchPresets<N> presets_;
+
+  bool turboActive_ = false;
+  MotorMask turboMask_ = 0; uint64_t turboEndMs_ = 0;   // end: when the longest plan should finish
+  uint16_t turboTurns_[N] = {0};
+
+  OdoCounters odo_[N] = {};
+  uint32_t stepsSeen_[N] = {0};        // driver's step count at the last look
+  int32_t  turboSteps_[N] = {0};       // steps towards the next whole turbo rotation
+  MotorMask turboCount_ = 0;           // session motors, and dropped ones finishing a rotation
+
+  int led_ = -1;   // last LED level written, avoids re-writing every pass
+};
+
+template <uint8_t N>
+void WinderScheduler<N>::begin(){
+  uint64_t now = clk_.millis();
+  for (uint8_t m = 0; m < N; m++) reschedule(m, now);
+  switchSettled(now);                          // switch is settled at boot
+  armAll();
+}
+
+template <uint8_t N>
+void WinderScheduler<N>::capture(ResumeState<N>& r) const {
+  memset(&r, 0, sizeof(r));                      // padding too: the firmware compares images
+  for (uint8_t m = 0; m < N; m++){
+    r.nextDue[m] = nextDue_[m]; r.slotDue[m] = slotDue_[m]; r.turns[m] = turns_[m];
+    r.burstLeft[m] = burstLeft_[m]; r.slot[m] = slot_[m]; r.lastDir[m] = (int8_t)lastDir_[m];
+    r.turboTurns[m] = turboTurns_[m]; r.odo[m] = odo_[m]; r.turboSteps[m] = turboSteps_[m];
+  }
+  r.turboEndMs = turboEndMs_; r.turboMask = turboMask_; r.turboCount = turboCount_; r.todOffsetMs = todOffsetMs_;
+  r.enabled = enabled_; r.turboActive = turboActive_; r.clockSet = clockSet_;
+}
+
+template <uint8_t N>
+void WinderScheduler<N>::resume(const ResumeState<N>& r, int64_t shiftMs){
+  uint64_t now = clk_.millis();
+  auto moved = [&](uint64_t t) -> uint64_t {
+    if (!t) return 0;
+    int64_t v = (int64_t)t + shiftMs;
+    return v < 1 ? 1 : (uint64_t)v;                // overdue: due at once
+  };
+  enabled_ = r.enabled; clockSet_ = r.clockSet;
+  // The day keeps its place: time of day = clock + offset on either clock
+  todOffsetMs_ = (uint32_t)(((int64_t)r.todOffsetMs - shiftMs % (int64_t)PROGRAM_DAY_MS + 2 * (int64_t)PROGRAM_DAY_MS) % PROGRAM_DAY_MS);
+  for (uint8_t m = 0; m < N; m++){
+    turns_[m] = r.turns[m]; lastDir_[m] = r.lastDir[m] < 0 ? -1 : +1;
+    table_[m].compile(tpd_[m], program_);
+    nextDue_[m] = moved(r.nextDue[m]); slotDue_[m] = moved(r.slotDue[m]);
+    int64_t was = (int64_t)r.nextDue[m] + shiftMs;   // keeps the even grid's phase
+    behind_[m] = r.nextDue[m] && was < 1 && !bursty(m) ? (uint32_t)(1 - was) : 0;
+    burstLeft_[m] = bursty(m) ? r.burstLeft[m] : 0; slot_[m] = r.slot[m];
+    if (slot_[m] >= table_[m].slots()) slot_[m] = 0;
+    if (tpd_[m] > 0 && !nextDue_[m]) reschedule(m, now);   // settings changed under it
+    turboTurns_[m] = r.turboTurns[m];
+    odo_[m] = r.odo[m]; turboSteps_[m] = r.turboSteps[m];
+    stepsSeen_[m] = mot_.stepsMade(m);         // the driver counts from boot
+  }
+  // The plan's unfinished steps come back with the motors' moves
+  turboActive_ = r.turboActive; turboMask_ = r.turboMask; turboCount_ = r.turboCount;
+  turboEndMs_ = moved(r.turboEndMs);
+  switchSettled(now);                          // it may have moved while the chip was down
+  armAll();
+}
+
+// Even spread: one interval from now. Burst program: recompile the slot
+// table and wait for the next slot.
+template <uint8_t N>
+void WinderScheduler<N>::reschedule(uint8_t m, uint64_t now){
+  burstLeft_[m] = 0; behind_[m] = 0;
+  if (table_[m].compile(tpd_[m], program_)){ planSlot(m, now); nextDue_[m] = slotDue_[m]; return; }
+  nextDue_[m] = (tpd_[m] > 0) ? now + intervalFromTPD(tpd_[m]) : 0;
+}
+
+template <uint8_t N>
+void WinderScheduler<N>::planSlot(uint8_t m, uint64_t from){
+  uint32_t wait;
+  slot_[m] = table_[m].next(timeOfDay(from), wait);
+  slotDue_[m] = from + wait;
+}
+
+// A burst motor's event: take on the slot's turns when it has started,
+// then one rotation; due again at once while turns are owed
+template <uint8_t N>
+void WinderScheduler<N>::fireBurst(uint8_t m, uint64_t now){
+  if (slotDue_[m] <= now){
+    burstLeft_[m] += table_[m].turns(slot_[m]);
+    planSlot(m, slotDue_[m] + 1);
+    // Slots missed while stopped are skipped (counted up to a day of them)
+    for (uint16_t i = 0; slotDue_[m] < now && i < table_[m].slots(); i++){
+      odo_[m].v[ODO_MISSED] += table_[m].turns(slot_[m]);
+      planSlot(m, slotDue_[m] + 1);
+    }
+    if (slotDue_[m] <= now) planSlot(m, now);
+  }
+  if (burstLeft_[m]){ rotate(m); burstLeft_[m]--; }
+  nextDue_[m] = burstLeft_[m] ? now : slotDue_[m];
+}
+
+template <uint8_t N>
+int WinderScheduler<N>::pickDir(uint8_t m){
+  int plan = dirPlan_[m];
+  if (plan == +1){ lastDir_[m] = +1; return +1; }
+  if (plan == -1){ lastDir_[m] = -1; return -1; }
+  lastDir_[m] = (lastDir_[m] > 0) ? -1 : +1; return lastDir_[m];
+}
+
+// ---------- DPDT switch presets ----------
+template <uint8_t N>
+int WinderScheduler<N>::readModeRaw(){
+  int a = io_.read(pins_.modeA), b = io_.read(pins_.modeB);
+  if (a == 0 && b == 1) return 0;
+  if (a == 1 && b == 1) return 1;
+  if (a == 1 && b == 0) return 2;
+  return 1;
+}
+// Every edge pushes the expiry out, so a bouncing contact settles first
+template <uint8_t N>
+void WinderScheduler<N>::switchEdge(){ events_.set(EV_DEBOUNCE, clk_.millis() + debounceMs_); }
+
+// Quiet for debounceMs: read the pins once; a new position is delivered once
+template <uint8_t N>
+void WinderScheduler<N>::switchSettled(uint64_t now){
+  events_.clear(EV_DEBOUNCE);
+  stableMode_ = readModeRaw();
+  if (stableMode_ != applied_) applyPreset((uint8_t)stableMode_, now);
+}
+
+template <uint8_t N>
+void WinderScheduler<N>::applyPreset(uint8_t pos, uint64_t now){
+  applied_ = pos;
+  const SwitchPreset<N>& p = presets_.pos[pos];
+  if (p.manual) return;
+  for (uint8_t m = 0; m < N; m++){
+    int tpd = tpd_[m];
+    tpd_[m] = p.tpd[m]; dirPlan_[m] = p.dir[m];
+    if (tpd_[m] == tpd) continue;
+    reschedule(m, now);
+    arm(m);
+  }
+}
+
+// ---------- Turbo ----------
+// One streaming move per motor instead of a pre-queued span topped up two
+// turns at a time: as many whole rotations as fit the requested time at
+// the current speed and ramp (MotorDriver::moveMs()), rounded to the
+// nearest, so a session ends on a rotation boundary within half a
+// rotation of its deadline. A rotation already in progress is finished
+// first, in its own direction, and counts towards the time. A new request
+// while a session runs replaces its plan from the rotation in progress on;
+// motors it drops finish that rotation.
+template <uint8_t N>
+uint16_t WinderScheduler<N>::turboTurnsFor(uint32_t partial, uint32_t ms){
+  uint32_t spr = (uint32_t)stepsPerRev_;
+  uint32_t one = mot_.moveMs(partial + spr), rev = mot_.moveMs(partial + 2 * spr) - one;
+  if (!rev) rev = 1;
+  uint32_t lim = ms + rev / 2;
+  uint32_t k = lim > one ? 1 + (lim - one) / rev : 1;
+  while (k > 1 && mot_.moveMs(partial + k * spr) > lim) k--;          // ramps not a whole rotation long
+  while (k < 0xFFFF && mot_.moveMs(partial + (k + 1) * spr) <= lim) k++;
+  return (uint16_t)k;
+}
+
+template <uint8_t N>
+void WinderScheduler<N>::startTurbo(MotorMask mask, uint32_t minutes){
+  uint64_t now = clk_.millis();
+  countSteps();
+  uint32_t spr = (uint32_t)stepsPerRev_, longest = 0;
+  for (uint8_t m = 0; m < N; m++){
+    bool in = mask & (1u << m);
+    if (!in && !(turboActive_ && (turboMask_ & (1u << m)))) continue;
+    int32_t left = mot_.distanceToGo(m);
+    int dir = left < 0 ? -1 : +1;
+    uint32_t abs = (uint32_t)(left < 0 ? -left : left), partial = abs % spr;
+    uint16_t k = in ? turboTurnsFor(partial, minutes * 60000UL) : 0;
+    uint32_t target = partial + k * spr;
+    if (target != abs) mot_.move(m, dir * ((int32_t)target - (int32_t)abs));
+    turboTurns_[m] = k;
+    // New to the session: the rotation in progress was counted when it started
+    if (in && !(turboCount_ & (1u << m))){ turboSteps_[m] = -(int32_t)partial; turboCount_ |= (MotorMask)(1u << m); }
+    if (in){ uint32_t ms = mot_.moveMs(target); if (ms > longest) longest = ms; }
+  }
+  turboMask_ = mask; turboActive_ = mask != 0;
+  turboEndMs_ = now + longest;
+  armAll();                                    // no scheduled rotations during turbo
+}
+
+// Over once every planned move has finished (or was stopped)
+template <uint8_t N>
+void WinderScheduler<N>::updateTurbo(){
+  if (!turboActive_) return;
+  for (uint8_t m = 0; m < N; m++) if ((turboMask_ & (1u << m)) && mot_.distanceToGo(m) != 0) return;
+  turboActive_ = false; turboMask_ = 0;
+  armAll();
+}
+
+// Steps made since the last look; for turbo motors, whole rotations of them.
+// A motor leaves the turbo count once it is out of the session and at rest.
+template <uint8_t N>
+void WinderScheduler<N>::countSteps(){
+  for (uint8_t m = 0; m < N; m++){
+    uint32_t s = mot_.stepsMade(m), d = s - stepsSeen_[m];
+    stepsSeen_[m] = s;
+    odo_[m].v[ODO_STEPS] += d;
+    MotorMask bit = (MotorMask)(1u << m);
+    if (!(turboCount_ & bit)) continue;
+    turboSteps_[m] += (int32_t)d;
+    while (turboSteps_[m] >= stepsPerRev_){ turboSteps_[m] -= stepsPerRev_; odo_[m].v[ODO_TURBO]++; }
+    if (!(turboActive_ && (turboMask_ & bit)) && mot_.distanceToGo(m) == 0){ turboCount_ &= (MotorMask)~bit; turboSteps_[m] = 0; }
+  }
+}
+
+template <uint8_t N>
+uint16_t WinderScheduler<N>::turboDone(uint8_t m){
+  if (!turboActive_ || !(turboMask_ & (1u << m))) return turboTurns_[m];
+  int32_t left = mot_.distanceToGo(m);
+  uint32_t abs = (uint32_t)(left < 0 ? -left : left), spr = (uint32_t)stepsPerRev_;
+  uint32_t todo = (abs + spr - 1) / spr;         // the rotation in progress counts as not done
+  return todo >= turboTurns_[m] ? 0 : (uint16_t)(turboTurns_[m] - todo);
+}
+
+template <uint8_t N>
+void WinderScheduler<N>::indicate(bool on){
+  if (pins_.led < 0 || led_ == (int)on) return;
+  io_.write(pins_.led, on ? 1 : 0); led_ = on;
+}
+
+// ---------- Web commands / status ----------
+template <uint8_t N>
+void WinderScheduler<N>::apply(const MotionCmd<N>& c){
+  switch (c.op){
+    case CMD_START: enabled_ = true; armAll(); break;
+    case CMD_STOP:  enabled_ = false; armAll(); break;
+    case CMD_CONFIG: {
+      uint64_t now = clk_.millis();
+      if (programValid(c.program)) program_ = c.program;
+      for (uint8_t m = 0; m < N; m++){ tpd_[m] = c.tpd[m]; dirPlan_[m] = c.dir[m]; reschedule(m, now); }
+      armAll();
+      break;
+    }
+    case CMD_CLOCK: {
+      // Re-plan burst slots on the new day; turns already owed are kept
+      uint64_t now = clk_.millis();
+      todOffsetMs_ = c.todOffsetMs % PROGRAM_DAY_MS; clockSet_ = true;
+      for (uint8_t m = 0; m < N; m++) if (bursty(m)){ planSlot(m, now); if (!burstLeft_[m]) nextDue_[m] = slotDue_[m]; }
+      armAll();
+      break;
+    }
+    case CMD_TURBO: startTurbo(c.mask, (uint32_t)c.minutes); break;
+    case CMD_PRESET: {
+      // An edit to the selected position takes effect now
+      if (c.preset >= SWITCH_POSITIONS) break;
+      SwitchPreset<N>& p = presets_.pos[c.preset];
+      p.manual = c.manual;
+      for (uint8_t m = 0; m < N; m++){ p.tpd[m] = c.tpd[m]; p.dir[m] = c.dir[m]; }
+      if (c.preset == stableMode_) applyPreset(c.preset, clk_.millis());
+      break;
+    }
+  }
+}
+
+template <uint8_t N>
+void WinderScheduler<N>::fillStatus(MotionStatus<N>& st){
+  uint64_t now = clk_.millis();
+  st.stampMs = (uint32_t)now;
+  st.enabled = enabled_; st.switchMode = stableMode_;
+  st.program = program_; st.clockSet = clockSet_;
+  for (uint8_t m = 0; m < N; m++){
+    st.tpd[m] = tpd_[m]; st.dir[m] = dirPlan_[m];
+    int64_t rem = (tpd_[m] > 0 && nextDue_[m] > 0) ? (int64_t)(nextDue_[m] - now) : -1;
+    if (rem < 0 && rem != -1) rem = 0;
+    st.nextMs[m] = (int32_t)rem;
+  }
+  int64_t tleft = turboActive_ ? (int64_t)(turboEndMs_ - now) : 0;
+  if (tleft < 0) tleft = 0;
+  st.turboActive = turboActive_; st.turboMask = turboMask_; st.turboLeftMs = (int32_t)tleft;
+  for (uint8_t m = 0; m < N; m++){
+    st.turboTurns[m] = turboTurns_[m]; st.turboDone[m] = turboDone(m);
+    st.odo[m] = odo_[m]; st.odo[m].v[ODO_TPD] = (uint32_t)(tpd_[m] > 0 ? tpd_[m] : 0);
+  }
+}
+
+template <uint8_t N>
+uint64_t WinderScheduler<N>::nextEventMs(){
+  return moving() ? clk_.millis() : events_.topAt();
+}
+
+// ---------- Scheduler pass ----------
+template <uint8_t N>
+void WinderScheduler<N>::poll(){
+  uint64_t now = clk_.millis();
+  if (events_.at(EV_DEBOUNCE) <= now) switchSettled(now);
+
+  updateTurbo();
+  countSteps();
+
+  if (!enabled_){
+    indicate(false);
+    for (uint8_t m = 0; m < N; m++) if (mot_.distanceToGo(m) != 0) mot_.stop(m);
+    return;
+  }
+  indicate(true);
+
+  // Due rotations, earliest first. One whose motor is still moving stays due
+  // and is retried on the next pass.
+  uint8_t wait[N], nw = 0;
+  while (events_.topAt() <= now){
+    uint8_t m = events_.top();
+    events_.clear(m);
+    if (m >= N) continue;                      // debounce is handled above
+    if (mot_.distanceToGo(m) != 0){ wait[nw++] = m; continue; }
+    int64_t due = (int64_t)nextDue_[m] - behind_[m];
+    late_[m] = nextDue_[m] && due <= (int64_t)now ? (uint32_t)((int64_t)now - due) : 0;
+    if (late_[m] >= LATE_SLOT_MS) odo_[m].v[ODO_LATE]++;
+    if (bursty(m)){ fireBurst(m, now); arm(m); continue; }
+    uint32_t iv = intervalFromTPD(tpd_[m]);
+    rotate(m);
+    int64_t next = due + iv;
+    behind_[m] = 0;
+    if (next <= (int64_t)now){                // missed slots are skipped, not replayed back to back
+      uint64_t k = (uint64_t)((int64_t)now - next) / iv + 1;   // whole intervals missed; the grid stays put
+      odo_[m].v[ODO_MISSED] += (uint32_t)k;
+      next += (int64_t)(k * iv);
+    }
+    nextDue_[m] = (uint64_t)next;
+    arm(m);
+  }
+  for (uint8_t i = 0; i < nw; i++) arm(wait[i]);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+// ===================== Seqlock =====================
+// Single-writer snapshot. The writer never waits; readers retry if they raced
+// a publish. The payload is stored as relaxed atomic words so a torn read is
+// detected by the sequence check instead of being a data race.
+
+template <class T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock payload must be trivially copyable");
+  static const size_t WORDS = (sizeof(T) + 3) / 4;
+public:
+  void publish(const T& v){
+    uint32_t w[WORDS] = {0};
+    memcpy(w, &v, sizeof(T));
+    uint32_t s = seq_.load(std::memory_order_relaxed);
+    seq_.store(s + 1, std::memory_order_relaxed);               // odd: write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; i++) data_[i].store(w[i], std::memory_order_relaxed);
+    seq_.store(s + 2, std::memory_order_release);
+  }
+
+  // Copies the latest snapshot into out. Returns the number of retries taken.
+  uint32_t read(T& out) const {
+    uint32_t w[WORDS];
+    for (uint32_t tries = 0;; tries++){
+      uint32_t s0 = seq_.load(std::memory_order_acquire);
+      if (s0 & 1) continue;
+      for (size_t i = 0; i < WORDS; i++) w[i] = data_[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) == s0){ memcpy(&out, w, sizeof(T)); return tries; }
+    }
+  }
+
+  uint32_t sequence() const { return seq_.load(std::memory_order_acquire); }
+
+private:
+  std::atomic<uint32_t> seq_{0};
+  std::atomic<uint32_t> data_[WORDS] = {};
+};
@@ -0,0 +1,124 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "switch_presets.h"
+#include "wind_program.h"
+
+// ===================== Settings blob =====================
+// Every persisted setting in one versioned, CRC-checked record, written
+// with a single NVS putBytes() instead of one put per key. Layout:
+//   header  magic 'WB', version, motor count, payload size, CRC-32 of payload
+//   payload rpm, profile, program, ssid, pass, then tpd/dir per motor;
+//           v2 adds the applied switch position and the preset table
+//           (manual flag, tpd/dir per motor, for each position)
+// Per-motor fields come last and are sized by the stored motor count, so a
+// blob from a build with a different MOTOR_COUNT still loads (extra motors
+// keep their defaults). A reader of version V accepts older versions and
+// fills fields they lacked from the defaults it was handed.
+
+static const uint16_t SETTINGS_MAGIC   = 0x4257;   // "WB"
+static const uint8_t  SETTINGS_VERSION = 2;
+
+template <uint8_t N>
+struct Settings {
+  int16_t  rpm;
+  uint8_t  profile;                    // RampProfile
+  WindProgram program;
+  char     ssid[33], pass[65];
+  int16_t  tpd[N];
+  int8_t   dir[N];
+  uint8_t  switchPos;                  // position whose preset tpd/dir reflect (SWITCH_UNKNOWN: none)
+  SwitchPresets<N> presets;
+};
+
+struct SettingsHeader {
+  uint16_t magic;
+  uint8_t  version, motors;
+  uint16_t size;                       // payload bytes after the header
+  uint16_t reserved;
+  uint32_t crc;
+};
+
+uint32_t settingsCrc(const uint8_t* p, size_t n);   // CRC-32 (IEEE)
+
+// Payload bytes of a layout version for a given motor count
+constexpr size_t settingsPayloadV1(unsigned motors){ return 2 + 1 + 3 * 2 + 33 + 65 + 3 * motors; }
+constexpr size_t settingsPayload(unsigned motors){ return settingsPayloadV1(motors) + 1 + SWITCH_POSITIONS * (1 + 3 * motors); }
+template <uint8_t N>
+constexpr size_t settingsBlobMax(){ return sizeof(SettingsHeader) + settingsPayload(N); }
+
+template <uint8_t N>
+size_t settingsEncode(const Settings<N>& s, uint8_t* out, size_t cap){
+  if (cap < settingsBlobMax<N>()) return 0;
+  uint8_t* p = out + sizeof(SettingsHeader);
+  auto put = [&](const void* v, size_t n){ memcpy(p, v, n); p += n; };
+  put(&s.rpm, 2); put(&s.profile, 1);
+  put(&s.program.everyMin, 2); put(&s.program.startMin, 2); put(&s.program.endMin, 2);
+  put(s.ssid, 33); put(s.pass, 65);
+  put(s.tpd, 2 * N); put(s.dir, N);
+  put(&s.switchPos, 1);
+  for (const SwitchPreset<N>& q : s.presets.pos){ put(&q.manual, 1); put(q.tpd, 2 * N); put(q.dir, N); }
+  SettingsHeader h{ SETTINGS_MAGIC, SETTINGS_VERSION, N, (uint16_t)(p - out - sizeof(h)), 0, 0 };
+  h.crc = settingsCrc(out + sizeof(h), h.size);
+  memcpy(out, &h, sizeof(h));
+  return (size_t)(p - out);
+}
+
+// false (s untouched) on a short, foreign, corrupt or newer blob
+template <uint8_t N>
+bool settingsDecode(const uint8_t* in, size_t len, Settings<N>& s){
+  SettingsHeader h;
+  if (len < sizeof(h)) return false;
+  memcpy(&h, in, sizeof(h));
+  if (h.magic != SETTINGS_MAGIC || h.version == 0 || h.version > SETTINGS_VERSION) return false;
+  if (sizeof(h) + h.size > len || h.motors == 0 || h.motors > 16) return false;
+  if (settingsCrc(in + sizeof(h), h.size) != h.crc) return false;
+  const uint8_t* p = in + sizeof(h);
+  if (h.size != (h.version == 1 ? settingsPayloadV1(h.motors) : settingsPayload(h.motors))) return false;
+  Settings<N> t = s;
+  auto get = [&](void* v, size_t n){ memcpy(v, p, n); p += n; };
+  get(&t.rpm, 2); get(&t.profile, 1);
+  get(&t.program.everyMin, 2); get(&t.program.startMin, 2); get(&t.program.endMin, 2);
+  get(t.ssid, 33); get(t.pass, 65);
+  t.ssid[32] = 0; t.pass[64] = 0;
+  const uint8_t* tp = p;
+  const uint8_t* dp = p + 2 * h.motors;
+  for (uint8_t m = 0; m < N && m < h.motors; m++){ memcpy(&t.tpd[m], tp + 2 * m, 2); t.dir[m] = (int8_t)dp[m]; }
+  p += 3 * h.motors;
+  if (h.version >= 2){
+    get(&t.switchPos, 1);
+    for (SwitchPreset<N>& q : t.presets.pos){
+      get(&q.manual, 1);
+      for (uint8_t m = 0; m < N && m < h.motors; m++){ memcpy(&q.tpd[m], p + 2 * m, 2); q.dir[m] = (int8_t)p[2 * h.motors + m]; }
+      p += 3 * h.motors;
+      if (!switchPresetValid(q)) q = s.presets.pos[&q - t.presets.pos];   // keep the default
+    }
+    if (t.switchPos >= SWITCH_POSITIONS) t.switchPos = SWITCH_UNKNOWN;
+  }
+  s = t;
+  return true;
+}
+
+// ===================== Write-behind =====================
+// Debounces saves: a flush is due once changes have been quiet for
+// quietMs, or maxMs after the first unsaved change if they keep coming.
+class WriteBehind {
+public:
+  WriteBehind(uint32_t quietMs, uint32_t maxMs) : quietMs_(quietMs), maxMs_(maxMs) {}
+  void touch(uint32_t now){
+    if (!dirty_){ dirty_ = true; firstAt_ = now; }
+    lastAt_ = now; changes_++;
+  }
+  bool dirty() const { return dirty_; }
+  bool due(uint32_t now) const {
+    return dirty_ && (now - lastAt_ >= quietMs_ || now - firstAt_ >= maxMs_);
+  }
+  // Changes folded into the flush that just happened
+  uint32_t flushed(){ uint32_t n = changes_; dirty_ = false; changes_ = 0; return n; }
+
+private:
+  uint32_t quietMs_, maxMs_;
+  bool dirty_ = false;
+  uint32_t firstAt_ = 0, lastAt_ = 0, changes_ = 0;
+};
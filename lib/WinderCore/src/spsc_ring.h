@@ -0,0 +1,40 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// ===================== SPSC ring =====================
+// Bounded single-producer/single-consumer queue. One task pushes, one task
+// pops; neither side ever blocks or allocates. N must be a power of two.
+
+template <class T, size_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+public:
+  // Producer side. Returns false when full (caller decides whether to retry).
+  bool push(const T& v){
+    uint32_t h = head_.load(std::memory_order_relaxed);
+    if (h - tail_.load(std::memory_order_acquire) == N) return false;
+    buf_[h & (N - 1)] = v;
+    head_.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false when empty.
+  bool pop(T& out){
+    uint32_t t = tail_.load(std::memory_order_relaxed);
+    if (t == head_.load(std::memory_order_acquire)) return false;
+    out = buf_[t & (N - 1)];
+    tail_.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const { return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire); }
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity(){ return N; }
+
+private:
+  T buf_[N] = {};
+  alignas(4) std::atomic<uint32_t> head_{0};   // written by producer only
+  alignas(4) std::atomic<uint32_t> tail_{0};   // written by consumer only
+};
@@ -0,0 +1,22 @@
+#include "status_json.h"
+
+uint32_t statusHash(const char* s){
+  uint32_t h = 2166136261u;
+  while (s && *s){ h ^= (uint8_t)*s++; h *= 16777619u; }
+  return h;
+}
+
+uint32_t statusDueAt(int32_t relMs, uint32_t nowMs){ return relMs < 0 ? 0 : nowMs + (uint32_t)relMs; }
+
+// Due time to compare against what was sent. An overdue countdown is clamped
+// to 0 ms every tick; if the client already counted past it, nothing moved.
+uint32_t statusDueFor(int32_t relMs, uint32_t sentAt, uint32_t nowMs){
+  if (relMs == 0 && sentAt && (int32_t)(nowMs - sentAt) >= 0) return sentAt;
+  return statusDueAt(relMs, nowMs);
+}
+
+bool statusMoved(uint32_t a, uint32_t b){
+  if ((a == 0) != (b == 0)) return true;
+  int32_t d = (int32_t)(a - b);
+  return d > (int32_t)STATUS_RESYNC_MS || d < -(int32_t)STATUS_RESYNC_MS;
+}
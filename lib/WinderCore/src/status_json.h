@@ -0,0 +1,165 @@
+#pragma once
+#include <stdint.h>
+#include "json_out.h"
+#include "motion_link.h"
+
+// ===================== Status JSON =====================
+// One encoder for GET /status (full document) and the /events stream
+// (only the fields a subscriber hasn't seen). Countdowns are sent as
+// "ms from now" only when the underlying due time moves, so browsers
+// count down locally between events. Per-motor keys are flat and 1-based:
+// tpd1, dir1, next1_ms, turbo_m1, turbo_turns1, turbo_done1, ...
+
+static const uint32_t STATUS_RESYNC_MS = 1000;   // countdown drift before a re-send
+static const size_t   STATUS_NET_MAX   = 96;     // network line buffer, incl. NUL
+
+struct StatusExtra {
+  const char* network;                 // at most STATUS_NET_MAX - 1 bytes
+  uint32_t bootMotionMs, bootStepMs, bootHttpMs;
+  uint32_t heapFree, heapMinFree, heapMaxBlock;
+  const char* bootKind;                // "cold", "checkpoint" or "warm" (at most 10 chars)
+  uint32_t bootResumeUs;               // restoring state at boot
+};
+
+// What one subscriber was last sent
+template <uint8_t N>
+struct StatusSent {
+  bool valid;
+  MotionStatus<N> st;
+  uint32_t dueAt[N];                   // absolute ms, 0 = no schedule
+  uint32_t turboEndAt;
+  uint32_t netHash;
+};
+
+// Largest document statusJsonFull() can produce, incl. NUL
+constexpr size_t statusMotorsMax(unsigned m){
+  return m == 0 ? 0 : statusMotorsMax(m - 1)
+    + 2 * jsonFieldMax(3 + jsonDigits(m), JSON_I32_MAX)      // tpdN, dirN
+    + jsonFieldMax(4 + jsonDigits(m) + 3, JSON_I32_MAX)      // nextN_ms
+    + jsonFieldMax(7 + jsonDigits(m), JSON_BOOL_MAX)         // turbo_mN
+    + jsonFieldMax(11 + jsonDigits(m), JSON_U32_MAX)         // turbo_turnsN
+    + jsonFieldMax(10 + jsonDigits(m), JSON_U32_MAX);        // turbo_doneN
+}
+template <uint8_t N>
+constexpr size_t statusJsonMax(){
+  return 2 + 1
+    + jsonFieldMax("network", jsonQuotedMax(STATUS_NET_MAX - 1))
+    + jsonFieldMax("motors", JSON_U32_MAX)
+    + jsonFieldMax("enabled", JSON_BOOL_MAX) + jsonFieldMax("switch_mode", JSON_I32_MAX)
+    + jsonFieldMax("profile", jsonQuotedMax(9))
+    + jsonFieldMax("every_min", JSON_U32_MAX) + jsonFieldMax("window_start_min", JSON_U32_MAX)
+    + jsonFieldMax("window_end_min", JSON_U32_MAX) + jsonFieldMax("clock_set", JSON_BOOL_MAX)
+    + statusMotorsMax(N)
+    + jsonFieldMax("turbo_active", JSON_BOOL_MAX) + jsonFieldMax("turbo_left_ms", JSON_I32_MAX)
+    + jsonFieldMax("boot_motion_ms", JSON_U32_MAX) + jsonFieldMax("boot_step_ms", JSON_U32_MAX)
+    + jsonFieldMax("boot_http_ms", JSON_U32_MAX)
+    + jsonFieldMax("boot", jsonQuotedMax(10)) + jsonFieldMax("boot_resume_us", JSON_U32_MAX)
+    + jsonFieldMax("heap_free", JSON_U32_MAX) + jsonFieldMax("heap_min_free", JSON_U32_MAX)
+    + jsonFieldMax("heap_max_block", JSON_U32_MAX)
+    + jsonFieldMax("idle_permille", JSON_U32_MAX) + jsonFieldMax("wakeups_per_s", JSON_U32_MAX)
+    + jsonFieldMax("cpu_ma", JSON_U32_MAX) + jsonFieldMax("light_sleep", JSON_BOOL_MAX);
+}
+
+// Shared helpers (status_json.cpp)
+uint32_t statusHash(const char* s);
+uint32_t statusDueAt(int32_t relMs, uint32_t nowMs);                    // 0 = none
+uint32_t statusDueFor(int32_t relMs, uint32_t sentAt, uint32_t nowMs);  // overdue stays put
+bool     statusMoved(uint32_t a, uint32_t b);
+
+template <uint8_t N>
+void statusJsonFull(JsonOut& j, const MotionStatus<N>& st, const StatusExtra& x){
+  j.begin();
+  j.str("network", x.network);
+  j.unum("motors", N);
+  j.boolean("enabled", st.enabled);
+  j.num("switch_mode", st.switchMode);
+  j.str("profile", rampProfileName(st.profile));
+  j.unum("every_min", st.program.everyMin);
+  j.unum("window_start_min", st.program.startMin);
+  j.unum("window_end_min", st.program.endMin);
+  j.boolean("clock_set", st.clockSet);
+  for (uint8_t m = 0; m < N; m++){
+    j.numN("tpd", m + 1, nullptr, st.tpd[m]);
+    j.numN("dir", m + 1, nullptr, st.dir[m]);
+  }
+  for (uint8_t m = 0; m < N; m++) j.numN("next", m + 1, "_ms", st.nextMs[m]);
+  j.boolean("turbo_active", st.turboActive);
+  for (uint8_t m = 0; m < N; m++) j.keyN("turbo_m", m + 1, nullptr).raw(st.turboMask & (1u << m) ? "true" : "false");
+  j.num("turbo_left_ms", st.turboLeftMs);
+  for (uint8_t m = 0; m < N; m++){
+    j.numN("turbo_turns", m + 1, nullptr, st.turboTurns[m]);
+    j.numN("turbo_done", m + 1, nullptr, st.turboDone[m]);
+  }
+  j.unum("boot_motion_ms", x.bootMotionMs);
+  j.unum("boot_step_ms", x.bootStepMs);
+  j.unum("boot_http_ms", x.bootHttpMs);
+  j.str("boot", x.bootKind);
+  j.unum("boot_resume_us", x.bootResumeUs);
+  j.unum("heap_free", x.heapFree);
+  j.unum("heap_min_free", x.heapMinFree);
+  j.unum("heap_max_block", x.heapMaxBlock);
+  j.unum("idle_permille", st.idlePermille);
+  j.unum("wakeups_per_s", st.wakeupsPerSec);
+  j.unum("cpu_ma", st.currentMa);
+  j.boolean("light_sleep", st.lightSleep);
+  j.end();
+}
+
+// Full document that also primes `sent` (first event on a new stream)
+template <uint8_t N>
+void statusJsonFull(JsonOut& j, const MotionStatus<N>& st, const StatusExtra& x, StatusSent<N>& sent, uint32_t nowMs){
+  statusJsonFull(j, st, x);
+  sent.valid = true; sent.st = st; sent.netHash = statusHash(x.network);
+  for (uint8_t m = 0; m < N; m++) sent.dueAt[m] = statusDueAt(st.nextMs[m], nowMs);
+  sent.turboEndAt = st.turboActive ? nowMs + (uint32_t)st.turboLeftMs : 0;
+}
+
+// Changed fields only. Returns false when the subscriber is already up to date.
+template <uint8_t N>
+bool statusJsonDiff(JsonOut& j, StatusSent<N>& sent, const MotionStatus<N>& st, const char* network, uint32_t nowMs){
+  const MotionStatus<N>& p = sent.st;
+  bool all = !sent.valid;
+  uint32_t due[N];
+  j.begin();
+  uint32_t nh = statusHash(network);
+  if (all || nh != sent.netHash) j.str("network", network);
+  if (all || st.enabled != p.enabled) j.boolean("enabled", st.enabled);
+  if (all || st.switchMode != p.switchMode) j.num("switch_mode", st.switchMode);
+  if (all || st.profile != p.profile) j.str("profile", rampProfileName(st.profile));
+  if (all || !programSame(st.program, p.program)){
+    j.unum("every_min", st.program.everyMin);
+    j.unum("window_start_min", st.program.startMin);
+    j.unum("window_end_min", st.program.endMin);
+  }
+  if (all || st.clockSet != p.clockSet) j.boolean("clock_set", st.clockSet);
+  for (uint8_t m = 0; m < N; m++){
+    if (all || st.tpd[m] != p.tpd[m]) j.numN("tpd", m + 1, nullptr, st.tpd[m]);
+    if (all || st.dir[m] != p.dir[m]) j.numN("dir", m + 1, nullptr, st.dir[m]);
+    // Countdown bases only move when re-sent, so local clocks stay in step
+    uint32_t a = statusDueFor(st.nextMs[m], sent.dueAt[m], nowMs);
+    bool mv = all || statusMoved(a, sent.dueAt[m]);
+    if (mv) j.numN("next", m + 1, "_ms", st.nextMs[m]);
+    due[m] = mv ? a : sent.dueAt[m];
+  }
+  if (all || st.turboActive != p.turboActive) j.boolean("turbo_active", st.turboActive);
+  if (all || st.turboMask != p.turboMask)
+    for (uint8_t m = 0; m < N; m++) j.keyN("turbo_m", m + 1, nullptr).raw(st.turboMask & (1u << m) ? "true" : "false");
+  uint32_t endAt = st.turboActive ? statusDueFor(st.turboLeftMs, sent.turboEndAt, nowMs) : 0;
+  bool turboMv = all || statusMoved(endAt, sent.turboEndAt);
+  if (turboMv) j.num("turbo_left_ms", st.turboLeftMs);
+  for (uint8_t m = 0; m < N; m++){
+    if (all || st.turboTurns[m] != p.turboTurns[m]) j.numN("turbo_turns", m + 1, nullptr, st.turboTurns[m]);
+    if (all || st.turboDone[m] != p.turboDone[m]) j.numN("turbo_done", m + 1, nullptr, st.turboDone[m]);
+  }
+  if (all || st.idlePermille != p.idlePermille) j.unum("idle_permille", st.idlePermille);
+  if (all || st.wakeupsPerSec != p.wakeupsPerSec) j.unum("wakeups_per_s", st.wakeupsPerSec);
+  if (all || st.currentMa != p.currentMa) j.unum("cpu_ma", st.currentMa);
+  if (all || st.lightSleep != p.lightSleep) j.boolean("light_sleep", st.lightSleep);
+  j.end();
+  if (j.empty()) return false;
+
+  sent.valid = true; sent.st = st; sent.netHash = nh;
+  for (uint8_t m = 0; m < N; m++) sent.dueAt[m] = due[m];
+  if (turboMv) sent.turboEndAt = endAt;
+  return true;
+}
@@ -0,0 +1,236 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "power_budget.h"
+#include "ramp_profile.h"
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+// ===================== Step engine =====================
+// Timer-driven half-step generator for 28BYJ-48 / ULN2003 motors.
+// tick() runs from a periodic timer ISR every STEP_TICK_US and emits coil
+// patterns at the planned interval; the task side only queues moves.
+// No Arduino dependencies, so the host simulator drives the same code.
+
+static const uint32_t STEP_TICK_US   = 25;                       // ISR period
+static const uint32_t STEP_TICK_HZ   = 1000000UL / STEP_TICK_US;
+static const uint8_t  WINDER_MAX_MOTORS = 16;
+
+typedef uint16_t MotorMask;   // bit m = motor m
+
+// Called at most once per tick with every motor that stepped: bit m of
+// `changed` set -> coils[m] is motor m's new pattern (bit0..bit3 = IN1..IN4).
+typedef void (*CoilWriter)(MotorMask changed, const uint8_t* coils);
+
+// Half-step sequence on IN1..IN4 (same order AccelStepper HALF4WIRE produced)
+constexpr uint8_t HALFSTEP_SEQ[8] = { 0x1, 0x3, 0x2, 0x6, 0x4, 0xC, 0x8, 0x9 };
+
+template <uint8_t N>
+class StepEngine {
+  static_assert(N >= 1 && N <= WINDER_MAX_MOTORS, "1..16 motors");
+public:
+  explicit StepEngine(CoilWriter out) : out_(out) { setSpeed(1000, 200, 400); }
+
+  // Cruise speed and acceleration ramp (steps/s). Safe to call while running;
+  // builds the interval table on the calling task when it isn't cached.
+  void setSpeed(uint32_t maxSps, uint32_t startSps, uint32_t rampSteps, RampProfile p = RAMP_TRAPEZOID){
+    setRamp(cache_.get(p, STEP_TICK_HZ, maxSps, startSps, rampSteps));
+  }
+  // Prebuilt table (e.g. constexpr); must outlive its use. Picked up next tick.
+  void setRamp(const RampTable& t){ replan(t); ramp_.store(&t, std::memory_order_release); }
+  const RampTable& ramp() const { return *ramp_.load(std::memory_order_relaxed); }
+  uint32_t rampBuilds() const { return cache_.builds(); }
+  // De-energize a motor's coils one step interval after its move ends (the
+  // 64:1 gearbox holds the drum). Off by default: coils hold like AccelStepper.
+  void setRelease(bool on){ release_ = on; }
+  // Coil-current cap (power_budget.h), 0 = off. A move from rest is held
+  // while it would ramp alongside another motor and the estimated draw would
+  // exceed capMa; it starts once the other is cruising (or done) and clear
+  // of its deceleration. A motor is never held when nothing else moves.
+  void setPowerBudget(uint16_t capMa, uint16_t coilMa, uint16_t tauUs){
+    capMa_ = capMa; coilMa_ = coilMa; tauUs_ = tauUs;
+    replan(ramp());
+  }
+  // Starts the budget has held back since boot
+  uint32_t powerHolds() const { return holds_.load(std::memory_order_relaxed); }
+
+  // Task side (lock-free, callable from any task)
+  void move(uint8_t m, int32_t steps){ ax_[m].pending.fetch_add(steps, std::memory_order_relaxed); }
+  void stop(uint8_t m){ ax_[m].stopReq.store(true, std::memory_order_relaxed); }
+  int32_t distanceToGo(uint8_t m) const {
+    return ax_[m].remaining.load(std::memory_order_relaxed) + ax_[m].pending.load(std::memory_order_relaxed);
+  }
+  bool isRunning(uint8_t m) const { return distanceToGo(m) != 0; }
+  // Nothing moving and no coil release pending: the timer may stop
+  bool settled() const {
+    if (releasing_.load(std::memory_order_relaxed)) return false;
+    for (uint8_t m = 0; m < N; m++) if (isRunning(m)) return false;
+    return true;
+  }
+  int32_t position(uint8_t m) const { return ax_[m].position.load(std::memory_order_relaxed); }
+  uint32_t stepCount(uint8_t m) const { return ax_[m].steps.load(std::memory_order_relaxed); }
+  // First to last step of a `steps` move from rest at the current ramp, us:
+  // step k follows step k-1 by q[min(k, steps - k, ramp length)]
+  uint64_t moveUs(uint32_t steps) const {
+    const RampTable& r = ramp();
+    uint32_t S = r.steps;
+    uint64_t q = 0;
+    if (steps < 2) return 0;
+    if (S && steps >= 2 * S){
+      for (uint32_t k = 1; k < S; k++) q += 2ULL * r.q[k];
+      q += (uint64_t)(steps - 2 * S + 1) * r.q[S];
+    } else {
+      for (uint32_t k = 1; k < steps; k++){ uint32_t i = k < steps - k ? k : steps - k; q += r.q[i < S ? i : S]; }
+    }
+    return (q * STEP_TICK_US) >> 16;
+  }
+  // Interval the ISR is currently stepping at, in 1/65536 ticks
+  uint32_t IRAM_ATTR intervalQ(uint8_t m) const { return ax_[m].intervalQ; }
+  uint8_t coils(uint8_t m) const { return coils_[m]; }
+  // Half-step phase (0..7); setPhase() only before the timer runs (warm resume)
+  uint8_t phase(uint8_t m) const { return ax_[m].phase; }
+  void setPhase(uint8_t m, uint8_t p){ ax_[m].phase = (uint8_t)(p & 7); }
+
+  // ISR side
+  void IRAM_ATTR tick();
+
+private:
+  struct Axis {
+    std::atomic<int32_t>  pending{0};    // queued by task, folded in by ISR
+    std::atomic<bool>     stopReq{false};
+    std::atomic<int32_t>  remaining{0};  // owned by ISR
+    std::atomic<int32_t>  position{0};
+    std::atomic<uint32_t> steps{0};
+    uint32_t accQ = 0;                   // Q16 tick accumulator
+    uint32_t intervalQ = 0;              // Q16 ticks per step
+    uint32_t ramp = 0;                   // steps taken into the accel ramp
+    uint16_t holdTicks = 0;              // until the coils are released
+    uint8_t  phase = 0;
+    bool     held = false;               // start waiting on the power budget
+  };
+
+  // Two plan slots, rebuilt on the task like RampCache's tables
+  void replan(const RampTable& t){
+    if (!capMa_){ plan_.store(nullptr, std::memory_order_release); return; }
+    PowerPlan& p = plans_[planNext_]; planNext_ ^= 1;
+    p = powerPlan(t, STEP_TICK_US, capMa_, coilMa_, tauUs_);
+    plan_.store(&p, std::memory_order_release);
+  }
+  bool IRAM_ATTR admit(uint8_t c, int32_t steps, const RampTable* r, const PowerPlan& p) const;
+
+  // ISR is the only writer, so a plain load/store (no atomic RMW in the ISR)
+  void IRAM_ATTR releaseMark(uint8_t m, bool on){
+    MotorMask v = releasing_.load(std::memory_order_relaxed);
+    releasing_.store(on ? (MotorMask)(v | (1u << m)) : (MotorMask)(v & ~(1u << m)), std::memory_order_relaxed);
+  }
+  // Table lookup: past the ramp every index reads the cruise interval
+  static uint32_t IRAM_ATTR intervalForRamp(const RampTable* r, uint32_t idx){ return r->q[idx < r->steps ? idx : r->steps]; }
+
+  CoilWriter out_;
+  Axis ax_[N];
+  uint8_t coils_[N] = {};
+  std::atomic<const RampTable*> ramp_{nullptr};
+  std::atomic<MotorMask> releasing_{0};
+  bool release_ = false;
+  RampCache cache_;
+  uint16_t capMa_ = 0, coilMa_ = 0, tauUs_ = 0;
+  PowerPlan plans_[2];
+  uint8_t planNext_ = 0;
+  std::atomic<const PowerPlan*> plan_{nullptr};
+  std::atomic<uint32_t> holds_{0};
+};
+
+// Would starting motor c on a `steps` move now keep the estimated draw
+// under the cap? Times are in cruise steps from now: c ramps up over
+// [0, span) and down over [cs, ce); a motor already cruising decelerates
+// over [ds, ds + span) once it is `steps` from its end. A motor that
+// ramps in either window counts at rampMa, one cruising at cruiseMa, one
+// at rest at its holding current.
+template <uint8_t N>
+bool IRAM_ATTR StepEngine<N>::admit(uint8_t c, int32_t steps, const RampTable* r, const PowerPlan& p) const {
+  uint32_t S = r->steps, W = p.rampSpan, n = (uint32_t)(steps > 0 ? steps : -steps);
+  uint32_t cs = n >= 2 * S ? W + n - 2 * S : 0, ce = n >= 2 * S ? cs + W : 2 * W;
+  uint32_t ma = p.rampMa;
+  bool others = false;
+  for (uint8_t o = 0; o < N; o++){
+    if (o == c) continue;
+    int32_t rem = ax_[o].remaining.load(std::memory_order_relaxed);
+    if (!rem){ ma += powerCoilsOn(coils_[o]) * p.coilMa; continue; }
+    others = true;
+    uint32_t left = (uint32_t)(rem > 0 ? rem : -rem);
+    bool ramps = ax_[o].ramp < S || left <= S;
+    if (!ramps){ uint32_t ds = left - S; ramps = ds < W || (cs < ds + W && ds < ce); }
+    ma += ramps ? p.rampMa : p.cruiseMa;
+  }
+  return !others || ma <= p.capMa;
+}
+
+template <uint8_t N>
+void IRAM_ATTR StepEngine<N>::tick(){
+  MotorMask changed = 0;
+  const RampTable* r = ramp_.load(std::memory_order_acquire);
+  const PowerPlan* p = plan_.load(std::memory_order_acquire);
+  for (uint8_t m = 0; m < N; m++){
+    Axis& a = ax_[m];
+    int32_t rem = a.remaining.load(std::memory_order_relaxed);
+
+    int32_t add = a.pending.load(std::memory_order_relaxed);
+    if (add && rem == 0 && p && !admit(m, add, r, *p)){
+      // Held: stays pending, so the motor reads busy; a stop cancels it
+      if (a.stopReq.load(std::memory_order_relaxed)){ a.pending.fetch_sub(add, std::memory_order_relaxed); a.held = false; }
+      else if (!a.held){ a.held = true; holds_.store(holds_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+      add = 0;
+    }
+    if (add){
+      a.held = false;
+      // Publish the new total before draining pending so distanceToGo() never reads 0 mid-fold
+      if (rem == 0 || (rem > 0) != (rem + add > 0)) a.ramp = 0;   // from rest or reversing
+      rem += add;
+      a.remaining.store(rem, std::memory_order_relaxed);
+      a.pending.fetch_sub(add, std::memory_order_relaxed);
+    }
+    if (a.stopReq.load(std::memory_order_relaxed)){
+      a.stopReq.store(false, std::memory_order_relaxed);
+      // Decelerate over the steps already ramped, like AccelStepper::stop()
+      int32_t lim = (int32_t)a.ramp;
+      if (rem > lim) rem = lim; else if (rem < -lim) rem = -lim;
+    }
+    if (rem == 0){
+      a.remaining.store(0, std::memory_order_relaxed); a.ramp = 0; a.intervalQ = 0;
+      if (a.holdTicks && --a.holdTicks == 0){
+        coils_[m] = 0; changed |= (MotorMask)(1u << m);
+        releaseMark(m, false);
+      }
+      continue;
+    }
+    if (a.holdTicks){ a.holdTicks = 0; releaseMark(m, false); }   // moving again before the release
+
+    if (a.intervalQ == 0){ a.intervalQ = intervalForRamp(r, 0); a.accQ = a.intervalQ; }
+    a.accQ += 1u << 16;
+    if (a.accQ < a.intervalQ){ a.remaining.store(rem, std::memory_order_relaxed); continue; }
+    a.accQ -= a.intervalQ;
+
+    int32_t dir = (rem > 0) ? 1 : -1;
+    a.phase = (uint8_t)((a.phase + dir) & 7);
+    coils_[m] = HALFSTEP_SEQ[a.phase];
+    changed |= (MotorMask)(1u << m);
+    rem -= dir;
+    a.position.store(a.position.load(std::memory_order_relaxed) + dir, std::memory_order_relaxed);
+    a.steps.store(a.steps.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    a.remaining.store(rem, std::memory_order_relaxed);
+
+    if (rem == 0){
+      if (release_){
+        a.holdTicks = (uint16_t)((a.intervalQ >> 16) + 1);   // let the last step land
+        releaseMark(m, true);
+      }
+      a.ramp = 0; a.intervalQ = 0; a.accQ = 0; continue;
+    }
+    if (a.ramp < r->steps) a.ramp++;
+    uint32_t left = (uint32_t)(rem > 0 ? rem : -rem);
+    a.intervalQ = intervalForRamp(r, a.ramp < left ? a.ramp : left);
+  }
+  if (changed) out_(changed, coils_);   // one batched write for every motor that stepped
+}
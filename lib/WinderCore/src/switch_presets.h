@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+
+// ===================== Switch presets =====================
+// What each position of the 3-way selector does when the switch is moved
+// to it: set every motor's TPD and direction plan, or (manual) leave the
+// settings alone for the web UI. A preset is applied once per debounced
+// change, so a /config save made while the switch sits on a preset
+// position holds until the switch moves again.
+
+static const uint8_t SWITCH_POSITIONS = 3;
+static const uint8_t SWITCH_UNKNOWN = 0xFF;   // no position applied yet
+
+template <uint8_t N>
+struct SwitchPreset {
+  uint8_t manual;                  // 1: keep the current settings
+  int16_t tpd[N];                  // 0..1200
+  int8_t  dir[N];                  // +1 CW, -1 CCW, 0 alternate
+};
+
+template <uint8_t N>
+struct SwitchPresets {
+  SwitchPreset<N> pos[SWITCH_POSITIONS];
+};
+
+// The fixed behaviour before the table: 0 = 500 TPD alternating,
+// 1 = manual, 2 = 800 TPD with positions alternating CW/CCW
+template <uint8_t N>
+SwitchPresets<N> switchPresetsDefault(){
+  SwitchPresets<N> t{};
+  t.pos[1].manual = 1;
+  for (uint8_t m = 0; m < N; m++){
+    t.pos[0].tpd[m] = 500; t.pos[0].dir[m] = 0;
+    t.pos[1].tpd[m] = 0;   t.pos[1].dir[m] = 0;
+    t.pos[2].tpd[m] = 800; t.pos[2].dir[m] = (m & 1) ? -1 : +1;
+  }
+  return t;
+}
+
+template <uint8_t N>
+bool switchPresetValid(const SwitchPreset<N>& p){
+  if (p.manual > 1) return false;
+  for (uint8_t m = 0; m < N; m++) if (p.tpd[m] < 0 || p.tpd[m] > 1200 || p.dir[m] < -1 || p.dir[m] > 1) return false;
+  return true;
+}
@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include "trace_ring.h"
+
+// Same wording as tools/trace_decode.py
+size_t traceFormat(const TraceRec& r, char* out, size_t n){
+  static const char* const BOOT[] = { "cold", "checkpoint", "warm" };
+  int k = snprintf(out, n, "%5lu.%03lu ", (unsigned long)(r.ms / 1000), (unsigned long)(r.ms % 1000));
+  if (k < 0 || (size_t)k >= n) return n ? n - 1 : 0;
+  char* p = out + k;
+  size_t left = n - (size_t)k;
+  unsigned a = r.a;
+  unsigned long b = r.b;
+  switch (r.id){
+    case TR_BOOT:       k = snprintf(p, left, "boot %s, restored in %lu us", a < 3 ? BOOT[a] : "?", b); break;
+    case TR_ROTATE:     k = snprintf(p, left, "rotate m%u %s, %lu ms late", (a & 0x7F) + 1, (a & 0x80) ? "CCW" : "CW", b); break;
+    case TR_TURBO_ON:   k = snprintf(p, left, "turbo on, mask 0x%02x", a); break;
+    case TR_TURBO_OFF:  k = snprintf(p, left, "turbo off"); break;
+    case TR_MODE:       k = snprintf(p, left, "switch position %u", a); break;
+    case TR_CMD:        k = snprintf(p, left, "command %u", a); break;
+    case TR_WIFI_EVENT: k = snprintf(p, left, "wifi event %u (reason %lu)", a, b); break;
+    case TR_AP_UP:      k = snprintf(p, left, "AP: up on ch %u", a); break;
+    case TR_AP_FAIL:    k = snprintf(p, left, "AP: softAP ch %u failed, retrying", a); break;
+    case TR_AP_DOWN:    k = snprintf(p, left, "AP: stopped (STA up)"); break;
+    case TR_STA_JOIN:   k = snprintf(p, left, "STA: joining, attempt %u", a); break;
+    case TR_STA_ASSOC:  k = snprintf(p, left, "STA: associated"); break;
+    case TR_STA_IP:     k = snprintf(p, left, "STA: IP %lu.%lu.%lu.%lu, attempt %u", b & 255, (b >> 8) & 255, (b >> 16) & 255, b >> 24, a); break;
+    case TR_STA_LOST:   k = snprintf(p, left, "STA: disconnected (reason %u)", a); break;
+    case TR_STA_FAIL:   k = snprintf(p, left, "STA: join failed (reason %u), AP stays up", a); break;
+    case TR_MDNS:       k = snprintf(p, left, "mDNS: http://winder-%06lx.local", b & 0xFFFFFF); break;
+    case TR_HTTP:       k = snprintf(p, left, "http route %u, %lu us", a, b); break;
+    case TR_PREFS:      k = snprintf(p, left, "prefs: saved, %u change(s), %lu us", a, b); break;
+    default:            k = snprintf(p, left, "event %u a=%u b=%lu", (unsigned)r.id, a, b); break;
+  }
+  if (k < 0) return (size_t)(p - out);
+  return (size_t)(p - out) + ((size_t)k < left ? (size_t)k : left - 1);
+}
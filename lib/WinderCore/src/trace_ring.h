@@ -0,0 +1,121 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+// ===================== Trace ring =====================
+// Fixed 16-byte binary records (time, event id, two arguments) in a RAM
+// ring, instead of Serial.printf lines that stall the caller once the
+// UART FIFO is full. add() is lock-free and wait-free from any task on
+// either core or from an ISR: it claims a slot with one atomic add and
+// stamps the slot's sequence word last. The oldest records are
+// overwritten; a reader checks the stamp before and after copying, so a
+// slot that was being rewritten is skipped instead of read torn.
+// tools/trace_decode.py turns a /trace download into a timeline; the
+// event ids below are mirrored there.
+
+enum TraceEvent : uint8_t {
+  TR_BOOT = 1,        // a: 0 cold, 1 checkpoint, 2 warm     b: state restore us
+  TR_ROTATE,          // a: motor | 0x80 if CCW              b: ms late against its due time
+  TR_TURBO_ON,        // a: motor mask
+  TR_TURBO_OFF,
+  TR_MODE,            // a: switch position 0..2
+  TR_CMD,             // a: MotionOp received by the motion task
+  TR_WIFI_EVENT,      // a: arduino_event_id_t                b: disconnect reason
+  TR_AP_UP,           // a: channel
+  TR_AP_FAIL,         // a: channel
+  TR_AP_DOWN,
+  TR_STA_JOIN,        // a: attempt
+  TR_STA_ASSOC,
+  TR_STA_IP,          // a: attempt                           b: IPv4, first octet in the low byte
+  TR_STA_LOST,        // a: reason
+  TR_STA_FAIL,        // a: reason
+  TR_MDNS,
+  TR_HTTP,            // a: route (main.cpp Route)            b: handler us
+  TR_PREFS,           // a: changes folded in (max 255)       b: flash write us
+  TR_EVENT_COUNT
+};
+
+struct TraceRec {
+  uint32_t seq;       // write index + 1
+  uint32_t ms;        // clock ms (wraps after 49 days)
+  uint16_t us;        // us within that ms
+  uint8_t  id;        // TraceEvent
+  uint8_t  a;
+  uint32_t b;
+};
+static_assert(sizeof(TraceRec) == 16, "trace records are 16 bytes on the wire");
+
+// /trace body: this header, then records oldest first to the end of the body
+struct TraceDumpHeader {
+  char     magic[4];  // "WTR1"
+  uint8_t  version, recSize;
+  uint16_t capacity;  // ring size in records
+  uint32_t head;      // records written since boot, at the download
+  uint32_t nowMs;     // clock at the download
+};
+static_assert(sizeof(TraceDumpHeader) == 16, "trace header is 16 bytes on the wire");
+
+template <uint16_t CAP>
+class TraceRing {
+  static_assert(CAP && (CAP & (CAP - 1)) == 0, "trace capacity must be a power of two");
+public:
+  void IRAM_ATTR add(uint8_t id, uint8_t a, uint32_t b, uint64_t nowUs){
+    uint32_t i = head_.fetch_add(1, std::memory_order_relaxed);
+    Slot& s = slot_[i & (CAP - 1)];
+    s.w[0].store(0, std::memory_order_relaxed);                  // being written
+    std::atomic_thread_fence(std::memory_order_release);
+    s.w[1].store((uint32_t)(nowUs / 1000), std::memory_order_relaxed);
+    s.w[2].store((uint32_t)(nowUs % 1000) | (uint32_t)id << 16 | (uint32_t)a << 24, std::memory_order_relaxed);
+    s.w[3].store(b, std::memory_order_relaxed);
+    s.w[0].store(i + 1, std::memory_order_release);
+  }
+
+  uint32_t head() const { return head_.load(std::memory_order_acquire); }
+  // Oldest index still in the ring
+  uint32_t oldest() const { uint32_t h = head(); return h > CAP ? h - CAP : 0; }
+
+  // Record `i` if it is intact (false: overwritten, or not yet complete)
+  bool get(uint32_t i, TraceRec& r) const { return state(i, r) > 0; }
+
+  // Intact records from index `from` (moved up to the oldest) until `max`
+  // are copied, the head is reached, or a record still being written is
+  // met (it is read next time); `from` is left at the next index
+  size_t read(uint32_t& from, TraceRec* out, size_t max) const {
+    uint32_t h = head(), o = h > CAP ? h - CAP : 0;
+    if ((int32_t)(from - o) < 0) from = o;
+    size_t n = 0;
+    for (; n < max && from != h; from++){
+      int st = state(from, out[n]);
+      if (st == 0) break;
+      if (st > 0) n++;
+    }
+    return n;
+  }
+
+private:
+  // 1: copied; 0: claimed but not stamped yet; -1: overwritten by a later lap
+  int state(uint32_t i, TraceRec& r) const {
+    const Slot& s = slot_[i & (CAP - 1)];
+    uint32_t q = s.w[0].load(std::memory_order_acquire);
+    if (q != i + 1) return (q == 0 || (int32_t)(q - (i + 1)) < 0) ? 0 : -1;
+    uint32_t ms = s.w[1].load(std::memory_order_relaxed);
+    uint32_t x  = s.w[2].load(std::memory_order_relaxed);
+    uint32_t b  = s.w[3].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (s.w[0].load(std::memory_order_relaxed) != i + 1) return -1;
+    r.seq = i + 1; r.ms = ms; r.us = (uint16_t)(x & 0xFFFF); r.id = (uint8_t)(x >> 16); r.a = (uint8_t)(x >> 24); r.b = b;
+    return 1;
+  }
+
+  struct Slot { std::atomic<uint32_t> w[4]; };
+  std::atomic<uint32_t> head_{0};
+  Slot slot_[CAP] = {};
+};
+
+// One-line text for the serial console: "  12.345 rotate m1 CW, 3 ms late"
+size_t traceFormat(const TraceRec& r, char* out, size_t n);
@@ -0,0 +1,142 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "json_in.h"
+#include "json_out.h"
+#include "motion_link.h"
+#include "ramp_profile.h"
+#include "status_json.h"
+#include "wind_program.h"
+
+// ===================== Web routes =====================
+// The motion-facing HTTP handlers (/, /status, /start, /stop, /config,
+// /turbo) behind a small request/response seam, so the same code answers
+// under the firmware's WebServer and under the host load harness
+// (sim/web_host.h). Board specifics (network line, heap, waking the motion
+// task, saving settings) come in through WebHooks. Responses are built in
+// the caller's buffer; nothing is allocated per request.
+
+enum WebMethod : uint8_t { WEB_GET, WEB_POST };
+
+struct WebReq {
+  uint8_t     method;                  // WebMethod
+  const char* path;
+  const char* body; size_t bodyLen;
+  const char* ifNoneMatch;             // "" when absent
+};
+
+class WebResp {
+public:
+  virtual void header(const char* name, const char* value) = 0;   // before send()
+  virtual void send(int code, const char* type, const char* body, size_t n) = 0;
+};
+
+template <uint8_t N>
+struct WebHooks {
+  bool (*queue)(const MotionCmd<N>& c);      // to the motion task; false when the ring is full
+  StatusExtra (*extra)(char* net);           // fills `net` (STATUS_NET_MAX) and the rest
+  uint32_t (*millis)();
+  const uint8_t* ui; size_t uiLen; const char* uiEtag;   // pre-gzipped page
+};
+
+inline constexpr char RESP_OK[]   = "{\"ok\":true}";
+inline constexpr char RESP_BAD[]  = "{\"ok\":false}";
+inline constexpr char RESP_BUSY[] = "{\"ok\":false,\"err\":\"busy\"}";
+
+static inline long webClamp(long v, long lo, long hi){ return v < lo ? lo : v > hi ? hi : v; }
+
+template <uint8_t N>
+class WebRoutes {
+public:
+  typedef void (WebRoutes::*Handler)(const WebReq&, WebResp&);
+  // Worst-case body of these routes, incl. NUL
+  static constexpr size_t BUF_MIN = statusJsonMax<N>();
+
+  WebRoutes(MotionStatusLock<N>& status, const WebHooks<N>& hooks, char* buf, size_t len)
+    : status_(status), hooks_(hooks), buf_(buf), len_(len) {}
+
+  // Pre-gzipped UI; browsers revalidate with If-None-Match and get a bodyless 304
+  void index(const WebReq& r, WebResp& o){
+    o.header("ETag", hooks_.uiEtag);
+    o.header("Cache-Control", "no-cache");
+    if (!strcmp(r.ifNoneMatch, hooks_.uiEtag)){ o.send(304, "text/html", "", 0); return; }
+    o.header("Content-Encoding", "gzip");
+    o.send(200, "text/html", (const char*)hooks_.ui, hooks_.uiLen);
+  }
+
+  void status(const WebReq&, WebResp& o){
+    MotionStatus<N> st; status_.read(st); statusAge(st, hooks_.millis());
+    char net[STATUS_NET_MAX];
+    JsonOut j(buf_, len_);
+    statusJsonFull(j, st, hooks_.extra(net));
+    o.send(200, "application/json", j.c_str(), j.length());
+  }
+
+  void start(const WebReq&, WebResp& o){ MotionCmd<N> c{}; c.op = CMD_START; command(c, o); }
+  void stop(const WebReq&, WebResp& o){ MotionCmd<N> c{}; c.op = CMD_STOP; command(c, o); }
+
+  // tpdN / dirN, profile and the burst program; omitted keys keep the current value
+  void config(const WebReq& r, WebResp& o){
+    JsonIn in(r.body, r.bodyLen);
+    if (!in.ok()){ sendConst(o, 400, RESP_BAD); return; }
+    MotionStatus<N> st; status_.read(st);
+    MotionCmd<N> c{}; c.op = CMD_CONFIG; c.profile = st.profile; c.program = st.program;
+    if (in.has("profile")){
+      char p[12]; int v = in.str("profile", p, sizeof(p)) ? rampProfileParse(p) : -1;
+      if (v < 0){ sendConst(o, 400, "{\"ok\":false,\"err\":\"profile\"}"); return; }
+      c.profile = (uint8_t)v;
+    }
+    c.program.everyMin = (uint16_t)webClamp(in.num("every_min", c.program.everyMin), 0, 0xFFFF);
+    c.program.startMin = (uint16_t)webClamp(in.num("window_start_min", c.program.startMin), 0, 0xFFFF);
+    c.program.endMin = (uint16_t)webClamp(in.num("window_end_min", c.program.endMin), 0, 0xFFFF);
+    if (!programValid(c.program)){ sendConst(o, 400, "{\"ok\":false,\"err\":\"program\"}"); return; }
+    for (uint8_t m = 0; m < N; m++){
+      char kt[8], kd[8]; snprintf(kt, sizeof(kt), "tpd%u", m + 1); snprintf(kd, sizeof(kd), "dir%u", m + 1);
+      long d = in.num(kd, st.dir[m]);
+      if (d < -1 || d > +1){ sendConst(o, 400, "{\"ok\":false,\"err\":\"dir\"}"); return; }
+      c.tpd[m] = (int16_t)webClamp(in.num(kt, st.tpd[m]), 0, 1200);
+      c.dir[m] = (int8_t)d;
+    }
+    command(c, o);
+  }
+
+  // {"min":1..15,"mN":bool}
+  void turbo(const WebReq& r, WebResp& o){
+    JsonIn in(r.body, r.bodyLen);
+    if (!in.ok()){ sendConst(o, 400, RESP_BAD); return; }
+    MotionCmd<N> c{}; c.op = CMD_TURBO; c.minutes = (int16_t)webClamp(in.num("min", 5), 1, 15);
+    for (uint8_t m = 0; m < N; m++){
+      char k[6]; snprintf(k, sizeof(k), "m%u", m + 1);
+      if (in.boolean(k, false)) c.mask |= (MotorMask)(1u << m);
+    }
+    command(c, o);
+  }
+
+  // Host servers: the handler for the request's method and path; false when none matches
+  bool dispatch(const WebReq& r, WebResp& o){
+    struct Route { const char* path; uint8_t method; Handler run; };
+    static const Route ROUTES[] = {
+      { "/", WEB_GET, &WebRoutes::index }, { "/status", WEB_GET, &WebRoutes::status },
+      { "/start", WEB_POST, &WebRoutes::start }, { "/stop", WEB_POST, &WebRoutes::stop },
+      { "/config", WEB_POST, &WebRoutes::config }, { "/turbo", WEB_POST, &WebRoutes::turbo },
+    };
+    for (const Route& e : ROUTES)
+      if (e.method == r.method && !strcmp(e.path, r.path)){ (this->*e.run)(r, o); return true; }
+    return false;
+  }
+
+private:
+  static void sendConst(WebResp& o, int code, const char* body){ o.send(code, "application/json", body, strlen(body)); }
+  bool command(const MotionCmd<N>& c, WebResp& o){
+    if (!hooks_.queue(c)){ sendConst(o, 503, RESP_BUSY); return false; }
+    sendConst(o, 200, RESP_OK);
+    return true;
+  }
+
+  MotionStatusLock<N>& status_;
+  const WebHooks<N>& hooks_;
+  char* buf_;
+  size_t len_;
+};
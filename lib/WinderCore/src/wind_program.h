@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+
+// ===================== Winding programs =====================
+// How a motor's daily turns are laid out. The classic mode spreads them
+// evenly over 24 h; a burst program delivers them in bursts every
+// `everyMin` minutes, optionally only inside a time-of-day window, with
+// the motor (and its coils) at rest in between. Either way a day carries
+// exactly tpd turns.
+//   everyMin 0                 even spread (86400000 / tpd)
+//   everyMin 60                a burst at the top of every hour
+//   everyMin 120, 480..1200    a burst every 2 h from 08:00, last at 18:00
+// Times of day come from the scheduler's clock plus an offset set once the
+// wall clock is known; until then the day starts at boot.
+
+static const uint32_t PROGRAM_DAY_MS     = 86400000UL;
+static const uint16_t PROGRAM_DAY_MIN    = 1440;
+static const uint16_t PROGRAM_MIN_EVERY  = 15;                              // minutes
+static const uint8_t  PROGRAM_MAX_SLOTS  = PROGRAM_DAY_MIN / PROGRAM_MIN_EVERY;
+
+struct WindProgram {
+  uint16_t everyMin;             // burst period, minutes; 0 = even spread
+  uint16_t startMin, endMin;     // window [start, end), minutes since midnight; equal = all day
+};
+
+inline bool programValid(const WindProgram& p){
+  if (p.everyMin == 0) return true;
+  return p.everyMin >= PROGRAM_MIN_EVERY && p.everyMin <= PROGRAM_DAY_MIN &&
+         p.startMin < PROGRAM_DAY_MIN && p.endMin < PROGRAM_DAY_MIN;
+}
+inline bool programSame(const WindProgram& a, const WindProgram& b){
+  return a.everyMin == b.everyMin && a.startMin == b.startMin && a.endMin == b.endMin;
+}
+
+// One motor's program compiled for its TPD: the burst slots of a day and
+// the turns each carries, remainders spread evenly (Bresenham), so the
+// slots always sum to tpd. Slot times are arithmetic, so finding the next
+// slot from any time of day is O(1).
+class BurstTable {
+public:
+  // false (and no slots) for an even-spread or invalid program
+  bool compile(int tpd, const WindProgram& p){
+    n_ = 0;
+    if (tpd <= 0 || p.everyMin == 0 || !programValid(p)) return false;
+    uint16_t len = (uint16_t)((p.endMin + PROGRAM_DAY_MIN - p.startMin) % PROGRAM_DAY_MIN);
+    if (!len) len = PROGRAM_DAY_MIN;
+    n_ = (uint8_t)((len + p.everyMin - 1) / p.everyMin);
+    startMs_ = (uint32_t)p.startMin * 60000UL;
+    everyMs_ = (uint32_t)p.everyMin * 60000UL;
+    for (uint8_t i = 0; i < n_; i++)
+      turns_[i] = (uint16_t)((uint32_t)(i + 1) * tpd / n_ - (uint32_t)i * tpd / n_);
+    return true;
+  }
+
+  uint8_t  slots() const { return n_; }
+  uint16_t turns(uint8_t i) const { return turns_[i]; }
+
+  // Next slot starting at or after todMs (ms since midnight): its index and
+  // the wait until it starts; past the last slot that is slot 0 tomorrow
+  uint8_t next(uint32_t todMs, uint32_t& waitMs) const {
+    uint32_t rel = (todMs + PROGRAM_DAY_MS - startMs_) % PROGRAM_DAY_MS;   // ms into the window
+    uint32_t k = (rel + everyMs_ - 1) / everyMs_;
+    if (k >= n_){ waitMs = PROGRAM_DAY_MS - rel; return 0; }
+    waitMs = k * everyMs_ - rel;
+    return (uint8_t)k;
+  }
+
+private:
+  uint8_t  n_ = 0;
+  uint32_t startMs_ = 0, everyMs_ = 0;
+  uint16_t turns_[PROGRAM_MAX_SLOTS];
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include "duty_meter.h"
+#include "motion_link.h"
+#include "scheduler.h"
+#include "settings_blob.h"
+#include "status_json.h"
+#include "step_engine.h"
+
+// ===================== Winder<N> =====================
+// Everything sized by the number of watch positions, in one place. The
+// firmware instantiates Winder<MOTOR_COUNT> from config.h's motor table;
+// the host simulator instantiates whatever sizes it wants to measure.
+
+template <uint8_t N>
+struct Winder {
+  static_assert(N >= 1 && N <= WINDER_MAX_MOTORS, "1..16 motors");
+  static const uint8_t MOTORS = N;
+
+  typedef StepEngine<N>       Engine;
+  typedef WinderScheduler<N>  Scheduler;
+  typedef MotionCmd<N>        Cmd;
+  typedef MotionStatus<N>     Status;
+  typedef MotionCmdRing<N>    CmdRing;
+  typedef MotionStatusLock<N> StatusLock;
+  typedef StatusSent<N>       Sent;
+  typedef ::Settings<N>       Settings;
+
+  static const MotorMask ALL = (MotorMask)((1u << N) - 1);
+  static constexpr size_t STATUS_JSON_MAX = statusJsonMax<N>();
+  static constexpr size_t SETTINGS_BLOB_MAX = settingsBlobMax<N>();
+};
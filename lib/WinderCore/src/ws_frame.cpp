@@ -0,0 +1,74 @@
+#include <string.h>
+#include "ws_frame.h"
+
+static uint32_t rol(uint32_t v, int k){ return v << k | v >> (32 - k); }
+
+static void sha1Block(uint32_t h[5], const uint8_t* b){
+  uint32_t w[80];
+  for (int i = 0; i < 16; i++) w[i] = (uint32_t)b[4 * i] << 24 | b[4 * i + 1] << 16 | b[4 * i + 2] << 8 | b[4 * i + 3];
+  for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+  uint32_t a = h[0], bb = h[1], c = h[2], d = h[3], e = h[4];
+  for (int i = 0; i < 80; i++){
+    uint32_t f, k;
+    if (i < 20){ f = (bb & c) | (~bb & d); k = 0x5A827999; }
+    else if (i < 40){ f = bb ^ c ^ d; k = 0x6ED9EBA1; }
+    else if (i < 60){ f = (bb & c) | (bb & d) | (c & d); k = 0x8F1BBCDC; }
+    else { f = bb ^ c ^ d; k = 0xCA62C1D6; }
+    uint32_t t = rol(a, 5) + f + e + k + w[i];
+    e = d; d = c; c = rol(bb, 30); bb = a; a = t;
+  }
+  h[0] += a; h[1] += bb; h[2] += c; h[3] += d; h[4] += e;
+}
+
+void sha1(const uint8_t* p, size_t n, uint8_t out[20]){
+  uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+  size_t i = 0;
+  for (; i + 64 <= n; i += 64) sha1Block(h, p + i);
+  uint8_t tail[128] = {};
+  size_t r = n - i, t = r < 56 ? 64 : 128;
+  memcpy(tail, p + i, r);
+  tail[r] = 0x80;
+  uint64_t bits = (uint64_t)n * 8;
+  for (int k = 0; k < 8; k++) tail[t - 1 - k] = (uint8_t)(bits >> (8 * k));
+  for (size_t k = 0; k < t; k += 64) sha1Block(h, tail + k);
+  for (int k = 0; k < 20; k++) out[k] = (uint8_t)(h[k / 4] >> (24 - 8 * (k % 4)));
+}
+
+void wsAccept(const char* key, char* out){
+  static const char GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+  static const char B64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  uint8_t in[64 + sizeof(GUID)], d[21] = {};
+  size_t k = strnlen(key, 64);
+  memcpy(in, key, k); memcpy(in + k, GUID, sizeof(GUID) - 1);
+  sha1(in, k + sizeof(GUID) - 1, d);
+  char* o = out;
+  for (int i = 0; i < 21; i += 3){
+    uint32_t v = (uint32_t)d[i] << 16 | d[i + 1] << 8 | d[i + 2];
+    *o++ = B64[v >> 18]; *o++ = B64[v >> 12 & 63]; *o++ = B64[v >> 6 & 63]; *o++ = B64[v & 63];
+  }
+  out[WS_ACCEPT_LEN - 1] = '=';   // 20 bytes: the last group has one byte of padding
+  out[WS_ACCEPT_LEN] = 0;
+}
+
+size_t wsHead(uint8_t* out, uint8_t op, size_t len, const uint8_t* mask){
+  size_t n = 0;
+  out[n++] = (uint8_t)(0x80 | op);
+  uint8_t m = mask ? 0x80 : 0;
+  if (len < 126) out[n++] = (uint8_t)(m | len);
+  else { out[n++] = (uint8_t)(m | 126); out[n++] = (uint8_t)(len >> 8); out[n++] = (uint8_t)len; }
+  if (mask) for (int i = 0; i < 4; i++) out[n++] = mask[i];
+  return n;
+}
+
+int wsParse(const uint8_t* p, size_t n, WsFrame& f){
+  if (n < 2) return 0;
+  f.fin = p[0] & 0x80; f.op = p[0] & 0x0F; f.masked = p[1] & 0x80;
+  size_t len = p[1] & 0x7F, h = 2;
+  if (!f.fin || len == 127) return -1;
+  if (len == 126){ if (n < 4) return 0; len = (size_t)p[2] << 8 | p[3]; h = 4; }
+  if (f.masked){ if (n < h + 4) return 0; memcpy(f.mask, p + h, 4); h += 4; }
+  f.head = h; f.len = len;
+  return (int)h;
+}
+
+void wsMask(uint8_t* p, size_t n, const uint8_t mask[4]){ for (size_t i = 0; i < n; i++) p[i] ^= mask[i & 3]; }
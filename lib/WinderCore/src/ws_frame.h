@@ -0,0 +1,32 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ===================== WebSocket framing =====================
+// Just enough of RFC 6455 for ctl_frame.h messages on a connection that
+// stays open: the handshake accept key, frame headers both ways, unmasking.
+// Messages must arrive in one frame (no fragmentation); lengths up to 64 KB.
+
+enum WsOp : uint8_t { WS_TEXT = 1, WS_BINARY = 2, WS_CLOSE = 8, WS_PING = 9, WS_PONG = 10 };
+
+static const size_t WS_ACCEPT_LEN = 28;        // base64 of a SHA-1
+static const size_t WS_HEAD_MAX = 8;           // 2 + 2 (16-bit length) + 4 (mask)
+
+struct WsFrame {
+  uint8_t  op;
+  bool     fin, masked;
+  uint8_t  mask[4];
+  size_t   head, len;      // header bytes, payload bytes
+};
+
+// Sec-WebSocket-Accept for a client's Sec-WebSocket-Key; out holds WS_ACCEPT_LEN + 1
+void wsAccept(const char* key, char* out);
+// Frame header for a `len`-byte payload; a client passes a mask (and masks
+// the payload with wsMask), a server passes nullptr. Returns its length.
+size_t wsHead(uint8_t* out, uint8_t op, size_t len, const uint8_t* mask);
+// Header of the frame at p: 0 while incomplete, -1 when not supported
+// (fragmented, 64-bit length), else the header length (filled into f)
+int  wsParse(const uint8_t* p, size_t n, WsFrame& f);
+void wsMask(uint8_t* p, size_t n, const uint8_t mask[4]);
+
+void sha1(const uint8_t* p, size_t n, uint8_t out[20]);
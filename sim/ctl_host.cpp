@@ -0,0 +1,131 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "ctl_host.h"
+#include "ws_frame.h"
+
+static int bindLoopback(int type, uint16_t& port){
+  int fd = socket(AF_INET, type, 0);
+  if (fd < 0) return -1;
+  sockaddr_in a{}; a.sin_family = AF_INET; a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(fd, (sockaddr*)&a, sizeof(a)) < 0 || (type == SOCK_STREAM && ::listen(fd, 8) < 0)){ ::close(fd); return -1; }
+  socklen_t l = sizeof(a); getsockname(fd, (sockaddr*)&a, &l); port = ntohs(a.sin_port);
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+bool CtlHost::listen(){
+  udp_ = bindLoopback(SOCK_DGRAM, udpPort_);
+  tcp_ = bindLoopback(SOCK_STREAM, wsPort_);
+  if (udp_ < 0 || tcp_ < 0){ close(); return false; }
+  return true;
+}
+
+void CtlHost::close(){
+  if (udp_ >= 0) ::close(udp_);
+  if (tcp_ >= 0) ::close(tcp_);
+  udp_ = tcp_ = -1;
+  for (Sock& s : socks_){ if (s.fd >= 0) ::close(s.fd); s = Sock(); }
+}
+
+// The HTTP upgrade request is complete in s.in: answer 101 with the accept key
+void CtlHost::upgrade(Sock& s){
+  s.in[s.have] = 0;
+  const char* k = strcasestr((const char*)s.in, "\r\nSec-WebSocket-Key:");
+  char key[64] = "";
+  if (k) sscanf(k + 20, " %63[^\r\n ]", key);
+  size_t used = (size_t)(strstr((const char*)s.in, "\r\n\r\n") + 4 - (const char*)s.in);
+  if (!key[0]){
+    static const char BAD[] = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    send(s.fd, BAD, sizeof(BAD) - 1, MSG_NOSIGNAL);
+    ::close(s.fd); s = Sock();
+    return;
+  }
+  char accept[WS_ACCEPT_LEN + 1], hdr[160];
+  wsAccept(key, accept);
+  int n = snprintf(hdr, sizeof(hdr), "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                   "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n", accept);
+  send(s.fd, hdr, (size_t)n, MSG_NOSIGNAL);
+  memmove(s.in, s.in + used, s.have - used); s.have -= used;
+  s.open = true; s.peer = ++peers_;
+}
+
+int CtlHost::frames(Sock& s, CtlHandler fn, void* ctx){
+  int done = 0;
+  while (s.fd >= 0){
+    WsFrame f;
+    int h = wsParse(s.in, s.have, f);
+    if (h < 0 || (h > 0 && (!f.masked || f.head + f.len > sizeof(s.in)))){ ::close(s.fd); s = Sock(); break; }
+    if (h == 0 || s.have < f.head + f.len) break;
+    uint8_t* p = s.in + f.head;
+    wsMask(p, f.len, f.mask);
+    uint8_t out[WS_HEAD_MAX + CTL_FRAME_MAX];
+    size_t n = 0;
+    if (f.op == WS_CLOSE){ n = wsHead(out, WS_CLOSE, 0, nullptr); send(s.fd, out, n, MSG_NOSIGNAL); ::close(s.fd); s = Sock(); break; }
+    if (f.op == WS_PING){ n = wsHead(out, WS_PONG, f.len, nullptr); memcpy(out + n, p, f.len); n += f.len; }
+    if (f.op == WS_BINARY){
+      size_t k = fn((uint64_t)1 << 48 | s.peer, p, f.len, out + 4, sizeof(out) - 4, ctx);
+      if (k){
+        uint8_t head[WS_HEAD_MAX];
+        size_t hn = wsHead(head, WS_BINARY, k, nullptr);
+        memmove(out + hn, out + 4, k); memcpy(out, head, hn); n = hn + k;
+      }
+      done++;
+    }
+    if (n) send(s.fd, out, n, MSG_NOSIGNAL);
+    size_t used = f.head + f.len;
+    memmove(s.in, s.in + used, s.have - used); s.have -= used;
+  }
+  return done;
+}
+
+int CtlHost::poll(int waitMs, CtlHandler fn, void* ctx){
+  pollfd p[2 + SOCKETS];
+  int np = 0;
+  p[np++] = pollfd{ udp_, POLLIN, 0 };
+  p[np++] = pollfd{ tcp_, POLLIN, 0 };
+  for (Sock& s : socks_) if (s.fd >= 0) p[np++] = pollfd{ s.fd, POLLIN, 0 };
+  if (::poll(p, (nfds_t)np, waitMs) <= 0) return 0;
+  int done = 0;
+  uint8_t in[CTL_FRAME_MAX + 1], out[CTL_FRAME_MAX];
+  for (;;){
+    sockaddr_in from{}; socklen_t fl = sizeof(from);
+    ssize_t k = recvfrom(udp_, in, sizeof(in), 0, (sockaddr*)&from, &fl);
+    if (k < 0) break;
+    uint64_t peer = (uint64_t)ntohl(from.sin_addr.s_addr) << 16 | ntohs(from.sin_port);
+    size_t n = fn(peer, in, (size_t)k, out, sizeof(out), ctx);
+    done++;
+    if (!n) continue;
+    if (dropReplies){ dropReplies--; continue; }
+    sendto(udp_, out, n, 0, (sockaddr*)&from, fl);
+  }
+  for (int c; (c = accept(tcp_, nullptr, nullptr)) >= 0;){
+    Sock* s = nullptr;
+    for (Sock& e : socks_) if (e.fd < 0){ s = &e; break; }
+    if (!s){ ::close(c); continue; }
+    int on = 1; setsockopt(c, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    fcntl(c, F_SETFL, fcntl(c, F_GETFL) | O_NONBLOCK);
+    *s = Sock(); s->fd = c;
+  }
+  for (Sock& s : socks_){
+    if (s.fd < 0) continue;
+    ssize_t k = recv(s.fd, s.in + s.have, sizeof(s.in) - 1 - s.have, 0);
+    if (k == 0 || (k < 0 && errno != EAGAIN)){ ::close(s.fd); s = Sock(); continue; }
+    if (k > 0) s.have += (size_t)k;
+    if (!s.open){
+      s.in[s.have] = 0;
+      if (strstr((const char*)s.in, "\r\n\r\n")) upgrade(s);
+      else if (s.have == sizeof(s.in) - 1){ ::close(s.fd); s = Sock(); }
+    }
+    if (s.open) done += frames(s, fn, ctx);
+  }
+  return done;
+}
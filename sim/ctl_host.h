@@ -0,0 +1,36 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "ctl_frame.h"
+
+// ===================== Host control stand-in =====================
+// Serves ctl_frame.h requests on loopback the way the firmware does: one
+// UDP socket, and a WebSocket listener whose connections stay open, all
+// answered from one poll() loop by a handler (CtlServer::handle, usually).
+
+typedef size_t (*CtlHandler)(uint64_t peer, const uint8_t* in, size_t n, uint8_t* out, size_t cap, void* ctx);
+
+class CtlHost {
+public:
+  static const uint8_t SOCKETS = 4;
+  ~CtlHost(){ close(); }
+  bool listen();                                   // 127.0.0.1, free ports
+  uint16_t udpPort() const { return udpPort_; }
+  uint16_t wsPort() const { return wsPort_; }
+  // Waits up to waitMs, then answers everything waiting; returns requests answered
+  int poll(int waitMs, CtlHandler fn, void* ctx);
+  void close();
+  // Test hook: datagram replies to drop, the next `n` of them (a lost reply)
+  std::atomic<uint32_t> dropReplies{0};
+
+private:
+  struct Sock { int fd = -1; bool open = false; uint32_t peer = 0; uint8_t in[512]; size_t have = 0; };
+  void upgrade(Sock& s);
+  int frames(Sock& s, CtlHandler fn, void* ctx);
+
+  int udp_ = -1, tcp_ = -1;
+  uint16_t udpPort_ = 0, wsPort_ = 0;
+  Sock socks_[SOCKETS];
+  uint32_t peers_ = 0;
+};
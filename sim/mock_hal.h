@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "hal.h"
+#include "step_engine.h"
+
+// ===================== Mock HAL =====================
+// Virtual clock, GPIO levels and a timing-model stepper for host runs.
+// Nothing here sleeps: the harness advances MockClock explicitly.
+// EngineDriver puts the real StepEngine behind the HAL instead, for runs
+// that call tick() themselves.
+
+class MockClock : public Clock {
+public:
+  uint64_t nowMs = 0;                          // full 64-bit virtual time
+  uint64_t millis() override { return nowMs; }
+  void advance(uint64_t ms){ nowMs += ms; }
+};
+
+class MockGpio : public Gpio {
+public:
+  int level[64];
+  uint32_t writes = 0;
+  MockGpio(){ for (int& l : level) l = 1; }   // INPUT_PULLUP idle high
+  int  read(int pin) override { return (pin >= 0 && pin < 64) ? level[pin] : 1; }
+  void write(int pin, int v) override { if (pin >= 0 && pin < 64) level[pin] = v; writes++; }
+};
+
+// Moves complete after |steps|/sps plus a fixed ramp allowance; no per-step work.
+class MockStepper : public MotorDriver {
+public:
+  struct Axis { uint64_t busyUntil = 0; int32_t queued = 0; };
+  struct MoveLog { uint8_t motor; uint64_t atMs; int32_t steps; };
+
+  MockStepper(MockClock& clk, uint32_t sps, uint32_t rampMs) : clk_(clk), sps_(sps), rampMs_(rampMs) {}
+
+  void move(uint8_t m, int32_t steps) override {
+    Axis& a = ax_[m];
+    uint64_t now = clk_.nowMs, from = a.busyUntil > now ? a.busyUntil : now;
+    if (a.busyUntil <= now) a.queued = 0;
+    a.queued += steps;
+    a.busyUntil = from + (uint64_t)(steps < 0 ? -steps : steps) * 1000 / sps_ + (a.busyUntil > now ? 0 : rampMs_);
+    steps_[m] += steps < 0 ? -steps : steps;
+    log.push_back({ m, now, steps });
+  }
+  void stop(uint8_t m) override {
+    steps_[m] -= unmade(m);
+    ax_[m].busyUntil = clk_.nowMs; ax_[m].queued = 0;
+  }
+  int32_t distanceToGo(uint8_t m) override {
+    const Axis& a = ax_[m];
+    if (a.busyUntil <= clk_.nowMs) return 0;
+    int32_t left = (int32_t)((a.busyUntil - clk_.nowMs) * sps_ / 1000) + 1;
+    return a.queued < 0 ? -left : left;
+  }
+  uint32_t moveMs(uint32_t steps) override { return (uint32_t)((uint64_t)steps * 1000 / sps_ + rampMs_); }
+  uint32_t stepsMade(uint8_t m) override { return (uint32_t)(steps_[m] - unmade(m)); }
+
+  uint64_t busyUntil(uint8_t m) const { return ax_[m].busyUntil; }
+  uint64_t totalSteps(uint8_t m) const { return steps_[m]; }
+  std::vector<MoveLog> log;
+
+private:
+  // Steps queued but not made yet; the ramp allowance is time, not steps
+  uint64_t unmade(uint8_t m){
+    int32_t left = distanceToGo(m), q = ax_[m].queued;
+    uint32_t l = (uint32_t)(left < 0 ? -left : left), lim = (uint32_t)(q < 0 ? -q : q);
+    return l < lim ? l : lim;
+  }
+
+  MockClock& clk_;
+  uint32_t sps_, rampMs_;
+  Axis ax_[16];
+  uint64_t steps_[16] = {0};
+};
+
+template <uint8_t N>
+class EngineDriver : public MotorDriver {
+public:
+  explicit EngineDriver(StepEngine<N>& e) : e(e) {}
+  void move(uint8_t m, int32_t steps) override { e.move(m, steps); }
+  void stop(uint8_t m) override { e.stop(m); }
+  int32_t distanceToGo(uint8_t m) override { return e.distanceToGo(m); }
+  uint32_t moveMs(uint32_t steps) override { return (uint32_t)(e.moveUs(steps) / 1000); }
+  uint32_t stepsMade(uint8_t m) override { return e.stepCount(m); }
+  StepEngine<N>& e;
+};
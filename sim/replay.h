@@ -0,0 +1,156 @@
+#pragma once
+#include <stdint.h>
+#include <chrono>
+#include "config.h"
+#include "mock_hal.h"
+#include "winder.h"
+
+// ===================== Shared replays =====================
+// Multi-day scheduler replay and turbo sessions on the mock HAL. The sim
+// scenarios print their numbers; test/ asserts on them (pio test -e native).
+
+typedef Winder<MOTOR_COUNT> ReplayWinder;
+
+// ---------- Multi-day scheduler replay ----------
+// The virtual clock jumps straight to the next interesting instant (a due
+// rotation, a motor finishing), so 30 days replay in well under a second.
+// Drift is each start against the ideal grid from the first one.
+struct DayMotor { int tpd; uint64_t turns, steps; long long maxDrift, lastDrift; };
+struct DayReplay { uint64_t polls; double pollNs; DayMotor m[MOTOR_COUNT]; };
+
+constexpr uint32_t REPLAY_PASS_MS = 2;   // pass cadence while a motor moves (and the old fixed cadence)
+
+// `tpd`: a plan per motor, or nullptr for MOTOR_TABLE's
+inline DayReplay replayDays(int days, int mode, const int* tpd){
+  typedef ReplayWinder W;
+  MockClock clk;
+  MockGpio io;
+  MockStepper mot(clk, (uint32_t)(STEP_RPM * STEPS_PER_REV / 60), 830);   // ramp allowance ~ accel/decel time at 1.2*sps/s
+  io.level[MODE_PIN_A] = mode == 0 ? 0 : 1;
+  io.level[MODE_PIN_B] = mode == 2 ? 0 : 1;
+
+  W::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) sched.setPlan(m, tpd ? tpd[m] : MOTOR_TABLE[m].tpd, DIR_ALT);
+  clk.nowMs = 1000;                        // boot offset
+  sched.begin();
+
+  DayReplay r{};
+  const uint64_t endMs = clk.nowMs + (uint64_t)days * 86400000ULL;
+  while (clk.nowMs < endMs){
+    auto t0 = std::chrono::steady_clock::now();
+    sched.poll();
+    r.pollNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    r.polls++;
+
+    // Next instant anything can change: a motor finishing or a rotation coming due
+    W::Status st{};
+    sched.fillStatus(st);
+    uint64_t next = UINT64_MAX;
+    for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+      if (mot.busyUntil(m) > clk.nowMs && mot.busyUntil(m) < next) next = mot.busyUntil(m);
+      if (st.nextMs[m] > 0 && clk.nowMs + st.nextMs[m] < next) next = clk.nowMs + st.nextMs[m];
+    }
+    if (next == UINT64_MAX || next < clk.nowMs + REPLAY_PASS_MS) next = clk.nowMs + REPLAY_PASS_MS;
+    clk.nowMs = (next + REPLAY_PASS_MS - 1) / REPLAY_PASS_MS * REPLAY_PASS_MS;   // passes land on the 2 ms grid
+  }
+
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+    DayMotor& d = r.m[m];
+    d.tpd = sched.tpd(m);
+    d.steps = mot.totalSteps(m);
+    uint32_t iv = W::Scheduler::intervalFromTPD(d.tpd);
+    uint64_t first = 0;
+    for (const MockStepper::MoveLog& l : mot.log){
+      if (l.motor != m) continue;
+      if (!d.turns) first = l.atMs - iv;
+      d.turns++;
+      d.lastDrift = (long long)(l.atMs - (first + d.turns * (uint64_t)iv));
+      if ((d.lastDrift < 0 ? -d.lastDrift : d.lastDrift) > (d.maxDrift < 0 ? -d.maxDrift : d.maxDrift)) d.maxDrift = d.lastDrift;
+    }
+  }
+  return r;
+}
+
+// ---------- Turbo sessions on the step engine ----------
+// Runs the real engine tick by tick. A session reports its end against the
+// deadline, turbo_left_ms against the actual end, whether every motor made
+// exactly its planned whole rotations, and whether done/planned only rose.
+struct TurboSession { int64_t errMs, leftErrMs; double revMs; bool exact, monotonic; uint32_t turns; };
+
+constexpr uint32_t REPLAY_TICKS_PER_MS = 1000 / STEP_TICK_US;
+
+inline void replayNoCoils(MotorMask, const uint8_t*){}
+inline uint32_t replaySps(int rpm){ return (uint32_t)(rpm * STEPS_PER_REV / 60); }
+inline void replaySetup(ReplayWinder::Engine& e, int rpm, uint8_t profile, uint16_t capMa){
+  uint32_t sps = replaySps(rpm);
+  e.setSpeed(sps, 100, sps * 5 / 12, (RampProfile)profile);
+  e.setRelease(COILS_RELEASE_IDLE);
+  e.setPowerBudget(capMa, COIL_MA, COIL_TAU_US);
+}
+inline void replayRunMs(ReplayWinder::Engine& e, MockClock& clk){
+  for (uint32_t t = 0; t < REPLAY_TICKS_PER_MS; t++) e.tick();
+  clk.advance(1);
+}
+
+// One ramp's duration at this speed/profile
+inline double replayRampMs(int rpm, uint8_t profile){
+  ReplayWinder::Engine e(replayNoCoils);
+  replaySetup(e, rpm, profile, 0);
+  return e.moveUs(2 * e.ramp().steps) / 2000.0;
+}
+
+// `mid`: motor 1 is 1.5 s into a scheduled rotation when turbo is pressed.
+// `replace`: a 2-minute request arrives one minute into the session.
+inline TurboSession turboSession(int rpm, uint8_t profile, uint32_t minutes, bool mid, bool replace, uint16_t capMa){
+  typedef ReplayWinder W;
+  MockClock clk; MockGpio io;
+  W::Engine engine(replayNoCoils);
+  replaySetup(engine, rpm, profile, capMa);
+  EngineDriver<MOTOR_COUNT> mot(engine);
+  W::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, -1 }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) sched.setPlan(m, 0, DIR_CW);   // manual, nothing scheduled
+  clk.nowMs = 1000;
+  sched.begin();
+  if (mid){ engine.move(0, -STEPS_PER_REV); for (int i = 0; i < 1500; i++) replayRunMs(engine, clk); }
+
+  W::Cmd c{}; c.op = CMD_TURBO; c.mask = W::ALL; c.minutes = (int16_t)minutes;
+  sched.apply(c);
+  uint64_t t0 = clk.nowMs, deadline = t0 + minutes * 60000ULL, predicted = 0;
+  uint16_t lastDone[MOTOR_COUNT] = {0};
+  int32_t pos0[MOTOR_COUNT];
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) pos0[m] = engine.position(m);
+  TurboSession s{};
+  s.monotonic = true;
+  bool replaced = false;
+  for (;;){
+    if (replace && !replaced && clk.nowMs >= t0 + 60000){
+      c.minutes = 2; sched.apply(c); replaced = true;
+      deadline = clk.nowMs + 2 * 60000ULL;
+      for (uint8_t m = 0; m < MOTOR_COUNT; m++) lastDone[m] = 0;
+    }
+    sched.poll();
+    if (!sched.turboActive()) break;
+    W::Status st{}; sched.fillStatus(st);
+    predicted = clk.nowMs + (uint64_t)st.turboLeftMs;
+    for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+      if (st.turboDone[m] < lastDone[m] || st.turboDone[m] > st.turboTurns[m]) s.monotonic = false;
+      lastDone[m] = st.turboDone[m];
+    }
+    replayRunMs(engine, clk);
+  }
+  s.errMs = (int64_t)clk.nowMs - (int64_t)deadline;
+  s.leftErrMs = (int64_t)clk.nowMs - (int64_t)predicted;
+  s.revMs = STEPS_PER_REV * 1000.0 / replaySps(rpm);
+  s.exact = true;
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+    uint32_t k = sched.turboTurns(m);
+    if (sched.turboDone(m) != k) s.exact = false;
+    // Finished on a whole rotation from where turbo (or the interrupted rotation) began
+    int32_t moved = engine.position(m) - pos0[m];
+    if (mid && m == 0) moved = engine.position(m) + STEPS_PER_REV;                 // from the rotation's start
+    if (moved % STEPS_PER_REV) s.exact = false;
+    if (!replace && (uint32_t)(moved < 0 ? -moved : moved) != k * STEPS_PER_REV) s.exact = false;
+    s.turns += k;
+  }
+  return s;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+
+// ===================== Host simulator =====================
+// Scenarios that run the firmware's portable logic (lib/WinderCore) against
+// virtual time on Linux. Each returns 0 on success, non-zero if a check fails.
+
+int simSteps(int argc, char** argv);
+int simLink(int argc, char** argv);
+int simDays(int argc, char** argv);
+int simEvents(int argc, char** argv);
+int simJson(int argc, char** argv);
+int simScan(int argc, char** argv);
+int simCoils(int argc, char** argv);
+int simScale(int argc, char** argv);
+int simRamp(int argc, char** argv);
+int simWrap(int argc, char** argv);
+int simBurst(int argc, char** argv);
+int simPrefs(int argc, char** argv);
+int simResume(int argc, char** argv);
+int simMetrics(int argc, char** argv);
+int simTrace(int argc, char** argv);
+int simSwitch(int argc, char** argv);
+int simPower(int argc, char** argv);
+int simTurbo(int argc, char** argv);
+int simFleet(int argc, char** argv);
+int simHistory(int argc, char** argv);
+int simHttp(int argc, char** argv);
+int simCtl(int argc, char** argv);
@@ -0,0 +1,133 @@
+// Burst programs: daily turns delivered in bursts every N minutes, inside
+// an optional time-of-day window, instead of evenly over 24 h.
+//   winder_sim burst [days]
+// For each program and TPD, replays the motion task event-driven on the
+// mock HAL and checks every calendar day carries exactly tpd turns, that
+// all turns start inside the window's bursts, and that BurstTable::next()
+// agrees with a scan of the day. Reports the longest rest and the wakeups.
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "mock_hal.h"
+#include "sim.h"
+#include "winder.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+typedef Winder<1> W1;
+static const uint64_t DAY = PROGRAM_DAY_MS;
+static const uint32_t TOD_OFFSET = 5 * 3600000UL + 1234;   // clock 0 is 05:00:01.234
+
+// next() against a scan of every slot of the day
+static int tableChecks(){
+  int fails = 0;
+  const WindProgram progs[] = { { 60, 0, 0 }, { 120, 480, 1200 }, { 15, 1320, 360 }, { 100, 0, 0 }, { 1440, 720, 720 } };
+  for (const WindProgram& p : progs){
+    BurstTable t;
+    CHECK(t.compile(777, p));
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < t.slots(); i++) sum += t.turns(i);
+    CHECK(sum == 777);
+    for (uint32_t tod = 0; tod < DAY; tod += 37003){
+      uint32_t wait, best = UINT32_MAX;
+      uint8_t k = t.next(tod, wait), bestK = 0;
+      for (uint8_t i = 0; i < t.slots(); i++){   // scan every slot of the day
+        uint32_t at = (uint32_t)((p.startMin + (uint32_t)i * p.everyMin) % PROGRAM_DAY_MIN) * 60000UL;
+        uint32_t d = (at + DAY - tod) % DAY;
+        if (d < best){ best = d; bestK = i; }
+      }
+      if (wait != best || k != bestK){ fails++; printf("  FAIL next() every %u from %u ms\n", p.everyMin, tod); break; }
+    }
+  }
+  WindProgram bad{ 10, 0, 0 };
+  BurstTable t;
+  CHECK(!programValid(bad) && !t.compile(650, bad) && t.slots() == 0);
+  return fails;
+}
+
+struct Result { uint32_t minDay, maxDay, outside; uint64_t longestRestMs, wakes, busyMs; };
+
+static Result run(const WindProgram& p, int tpd, int days, int& fails){
+  uint32_t sps = (uint32_t)(STEP_RPM * STEPS_PER_REV / 60);
+  MockClock clk;
+  MockGpio io;
+  MockStepper mot(clk, sps, 830);
+  W1::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  sched.setPlan(0, tpd, DIR_ALT);
+  sched.setProgram(p);
+  clk.nowMs = 1000;
+  sched.begin();
+  W1::Cmd c{}; c.op = CMD_CLOCK; c.todOffsetMs = TOD_OFFSET;
+  sched.apply(c);
+
+  // Calendar days start at local midnight; skip the partial first one
+  uint64_t firstMidnight = ((clk.nowMs + TOD_OFFSET) / DAY + 1) * DAY - TOD_OFFSET;
+  uint64_t end = firstMidnight + (uint64_t)days * DAY;
+  Result r{ UINT32_MAX, 0, 0, 0, 0, 0 };
+  uint64_t wakesBefore = 0;
+  while (clk.nowMs < end){
+    if (clk.nowMs < firstMidnight) wakesBefore = r.wakes;
+    sched.poll();
+    r.wakes++;
+    uint64_t next = sched.nextEventMs();
+    if (next > clk.nowMs){ clk.nowMs = next; continue; }
+    // Moving: the firmware passes every 2 ms until the rotation ends; count them, skip ahead
+    uint64_t done = mot.busyUntil(0) > clk.nowMs ? mot.busyUntil(0) : clk.nowMs + 2;
+    r.wakes += (done - clk.nowMs) / 2;
+    clk.nowMs = done;
+  }
+  r.wakes -= wakesBefore;
+
+  uint32_t perDay[64] = {0};
+  uint64_t rotMs = (uint64_t)STEPS_PER_REV * 1000 / sps + 830, lastEnd = 0;
+  BurstTable t;
+  uint32_t maxTurns = 0;
+  if (t.compile(tpd, p)) for (uint8_t i = 0; i < t.slots(); i++) if (t.turns(i) > maxTurns) maxTurns = t.turns(i);
+  for (const MockStepper::MoveLog& l : mot.log){
+    if (l.atMs < firstMidnight || l.atMs >= end) continue;
+    perDay[(l.atMs - firstMidnight) / DAY]++;
+    if (lastEnd && l.atMs - lastEnd > r.longestRestMs) r.longestRestMs = l.atMs - lastEnd;
+    lastEnd = l.atMs + rotMs;
+    r.busyMs += rotMs;
+    if (p.everyMin){
+      // Starts inside [window start, window end + one burst)
+      uint32_t tod = (uint32_t)((l.atMs + TOD_OFFSET) % DAY);
+      uint32_t rel = (tod + DAY - p.startMin * 60000UL) % DAY;
+      uint32_t len = ((p.endMin + PROGRAM_DAY_MIN - p.startMin) % PROGRAM_DAY_MIN) * 60000UL;
+      if (!len) len = DAY;
+      if (rel >= len + maxTurns * rotMs && len != DAY) r.outside++;
+    }
+  }
+  for (int d = 0; d < days && d < 64; d++){
+    if (perDay[d] < r.minDay) r.minDay = perDay[d];
+    if (perDay[d] > r.maxDay) r.maxDay = perDay[d];
+  }
+  CHECK(r.minDay == (uint32_t)tpd && r.maxDay == (uint32_t)tpd);
+  CHECK(r.outside == 0);
+  return r;
+}
+
+int simBurst(int argc, char** argv){
+  int days = argc > 1 ? atoi(argv[1]) : 2;
+  if (days < 1) days = 1;
+  if (days > 64) days = 64;
+  int fails = tableChecks();
+  struct Case { const char* name; WindProgram p; };
+  const Case cases[] = {
+    { "even (classic)",          { 0, 0, 0 } },
+    { "every 60 min",            { 60, 0, 0 } },
+    { "every 2 h, 08:00-20:00",  { 120, 480, 1200 } },
+    { "every 15 min, 22:00-06:00", { 15, 1320, 360 } },
+    { "once a day at 09:00",     { 1440, 540, 540 } },
+  };
+  const int TPDS[] = { 650, 800, 1200, 7 };
+  printf("  %-27s %5s  %-11s %13s %10s %9s\n", "program", "tpd", "turns/day", "longest rest", "wakeups/d", "busy");
+  for (const Case& k : cases)
+    for (int tpd : TPDS){
+      Result r = run(k.p, tpd, days, fails);
+      printf("  %-27s %5d  %4u..%-4u %10.1f min %10.0f %8.2f%%\n", k.name, tpd, r.minDay, r.maxDay,
+             r.longestRestMs / 60000.0, (double)r.wakes / days, 100.0 * r.busyMs / (days * DAY));
+    }
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
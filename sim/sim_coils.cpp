@@ -0,0 +1,114 @@
+// Batched coil driver: checks the compile-time CoilMap against a simulated
+// GPIO register file while the step engine runs one revolution per motor,
+// then a cycle-count model of the per-step cost: batched register write vs
+// the per-pin digitalWrite() it replaced vs AccelStepper::run().
+//   winder_sim coils [rpm]
+// The cycle costs below are Xtensa LX6 @ 240 MHz estimates; `pio run -e bench`
+// prints the measured numbers on target.
+#include <stdio.h>
+#include <stdlib.h>
+#include "coil_driver.h"
+#include "config.h"
+#include "sim.h"
+#include "winder.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+typedef Winder<MOTOR_COUNT> W;
+static constexpr CoilMap<MOTOR_COUNT> MAP(MOTOR_TABLE);   // must build at compile time
+
+// ----- Cost model (cycles) -----
+static const double C_DIGITALWRITE = 60;   // Arduino digitalWrite -> gpio_set_level
+static const double C_REG_STORE    = 4;    // one GPIO w1ts/w1tc store
+static const double C_LUT_MOTOR    = 8;    // CoilMap lookup + OR into masks
+static const double C_AXIS_IDLE    = 20;   // engine per-axis bookkeeping, no step
+static const double C_AXIS_STEP    = 50;   // phase/counters + next interval (ramp table lookup)
+static const double C_MICROS       = 90;   // micros() in AccelStepper::runSpeed()
+static const double C_ACCEL_RUN    = 25;   // run()/runSpeed() call + interval test
+static const double C_ACCEL_SPEED  = 280;  // computeNewSpeed(): float sqrt/divide per step
+
+static uint32_t bank[2];
+static uint32_t writes = 0, stores = 0, motorWrites = 0;
+static uint8_t lastCoils[MOTOR_COUNT];
+static int fails = 0;
+
+static bool pinLevel(int pin){ return (bank[pin >= 32] >> (pin & 31)) & 1; }
+
+static void applyCoils(MotorMask changed, const uint8_t* coils){
+  CoilMasks c = MAP.combine(changed, coils);
+  for (int b = 0; b < 2; b++){
+    if (c.set[b]){ bank[b] |= c.set[b]; stores++; }
+    if (c.clr[b]){ bank[b] &= ~c.clr[b]; stores++; }
+  }
+  writes++;
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+    if (changed & (1u << m)){
+      motorWrites++;
+      int from = -1, to = -1;
+      for (int i = 0; i < 8; i++){ if (HALFSTEP_SEQ[i] == lastCoils[m]) from = i; if (HALFSTEP_SEQ[i] == coils[m]) to = i; }
+      CHECK(coils[m] == 0 || (to >= 0 && (from < 0 || ((to - from) & 7) == 1 || ((from - to) & 7) == 1)));   // adjacent half-steps or released
+      lastCoils[m] = coils[m];
+    }
+    for (int i = 0; i < 4; i++) CHECK(pinLevel(MOTOR_TABLE[m].in[i]) == (bool)((lastCoils[m] >> i) & 1));
+  }
+}
+
+int simCoils(int argc, char** argv){
+  fails = 0;
+  // Every motor x pattern drives exactly its four pins, in the right bank
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++)
+    for (uint8_t p = 0; p < 16; p++){
+      const CoilMasks& e = MAP.entry(m, p);
+      for (int i = 0; i < 4; i++){
+        int pin = MOTOR_TABLE[m].in[i]; uint32_t bit = 1u << (pin & 31); int b = pin >= 32;
+        CHECK(((p >> i) & 1) ? (e.set[b] & bit) && !(e.clr[b] & bit) : (e.clr[b] & bit) && !(e.set[b] & bit));
+      }
+    }
+
+  int rpm = argc > 1 ? atoi(argv[1]) : STEP_RPM;
+  uint32_t sps = (uint32_t)(rpm * STEPS_PER_REV / 60);
+  if (sps > 1200) sps = 1200;
+  if (sps < 50) sps = 50;
+  W::Engine engine(applyCoils);
+  engine.setSpeed(sps, 100, (uint32_t)(sps / 2.4));
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) engine.move(m, (m & 1) ? -STEPS_PER_REV : STEPS_PER_REV);
+  uint64_t ticks = 0, steps = 0;
+  for (bool busy = true; busy; ticks++){
+    engine.tick();
+    busy = false;
+    for (uint8_t m = 0; m < MOTOR_COUNT; m++) busy |= engine.isRunning(m);
+  }
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) steps += engine.stepCount(m);
+  CHECK(steps == (uint64_t)MOTOR_COUNT * STEPS_PER_REV && motorWrites == steps);
+
+  // Same revolution costed three ways; ISR bookkeeping common to both engine variants
+  double base    = ticks * MOTOR_COUNT * C_AXIS_IDLE + steps * (C_AXIS_STEP - C_AXIS_IDLE);
+  double batched = base + motorWrites * C_LUT_MOTOR + stores * C_REG_STORE;
+  double perPin  = base + steps * 4 * C_DIGITALWRITE;
+  double accelPerStep = C_ACCEL_RUN + C_MICROS + C_ACCEL_SPEED + 4 * C_DIGITALWRITE;
+  double writeBatched = (motorWrites * C_LUT_MOTOR + stores * C_REG_STORE) / steps;
+
+  printf("  %llu ticks, %llu steps, %u batched writes (%.2f motors/write), %.2f register stores/write\n",
+         (unsigned long long)ticks, (unsigned long long)steps, writes, (double)motorWrites / writes, (double)stores / writes);
+  printf("  coil output per step:  batched %.0f cyc   per-pin digitalWrite %.0f cyc  (%.1fx)\n",
+         writeBatched, 4 * C_DIGITALWRITE, 4 * C_DIGITALWRITE / writeBatched);
+  printf("  whole step incl. ISR:  batched %.0f cyc   per-pin %.0f cyc   AccelStepper::run() %.0f cyc + %.0f per idle call\n",
+         batched / steps, perPin / steps, accelPerStep, C_ACCEL_RUN + C_MICROS);
+  printf("  ISR load at %u sps x %d motors: %.2f%% of one core (per-pin %.2f%%)\n",
+         sps, MOTOR_COUNT, 100.0 * batched / ticks / (240.0 * STEP_TICK_US), 100.0 * perPin / ticks / (240.0 * STEP_TICK_US));
+
+  // Idle release: coils drop one step interval after the move ends, and the
+  // timer isn't allowed to stop (settled) before that
+  W::Engine rel(applyCoils);
+  rel.setRelease(true);
+  rel.setSpeed(sps, 100, (uint32_t)(sps / 2.4));
+  rel.move(0, 100);
+  while (rel.isRunning(0)) rel.tick();
+  CHECK(!rel.settled() && rel.coils(0) != 0);
+  uint32_t after = 0;
+  while (!rel.settled() && after < STEP_TICK_HZ){ rel.tick(); after++; }
+  CHECK(rel.settled() && rel.coils(0) == 0 && lastCoils[0] == 0);
+  printf("  idle release: coils off %u ticks (%.1f ms) after the last step\n", after, after * STEP_TICK_US / 1000.0);
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
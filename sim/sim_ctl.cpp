@@ -0,0 +1,253 @@
+// Binary control protocol (ctl_frame.h) against the JSON routes.
+//   winder_sim ctl [commands]
+// Checks the frame codec (round trip, CRC, version), the WebSocket accept
+// key against RFC 6455's example, and the server's retry rule: a repeated
+// seq is answered without being applied again, a busy answer is not
+// remembered, a lost UDP reply is recovered by the client's resend.
+// Then sends the same mix of start/stop/config/turbo/status `commands`
+// times (default 500) over loopback three ways, one request at a time:
+// the JSON routes (web_routes.h on the WebServer stand-in, a connection per
+// request as WebServer closes each), binary over UDP, and binary over one
+// open WebSocket (tools/ctl's client). Reports round-trip p50/p99 and bytes
+// on the wire per command (TCP/UDP/IP headers not counted).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "config.h"
+#include "ctl_client.h"
+#include "ctl_host.h"
+#include "ctl_server.h"
+#include "mock_hal.h"
+#include "sim.h"
+#include "web_host.h"
+#include "winder.h"
+#include "ws_frame.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+typedef Winder<MOTOR_COUNT> W;
+typedef CtlServer<MOTOR_COUNT> Ctl;
+
+static W::CmdRing cmds;
+static W::StatusLock status;
+static std::atomic<uint32_t> queued{0};
+static bool refuse = false;
+static char respBuf[W::STATUS_JSON_MAX > 1024 ? W::STATUS_JSON_MAX : 1024];
+
+static std::mutex wakeLock;
+static std::condition_variable wake;          // xTaskNotifyGive() to the motion task
+
+static bool queueCmd(const W::Cmd& c){
+  if (refuse || !cmds.push(c)) return false;
+  queued++; wake.notify_one();
+  return true;
+}
+static StatusExtra extra(char* net){
+  snprintf(net, STATUS_NET_MAX, "STA 127.0.0.1 (sim)");
+  return StatusExtra{ net, 0, 0, 0, 0, 0, 0, "cold", 0 };
+}
+static uint32_t hostMillis(){ return (uint32_t)(webNowUs() / 1000); }
+static const uint8_t NO_UI[1] = {};
+static const WebHooks<MOTOR_COUNT> hooks = { queueCmd, extra, hostMillis, NO_UI, 0, "\"sim\"" };
+static WebRoutes<MOTOR_COUNT> routes(status, hooks, respBuf, sizeof(respBuf));
+static Ctl ctl(status, hooks);
+
+static bool restDispatch(const WebReq& r, WebResp& o, void*){ return routes.dispatch(r, o); }
+static size_t ctlHandle(uint64_t peer, const uint8_t* in, size_t n, uint8_t* out, size_t cap, void*){
+  return ctl.handle(peer, in, n, out, cap);
+}
+
+// One JSON request on its own connection, as a browser or curl against
+// WebServer does; bytes both ways, -1 on failure
+static long rest(uint16_t port, const char* method, const char* path, const char* body){
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in a{}; a.sin_family = AF_INET; a.sin_port = htons(port); a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (sockaddr*)&a, sizeof(a)) < 0){ close(fd); return -1; }
+  int on = 1; setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  char req[512];
+  size_t blen = body ? strlen(body) : 0;
+  int n = snprintf(req, sizeof(req), "%s %s HTTP/1.1\r\nHost: 127.0.0.1\r\n%sContent-Length: %zu\r\n\r\n%s",
+                   method, path, blen ? "Content-Type: application/json\r\n" : "", blen, body ? body : "");
+  send(fd, req, (size_t)n, MSG_NOSIGNAL);
+  std::string in;
+  char buf[2048];
+  for (ssize_t k; (k = recv(fd, buf, sizeof(buf), 0)) > 0;) in.append(buf, (size_t)k);
+  close(fd);
+  if (in.compare(0, 9, "HTTP/1.1 ") || atoi(in.c_str() + 9) != 200) return -1;
+  return n + (long)in.size();
+}
+
+struct Way { const char* name; std::vector<uint32_t> us{}; uint64_t bytes = 0, statusBytes = 0; uint32_t statusN = 0, failed = 0; };
+
+static uint32_t pct(std::vector<uint32_t> v, unsigned perMille){
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[(v.size() - 1) * perMille / 1000];
+}
+
+int simCtl(int argc, char** argv){
+  int count = argc > 1 ? atoi(argv[1]) : 500;
+  if (count < 10) count = 10;
+  int fails = 0;
+  const uint16_t ALL = Ctl::ALL;
+
+  // ---- Codec ----
+  char accept[WS_ACCEPT_LEN + 1];
+  wsAccept("dGhlIHNhbXBsZSBub25jZQ==", accept);
+  CHECK(!strcmp(accept, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo="));
+  CtlConfig cfg{}; cfg.set = CTL_SET_PROFILE; cfg.profile = RAMP_SCURVE;
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){ cfg.tpd[m] = (int16_t)(600 + m); cfg.dir[m] = m & 1 ? -1 : 0; }
+  uint8_t pay[CTL_CONFIG_FIXED + 3 * CTL_MAX_MOTORS], frame[CTL_FRAME_MAX], reply[CTL_FRAME_MAX];
+  size_t pn = ctlConfigPut(cfg, ALL, pay, sizeof(pay));
+  size_t fn = ctlEncode(CTL_CONFIG, 7, ALL, pay, (uint8_t)pn, frame, sizeof(frame));
+  CtlFrame f; CtlConfig back{};
+  CHECK(fn == CTL_OVERHEAD + CTL_CONFIG_FIXED + 3 * MOTOR_COUNT);
+  CHECK(ctlDecode(frame, fn, f) && f.op == CTL_CONFIG && f.seq == 7 && f.mask == ALL);
+  CHECK(ctlConfigGet(f.payload, f.len, f.mask, back) && back.profile == RAMP_SCURVE && back.tpd[MOTOR_COUNT - 1] == 600 + MOTOR_COUNT - 1);
+  frame[CTL_HEAD] ^= 1;
+  CHECK(!ctlDecode(frame, fn, f));                                   // CRC
+  CHECK(ctl.handle(1, frame, fn, reply, sizeof(reply)) == 0 && ctl.bad() == 1);
+  frame[CTL_HEAD] ^= 1;
+
+  // ---- Server: retries, busy, version, bad frames ----
+  W::Status st{};
+  st.profile = RAMP_TRAPEZOID;
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){ st.tpd[m] = 500; st.dir[m] = 0; st.nextMs[m] = -1; }
+  status.publish(st);
+  auto result = [&](size_t n){ CtlFrame r; return n && ctlDecode(reply, n, r) && r.len ? (int)r.payload[0] : -1; };
+  uint32_t q0 = queued;
+  CHECK(result(ctl.handle(1, frame, fn, reply, sizeof(reply))) == CTL_OK);
+  CHECK(result(ctl.handle(1, frame, fn, reply, sizeof(reply))) == CTL_OK);   // the same frame again
+  CHECK(queued == q0 + 1 && ctl.repeats() == 1);
+  CHECK(result(ctl.handle(2, frame, fn, reply, sizeof(reply))) == CTL_OK);   // another client, same seq
+  CHECK(queued == q0 + 2);
+  refuse = true;
+  uint8_t start[CTL_OVERHEAD];
+  size_t sn = ctlEncode(CTL_START, 8, 0, nullptr, 0, start, sizeof(start));
+  CHECK(result(ctl.handle(1, start, sn, reply, sizeof(reply))) == CTL_BUSY);
+  refuse = false;
+  CHECK(result(ctl.handle(1, start, sn, reply, sizeof(reply))) == CTL_OK);   // the retry gets its try
+  CHECK(queued == q0 + 3);
+  uint8_t bad[CTL_FRAME_MAX], one = 5;
+  size_t bn = ctlEncode(CTL_TURBO, 9, (uint16_t)(1u << MOTOR_COUNT), &one, 1, bad, sizeof(bad));
+  CHECK(result(ctl.handle(1, bad, bn, reply, sizeof(reply))) == CTL_BAD);   // no such motor
+  bn = ctlEncode(CTL_CONFIG, 10, ALL, pay, (uint8_t)(pn - 1), bad, sizeof(bad));
+  CHECK(result(ctl.handle(1, bad, bn, reply, sizeof(reply))) == CTL_BAD);   // short payload
+  cfg.dir[0] = 2;
+  pn = ctlConfigPut(cfg, ALL, pay, sizeof(pay));
+  bn = ctlEncode(CTL_CONFIG, 11, ALL, pay, (uint8_t)pn, bad, sizeof(bad));
+  CHECK(result(ctl.handle(1, bad, bn, reply, sizeof(reply))) == CTL_BAD && queued == q0 + 3);   // no such direction
+  start[2] = CTL_VERSION + 1;
+  uint16_t crc = ctlCrc(start, sn - 2); start[sn - 2] = (uint8_t)crc; start[sn - 1] = (uint8_t)(crc >> 8);
+  CHECK(result(ctl.handle(1, start, sn, reply, sizeof(reply))) == CTL_BAD_VERSION);
+  for (W::Cmd c; cmds.pop(c);){}
+
+  // ---- Motion side, servers ----
+  MockGpio io;
+  io.level[MODE_PIN_A] = 1; io.level[MODE_PIN_B] = 1;
+  MockClock clk;
+  MockStepper mot(clk, (uint32_t)(STEP_RPM * STEPS_PER_REV / 60), 830);
+  W::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) sched.setPlan(m, MOTOR_TABLE[m].tpd, DIR_ALT);
+  clk.nowMs = hostMillis();
+  sched.begin();
+  std::atomic<bool> done{false};
+  std::atomic<uint32_t> applied{0};
+  uint32_t queued0 = queued;
+  auto publish = [&]{ W::Status s{}; sched.fillStatus(s); s.stampMs = hostMillis(); status.publish(s); };
+  publish();
+  std::thread motion([&]{
+    while (!done){
+      clk.nowMs = hostMillis();
+      for (W::Cmd c; cmds.pop(c);){ sched.apply(c); applied++; }
+      sched.poll();
+      publish();
+      std::unique_lock<std::mutex> l(wakeLock);
+      if (cmds.empty()) wake.wait_for(l, std::chrono::milliseconds(1));
+    }
+  });
+  WebHost web;
+  CtlHost bin;
+  if (!web.listen() || !bin.listen()){ perror("ctl listen"); done = true; motion.join(); return 1; }
+  std::thread server([&]{ while (!done) web.handleClient(2, restDispatch, nullptr); });
+  std::thread ctlServer([&]{ while (!done) bin.poll(2, ctlHandle, nullptr); });
+
+  // A lost reply: the client resends the same frame and the node doesn't apply it twice
+  CtlClient udp, ws;
+  CHECK(udp.udp("127.0.0.1", bin.udpPort()));
+  CHECK(ws.ws("127.0.0.1", bin.wsPort()));
+  udp.timeoutMs = 50;
+  uint32_t before = queued, rep = ctl.repeats();
+  bin.dropReplies = 1;
+  CHECK(udp.stop() == CTL_OK);
+  CHECK(udp.resends == 1 && queued == before + 1 && ctl.repeats() == rep + 1);
+
+  // ---- The same commands three ways ----
+  char config[64 + 24 * MOTOR_COUNT], turbo[16 + 12 * MOTOR_COUNT];
+  JsonOut jc(config, sizeof(config)), jt(turbo, sizeof(turbo));
+  jc.begin(); jt.begin().num("min", 5);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+    char k[6]; snprintf(k, sizeof(k), "m%u", m + 1);
+    jc.numN("tpd", m + 1, nullptr, 700).numN("dir", m + 1, nullptr, 0); jt.boolean(k, true);
+  }
+  jc.end(); jt.end();
+  CtlConfig bc{};
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){ bc.tpd[m] = 700; bc.dir[m] = 0; }
+
+  Way ways[3] = { { "JSON routes" }, { "binary UDP" }, { "binary WebSocket" } };
+  for (int i = 0; i < count; i++){
+    int op = i % 5;                                  // start, config, turbo, stop, status
+    for (int w = 0; w < 3; w++){
+      Way& way = ways[w];
+      uint64_t t0 = webNowUs();
+      long bytes = -1;
+      if (w == 0){
+        static const char* const M[] = { "POST", "POST", "POST", "POST", "GET" };
+        static const char* const P[] = { "/start", "/config", "/turbo", "/stop", "/status" };
+        bytes = rest(web.port(), M[op], P[op], op == 1 ? config : op == 2 ? turbo : nullptr);
+      } else {
+        CtlClient& c = w == 1 ? udp : ws;
+        uint64_t b0 = c.sentBytes + c.recvBytes;
+        CtlStatus s;
+        int r = op == 0 ? c.start() : op == 1 ? c.config(bc, ALL) : op == 2 ? c.turbo(ALL, 5) : op == 3 ? c.stop() : c.status(s);
+        if (r == CTL_OK) bytes = (long)(c.sentBytes + c.recvBytes - b0);
+      }
+      uint32_t us = (uint32_t)(webNowUs() - t0);
+      if (bytes < 0){ way.failed++; continue; }
+      way.us.push_back(us); way.bytes += (uint64_t)bytes;
+      if (op == 4){ way.statusBytes += (uint64_t)bytes; way.statusN++; }
+    }
+  }
+  CtlStatus last;
+  CHECK(udp.status(last) == CTL_OK && last.motors == MOTOR_COUNT);
+  done = true;
+  server.join(); ctlServer.join(); motion.join();
+  for (W::Cmd c; cmds.pop(c);) applied++;
+
+  printf("%d requests each (start, config, turbo, stop, status in turn), one at a time on loopback\n", count);
+  printf("  %-17s %9s %9s %10s %10s %7s\n", "", "p50 us", "p99 us", "bytes/cmd", "status B", "failed");
+  for (Way& w : ways){
+    size_t n = w.us.size();
+    printf("  %-17s %9u %9u %10.0f %10.0f %7u\n", w.name, pct(w.us, 500), pct(w.us, 990),
+           n ? (double)w.bytes / n : 0.0, w.statusN ? (double)w.statusBytes / w.statusN : 0.0, w.failed);
+    CHECK(w.failed == 0 && n == (size_t)count);
+  }
+  printf("  (the JSON routes also open and close a TCP connection per request)\n");
+  printf("  UDP resends %u, repeats answered from memory %u\n", udp.resends, ctl.repeats());
+  CHECK(applied == queued - queued0);
+  CHECK(ways[1].bytes * 5 < ways[0].bytes && ways[2].bytes * 5 < ways[0].bytes);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) CHECK(last.m[m].tpd == 700);
+  return fails;
+}
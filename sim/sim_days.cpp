@@ -0,0 +1,30 @@
+// Multi-day replay of WinderScheduler on the mock HAL.
+//   winder_sim days [days] [switch_mode] [tpd1 tpd2 ...]
+// Reports achieved TPD, start drift against the ideal grid and the host CPU
+// cost of scheduler passes, projected to the firmware's 2 ms pass cadence.
+// The TPD/drift checks are test/test_scheduler.
+#include <stdio.h>
+#include <stdlib.h>
+#include "replay.h"
+#include "sim.h"
+
+int simDays(int argc, char** argv){
+  int days = argc > 1 ? atoi(argv[1]) : 30;
+  int mode = argc > 2 ? atoi(argv[2]) : 1;
+  int tpd[MOTOR_COUNT];
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) tpd[m] = argc > 3 + m ? atoi(argv[3 + m]) : MOTOR_TABLE[m].tpd;
+
+  DayReplay r = replayDays(days, mode, tpd);
+  printf("%d days, switch mode %d, %llu scheduler passes simulated\n", days, mode, (unsigned long long)r.polls);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+    const DayMotor& d = r.m[m];
+    printf("  M%d: target %d TPD, achieved %.2f TPD (%llu turns, %llu steps), drift max %lld ms, final %lld ms\n",
+           m + 1, d.tpd, (double)d.turns / days, (unsigned long long)d.turns, (unsigned long long)d.steps, d.maxDrift, d.lastDrift);
+  }
+
+  double nsPerPoll = r.pollNs / r.polls;
+  double devicePollsPerDay = 86400000.0 / REPLAY_PASS_MS;
+  printf("  cpu: %.1f ns/pass on host; %.0f passes/day at a fixed %u ms -> %.2f s host CPU per simulated day (event-driven: see wrap)\n",
+         nsPerPoll, devicePollsPerDay, REPLAY_PASS_MS, nsPerPoll * devicePollsPerDay / 1e9);
+  return 0;
+}
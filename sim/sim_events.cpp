@@ -0,0 +1,154 @@
+// /events push vs 3 s /status polling, per connected client.
+//   winder_sim events [minutes] [clients]
+// Drives the real scheduler on the mock HAL (with a config change and a
+// turbo session part-way through) and feeds the same status stream to both
+// encoders. Bytes count the HTTP payload plus typical header overhead for
+// polling; handler time is host CPU in the encoder. The last client joins a
+// quarter of the way in. Checks every stream: the first event is a full
+// document, an event goes out on exactly the ticks where a field changed
+// or a due time moved (nothing across quiet stretches), a countdown is
+// re-sent at most once per STATUS_RESYNC_MS, the config change reaches
+// every client on its tick, and the socket never idles past KEEPALIVE_MS.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "config.h"
+#include "mock_hal.h"
+#include "sim.h"
+#include "winder.h"
+
+static const uint32_t TICK_MS = 250;            // firmware SSE tick
+static const uint32_t POLL_MS = 3000;           // old UI refresh()
+static const uint32_t KEEPALIVE_MS = 15000;
+static const uint32_t HTTP_OVERHEAD = 330 + 120; // browser request headers + response headers (typical)
+typedef Winder<MOTOR_COUNT> W;
+static const char NET[] = "WiFi: HomeNet (192.168.1.42) / mDNS: http://winder-1a2b3c.local";
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+// Absolute due time behind a countdown, 0 = none
+static uint64_t dueAt(int32_t relMs, uint64_t now){ return relMs < 0 ? 0 : now + (uint64_t)relMs; }
+static bool dueMoved(uint64_t a, uint64_t b){
+  return (a == 0) != (b == 0) || (a > b ? a - b : b - a) > STATUS_RESYNC_MS;
+}
+
+// Whether anything a subscriber shows differs between two ticks, worked out
+// from the status itself rather than the encoder
+static bool changed(const W::Status& a, const W::Status& b, uint64_t now){
+  if (a.enabled != b.enabled || a.switchMode != b.switchMode || a.profile != b.profile || !programSame(a.program, b.program)
+      || a.clockSet != b.clockSet || a.turboActive != b.turboActive || a.turboMask != b.turboMask
+      || a.idlePermille != b.idlePermille || a.wakeupsPerSec != b.wakeupsPerSec || a.currentMa != b.currentMa
+      || a.lightSleep != b.lightSleep) return true;
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+    if (a.tpd[m] != b.tpd[m] || a.dir[m] != b.dir[m] || a.turboTurns[m] != b.turboTurns[m] || a.turboDone[m] != b.turboDone[m]) return true;
+    if (dueMoved(dueAt(a.nextMs[m], now), dueAt(b.nextMs[m], now - TICK_MS))) return true;
+  }
+  return a.turboActive && dueMoved(dueAt(a.turboLeftMs, now), dueAt(b.turboLeftMs, now - TICK_MS));
+}
+
+static double nsSince(std::chrono::steady_clock::time_point t0){
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int simEvents(int argc, char** argv){
+  int minutes = argc > 1 ? atoi(argv[1]) : 60;
+  int clients = argc > 2 ? atoi(argv[2]) : 4;
+
+  MockClock clk;
+  MockGpio io;
+  MockStepper mot(clk, (uint32_t)(STEP_RPM * STEPS_PER_REV / 60), 830);
+  W::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) sched.setPlan(m, MOTOR_TABLE[m].tpd, DIR_ALT);
+  sched.begin();
+
+  if (clients < 1) clients = 1;
+  if (clients > 64) clients = 64;
+  W::Sent sent[64] = {};
+  uint64_t lastTx[64] = {0}, nextTx[64][MOTOR_COUNT] = {}, joinAt[64] = {0};
+  char buf[W::STATUS_JSON_MAX];
+  uint64_t pollBytes = 0, sseBytes = 0, pollCalls = 0, sseEvents = 0, sseCalls = 0;
+  double pollNs = 0, sseNs = 0;
+  const uint64_t endMs = (uint64_t)minutes * 60000ULL;
+  const uint64_t configAt = endMs / 3 / TICK_MS * TICK_MS, turboAt = endMs / 2 / TICK_MS * TICK_MS;
+  if (clients > 1) joinAt[clients - 1] = endMs / 4 / TICK_MS * TICK_MS;
+
+  int fails = 0;
+  uint32_t notFull = 0, quietEvents = 0, missed = 0, bursts = 0, configMissed = 0, changedTicks = 0;
+  uint64_t quietBytes = 0, maxGap = 0;
+  char key[16];
+  W::Status prev{};
+
+  for (uint64_t t = 0; t < endMs; t += TICK_MS){
+    clk.nowMs = t;
+    if (t == configAt){
+      W::Cmd c{}; c.op = CMD_CONFIG;
+      for (uint8_t m = 0; m < MOTOR_COUNT; m++){ c.tpd[m] = m ? 650 : 800; c.dir[m] = m ? 0 : 1; }
+      sched.apply(c);
+    }
+    if (t == turboAt){ W::Cmd c{}; c.op = CMD_TURBO; c.mask = W::ALL; c.minutes = 5; sched.apply(c); }
+    sched.poll();
+    W::Status st{};
+    sched.fillStatus(st);
+    StatusExtra x{ NET, 5, 0, 900, 0, 0, 0, "cold", 0 };
+    bool moved = t > 0 && changed(st, prev, t);
+    changedTicks += moved;
+    prev = st;
+
+    if (t % POLL_MS == 0){
+      for (int c = 0; c < clients; c++){
+        auto t0 = std::chrono::steady_clock::now();
+        JsonOut j(buf, sizeof(buf));
+        statusJsonFull(j, st, x);
+        pollNs += nsSince(t0);
+        pollBytes += j.length() + HTTP_OVERHEAD;
+        pollCalls++;
+      }
+    }
+    for (int c = 0; c < clients; c++){
+      if (t < joinAt[c]) continue;
+      auto t0 = std::chrono::steady_clock::now();
+      JsonOut j(buf, sizeof(buf));
+      bool full = !sent[c].valid;
+      bool any = full ? (statusJsonFull(j, st, x, sent[c], clk.millis()), true) : statusJsonDiff(j, sent[c], st, NET, clk.millis());
+      sseNs += nsSince(t0);
+      sseCalls++;
+      if (!full && t - lastTx[c] > maxGap) maxGap = t - lastTx[c];
+      if (full){
+        notFull += !strstr(j.c_str(), "\"network\":") || !strstr(j.c_str(), "\"boot_motion_ms\":");
+      } else {
+        if (any && !moved){ quietEvents++; quietBytes += 6 + j.length() + 2; }
+        missed += moved && !any;
+        if (t == configAt) configMissed += !any || !strstr(j.c_str(), "\"tpd1\":800");
+      }
+      for (uint8_t m = 0; any && m < MOTOR_COUNT; m++){
+        snprintf(key, sizeof(key), "\"next%u_ms\"", m + 1);
+        if (!strstr(j.c_str(), key)) continue;
+        if (!full && t - nextTx[c][m] < STATUS_RESYNC_MS) bursts++;
+        nextTx[c][m] = t;
+      }
+      if (any){ sseBytes += 6 + j.length() + 2; sseEvents++; lastTx[c] = t; }
+      else if (t - lastTx[c] >= KEEPALIVE_MS){ sseBytes += 3; lastTx[c] = t; }
+    }
+  }
+
+  double secs = minutes * 60.0;
+  printf("%d min, %d client(s); status changes: config @%d min, 5 min turbo @%d min\n", minutes, clients, minutes / 3, minutes / 2);
+  printf("  polling /status every %u ms: %8.1f B/s per client, %6.2f us CPU/s per client (%llu requests)\n",
+         POLL_MS, pollBytes / secs / clients, pollNs / 1e3 / secs / clients, (unsigned long long)pollCalls);
+  printf("  /events, %u ms tick:        %8.1f B/s per client, %6.2f us CPU/s per client (%llu events)\n",
+         TICK_MS, sseBytes / secs / clients, sseNs / 1e3 / secs / clients, (unsigned long long)sseEvents);
+  printf("  -> %.1fx fewer bytes on the wire\n", (double)pollBytes / (sseBytes ? sseBytes : 1));
+  printf("  (device CPU also drops by the per-request HTTP parse/accept cost, not modelled here)\n");
+  printf("  %u ticks with a change; events on quiet ticks %u (%llu B), changes not sent %u, countdowns re-sent within %u ms %u, longest silence %llu ms\n",
+         changedTicks, quietEvents, (unsigned long long)quietBytes, missed, STATUS_RESYNC_MS, bursts, (unsigned long long)maxGap);
+  CHECK(notFull == 0);
+  CHECK(quietEvents == 0 && quietBytes == 0);
+  CHECK(changedTicks > 0 && missed == 0);
+  CHECK(bursts == 0);
+  CHECK(configMissed == 0);
+  CHECK(maxGap <= KEEPALIVE_MS);
+  CHECK(sseBytes < pollBytes);
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
@@ -0,0 +1,238 @@
+// Fleet: beacons, the live table and command fan-out over loopback.
+//   winder_sim fleet [nodes]
+// Runs `nodes` (default 60) simulated winders on 127.0.0.1, each its own
+// HTTP port, all served by one poll() thread that answers every request
+// after a per-node handler delay (3..10 ms, roughly an ESP32 WebServer on
+// Wi-Fi). Each node beacons (unicast to the aggregator's port here, as
+// multicast loopback is not always there in a sandbox). Checks the table
+// fills and decodes, bad datagrams are dropped, stale nodes expire, every
+// node gets a fanned-out command exactly once, and a batched request
+// through the aggregator's own HTTP reaches all of them. Reports fan-out
+// latency by fleet size against sending to one node after another.
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "config.h"
+#include "fleet_host.h"
+#include "sim.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+enum { P_CONFIG, P_START, P_STOP, P_TURBO, P_COUNT };
+static const char* const PATHS[P_COUNT] = { "/config", "/start", "/stop", "/turbo" };
+
+struct SimNode {
+  int fd = -1; uint16_t port = 0; uint32_t id = 0, delayMs = 0;
+  FleetBeacon b{};
+  std::atomic<uint32_t> hits[P_COUNT];
+  std::string lastBody;
+};
+struct SimConn { int fd; SimNode* node; std::string in; uint64_t replyAt; };
+
+static std::vector<SimNode*> nodes;
+static std::atomic<bool> nodesStop{false};
+static std::mutex bodyMu;
+
+static void nodeRequest(SimConn& c){
+  char method[8] = "", path[32] = "";
+  sscanf(c.in.c_str(), "%7s %31s", method, path);
+  size_t at = c.in.find("\r\n\r\n") + 4;
+  for (int p = 0; p < P_COUNT; p++) if (!strcmp(path, PATHS[p])) c.node->hits[p]++;
+  std::lock_guard<std::mutex> g(bodyMu);
+  c.node->lastBody = c.in.substr(at);
+}
+
+// All nodes on one thread: accept, read the request, answer after the node's delay
+static void nodesThread(){
+  std::vector<SimConn> conns;
+  std::vector<pollfd> p;
+  static const char RESP[] = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 11\r\nConnection: close\r\n\r\n{\"ok\":true}";
+  while (!nodesStop){
+    p.clear();
+    for (SimNode* n : nodes) p.push_back({ n->fd, POLLIN, 0 });
+    uint64_t now = fleetNowMs(), wait = 5;
+    for (SimConn& c : conns){
+      p.push_back({ c.fd, (short)(c.replyAt ? 0 : POLLIN), 0 });
+      if (c.replyAt) wait = c.replyAt > now ? std::min<uint64_t>(wait, c.replyAt - now) : 0;
+    }
+    ::poll(p.data(), p.size(), (int)wait);
+    for (size_t i = 0; i < nodes.size(); i++){
+      if (!(p[i].revents & POLLIN)) continue;
+      int fd = accept(nodes[i]->fd, nullptr, nullptr);
+      if (fd >= 0) conns.push_back({ fd, nodes[i], std::string(), 0 });
+    }
+    now = fleetNowMs();
+    for (size_t i = 0; i < conns.size(); i++){
+      SimConn& c = conns[i];
+      size_t pi = nodes.size() + i;
+      if (!c.replyAt && pi < p.size() && (p[pi].revents & (POLLIN | POLLHUP))){
+        char buf[2048];
+        ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+        if (n > 0) c.in.append(buf, (size_t)n);
+        size_t e = c.in.find("\r\n\r\n");
+        const char* cl = strcasestr(c.in.c_str(), "content-length:");
+        if (e != std::string::npos && c.in.size() >= e + 4 + (size_t)(cl ? atol(cl + 15) : 0)){
+          nodeRequest(c); c.replyAt = now + c.node->delayMs;
+        } else if (n <= 0){ close(c.fd); c.fd = -1; continue; }
+      }
+      if (c.replyAt && now >= c.replyAt){
+        send(c.fd, RESP, sizeof(RESP) - 1, MSG_NOSIGNAL);
+        close(c.fd); c.fd = -1;
+      }
+    }
+    conns.erase(std::remove_if(conns.begin(), conns.end(), [](const SimConn& c){ return c.fd < 0; }), conns.end());
+  }
+  for (SimConn& c : conns) close(c.fd);
+}
+
+static bool nodeListen(SimNode& n){
+  n.fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in a{}; a.sin_family = AF_INET; a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (n.fd < 0 || bind(n.fd, (sockaddr*)&a, sizeof(a)) < 0 || listen(n.fd, 64) < 0) return false;
+  socklen_t l = sizeof(a); getsockname(n.fd, (sockaddr*)&a, &l); n.port = ntohs(a.sin_port);
+  return true;
+}
+
+static void beacon(int fd, uint16_t port, const uint8_t* p, size_t n){
+  sockaddr_in a{}; a.sin_family = AF_INET; a.sin_port = htons(port); a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  sendto(fd, p, n, 0, (sockaddr*)&a, sizeof(a));
+}
+
+static uint32_t hits(int p){ uint32_t n = 0; for (SimNode* s : nodes) n += s->hits[p] == 1; return n; }
+
+// Lib table on its own: expiry by age, full table
+static int tableChecks(){
+  int fails = 0;
+  static HostFleet t;
+  FleetBeacon b{};
+  for (uint32_t i = 0; i < 60; i++){ b.node = i; t.update(b, 0, 1000); }
+  for (uint32_t i = 0; i < 30; i++){ b.node = i; t.update(b, 0, 11000); }
+  CHECK(t.size() == 60 && t.expire(18000, FLEET_STALE_MS) == 30 && t.size() == 30);
+  CHECK(t.find(5) >= 0 && t.find(45) < 0 && t[t.find(5)].beacons == 2);
+  FleetTable<4> small;
+  for (uint32_t i = 0; i < 4; i++){ b.node = i; CHECK(small.update(b, 0, 0) >= 0); }
+  b.node = 9; CHECK(small.update(b, 0, 0) == -1);
+  b.node = 2; CHECK(small.update(b, 0, 0) >= 0);              // known node still updates
+  // Wire format: round trip, names, rejects
+  b = FleetBeacon{}; b.node = 0x1a2b3c; b.seq = 7; b.httpPort = 80; b.uptimeS = 86400; b.flags = FLEET_ENABLED | FLEET_TURBO;
+  b.switchMode = 2; b.turboLeftS = 299; b.motors = 2;
+  b.m[0] = FleetMotor{ 650, 1, 1, 12 }; b.m[1] = FleetMotor{ -1, -1, 0, 0xFFFF };
+  uint8_t pkt[FLEET_BEACON_MAX]; FleetBeacon d{};
+  size_t n = fleetEncode(b, pkt, sizeof(pkt));
+  CHECK(n == fleetBeaconSize(2) && fleetDecode(pkt, n, d));
+  CHECK(d.node == b.node && d.seq == 7 && d.uptimeS == 86400 && d.turboLeftS == 299 && d.m[0].tpd == 650 && d.m[1].dir == -1 && d.m[1].nextS == 0xFFFF);
+  CHECK(!fleetDecode(pkt, n - 1, d) && !fleetChanged(b, d));
+  pkt[2] = FLEET_VERSION + 1; CHECK(!fleetDecode(pkt, n, d));
+  CHECK(fleetEncode(b, pkt, n - 1) == 0);
+  char name[FLEET_NAME_MAX]; fleetName(0xAB1a2b3c, name, sizeof(name));
+  CHECK(!strcmp(name, "winder-1a2b3c"));
+  return fails;
+}
+
+int simFleet(int argc, char** argv){
+  size_t count = argc > 1 ? (size_t)atoi(argv[1]) : 60;
+  if (count < 1 || count > FLEET_HOST_NODES) count = 60;
+  int fails = tableChecks();
+
+  nodes.clear();
+  for (size_t i = 0; i < count; i++){
+    SimNode* n = new SimNode;
+    for (auto& h : n->hits) h = 0;
+    n->id = 0x100000 + (uint32_t)i * 0x1011; n->delayMs = 3 + (uint32_t)(i * 37) % 8;
+    if (!nodeListen(*n)){ printf("  cannot listen on loopback\n"); return 1; }
+    n->b.node = n->id; n->b.httpPort = n->port; n->b.uptimeS = (uint32_t)i * 60; n->b.flags = FLEET_ENABLED;
+    n->b.switchMode = (uint8_t)(i % 4); n->b.motors = MOTOR_COUNT;
+    for (uint8_t m = 0; m < MOTOR_COUNT; m++) n->b.m[m] = FleetMotor{ (int16_t)(600 + i), (int8_t)(m & 1 ? -1 : 1), 0, (uint16_t)(i + m) };
+    nodes.push_back(n);
+  }
+  nodesStop = false;
+  std::thread srv(nodesThread);
+
+  FleetHost* host = new FleetHost;
+  CHECK(host->listen(0, false) && host->serve(0));
+  int tx = socket(AF_INET, SOCK_DGRAM, 0);
+  uint8_t pkt[FLEET_BEACON_MAX];
+  for (SimNode* n : nodes) beacon(tx, host->beaconPort(), pkt, fleetEncode(n->b, pkt, sizeof(pkt)));
+  beacon(tx, host->beaconPort(), (const uint8_t*)"GET / HTTP/1.1\r\n\r\n", 18);  // not a beacon
+  for (uint64_t end = fleetNowMs() + 2000; host->table().size() < count && fleetNowMs() < end;) host->poll(10);
+  host->poll(10);
+  const HostFleet& t = host->table();
+  bool same = t.size() == count;
+  for (SimNode* n : nodes){
+    int i = t.find(n->id);
+    if (i < 0){ same = false; continue; }
+    const FleetNode& e = t[(uint16_t)i];
+    same &= e.ip == htonl(INADDR_LOOPBACK) && e.b.httpPort == n->port && e.b.switchMode == n->b.switchMode
+         && e.b.m[MOTOR_COUNT - 1].tpd == n->b.m[MOTOR_COUNT - 1].tpd && e.b.m[1].dir == -1;
+  }
+  printf("  %zu nodes beaconing, table %u, bad datagrams dropped %u\n", count, t.size(), host->badBeacons());
+  CHECK(same);
+  CHECK(host->badBeacons() == 1);
+
+  // Fan-out through the table: every node once, same body
+  static char report[1 << 18];
+  const char* turbo = "{\"min\":5,\"m1\":true,\"m2\":true}";
+  FanStats fan = host->command("turbo", turbo, report, sizeof(report));
+  bool bodies = true;
+  { std::lock_guard<std::mutex> g(bodyMu); for (SimNode* n : nodes) bodies &= n->lastBody == turbo; }
+  CHECK(fan.ok == count && hits(P_TURBO) == count && bodies);
+
+  // Same command one node after another
+  static FanTarget tg[FLEET_HOST_NODES];
+  static FanResult rs[FLEET_HOST_NODES];
+  size_t nt = host->targets(tg, FLEET_HOST_NODES);
+  uint64_t t0 = fleetNowUs();
+  bool seqOk = true;
+  for (size_t i = 0; i < nt; i++) seqOk &= fleetFanOut(&tg[i], 1, "POST", "/stop", "", &rs[i]).ok == 1;
+  uint32_t seqUs = (uint32_t)(fleetNowUs() - t0);
+  CHECK(seqOk && hits(P_STOP) == count);
+  printf("  /turbo to %zu nodes: %.1f ms (p50 %.1f, p99 %.1f ms); one after another %.1f ms, %.1fx\n", count,
+         fan.totalUs / 1000.0, fan.p50Us / 1000.0, fan.p99Us / 1000.0, seqUs / 1000.0, (double)seqUs / fan.totalUs);
+  CHECK(fan.totalUs * 4 < seqUs);
+
+  // Latency by fleet size
+  for (size_t k : { (size_t)1, (size_t)10, (size_t)25, (size_t)50, nt }){
+    if (k > nt) continue;
+    FanStats s = fleetFanOut(tg, k, "POST", "/config", "{\"profile\":\"scurve\"}", rs);
+    printf("  fan-out %3zu node(s): total %6.1f ms, p50 %5.1f ms, p99 %5.1f ms, %u ok\n",
+           k, s.totalUs / 1000.0, s.p50Us / 1000.0, s.p99Us / 1000.0, s.ok);
+    CHECK(s.ok == k);
+  }
+
+  // Batched request through the aggregator's HTTP; table served as JSON
+  std::atomic<bool> serving{true};
+  std::thread agg([&]{ while (serving) host->poll(5); });
+  FanTarget self{ htonl(INADDR_LOOPBACK), host->httpPort(), 0 };
+  static char resp[1 << 18];
+  FanResult r{}; r.resp = resp; r.respCap = sizeof(resp);
+  fleetFanOut(&self, 1, "POST", "/fleet/start", "", &r, 5000);
+  char want[32]; snprintf(want, sizeof(want), "\"ok\":%zu,", count);
+  printf("  POST /fleet/start: HTTP %d in %.1f ms\n", r.status, r.us / 1000.0);
+  CHECK(r.status == 200 && strstr(resp, want) && hits(P_START) == count);
+  fleetFanOut(&self, 1, "GET", "/fleet", nullptr, &r, 5000);
+  size_t listed = 0;
+  for (const char* p = resp; (p = strstr(p, "\"node\":\"winder-")); p++) listed++;
+  CHECK(r.status == 200 && listed == count);
+  fleetFanOut(&self, 1, "POST", "/fleet/reboot", "", &r, 5000);
+  CHECK(r.status == 404);
+  serving = false; agg.join();
+
+  nodesStop = true; srv.join();
+  close(tx);
+  delete host;
+  for (SimNode* n : nodes){ close(n->fd); delete n; }
+  nodes.clear();
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
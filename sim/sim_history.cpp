@@ -0,0 +1,153 @@
+// Odometer and hourly history on the mock HAL.
+//   winder_sim history [days]
+// Replays `days` (default 70) of scheduling with a stop, turbo sessions, a
+// TPD change mid-run and a long stop, closing an OdoHistory bucket every
+// hour from the status snapshot as the firmware's web task does. Checks the
+// odometer against the HAL (cw + ccw = turns, steps = steps made, turbo =
+// the planned whole rotations, skipped slots = the stopped time) and every
+// decoded bucket against a plain copy, across eviction; reports bytes per
+// hour and how many days the ring holds.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "config.h"
+#include "mock_hal.h"
+#include "odometer.h"
+#include "sim.h"
+#include "winder.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+typedef Winder<MOTOR_COUNT> W;
+typedef OdoHistory<MOTOR_COUNT, HISTORY_BYTES> History;
+static const uint64_t HOUR = 3600000ULL, DAY = 24 * HOUR;
+static const uint32_t PASS_MS = 2;
+
+struct Row { uint32_t v[MOTOR_COUNT][ODO_FIELDS]; };
+
+int simHistory(int argc, char** argv){
+  int days = argc > 1 ? atoi(argv[1]) : 70;   // long enough for the ring to wrap
+  if (days < 12) days = 12;
+  int fails = 0;
+
+  uint32_t sps = (uint32_t)(STEP_RPM * STEPS_PER_REV / 60);
+  MockClock clk;
+  MockGpio io;
+  MockStepper mot(clk, sps, 830);
+  io.level[MODE_PIN_A] = 1; io.level[MODE_PIN_B] = 1;
+  W::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) sched.setPlan(m, MOTOR_TABLE[m].tpd, DIR_ALT);
+  clk.nowMs = 1000;
+  sched.begin();
+
+  // Script (ms from boot): a 5 h stop on day 2, turbo on days 4 and 6 (the
+  // second one on motor 1 only), TPD 500 from day 8, a 30 h stop from day 10
+  const uint64_t STOP1 = 2 * DAY + 6 * HOUR, START1 = STOP1 + 5 * HOUR;
+  const uint64_t TURBO1 = 4 * DAY + 9 * HOUR + 1234, TURBO2 = 6 * DAY + 20 * HOUR;
+  const uint64_t CONFIG = 8 * DAY + 12 * HOUR + 777;
+  const uint64_t STOP2 = 10 * DAY + 3 * HOUR, START2 = STOP2 + 30 * HOUR;
+  const int NEW_TPD = 500;
+  uint64_t script[] = { STOP1, START1, TURBO1, TURBO2, CONFIG, STOP2, START2 };
+  size_t next = 0;
+
+  History hist;
+  W::Status st{};
+  sched.fillStatus(st);
+  hist.reset(st.odo, (uint32_t)STEPS_PER_REV);
+  std::vector<Row> ref;
+  OdoCounters lastClose[MOTOR_COUNT];
+  memcpy(lastClose, st.odo, sizeof(lastClose));
+  uint64_t nextHour = HOUR;
+  uint32_t turboPlan[MOTOR_COUNT] = {0};
+
+  const uint64_t endMs = (uint64_t)days * DAY;
+  while (clk.nowMs < endMs){
+    while (next < sizeof(script) / sizeof(script[0]) && script[next] <= clk.nowMs){
+      uint64_t at = script[next++];
+      W::Cmd c{};
+      if (at == STOP1 || at == STOP2) c.op = CMD_STOP;
+      else if (at == START1 || at == START2) c.op = CMD_START;
+      else if (at == TURBO1 || at == TURBO2){ c.op = CMD_TURBO; c.minutes = 20; c.mask = at == TURBO1 ? W::ALL : 1; }
+      else {
+        c.op = CMD_CONFIG; c.program = sched.program();
+        for (uint8_t m = 0; m < MOTOR_COUNT; m++){ c.tpd[m] = NEW_TPD; c.dir[m] = DIR_ALT; }
+      }
+      sched.apply(c);
+      sched.poll();
+      if (c.op == CMD_TURBO) for (uint8_t m = 0; m < MOTOR_COUNT; m++) if (c.mask & (1u << m)) turboPlan[m] += sched.turboTurns(m);
+    }
+    sched.poll();
+
+    if (clk.nowMs >= nextHour){
+      sched.fillStatus(st);
+      Row r;
+      for (uint8_t m = 0; m < MOTOR_COUNT; m++)
+        for (uint8_t f = 0; f < ODO_FIELDS; f++) r.v[m][f] = f == ODO_TPD ? st.odo[m].v[f] : st.odo[m].v[f] - lastClose[m].v[f];
+      memcpy(lastClose, st.odo, sizeof(lastClose));
+      ref.push_back(r);
+      CHECK(hist.follows(st.odo));
+      hist.close(st.odo);
+      nextHour += HOUR;
+    }
+
+    uint64_t t = nextHour;
+    if (next < sizeof(script) / sizeof(script[0]) && script[next] < t) t = script[next];
+    if (sched.nextEventMs() < t) t = sched.nextEventMs();
+    for (uint8_t m = 0; m < MOTOR_COUNT; m++)
+      if (mot.busyUntil(m) > clk.nowMs && mot.busyUntil(m) < t) t = mot.busyUntil(m);
+    if (t < clk.nowMs + PASS_MS) t = clk.nowMs + PASS_MS;
+    clk.nowMs = (t + PASS_MS - 1) / PASS_MS * PASS_MS;
+  }
+  while (mot.busyUntil(0) > clk.nowMs || (MOTOR_COUNT > 1 && mot.busyUntil(MOTOR_COUNT - 1) > clk.nowMs)) clk.nowMs += PASS_MS;
+  sched.poll();
+  sched.fillStatus(st);
+
+  // ---- Odometer against the HAL and the script ----
+  printf("%d days: stop 5 h (day 2), turbo 20 min x2, TPD %d from day 8, stop 30 h (day 10)\n", days, NEW_TPD);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+    const uint32_t* v = sched.odometer(m).v;
+    // Every slot of the plan is either turned or skipped; stops and turbo
+    // keep the grid, the TPD change restarts it and may drop a fraction of a slot
+    double slots = (CONFIG - 1000) * MOTOR_TABLE[m].tpd / (double)DAY + (clk.nowMs - CONFIG) * NEW_TPD / (double)DAY;
+    printf("  M%d: cw %u ccw %u turbo %u (planned %u) missed %u late %u steps %u (HAL %u); turned + skipped %u of %.1f slots\n",
+           m + 1, v[ODO_CW], v[ODO_CCW], v[ODO_TURBO], turboPlan[m], v[ODO_MISSED], v[ODO_LATE], v[ODO_STEPS],
+           mot.stepsMade(m), sched.turns(m) + v[ODO_MISSED], slots);
+    CHECK(v[ODO_CW] + v[ODO_CCW] == sched.turns(m));
+    CHECK(v[ODO_CW] - v[ODO_CCW] + 1 <= 2);                             // alternating
+    CHECK(v[ODO_STEPS] == mot.stepsMade(m));
+    CHECK(v[ODO_TURBO] == turboPlan[m]);
+    CHECK((uint64_t)(v[ODO_CW] + v[ODO_CCW] + v[ODO_TURBO]) * STEPS_PER_REV == v[ODO_STEPS]);
+    CHECK(fabs(sched.turns(m) + v[ODO_MISSED] - slots) <= 5);
+    CHECK(v[ODO_MISSED] >= (START1 - STOP1 + START2 - STOP2) * NEW_TPD / DAY);
+    CHECK(v[ODO_LATE] >= 2 && v[ODO_LATE] <= 4);                        // after each stop and turbo
+  }
+
+  // ---- History against the plain copy ----
+  uint32_t total[MOTOR_COUNT][ODO_FIELDS] = {};
+  size_t first = ref.size() - hist.hours();
+  int bad = 0;
+  hist.each([&](uint16_t i, const History::Bucket& b){
+    if (memcmp(b, ref[first + i].v, sizeof(b))) bad++;
+  });
+  for (const Row& r : ref)
+    for (uint8_t m = 0; m < MOTOR_COUNT; m++) for (uint8_t f = 0; f < ODO_TPD; f++) total[m][f] += r.v[m][f];
+  History::Bucket open;
+  hist.open(st.odo, open);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++)
+    for (uint8_t f = 0; f < ODO_TPD; f++) CHECK(total[m][f] + open[m][f] == st.odo[m].v[f]);
+  CHECK(bad == 0);
+  CHECK(hist.hours() < ref.size());                                  // the ring wrapped
+  CHECK(hist.bytes() <= hist.capacity());
+  double perHour = (double)hist.bytes() / hist.hours();
+  printf("  history: %zu hours closed, %u kept in %u of %u bytes (%.2f B/hour, %.1f days), %d bucket(s) differ\n",
+         ref.size(), hist.hours(), hist.bytes(), hist.capacity(), perHour, hist.hours() / 24.0, bad);
+  printf("  plain buckets would take %zu bytes for the same hours\n", (size_t)hist.hours() * sizeof(Row));
+  CHECK(hist.hours() >= 30 * 24);                                    // a month fits
+
+  // Lost totals (cold start) are caught before they would close a bucket
+  OdoCounters zero[MOTOR_COUNT] = {};
+  CHECK(!hist.follows(zero));
+  return fails;
+}
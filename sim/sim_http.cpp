@@ -0,0 +1,220 @@
+// HTTP load on the route handlers (web_routes.h) through a loopback
+// stand-in for WebServer (web_host.h), with the motion side running.
+//   winder_sim http [clients] [seconds]
+// N clients in a closed loop send a mix of /status, /, /config and /turbo;
+// the server answers one client at a time, as WebServer does, and a motion
+// thread drains the command ring and publishes status every 2 ms. Reports
+// throughput and p50/p99/p999 latency per route. The server's busy spans
+// (accept to close) are then replayed against the step engine in virtual
+// time for the two layouts: handlers and step service sharing one loop
+// (as loop() did), where a step due during a handler waits for it, and the
+// firmware's now (motion on the other core, step timer ISR), where they
+// don't. Step error is each step's interval against the planned one, as
+// /metrics step_error_us measures it on the board.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "config.h"
+#include "mock_hal.h"
+#include "sim.h"
+#include "web_host.h"
+#include "winder.h"
+
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#if __has_include("ui_index.h")
+#include "ui_index.h"                  // tools/build_ui.py output
+#else
+static const char UI_INDEX_ETAG[] = "\"sim\"";
+static const size_t UI_INDEX_GZ_LEN = 5300;
+static const uint8_t UI_INDEX_GZ[UI_INDEX_GZ_LEN] = {};
+#endif
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+typedef Winder<MOTOR_COUNT> W;
+static const int HTTP_TPD = 700;
+static const uint32_t PASS_US = 2000;
+
+// ---------- Motion side ----------
+class HostClock : public Clock {
+public:
+  uint64_t millis() override { return (webNowUs() - t0) / 1000 + 1; }
+  uint64_t t0 = webNowUs();
+};
+
+static W::CmdRing cmds;
+static W::StatusLock status;
+static std::atomic<uint32_t> queued{0};
+static char respBuf[W::STATUS_JSON_MAX > 1024 ? W::STATUS_JSON_MAX : 1024];
+static HostClock hostClock;
+
+static bool queueCmd(const W::Cmd& c){ if (!cmds.push(c)) return false; queued++; return true; }
+static StatusExtra extra(char* net){
+  snprintf(net, STATUS_NET_MAX, "STA 127.0.0.1 (sim)");
+  return StatusExtra{ net, 0, 0, 0, 0, 0, 0, "cold", 0 };
+}
+static uint32_t hostMillis(){ return (uint32_t)hostClock.millis(); }
+static const WebHooks<MOTOR_COUNT> hooks = { queueCmd, extra, hostMillis, UI_INDEX_GZ, UI_INDEX_GZ_LEN, UI_INDEX_ETAG };
+static WebRoutes<MOTOR_COUNT> routes(status, hooks, respBuf, sizeof(respBuf));
+
+static bool dispatch(const WebReq& r, WebResp& o, void*){ return routes.dispatch(r, o); }
+
+// One request straight through the handlers, no socket
+struct CaptureResp : WebResp {
+  int code = 0; char body[64] = {};
+  void header(const char*, const char*) override {}
+  void send(int c, const char*, const char* b, size_t n) override { code = c; snprintf(body, sizeof(body), "%.*s", (int)n, b); }
+};
+
+// ---------- Step replay ----------
+static uint64_t replayNowUs;
+static uint64_t stepAtUs[MOTOR_COUNT];
+static uint32_t stepPlanQ[MOTOR_COUNT];
+static std::vector<uint32_t> stepErr;
+static W::Engine* replayEngine;
+
+static void onCoils(MotorMask changed, const uint8_t*){
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+    if (!(changed & (1u << m))) continue;
+    if (stepPlanQ[m]){
+      uint32_t actual = (uint32_t)(replayNowUs - stepAtUs[m]), plan = (uint32_t)(((uint64_t)stepPlanQ[m] * STEP_TICK_US) >> 16);
+      stepErr.push_back(actual > plan ? actual - plan : plan - actual);
+    }
+    stepAtUs[m] = replayNowUs; stepPlanQ[m] = replayEngine->intervalQ(m);
+  }
+}
+
+struct Busy { uint64_t at, us; };
+struct StepStats { uint32_t p50, p99, max; uint64_t steps; };
+
+static uint32_t pct(std::vector<uint32_t>& v, unsigned perMille){
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[(v.size() - 1) * perMille / 1000];
+}
+
+// Every motor turning for `lenUs`. Shared loop: a tick due inside a busy
+// span runs once at its end (later ticks are lost, as with a polled
+// stepper); otherwise the timer ticks on schedule.
+static StepStats replay(const std::vector<Busy>& busy, uint64_t t0, uint64_t lenUs, bool shared){
+  W::Engine e(onCoils);
+  replayEngine = &e;
+  uint32_t sps = (uint32_t)(STEP_RPM * STEPS_PER_REV / 60);
+  e.setSpeed(sps, 100, sps * 5 / 12);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){ e.move(m, (int32_t)(lenUs / 1000 * sps / 1000 + STEPS_PER_REV)); stepPlanQ[m] = 0; }
+  stepErr.clear();
+  size_t b = 0;
+  uint64_t steps = 0;
+  for (uint64_t t = 0; t < lenUs; t += STEP_TICK_US){
+    if (shared){
+      while (b < busy.size() && busy[b].at + busy[b].us - t0 <= t) b++;
+      if (b < busy.size() && busy[b].at - t0 <= t) t = busy[b].at + busy[b].us - t0;
+    }
+    replayNowUs = t;
+    e.tick();
+  }
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) steps += (uint64_t)e.position(m);
+  StepStats s{ pct(stepErr, 500), pct(stepErr, 990), 0, steps };
+  s.max = stepErr.empty() ? 0 : stepErr.back();
+  return s;
+}
+
+int simHttp(int argc, char** argv){
+  uint16_t clients = argc > 1 ? (uint16_t)atoi(argv[1]) : 4;
+  double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+  if (clients < 1) clients = 1;
+  int fails = 0;
+
+  // Motion task stand-in: commands in, status out, every 2 ms
+  MockGpio io;
+  io.level[MODE_PIN_A] = 1; io.level[MODE_PIN_B] = 1;
+  MockClock motClk;
+  MockStepper mot(motClk, (uint32_t)(STEP_RPM * STEPS_PER_REV / 60), 830);
+  W::Scheduler sched(motClk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) sched.setPlan(m, MOTOR_TABLE[m].tpd, DIR_ALT);
+  motClk.nowMs = hostClock.millis();
+  sched.begin();
+  std::atomic<bool> done{false};
+  uint32_t applied = 0;
+  auto publish = [&]{ W::Status st{}; sched.fillStatus(st); st.stampMs = (uint32_t)hostClock.millis(); status.publish(st); };
+  publish();
+
+  // A direction outside -1..1 is refused, not mapped to Alternate
+  static const char BAD_DIR[] = "{\"dir1\":2}";
+  CaptureResp cr;
+  routes.dispatch(WebReq{ WEB_POST, "/config", BAD_DIR, sizeof(BAD_DIR) - 1, "" }, cr);
+  CHECK(cr.code == 400 && !strcmp(cr.body, "{\"ok\":false,\"err\":\"dir\"}") && queued == 0);
+
+  std::thread motion([&]{
+    while (!done){
+      motClk.nowMs = hostClock.millis();
+      W::Cmd c;
+      while (cmds.pop(c)){ sched.apply(c); applied++; }
+      sched.poll();
+      publish();
+      std::this_thread::sleep_for(std::chrono::microseconds(PASS_US));
+    }
+  });
+
+  WebHost host;
+  if (!host.listen()){ perror("http listen"); done = true; motion.join(); return 1; }
+  std::vector<Busy> busy;
+  std::thread server([&]{
+    while (!done) if (host.handleClient(5, dispatch, nullptr)) busy.push_back(Busy{ host.lastAtUs(), host.lastUs() });
+  });
+
+  char config[64 + 24 * MOTOR_COUNT], turbo[16 + 12 * MOTOR_COUNT];
+  JsonOut jc(config, sizeof(config)), jt(turbo, sizeof(turbo));
+  jc.begin(); jt.begin().num("min", 5);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){ char k[6]; snprintf(k, sizeof(k), "m%u", m + 1);
+    jc.numN("tpd", m + 1, nullptr, HTTP_TPD).numN("dir", m + 1, nullptr, 0); jt.boolean(k, m < 2);
+  }
+  jc.end(); jt.end();
+  static const char* const NAMES[] = { "/status", "/", "/config", "/turbo" };
+  const LoadReq mix[] = { { "GET", "/status", nullptr, 55 }, { "GET", "/", nullptr, 20 },
+                          { "POST", "/config", config, 15 }, { "POST", "/turbo", turbo, 10 } };
+  uint64_t t0 = webNowUs();
+  LoadResult r = webLoad(host.port(), mix, 4, clients, seconds, 12345);
+  uint64_t lenUs = webNowUs() - t0;
+  done = true;
+  server.join(); motion.join();
+  for (W::Cmd c; cmds.pop(c);) applied++;
+
+  // ---- Latency ----
+  printf("%u client(s), %.1f s: %u requests (%.0f/s), %u busy (command ring full), %u failed\n",
+         clients, r.seconds, r.ok + r.busy + r.failed, r.ok / r.seconds, r.busy, r.failed);
+  std::vector<uint32_t> all;
+  for (int k = 0; k < 4; k++){
+    std::vector<uint32_t>& v = r.us[k];
+    all.insert(all.end(), v.begin(), v.end());
+    printf("  %-8s %6zu  p50 %7.2f  p99 %7.2f  p999 %7.2f ms\n", NAMES[k], v.size(),
+           pct(v, 500) / 1000.0, pct(v, 990) / 1000.0, pct(v, 999) / 1000.0);
+  }
+  printf("  %-8s %6zu  p50 %7.2f  p99 %7.2f  p999 %7.2f ms\n", "all", all.size(),
+         pct(all, 500) / 1000.0, pct(all, 990) / 1000.0, pct(all, 999) / 1000.0);
+  uint64_t busyUs = 0; uint32_t longest = 0;
+  for (const Busy& b : busy){ busyUs += b.us; if (b.us > longest) longest = b.us; }
+  printf("  server busy %.0f%% of the run, longest client %.2f ms\n", 100.0 * busyUs / lenUs, longest / 1000.0);
+
+  // ---- Step timing in both layouts ----
+  StepStats shared = replay(busy, t0, lenUs, true), split = replay(busy, t0, lenUs, false);
+  printf("  steps, handlers in the stepping loop:  %7llu, error p50 %u us, p99 %u us, max %u us\n",
+         (unsigned long long)shared.steps, shared.p50, shared.p99, shared.max);
+  printf("  steps, motion core + step timer (now): %7llu, error p50 %u us, p99 %u us, max %u us\n",
+         (unsigned long long)split.steps, split.p50, split.p99, split.max);
+
+  // Every request answered, every queued command reached the motion side
+  W::Status st; status.read(st);
+  CHECK(r.failed == 0 && r.ok > 0);
+  CHECK(applied == queued);
+  if (!r.us[2].empty()) for (uint8_t m = 0; m < MOTOR_COUNT; m++) CHECK(st.tpd[m] == HTTP_TPD);
+  CHECK(split.max <= STEP_TICK_US);                 // the timer alone: within one tick
+  CHECK(shared.steps <= split.steps);
+  return fails;
+}
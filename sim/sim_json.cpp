@@ -0,0 +1,93 @@
+// Request/response JSON: JsonIn parsing checks, worst-case response size
+// against the Winder<N>::STATUS_JSON_MAX bound the firmware static_asserts on
+// (for the configured motor count and for 16), and a
+// heap-allocation count around the encode/parse paths (must be zero).
+//   winder_sim json
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+#include "json_in.h"
+#include "config.h"
+#include "sim.h"
+#include "winder.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+// Count every heap allocation in the simulator process
+static std::atomic<uint32_t> allocs{0};
+void* operator new(size_t n){ allocs++; if (void* p = malloc(n ? n : 1)) return p; throw std::bad_alloc(); }
+void* operator new[](size_t n){ allocs++; if (void* p = malloc(n ? n : 1)) return p; throw std::bad_alloc(); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+static JsonIn in(const char* s){ return JsonIn(s, strlen(s)); }
+
+static int parseChecks(){
+  int fails = 0;
+  char s[65];
+  CHECK(in("{}").ok() && !in("{}").has("a"));
+  CHECK(!in("").ok() && !in("[1]").ok() && !in("{\"a\":}").ok() && !in("{\"a\":1,}").ok() && !in("{\"a\":1").ok());
+
+  JsonIn c = in(" {\"tpd1\": 800, \"dir1\":-1 ,\"tpd2\":12.5,\"x\":{\"tpd2\":1,\"y\":[1,{\"z\":\"}\"}]},\"dir2\":\"1\"} ");
+  CHECK(c.ok());
+  CHECK(c.num("tpd1", 0) == 800 && c.num("dir1", 0) == -1);
+  CHECK(c.num("tpd2", 7) == 7);                 // not an integer
+  CHECK(c.num("dir2", 7) == 7);                 // string, not a number
+  CHECK(c.num("y", 7) == 7 && !c.has("z"));     // nested keys are not top-level
+  CHECK(in("{\"a\":99999999999}").num("a", 5) == 5);
+
+  JsonIn t = in("{\"m1\":true,\"m2\":false,\"min\":10}");
+  CHECK(t.boolean("m1", false) && !t.boolean("m2", true) && t.boolean("m3", true) && t.num("min", 5) == 10);
+
+  JsonIn w = in("{\"ssid\":\"Caf\\u00e9 \\\"5G\\\"\",\"pass\":\"p\\\\w\\/d\"}");
+  CHECK(w.str("ssid", s, sizeof(s)) && !strcmp(s, "Caf\xc3\xa9 \"5G\""));
+  CHECK(w.str("pass", s, sizeof(s)) && !strcmp(s, "p\\w/d"));
+  CHECK(!w.str("ssid", s, 4));                  // too long for the buffer
+  CHECK(!w.str("none", s, sizeof(s)) && !in("{\"ssid\":1}").str("ssid", s, sizeof(s)));
+  CHECK(!in("{\"s\":\"\\u00\"}").str("s", s, sizeof(s)));
+  return fails;
+}
+
+template <uint8_t N>
+static int sizeChecks(){
+  typedef Winder<N> W;
+  int fails = 0;
+  static char buf[W::STATUS_JSON_MAX], diff[W::STATUS_JSON_MAX];
+  char net[STATUS_NET_MAX];
+  memset(net, 0x01, sizeof(net) - 1); net[sizeof(net) - 1] = 0;   // every byte escapes to \u0001
+
+  typename W::Status st{};
+  st.enabled = 1; st.switchMode = 255; st.turboActive = 1; st.turboMask = W::ALL;
+  for (int m = 0; m < N; m++){ st.tpd[m] = INT16_MIN; st.dir[m] = INT8_MIN; st.nextMs[m] = INT32_MIN; }
+  st.turboLeftMs = INT32_MIN;
+  st.idlePermille = st.wakeupsPerSec = st.currentMa = UINT16_MAX; st.lightSleep = 1;
+  st.program = WindProgram{ UINT16_MAX, UINT16_MAX, UINT16_MAX }; st.clockSet = 1;
+  StatusExtra x{ net, UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX, "checkpoint", UINT32_MAX };
+
+  uint32_t a0 = allocs;
+  JsonOut j(buf, sizeof(buf));
+  statusJsonFull(j, st, x);
+  typename W::Sent sent{};
+  JsonOut d(diff, sizeof(diff));
+  statusJsonDiff(d, sent, st, net, 12345);
+  JsonIn r = in("{\"tpd1\":800,\"ssid\":\"HomeNet\"}");
+  char s[33];
+  bool parsed = r.num("tpd1", 0) == 800 && r.str("ssid", s, sizeof(s));
+  uint32_t used = allocs - a0;
+
+  CHECK(j.ok() && d.ok() && parsed);
+  CHECK(used == 0);
+  printf("  %2u motors: /status worst case %zu B, bound %zu B; heap allocations in encode/parse: %u\n",
+         N, j.length() + 1, W::STATUS_JSON_MAX, used);
+  return fails;
+}
+
+int simJson(int, char**){
+  int fails = parseChecks() + sizeChecks<MOTOR_COUNT>() + sizeChecks<WINDER_MAX_MOTORS>();
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
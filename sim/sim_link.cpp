@@ -0,0 +1,84 @@
+// Web <-> motion link: SPSC command ring and seqlock status snapshot.
+// Basic behaviour checks, then a two-thread stress run that verifies ordering
+// through the ring and that no reader ever observes a torn snapshot.
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "config.h"
+#include "motion_link.h"
+#include "sim.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+static int basicChecks(){
+  int fails = 0;
+  SpscRing<int, 4> r;
+  int v = 0;
+  CHECK(r.empty() && !r.pop(v));
+  for (int i = 0; i < 4; i++) CHECK(r.push(i));
+  CHECK(!r.push(99));                       // full
+  CHECK(r.size() == 4);
+  for (int i = 0; i < 4; i++){ CHECK(r.pop(v)); CHECK(v == i); }
+  CHECK(!r.pop(v));
+  for (int i = 0; i < 10; i++){ CHECK(r.push(i)); CHECK(r.pop(v) && v == i); }   // index wrap
+
+  Seqlock<MotionStatus<MOTOR_COUNT>> lock;
+  MotionStatus<MOTOR_COUNT> a{}, b{};
+  a.enabled = 1; a.tpd[0] = 650; a.nextMs[1] = 123456; a.turboLeftMs = -1;
+  lock.publish(a);
+  CHECK(lock.read(b) == 0);
+  CHECK(b.enabled == 1 && b.tpd[0] == 650 && b.nextMs[1] == 123456 && b.turboLeftMs == -1);
+  CHECK(lock.sequence() == 2);
+  return fails;
+}
+
+struct Wide { uint32_t w[16]; };   // every word equal when consistent
+
+static int stress(uint32_t n){
+  int fails = 0;
+  SpscRing<uint32_t, 16> ring;
+  std::atomic<bool> orderOk{true};
+  auto t0 = std::chrono::steady_clock::now();
+  std::thread cons([&]{
+    uint32_t want = 0, v;
+    while (want < n){ if (ring.pop(v)){ if (v != want) orderOk = false; want++; } else std::this_thread::yield(); }
+  });
+  for (uint32_t i = 0; i < n; ){ if (ring.push(i)) i++; else std::this_thread::yield(); }
+  cons.join();
+  double ringNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+  CHECK(orderOk);
+
+  Seqlock<Wide> lock;
+  std::atomic<bool> done{false}, torn{false};
+  std::atomic<uint64_t> reads{0}, retries{0};
+  auto reader = [&]{
+    Wide w;
+    while (!done){
+      retries += lock.read(w);
+      for (int i = 1; i < 16; i++) if (w.w[i] != w.w[0]) torn = true;
+      reads++;
+      std::this_thread::yield();
+    }
+  };
+  std::thread r1(reader), r2(reader);
+  Wide w;
+  for (uint32_t i = 0; i < n; i++){ for (auto& x : w.w) x = i; lock.publish(w); if ((i & 63) == 0) std::this_thread::yield(); }
+  done = true;
+  r1.join(); r2.join();
+  CHECK(!torn);
+
+  printf("  ring: %u msgs in order, %.1f ns/msg\n", n, ringNs);
+  printf("  seqlock: %u publishes, %llu reads, %llu retries, torn=%d\n", n,
+         (unsigned long long)reads.load(), (unsigned long long)retries.load(), (int)torn.load());
+  return fails;
+}
+
+int simLink(int argc, char** argv){
+  uint32_t n = argc > 1 ? (uint32_t)atoi(argv[1]) : 1000000;
+  int fails = basicChecks();
+  fails += stress(n);
+  printf("link: %s\n", fails ? "FAIL" : "ok");
+  return fails;
+}
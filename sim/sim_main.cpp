@@ -0,0 +1,51 @@
+// Host simulator entry point (PlatformIO env:native).
+//   pio run -e native && .pio/build/native/program <scenario|all>
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+
+struct Scenario { const char* name; int (*run)(int, char**); const char* help; };
+
+static const Scenario SCENARIOS[] = {
+  { "steps", simSteps, "step engine timing/jitter on a virtual timer vs polled loop()" },
+  { "coils", simCoils, "batched coil driver: register-file check and per-step cycle model" },
+  { "ramp",  simRamp,  "acceleration tables vs reference/AccelStepper shape, per-step cost" },
+  { "scale", simScale, "Winder<N> for 1..16 motors: per-tick ISR and scheduler cost, linearity" },
+  { "link",  simLink,  "command ring + status seqlock checks and two-thread stress" },
+  { "days",  simDays,  "replay N days of scheduling on the mock HAL: TPD, drift, CPU" },
+  { "wrap",  simWrap,  "tickless scheduling across the 32-bit millis() wrap: no late events, wakeups/day" },
+  { "burst", simBurst, "burst programs: exact turns per calendar day, window, O(1) slot lookup" },
+  { "events", simEvents, "/events vs 3 s /status polling: bytes/s and CPU per client; snapshot, diff-only, resync and keepalive checks" },
+  { "scan",  simScan,  "Wi-Fi scan cache: dedup/sort/eviction checks, fold cost vs nested loop" },
+  { "json",  simJson,  "request parser checks, worst-case response size, zero-allocation check" },
+  { "prefs", simPrefs, "settings blob: CRC/migration checks, flash writes and handler cost vs per-key puts" },
+  { "resume", simResume, "warm resume across resets: no lost/doubled turns, grid kept, turbo end, boot cost" },
+  { "metrics", simMetrics, "/metrics: histogram/format checks, instrumentation cost vs the ISR and passes it measures" },
+  { "trace", simTrace, "trace ring: no torn/duplicate records under concurrent writers, add() vs blocking printf" },
+  { "switch", simSwitch, "mode switch: bouncy edge traces delivered once after the debounce, presets apply once, boot rules" },
+  { "power", simPower, "coil-current budget: peak/average draw with staggered vs simultaneous ramps, TPD kept" },
+  { "turbo", simTurbo, "turbo sessions on the step engine: end vs deadline, whole rotations, old top-up code" },
+  { "fleet", simFleet, "fleet beacons, live table and /config,/start,/stop,/turbo fan-out to N loopback nodes: latency vs one by one" },
+  { "history", simHistory, "odometer vs the HAL over weeks of stops/turbo/config, hourly history ring: exact buckets, bytes/hour" },
+  { "http", simHttp, "route handlers under loopback HTTP load: p50/p99/p999 per route, throughput, step error shared loop vs motion task" },
+  { "ctl", simCtl, "binary control frames: codec/retry checks, latency and bytes per command vs the JSON routes over UDP and WebSocket" },
+};
+
+int main(int argc, char** argv){
+  if (argc >= 2){
+    for (const Scenario& s : SCENARIOS)
+      if (!strcmp(argv[1], s.name)) return s.run(argc - 1, argv + 1);
+  }
+  if (argc >= 2 && !strcmp(argv[1], "all")){
+    int fails = 0;
+    for (const Scenario& s : SCENARIOS){
+      char* av[] = { (char*)s.name, nullptr };
+      printf("=== %s ===\n", s.name);
+      fails += s.run(1, av) != 0;
+    }
+    return fails;
+  }
+  printf("usage: %s <scenario|all>\n", argv[0]);
+  for (const Scenario& s : SCENARIOS) printf("  %-10s %s\n", s.name, s.help);
+  return 2;
+}
@@ -0,0 +1,199 @@
+// /metrics instrumentation: bucket and format checks, and what recording
+// costs against the work it measures.
+//   winder_sim metrics [ticks]
+// Checks bucket edges, that Prometheus output is cumulative with +Inf equal
+// to _count, and that chunks never split a line. Then times the step ISR
+// with and without main.cpp's per-step timing hook (on a virtual cycle
+// counter, which also checks step error stays within one tick), a
+// scheduler pass with and without the rotation-delay recording, and a full
+// scrape. The added cost must stay under 1% of each loop's period at its
+// busiest (25 us tick, 2 ms pass). Host ns.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include "config.h"
+#include "metrics.h"
+#include "mock_hal.h"
+#include "sim.h"
+#include "winder.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+typedef Winder<MOTOR_COUNT> W;
+static const uint32_t CPU_MHZ = 240;
+
+static double nsSince(std::chrono::steady_clock::time_point t0){
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// ----- main.cpp's onCoils(), on a virtual cycle counter -----
+static uint32_t simCycles;
+static W::Engine* hooked;
+static StepTiming<MOTOR_COUNT> stepTiming;
+static uint8_t lastCoils[MOTOR_COUNT];
+static void plainCoils(MotorMask changed, const uint8_t* coils){
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) if (changed & (1u << m)) lastCoils[m] = coils[m];
+}
+static void timedCoils(MotorMask changed, const uint8_t* coils){
+  plainCoils(changed, coils);
+  stepTiming.record(changed, simCycles, CPU_MHZ, *hooked);
+}
+
+static int formatChecks(){
+  int fails = 0;
+  Histogram h;
+  const uint32_t vals[] = { 0, 1, 2, 3, 4, 7, 8, 1000, 16383, 16384, 4000000000u };
+  uint64_t sum = 0;
+  for (uint32_t v : vals){ h.record(v); sum += v; }
+  CHECK(h.bucket(0) == 1 && h.bucket(1) == 1 && h.bucket(2) == 2 && h.bucket(3) == 2 && h.bucket(4) == 1);
+  CHECK(h.bucket(10) == 1 && h.bucket(14) == 1 && h.bucket(METRIC_BUCKETS - 1) == 2);
+  CHECK(h.count() == 11 && h.sum() == sum && h.max() == 4000000000u);
+  for (uint8_t k = 1; k < METRIC_BUCKETS - 1; k++){            // every value lands under its bucket's le
+    Histogram t; t.record(Histogram::le(k)); CHECK(t.bucket(k) == 1);
+    Histogram u; u.record(Histogram::le(k) + 1); CHECK(u.bucket(k + 1) == 1);
+  }
+
+  // Small buffer so the output spans many chunks
+  static char buf[200];
+  struct Sink { std::string all; size_t chunks = 0; bool split = false; size_t biggest = 0; } sk;
+  ChunkOut o(buf, sizeof(buf), [](const char* p, size_t n, void* c){
+    Sink& s = *(Sink*)c;
+    s.all.append(p, n); s.chunks++;
+    if (n && p[n - 1] != '\n') s.split = true;
+    if (n > s.biggest) s.biggest = n;
+  }, &sk);
+  promType(o, "winder_test_us", "histogram", "test");
+  promHistogram(o, "winder_test_us", "", h);
+  promHistogram(o, "winder_test_us", "motor=\"2\"", h);
+  promValue(o, "winder_up", "", 7);
+  o.flush();
+  CHECK(!sk.split && sk.biggest < sizeof(buf) && sk.chunks > 3 && o.total() == sk.all.size());
+
+  // Cumulative buckets, +Inf == _count, _sum as recorded
+  unsigned long prev = 0, inf = 0, count = 0;
+  unsigned long long s = 0;
+  int buckets = 0;
+  bool mono = true;
+  for (size_t at = 0; at < sk.all.size();){
+    size_t nl = sk.all.find('\n', at);
+    std::string line = sk.all.substr(at, nl - at);
+    at = nl + 1;
+    if (line.compare(0, 22, "winder_test_us_bucket{") || line.find("motor") != std::string::npos){
+      if (!line.compare(0, 19, "winder_test_us_sum ")) s = strtoull(line.c_str() + 19, nullptr, 10);
+      if (!line.compare(0, 21, "winder_test_us_count ")) count = strtoul(line.c_str() + 21, nullptr, 10);
+      continue;
+    }
+    unsigned long v = strtoul(line.c_str() + line.rfind(' ') + 1, nullptr, 10);
+    if (v < prev) mono = false;
+    prev = v; buckets++;
+    if (line.find("+Inf") != std::string::npos) inf = v;
+  }
+  CHECK(mono && buckets == METRIC_BUCKETS && inf == 11 && count == 11 && s == sum);
+  CHECK(sk.all.find("winder_test_us_bucket{motor=\"2\",le=\"+Inf\"} 11\n") != std::string::npos);
+  CHECK(sk.all.find("winder_test_us_sum{motor=\"2\"} ") != std::string::npos);
+
+  char jb[jsonHistogramMax(16) + 1];
+  JsonOut j(jb, sizeof(jb));
+  Histogram worst;
+  for (uint8_t k = 0; k < METRIC_BUCKETS; k++) for (int i = 0; i < 3; i++) worst.record(0xFFFFFFFFu);
+  jsonHistogram(j, "0123456789abcdef", worst);
+  CHECK(j.ok());
+  return fails;
+}
+
+// ns per tick, every motor cruising; best of three
+static double tickCost(CoilWriter w, uint32_t ticks, uint32_t& maxErr, int& fails){
+  double best = 1e18;
+  for (int rep = 0; rep < 3; rep++){
+    W::Engine engine(w);
+    hooked = &engine;
+    stepTiming.restart();
+    engine.setSpeed((uint32_t)(STEP_RPM * STEPS_PER_REV / 60), 200, 400);
+    for (uint8_t m = 0; m < MOTOR_COUNT; m++) engine.move(m, (m & 1) ? -2000000 : 2000000);
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < ticks; i++){ simCycles += STEP_TICK_US * CPU_MHZ; engine.tick(); }
+    double ns = nsSince(t0) / ticks;
+    if (ns < best) best = ns;
+    for (uint8_t m = 0; m < MOTOR_COUNT; m++) CHECK(lastCoils[m] == engine.coils(m));
+  }
+  maxErr = 0;
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) if (stepTiming.errUs[m].max() > maxErr) maxErr = stepTiming.errUs[m].max();
+  return best;
+}
+
+// ns per scheduler pass, 2 ms apart for about an hour, optionally recording start delays
+static double passCost(bool record, uint64_t& rotations){
+  MockClock clk; MockGpio io; MockStepper mot(clk, 680, 830);
+  W::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) sched.setPlan(m, 1200, DIR_ALT);
+  clk.nowMs = 1000; sched.begin();
+  Histogram late[MOTOR_COUNT];
+  uint32_t seen[MOTOR_COUNT] = {0};
+  const int PASSES = 2000000;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < PASSES; i++){
+    clk.advance(2);
+    sched.poll();
+    if (record)
+      for (uint8_t m = 0; m < MOTOR_COUNT; m++)
+        if (sched.turns(m) != seen[m]){ seen[m] = sched.turns(m); late[m].record(sched.lateMs(m)); }
+  }
+  double ns = nsSince(t0) / PASSES;
+  rotations = 0;
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) rotations += record ? late[m].count() : sched.turns(m);
+  return ns;
+}
+
+int simMetrics(int argc, char** argv){
+  uint32_t ticks = argc > 1 ? (uint32_t)atoi(argv[1]) : 2000000;
+  int fails = formatChecks();
+
+  uint32_t errPlain, errTimed;
+  double plain = tickCost(plainCoils, ticks, errPlain, fails);
+  double timed = tickCost(timedCoils, ticks, errTimed, fails);
+  uint32_t steps = 0;
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) steps += stepTiming.errUs[m].count();
+  CHECK(steps > 0 && errTimed <= STEP_TICK_US);              // perfect timer: only tick quantization
+  double isrPct = 100.0 * (timed > plain ? timed - plain : 0) / (STEP_TICK_US * 1000.0);   // of the tick period
+
+  uint64_t rotA, rotB;
+  double passPlain = passCost(false, rotA), passTimed = passCost(true, rotB);
+  CHECK(rotA == rotB && rotB > 0);
+  double passPct = 100.0 * (passTimed > passPlain ? passTimed - passPlain : 0) / 2e6;   // of a 2 ms pass
+
+  // record() alone, and a full scrape of what main.cpp exports
+  Histogram h;
+  const int N = 10000000;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < N; i++) h.record((uint32_t)i * 2654435761u >> 18);
+  double recNs = nsSince(t0) / N;
+  static char buf[1024];
+  size_t bytes = 0;
+  const int SCRAPES = 2000;
+  Histogram* hs[3 + 5 + 2 * MOTOR_COUNT];
+  for (Histogram*& p : hs) p = &h;
+  t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < SCRAPES; i++){
+    ChunkOut o(buf, sizeof(buf), [](const char*, size_t, void*){}, nullptr);
+    for (Histogram* p : hs){ promType(o, "winder_x_us", "histogram", "x"); promHistogram(o, "winder_x_us", "motor=\"1\"", *p); }
+    o.flush();
+    bytes = o.total();
+  }
+  double scrapeUs = nsSince(t0) / SCRAPES / 1000;
+
+  // Web loop: 2 records and 3 micros() per iteration, on a 2 ms pass at its busiest
+  const double MICROS_NS = 300;   // esp_timer read on the ESP32, ~70 cycles
+  double webPct = 100.0 * (2 * recNs + 3 * MICROS_NS) / 2e6;
+
+  printf("  step ISR: %.1f ns/tick plain, %.1f with step timing (%.4f%% of the %u us tick); %u steps, max error %u us\n",
+         plain, timed, isrPct, STEP_TICK_US, steps, errTimed);
+  printf("  scheduler pass: %.1f ns plain, %.1f with start-delay recording (%.4f%% of a 2 ms pass), %llu rotations\n",
+         passPlain, passTimed, passPct, (unsigned long long)rotB);
+  printf("  record(): %.2f ns; web loop overhead %.3f%% of a 2 ms pass\n", recNs, webPct);
+  printf("  scrape: %zu B of Prometheus text in %.0f us (%zu histograms)\n", bytes, scrapeUs, sizeof(hs) / sizeof(hs[0]));
+  CHECK(webPct < 1.0 && isrPct < 1.0 && passPct < 1.0);
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
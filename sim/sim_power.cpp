@@ -0,0 +1,132 @@
+// Coil-current budget: combined draw with and without staggered ramps.
+//   winder_sim power [hours] [capMa]
+// Runs the real scheduler on the real step engine, tick by tick while
+// anything moves (the clock jumps over idle time), for every motor on the
+// same TPD so their rotations fall due together, plus a turbo on all
+// motors. Every tick sums the modelled coil current of each motor
+// (power_budget.h: pattern, step interval, L/R fill). Once with no cap,
+// once with the budget: checks the budget keeps the peak under the cap,
+// the same rotations are started and every step is made, and no start
+// waits longer than a ramp or two.
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "mock_hal.h"
+#include "sim.h"
+#include "winder.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+typedef Winder<MOTOR_COUNT> W;
+static const uint32_t TICKS_PER_MS = 1000 / STEP_TICK_US;
+
+static void noCoils(MotorMask, const uint8_t*){}
+
+// StepEngine behind the scheduler's HAL; notes when each queued move starts stepping
+struct EngineMotors : EngineDriver<MOTOR_COUNT> {
+  uint64_t queuedAt[MOTOR_COUNT] = {0};
+  uint32_t queuedSteps[MOTOR_COUNT] = {0};
+  uint64_t issued = 0;
+  explicit EngineMotors(W::Engine& e) : EngineDriver(e) {}
+  void move(uint8_t m, int32_t steps) override {
+    if (!e.isRunning(m)){ queuedAt[m] = ~0ULL; queuedSteps[m] = e.stepCount(m); }
+    e.move(m, steps);
+    issued += (uint64_t)(steps < 0 ? -steps : steps);
+  }
+};
+
+struct Run { double peakMa, avgMa, movingAvgMa, overCapMs, maxWaitMs; uint64_t turns, steps, issued, moves, holds; uint64_t movingMs; };
+
+static Run run(uint32_t hours, uint16_t capMa, uint16_t checkCap){
+  MockClock clk; MockGpio io;
+  W::Engine engine(noCoils);
+  uint32_t sps = (uint32_t)(STEP_RPM * STEPS_PER_REV / 60);
+  engine.setSpeed(sps, 100, sps * 5 / 12);
+  engine.setRelease(COILS_RELEASE_IDLE);
+  engine.setPowerBudget(capMa, COIL_MA, COIL_TAU_US);
+  EngineMotors mot(engine);
+  W::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, -1 }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  io.level[MODE_PIN_A] = 1; io.level[MODE_PIN_B] = 1;          // manual: the plans below hold
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) sched.setPlan(m, 650, m & 1 ? DIR_CCW : DIR_CW);
+  clk.nowMs = 1000;
+  sched.begin();
+
+  Run r{};
+  double sumMa = 0;
+  const uint64_t end = clk.nowMs + hours * 3600000ULL, turboAt = clk.nowMs + 1800000;
+  bool turbo = false;
+  float fill[MOTOR_COUNT] = {0};
+  uint32_t fillQ[MOTOR_COUNT] = {0};
+  while (clk.nowMs < end){
+    if (!turbo && clk.nowMs >= turboAt){
+      W::Cmd c{}; c.op = CMD_TURBO; c.mask = W::ALL; c.minutes = 2;
+      sched.apply(c);
+      turbo = true;
+    }
+    sched.poll();
+    if (engine.settled()){
+      uint64_t next = sched.nextEventMs();
+      if (!turbo && next > turboAt) next = turboAt;
+      clk.nowMs = next > clk.nowMs ? next : clk.nowMs + 1;
+      continue;
+    }
+    // One ms of ISR ticks, summing the modelled draw
+    double msSum = 0;
+    for (uint32_t t = 0; t < TICKS_PER_MS; t++){
+      engine.tick();
+      float ma = 0;
+      for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+        uint32_t q = engine.intervalQ(m);
+        if (q != fillQ[m]){ fillQ[m] = q; fill[m] = powerMotorMa(0x3, q, STEP_TICK_US, COIL_MA, COIL_TAU_US) / (2.0f * COIL_MA); }
+        ma += powerCoilsOn(engine.coils(m)) * COIL_MA * fill[m];
+      }
+      if (ma > r.peakMa) r.peakMa = ma;
+      if (checkCap && ma > checkCap) r.overCapMs += 1.0 / TICKS_PER_MS;
+      msSum += ma;
+    }
+    sumMa += msSum / TICKS_PER_MS;
+    r.movingMs++;
+    for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+      if (mot.queuedAt[m] == ~0ULL) mot.queuedAt[m] = clk.nowMs;           // queued during the last pass
+      else if (mot.queuedAt[m] && engine.stepCount(m) != mot.queuedSteps[m]){
+        double w = (double)(clk.nowMs - mot.queuedAt[m]);
+        if (w > r.maxWaitMs) r.maxWaitMs = w;
+        mot.queuedAt[m] = 0; r.moves++;
+      }
+    }
+    clk.advance(1);
+  }
+  uint64_t span = end - 1000;
+  r.avgMa = sumMa / span;
+  r.movingAvgMa = r.movingMs ? sumMa / r.movingMs : 0;
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){ r.turns += sched.turns(m); r.steps += engine.stepCount(m); }
+  r.issued = mot.issued;
+  r.holds = engine.powerHolds();
+  return r;
+}
+
+static void report(const char* name, const Run& r){
+  printf("  %-12s peak %4.0f mA, avg %5.1f mA (%5.1f mA while moving, %.0f s), over cap %6.1f ms, starts %llu held %llu, longest start wait %.0f ms\n",
+         name, r.peakMa, r.avgMa, r.movingAvgMa, r.movingMs / 1000.0, r.overCapMs,
+         (unsigned long long)r.moves, (unsigned long long)r.holds, r.maxWaitMs);
+}
+
+int simPower(int argc, char** argv){
+  uint32_t hours = argc > 1 ? (uint32_t)atoi(argv[1]) : 6;
+  uint16_t cap = argc > 2 ? (uint16_t)atoi(argv[2]) : POWER_BUDGET_MA;
+  int fails = 0;
+  printf("  %d motors at %d TPD, same phase; turbo on all for 2 min; %u h; cap %u mA (coil %u mA, L/R %u us)\n",
+         MOTOR_COUNT, 650, hours, cap, COIL_MA, COIL_TAU_US);
+  Run free = run(hours, 0, cap), held = run(hours, cap, cap);
+  report("uncapped", free);
+  report("budget", held);
+  CHECK(free.peakMa > cap);                                   // the problem is there to solve
+  CHECK(held.peakMa <= cap);
+  CHECK(held.overCapMs == 0);
+  CHECK(held.turns == free.turns);                            // same scheduled rotations
+  CHECK(held.steps == held.issued && free.steps == free.issued); // every queued step made
+  CHECK(held.maxWaitMs < 2000);
+  CHECK(free.holds == 0 && held.holds > 0);
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
@@ -0,0 +1,149 @@
+// Settings persistence: the CRC-checked blob and its write-behind against
+// the old one-NVS-key-per-setting saves, on a burst of UI saves.
+//   winder_sim prefs [saves] [gap_ms]
+// Checks the blob round-trips, that corruption, truncation, foreign and
+// newer blobs are rejected, and that v1 blobs and blobs from another motor
+// count load.
+// Flash cost uses an NVS model (32-byte entries, per-operation latency);
+// the handler cost of the new path is measured on the host.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "config.h"
+#include "sim.h"
+#include "winder.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+// NVS model: each set is a flash write of one or more 32-byte entries
+static const double NVS_OP_US    = 450;   // per nvs_set_* incl. page lookup
+static const double NVS_ENTRY_US = 60;    // per 32-byte entry programmed
+static const uint32_t PREFS_QUIET_MS = 2000, PREFS_MAX_DELAY_MS = 15000;   // as main.cpp
+
+struct Flash { uint32_t ops = 0, entries = 0; double us = 0; };
+static void nvsSet(Flash& f, size_t entries){ f.ops++; f.entries += (uint32_t)entries; f.us += NVS_OP_US + entries * NVS_ENTRY_US; }
+static size_t strEntries(const char* s){ return 1 + (strlen(s) + 1 + 31) / 32; }
+
+// What savePrefs() wrote before: rpm, profile, program (3), tpd/dir per motor
+static void legacySave(Flash& f, uint8_t motors){ for (int i = 0; i < 5 + 2 * motors; i++) nvsSet(f, 1); }
+// saveWifiCreds(): two strings
+static void legacyWifi(Flash& f, const char* ssid, const char* pass){ nvsSet(f, strEntries(ssid)); nvsSet(f, strEntries(pass)); }
+// One blob: index entry + data header + data
+static void blobSave(Flash& f, size_t bytes){ nvsSet(f, 2 + (bytes + 31) / 32); }
+
+template <uint8_t N>
+static Settings<N> sample(){
+  Settings<N> s{};
+  s.rpm = 15; s.profile = RAMP_SCURVE; s.program = WindProgram{ 60, 480, 1200 };
+  strcpy(s.ssid, "HomeNet"); strcpy(s.pass, "correct horse battery staple");
+  for (uint8_t m = 0; m < N; m++){ s.tpd[m] = (int16_t)(600 + 10 * m); s.dir[m] = (int8_t)((m % 3) - 1); }
+  s.switchPos = 2; s.presets = switchPresetsDefault<N>();
+  for (uint8_t m = 0; m < N; m++) s.presets.pos[2].tpd[m] = (int16_t)(900 + m);
+  return s;
+}
+
+static int blobChecks(){
+  int fails = 0;
+  CHECK(settingsCrc((const uint8_t*)"123456789", 9) == 0xCBF43926u);
+
+  uint8_t blob[settingsBlobMax<WINDER_MAX_MOTORS>()];
+  Settings<2> a = sample<2>(), b{};
+  size_t n = settingsEncode(a, blob, sizeof(blob));
+  CHECK(n == settingsBlobMax<2>());
+  CHECK(settingsDecode(blob, n, b) && !memcmp(&a, &b, sizeof(a)));
+
+  // Every single-bit flip in the payload is caught
+  int missed = 0;
+  for (size_t i = sizeof(SettingsHeader); i < n; i++)
+    for (int bit = 0; bit < 8; bit++){
+      blob[i] ^= (uint8_t)(1 << bit);
+      Settings<2> t = a;
+      if (settingsDecode(blob, n, t)) missed++;
+      blob[i] ^= (uint8_t)(1 << bit);
+    }
+  CHECK(missed == 0);
+  Settings<2> keep = sample<2>(); keep.tpd[0] = 1;
+  CHECK(!settingsDecode(blob, n - 1, keep) && keep.tpd[0] == 1);            // truncated: untouched
+  SettingsHeader h; memcpy(&h, blob, sizeof(h));
+  h.version = SETTINGS_VERSION + 1; memcpy(blob, &h, sizeof(h));
+  CHECK(!settingsDecode(blob, n, keep));                                     // newer firmware's blob
+  h.version = SETTINGS_VERSION; h.magic = 0x1234; memcpy(blob, &h, sizeof(h));
+  CHECK(!settingsDecode(blob, n, keep));                                     // not ours
+
+  // A v1 blob (no presets): loads, the presets and applied position keep their defaults
+  n = settingsEncode(a, blob, sizeof(blob));
+  h.magic = SETTINGS_MAGIC; h.version = 1; h.size = (uint16_t)settingsPayloadV1(2);
+  h.crc = settingsCrc(blob + sizeof(h), h.size);
+  memcpy(blob, &h, sizeof(h));
+  Settings<2> v1{};
+  v1.switchPos = SWITCH_UNKNOWN; v1.presets = switchPresetsDefault<2>();
+  CHECK(settingsDecode(blob, sizeof(h) + h.size, v1) && v1.tpd[1] == a.tpd[1] && !strcmp(v1.pass, a.pass));
+  CHECK(v1.switchPos == SWITCH_UNKNOWN && v1.presets.pos[2].tpd[0] == 800 && v1.presets.pos[1].manual);
+
+  // Motor count changed between builds: shared motors carry over, new ones keep defaults
+  Settings<4> four = sample<4>(), fourIn{};
+  n = settingsEncode(four, blob, sizeof(blob));
+  Settings<2> two{};
+  CHECK(settingsDecode(blob, n, two) && two.tpd[1] == four.tpd[1] && two.dir[1] == four.dir[1] && !strcmp(two.pass, four.pass));
+  CHECK(two.presets.pos[2].tpd[1] == four.presets.pos[2].tpd[1] && two.switchPos == 2);
+  n = settingsEncode(a, blob, sizeof(blob));
+  fourIn.tpd[3] = 777;
+  fourIn.presets = switchPresetsDefault<4>();
+  CHECK(settingsDecode(blob, n, fourIn) && fourIn.tpd[0] == a.tpd[0] && fourIn.tpd[3] == 777);
+  CHECK(fourIn.presets.pos[2].tpd[1] == 901 && fourIn.presets.pos[2].tpd[3] == 800);
+  return fails;
+}
+
+int simPrefs(int argc, char** argv){
+  int saves = argc > 1 ? atoi(argv[1]) : 10;
+  uint32_t gap = argc > 2 ? (uint32_t)atoi(argv[2]) : 800;
+  if (saves < 1) saves = 1;
+  int fails = blobChecks();
+  typedef Winder<MOTOR_COUNT> W;
+  W::Settings cfg = sample<MOTOR_COUNT>();
+  uint8_t blob[W::SETTINGS_BLOB_MAX];
+
+  // Burst of Save clicks `gap` ms apart, then one Wi-Fi change; then quiet
+  Flash before, after;
+  for (int i = 0; i < saves; i++) legacySave(before, MOTOR_COUNT);
+  legacyWifi(before, cfg.ssid, cfg.pass);
+  double beforeHandlerUs = before.us / (saves + 1);
+
+  WriteBehind wb(PREFS_QUIET_MS, PREFS_MAX_DELAY_MS);
+  uint32_t flushes = 0, folded = 0, lastSaveAt = 0;
+  double handlerNs = 0;
+  for (uint32_t t = 0, i = 0; t < saves * gap + 60000; t += 2){   // web task passes
+    if (i <= (uint32_t)saves && t == i * gap){
+      auto t0 = std::chrono::steady_clock::now();
+      if (i < (uint32_t)saves) cfg.tpd[0] = (int16_t)(600 + i);
+      else strcpy(cfg.ssid, "OtherNet");
+      wb.touch(t);
+      handlerNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+      lastSaveAt = t; i++;
+    }
+    if (wb.due(t)){
+      size_t n = settingsEncode(cfg, blob, sizeof(blob));
+      blobSave(after, n);
+      folded += wb.flushed(); flushes++;
+      if (flushes == 1) printf("  first flush %u ms after the last change\n", t - lastSaveAt);
+    }
+  }
+  CHECK(!wb.dirty() && folded == (uint32_t)saves + 1);
+  // gap under the quiet period: one flush; the max delay caps how long a stream of saves can defer it
+  uint32_t expect = 1 + (gap < PREFS_QUIET_MS ? (saves * gap) / PREFS_MAX_DELAY_MS : (uint32_t)saves);
+  CHECK(flushes <= expect);
+  Settings<MOTOR_COUNT> back{};
+  CHECK(settingsDecode(blob, settingsBlobMax<MOTOR_COUNT>(), back) && !strcmp(back.ssid, "OtherNet") && back.tpd[0] == 600 + saves - 1);
+
+  printf("  %d saves %u ms apart + 1 Wi-Fi change, %d motors\n", saves, gap, MOTOR_COUNT);
+  printf("  per-key puts:   %u flash writes (%u entries), %.1f ms of flash in HTTP handlers, %.2f ms per handler\n",
+         before.ops, before.entries, before.us / 1000, beforeHandlerUs / 1000);
+  printf("  blob + write-behind: %u flash write(s) (%u entries), %.1f ms of flash on the web task between requests\n",
+         after.ops, after.entries, after.us / 1000);
+  printf("  handler cost now: %.0f ns per save (copy into the settings struct, no flash); blob %zu B\n",
+         handlerNs / (saves + 1), W::SETTINGS_BLOB_MAX);
+  printf("  flash writes per config change: %.2f -> %.2f\n", (double)before.ops / (saves + 1), (double)after.ops / (saves + 1));
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
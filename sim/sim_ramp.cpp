@@ -0,0 +1,170 @@
+// Acceleration profiles: the compile-time/lazy interval tables against a
+// double-precision reference and AccelStepper's constant-acceleration shape,
+// then the per-step cost of a table lookup vs the divide the engine used and
+// AccelStepper::computeNewSpeed()'s float math (same types and constants).
+//   winder_sim ramp [rpm]
+// Host ns; on the ESP32 the AccelStepper path is worse still, its double
+// constants pull in software double-precision division.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "config.h"
+#include "sim.h"
+#include "winder.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+// Boot table for the default speed is a compile-time constant
+static constexpr RampTable BOOT = rampTable(RAMP_TRAPEZOID, STEP_TICK_HZ, 1024, 100, 426);
+static_assert(BOOT.q[0] == (400u << 16), "start interval: 100 sps = 400 ticks");
+static_assert(BOOT.q[426] == (uint32_t)(((uint64_t)STEP_TICK_HZ << 16) / 1024), "cruise interval");
+
+static double refSpeed(uint8_t p, double v0, double v1, double n, double k){
+  if (k >= n) return v1;
+  double u = k / n;
+  return p == RAMP_SCURVE ? v0 + (v1 - v0) * u * u * (3 - 2 * u) : sqrt(v0 * v0 + (v1 * v1 - v0 * v0) * u);
+}
+static double speedAt(const RampTable& t, uint32_t k){ return (double)STEP_TICK_HZ * 65536.0 / t.q[k]; }
+
+// AccelStepper 1.64 computeNewSpeed() for a forward move, as the firmware ran it
+struct AccelModel {
+  long n = 0, target, pos = 0;
+  float c0, cn = 0, cmin, speed = 0, accel;
+  unsigned long stepInterval = 0;
+  AccelModel(float maxSpeed, float a, long tgt) : target(tgt), accel(a) {
+    c0 = 0.676 * sqrt(2.0 / a) * 1000000.0;
+    cmin = 1000000.0 / maxSpeed;
+  }
+  void step(){
+    long distanceTo = target - pos;
+    long stepsToStop = (long)((speed * speed) / (2.0 * accel));
+    if (distanceTo == 0 && stepsToStop <= 1){ stepInterval = 0; speed = 0.0; n = 0; return; }
+    if (n > 0){ if (stepsToStop >= distanceTo) n = -stepsToStop; }
+    else if (n < 0){ if (stepsToStop < distanceTo) n = -n; }
+    if (n == 0) cn = c0;
+    else { cn = cn - ((2.0 * cn) / ((4.0 * n) + 1)); if (cn < cmin) cn = cmin; }
+    n++;
+    stepInterval = cn;
+    speed = 1000000.0 / cn;
+  }
+};
+
+// Interval the engine computed before the tables: linear speed ramp, one 64-bit divide
+static uint32_t divideInterval(uint32_t v0, uint32_t vmax, uint32_t n, uint32_t idx){
+  uint32_t v = (idx >= n || n == 0) ? vmax : v0 + (uint32_t)(((uint64_t)(vmax - v0) * idx) / n);
+  return (uint32_t)(((uint64_t)STEP_TICK_HZ << 16) / v);
+}
+
+static double nsSince(std::chrono::steady_clock::time_point t0){
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static volatile uint64_t sink;
+
+static int shapeChecks(uint32_t sps, uint32_t n){
+  int fails = 0;
+  RampCache cache;
+  for (uint8_t p = 0; p < RAMP_PROFILES; p++){
+    const RampTable& t = cache.get(p, STEP_TICK_HZ, sps, 100, n);
+    double maxErr = 0;
+    for (uint32_t k = 0; k <= n; k++){
+      double e = fabs(speedAt(t, k) / refSpeed(p, 100, sps, n, k) - 1);
+      if (e > maxErr) maxErr = e;
+      if (k) CHECK(t.q[k] <= t.q[k - 1]);   // never slows down while ramping up
+    }
+    // Acceleration per step, a = (v[k+1]^2 - v[k]^2) / 2, at the ends and the middle
+    auto acc = [&](uint32_t k){ double a = speedAt(t, k), b = speedAt(t, k + 1); return (b * b - a * a) / 2; };
+    double aStart = acc(0), aMid = acc(n / 2), aEnd = acc(n - 1);
+    printf("  %-9s vs reference: max speed error %.4f%%; accel start/mid/end %.0f/%.0f/%.0f steps/s^2\n",
+           rampProfileName(p), maxErr * 100, aStart, aMid, aEnd);
+    CHECK(maxErr < 0.001);
+    if (p == RAMP_TRAPEZOID) CHECK(fabs(aStart / aMid - 1) < 0.05 && fabs(aEnd / aMid - 1) < 0.05);
+    else CHECK(aStart < aMid * 0.05 && aEnd < aMid * 0.05 && aMid > 0);
+  }
+  CHECK(cache.builds() == 2);
+  cache.get(RAMP_TRAPEZOID, STEP_TICK_HZ, sps, 100, n);   // both still cached
+  CHECK(cache.builds() == 2);
+
+  // From rest the trapezoid matches AccelStepper's ramp with accel = 1.2 * sps
+  const RampTable& t = cache.get(RAMP_TRAPEZOID, STEP_TICK_HZ, sps, 1, n);
+  AccelModel a((float)sps, 1.2f * sps, 100000);
+  double worst = 0;
+  for (uint32_t k = 0; k < n; k++){
+    a.step(); a.pos++;
+    if (k >= n / 4){ double e = fabs(a.speed / speedAt(t, k) - 1); if (e > worst) worst = e; }
+  }
+  printf("  trapezoid vs AccelStepper (accel 1.2*sps): max speed difference %.2f%% over the last 3/4 of the ramp\n", worst * 100);
+  CHECK(worst < 0.03);
+  return fails;
+}
+
+template <RampProfile P>
+static int engineRun(uint32_t sps, uint32_t n){
+  int fails = 0;
+  typedef Winder<1> W1;
+  W1::Engine e([](MotorMask, const uint8_t*){});
+  e.setSpeed(sps, 100, n, P);
+  e.move(0, STEPS_PER_REV);
+  uint64_t ticks = 0;
+  while (e.isRunning(0)){ e.tick(); ticks++; }
+  CHECK(e.stepCount(0) == (uint32_t)STEPS_PER_REV && e.ramp().profile == P);
+  printf("  engine %-9s: one revolution in %.3f s\n", rampProfileName(P), ticks * STEP_TICK_US / 1e6);
+  return fails;
+}
+
+int simRamp(int argc, char** argv){
+  int rpm = argc > 1 ? atoi(argv[1]) : STEP_RPM;
+  uint32_t sps = (uint32_t)(rpm * STEPS_PER_REV / 60);
+  if (sps > 1200) sps = 1200;
+  if (sps < 50) sps = 50;
+  uint32_t n = sps * 5 / 12;
+  printf("  %u sps, ramp %u steps from 100 sps\n", sps, n);
+  int fails = shapeChecks(sps, n) + engineRun<RAMP_TRAPEZOID>(sps, n) + engineRun<RAMP_SCURVE>(sps, n);
+
+  // Per-step interval cost over one revolution (ramp up, cruise, ramp down)
+  const int REPS = 200;
+  const long STEPS = STEPS_PER_REV;
+  RampCache cache;
+  const RampTable* t = &cache.get(RAMP_TRAPEZOID, STEP_TICK_HZ, sps, 100, n);
+  uint64_t sum = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < REPS; r++)
+    for (long k = 0, ramp = 0; k < STEPS; k++){
+      uint32_t left = (uint32_t)(STEPS - k);
+      uint32_t idx = (uint32_t)ramp < left ? (uint32_t)ramp : left;
+      sum += t->q[idx < t->steps ? idx : t->steps];
+      if (ramp < t->steps) ramp++;
+    }
+  double tableNs = nsSince(t0) / REPS / STEPS;
+
+  t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < REPS; r++)
+    for (long k = 0, ramp = 0; k < STEPS; k++){
+      uint32_t left = (uint32_t)(STEPS - k);
+      sum += divideInterval(100, sps, n, (uint32_t)ramp < left ? ramp : left);
+      if ((uint32_t)ramp < n) ramp++;
+    }
+  double divideNs = nsSince(t0) / REPS / STEPS;
+
+  t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < REPS; r++){
+    AccelModel a((float)sps, 1.2f * sps, STEPS);
+    for (long k = 0; k < STEPS; k++){ a.step(); a.pos++; sum += a.stepInterval; }
+  }
+  double accelNs = nsSince(t0) / REPS / STEPS;
+
+  t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < REPS; r++){
+    cache.get(RAMP_SCURVE, STEP_TICK_HZ, sps + r, 100, n);   // miss every time
+    sum += cache.builds();
+  }
+  double buildUs = nsSince(t0) / REPS / 1e3;
+  sink = sum;
+
+  printf("  per-step interval: table %.2f ns, 64-bit divide %.2f ns (%.1fx), AccelStepper computeNewSpeed %.2f ns (%.1fx)\n",
+         tableNs, divideNs, divideNs / tableNs, accelNs, accelNs / tableNs);
+  printf("  lazy table build on a speed/profile change: %.1f us (task side, once)\n", buildUs);
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
@@ -0,0 +1,226 @@
+// Warm resume: the scheduler's state captured at a reset and resumed on a
+// fresh clock, as the firmware does from RTC memory.
+//   winder_sim resume [resets]
+// A reference run goes two days uninterrupted; the same run is then reset
+// at random points (and mid-rotation, mid-burst, mid-turbo), down 50..2000
+// ms each time, every boot on a new clock near 0. Checks no rotation is
+// lost or doubled, the Alternate pattern carries on, rotations keep their
+// real-time grid (late only by the downtime and the re-issued remainder),
+// turbo ends when it would have, and a cold checkpoint keeps direction
+// and counters. Times capture + CRC + resume.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "config.h"
+#include "mock_hal.h"
+#include "sim.h"
+#include "winder.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+typedef Winder<MOTOR_COUNT> W;
+static const uint64_t DAY = PROGRAM_DAY_MS;
+static const uint64_t BOOT_MS = 300;                       // clock at resume after a reset
+static const uint64_t TURBO_AT = 3 * 3600000ULL;           // real time of the turbo press
+static const int16_t  TURBO_MIN = 10;
+static const uint32_t TOD_OFFSET = 7 * 3600000UL;
+
+// What main.cpp mirrors into RTC memory, minus its header
+struct Image {
+  ResumeState<MOTOR_COUNT> sched;
+  int32_t remaining[MOTOR_COUNT];
+  uint8_t phase[MOTOR_COUNT];
+};
+
+struct Move { uint64_t at; int8_t dir; };
+struct Run {
+  std::vector<Move> moves[MOTOR_COUNT];
+  uint64_t turboOffAt = 0, maxDown = 0;
+  uint32_t turns[MOTOR_COUNT] = {0};
+  int resumes = 0;
+};
+
+static uint32_t sps(){ return (uint32_t)(STEP_RPM * STEPS_PER_REV / 60); }
+static uint64_t rotMs(){ return (uint64_t)STEPS_PER_REV * 1000 / sps() + 830; }
+
+static void configure(W::Scheduler& s, const WindProgram& p){
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) s.setPlan(m, MOTOR_TABLE[m].tpd, DIR_ALT);
+  s.setProgram(p);
+}
+
+// Replays `len` ms of real time, resetting at each of `resets` (real ms)
+static Run replay(const WindProgram& p, uint64_t len, std::vector<uint64_t> resets, uint32_t seed){
+  Run r;
+  srand(seed);
+  ResumeState<MOTOR_COUNT> st{};
+  int32_t left[MOTOR_COUNT] = {0};
+  int64_t base = -1000;                                    // real = clock + base
+  uint64_t oldClock = 0;
+  bool turboSent = false, turboOn = false;
+  size_t nextReset = 0;
+  for (int session = 0; ; session++){
+    MockClock clk;
+    MockGpio io;
+    MockStepper mot(clk, sps(), 830);
+    W::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+    configure(sched, p);
+    if (session == 0){
+      clk.nowMs = 1000;
+      sched.begin();
+      W::Cmd c{}; c.op = CMD_CLOCK; c.todOffsetMs = TOD_OFFSET;
+      sched.apply(c);
+    } else {
+      uint64_t down = 50 + (uint64_t)(rand() % 1951);
+      if (down > r.maxDown) r.maxDown = down;
+      uint64_t resetAt = (uint64_t)((int64_t)oldClock + base);
+      clk.nowMs = BOOT_MS;
+      base = (int64_t)(resetAt + down) - (int64_t)BOOT_MS;
+      sched.resume(st, (int64_t)BOOT_MS - (int64_t)down - (int64_t)oldClock);
+      for (uint8_t m = 0; m < MOTOR_COUNT; m++)
+        if (left[m]){ mot.move(m, left[m]); mot.log.pop_back(); }   // the interrupted rotation, finished
+      r.resumes++;
+    }
+
+    bool reset = false;
+    for (;;){
+      uint64_t real = (uint64_t)((int64_t)clk.nowMs + base);
+      if (real >= len) break;
+      if (nextReset < resets.size() && real >= resets[nextReset]){ nextReset++; reset = true; break; }
+      if (!turboSent && real >= TURBO_AT){
+        W::Cmd c{}; c.op = CMD_TURBO; c.minutes = TURBO_MIN; c.mask = 1;
+        sched.apply(c); turboSent = turboOn = true;
+      }
+      sched.poll();
+      if (turboOn && !sched.turboActive()){ turboOn = false; r.turboOffAt = real; }
+      uint64_t next = sched.nextEventMs();
+      if (next <= clk.nowMs){                              // moving: next pass when a motor finishes
+        next = clk.nowMs + 2;
+        for (uint8_t m = 0; m < MOTOR_COUNT; m++)
+          if (mot.busyUntil(m) > clk.nowMs && (next == clk.nowMs + 2 || mot.busyUntil(m) < next)) next = mot.busyUntil(m);
+      }
+      uint64_t cap = len;
+      if (nextReset < resets.size() && resets[nextReset] < cap) cap = resets[nextReset];
+      if (!turboSent && TURBO_AT < cap) cap = TURBO_AT;
+      uint64_t capClock = (uint64_t)((int64_t)cap - base);
+      clk.nowMs = next < capClock ? next : (capClock > clk.nowMs ? capClock : clk.nowMs + 1);
+    }
+
+    for (const MockStepper::MoveLog& l : mot.log)
+      if (l.steps == STEPS_PER_REV || l.steps == -STEPS_PER_REV)   // scheduled rotations, not turbo
+        r.moves[l.motor].push_back(Move{ (uint64_t)((int64_t)l.atMs + base), (int8_t)(l.steps > 0 ? 1 : -1) });
+    if (!reset){
+      for (uint8_t m = 0; m < MOTOR_COUNT; m++) r.turns[m] = sched.turns(m);
+      return r;
+    }
+    sched.capture(st);
+    for (uint8_t m = 0; m < MOTOR_COUNT; m++) left[m] = mot.distanceToGo(m);
+    oldClock = clk.nowMs;
+  }
+}
+
+static int compare(const char* name, const Run& ref, const Run& got, uint64_t len){
+  int fails = 0;
+  uint64_t worst = 0, tol = got.maxDown + 2 * rotMs();
+  size_t total = 0;
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+    const std::vector<Move>& a = ref.moves[m];
+    const std::vector<Move>& b = got.moves[m];
+    CHECK(got.turns[m] == b.size());                       // counter = rotations started, none twice
+    size_t n = 0;
+    while (n < a.size() && a[n].at < len - 10 * 60000ULL) n++;
+    CHECK(b.size() >= n);
+    for (size_t i = 0; i < n && i < b.size(); i++){
+      if (b[i].dir != a[i].dir){ fails++; printf("  FAIL %s motor %u rotation %zu: direction\n", name, m, i); break; }
+      if (b[i].at < a[i].at || b[i].at - a[i].at > tol){ fails++; printf("  FAIL %s motor %u rotation %zu: %lld ms off\n",
+                                                          name, m, i, (long long)(b[i].at - a[i].at)); break; }
+      if (b[i].at - a[i].at > worst) worst = b[i].at - a[i].at;
+    }
+    total += n;
+  }
+  int64_t turboDiff = (int64_t)got.turboOffAt - (int64_t)ref.turboOffAt;
+  CHECK(ref.turboOffAt && got.turboOffAt && turboDiff >= 0 && (uint64_t)turboDiff <= tol);
+  printf("  %-22s %d resets (down up to %llu ms): %zu rotations match, worst %llu ms late, turbo ends %+lld ms\n",
+         name, got.resumes, (unsigned long long)got.maxDown, total, (unsigned long long)worst, (long long)turboDiff);
+  return fails;
+}
+
+// Power cut: only what the hourly NVS checkpoint keeps, as main.cpp's cold path
+static int checkpointCheck(){
+  int fails = 0;
+  MockClock clk; MockGpio io; MockStepper mot(clk, sps(), 830);
+  W::Scheduler a(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  configure(a, WindProgram{ 0, 0, 0 });
+  clk.nowMs = 1000; a.begin();
+  while (mot.log.size() < 7){ a.poll(); clk.nowMs = a.nextEventMs() > clk.nowMs ? a.nextEventMs() : clk.nowMs + 2; }
+  ResumeState<MOTOR_COUNT> r;
+  a.capture(r);
+  int8_t last = (int8_t)(mot.log.back().steps > 0 ? 1 : -1);
+  uint8_t lm = mot.log.back().motor;
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){ r.nextDue[m] = r.slotDue[m] = 0; r.burstLeft[m] = 0; r.slot[m] = 0; }
+  r.turboActive = 0; r.turboMask = 0; r.turboEndMs = 0; r.clockSet = 0; r.todOffsetMs = 0;
+  r.turboCount = 0; memset(r.turboSteps, 0, sizeof(r.turboSteps));
+
+  MockClock clk2; MockStepper mot2(clk2, sps(), 830);
+  W::Scheduler b(clk2, io, mot2, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  configure(b, WindProgram{ 0, 0, 0 });
+  clk2.nowMs = 1000; b.begin(); b.resume(r, 0);
+  while (mot2.log.empty() || mot2.log.back().motor != lm){ b.poll(); clk2.nowMs = b.nextEventMs() > clk2.nowMs ? b.nextEventMs() : clk2.nowMs + 2; }
+  CHECK((mot2.log.back().steps > 0 ? 1 : -1) == -last);     // Alternate pattern carries on
+  CHECK(b.turns(lm) > a.turns(lm));
+  uint64_t iv = W::Scheduler::intervalFromTPD(b.tpd(0));
+  CHECK(b.nextEventMs() <= clk2.nowMs + iv);               // fresh deadlines, nothing stale
+  return fails;
+}
+
+int simResume(int argc, char** argv){
+  int resets = argc > 1 ? atoi(argv[1]) : 40;
+  if (resets < 0) resets = 0;
+  int fails = checkpointCheck();
+  const uint64_t len = 2 * DAY;
+  struct Case { const char* name; WindProgram p; };
+  const Case cases[] = {
+    { "even (classic)", { 0, 0, 0 } },
+    { "every 60 min",   { 60, 0, 0 } },
+  };
+  for (const Case& k : cases){
+    Run ref = replay(k.p, len, {}, 1);
+    // Random instants plus the awkward ones: mid-rotation (of a burst) and mid-turbo
+    std::vector<uint64_t> at;
+    srand(7);
+    for (int i = 0; i < resets; i++) at.push_back(60000 + (uint64_t)rand() * 1000 % (len - 120000));
+    const std::vector<Move>& mv = ref.moves[0];
+    if (mv.size() > 40) at.push_back(mv[40].at + rotMs() / 2);
+    at.push_back(TURBO_AT + (TURBO_MIN / 2) * 60000ULL);
+    std::sort(at.begin(), at.end());
+    Run got = replay(k.p, len, at, 2);
+    fails += compare(k.name, ref, got, len);
+  }
+
+  // Boot cost: CRC check of the image, resume, then the first mirror (capture + CRC)
+  MockClock clk; MockGpio io; MockStepper mot(clk, sps(), 830);
+  W::Scheduler s(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  configure(s, WindProgram{ 60, 480, 1200 });
+  clk.nowMs = 1000; s.begin();
+  Image img;
+  memset(&img, 0, sizeof(img));
+  s.capture(img.sched);
+  const int REPS = 20000;
+  uint32_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < REPS; i++){
+    sink += settingsCrc((const uint8_t*)&img, sizeof(img));
+    s.resume(img.sched, -500);
+    s.capture(img.sched);
+    sink += settingsCrc((const uint8_t*)&img, sizeof(img));
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / REPS;
+  // ESP32 model: nibble CRC ~24 cycles/byte at 240 MHz, table compile ~8 cycles per slot
+  double espUs = (2.0 * sizeof(img) * 24 + MOTOR_COUNT * PROGRAM_MAX_SLOTS * 8) / 240.0;
+  printf("  image %zu B; CRC + resume + capture + CRC: %.0f ns on this host, ~%.0f us modeled on the ESP32 (%u)\n",
+         sizeof(img), ns, espUs, sink & 1);
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
@@ -0,0 +1,84 @@
+// Winder<N> scaling: per-tick ISR cost (StepEngine<N>::tick + 74HC595 frame
+// update) and per-pass scheduler cost for 1..16 motors, with every motor
+// running. Checks the latched frame matches the engine after each run and
+// that the per-motor cost stays flat, i.e. the total grows linearly in N.
+//   winder_sim scale [ticks]
+// Host ns; the ratios, not the absolute numbers, carry over to the ESP32.
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "coil_driver.h"
+#include "config.h"
+#include "mock_hal.h"
+#include "sim.h"
+#include "winder.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+template <uint8_t N> static ShiftFrame<N> frame;
+template <uint8_t N> static void shiftOut(MotorMask changed, const uint8_t* coils){ frame<N>.update(changed, coils); }
+
+struct Cost { double cruiseNs, busyNs, pollNs; };
+
+static double nsSince(std::chrono::steady_clock::time_point t0){
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// ns per tick with all N motors moving at sps; best of three runs
+template <uint8_t N>
+static double tickCost(uint32_t sps, uint32_t ticks, int& fails){
+  double best = 1e18;
+  for (int rep = 0; rep < 3; rep++){
+    typename Winder<N>::Engine engine(shiftOut<N>);
+    engine.setSpeed(sps, sps, 0);
+    for (uint8_t m = 0; m < N; m++) engine.move(m, (m & 1) ? -2000000 : 2000000);
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < ticks; i++) engine.tick();
+    double ns = nsSince(t0) / ticks;
+    if (ns < best) best = ns;
+    for (uint8_t m = 0; m < N; m++) CHECK(frame<N>.coils(m) == engine.coils(m) && engine.stepCount(m) > 0);
+  }
+  return best;
+}
+
+template <uint8_t N>
+static Cost measure(uint32_t ticks, int& fails){
+  Cost c;
+  c.cruiseNs = tickCost<N>((uint32_t)(STEP_RPM * STEPS_PER_REV / 60), ticks, fails);
+  c.busyNs   = tickCost<N>(STEP_TICK_HZ, ticks, fails);   // a step on every motor every tick
+
+  MockClock clk;
+  MockGpio io;
+  MockStepper mot(clk, 1024, 830);
+  typename Winder<N>::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  for (uint8_t m = 0; m < N; m++) sched.setPlan(m, 650, DIR_ALT);
+  sched.begin();
+  const int PASSES = 200000;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < PASSES; i++){ clk.advance(2); sched.poll(); }
+  c.pollNs = nsSince(t0) / PASSES;
+  return c;
+}
+
+int simScale(int argc, char** argv){
+  uint32_t ticks = argc > 1 ? (uint32_t)atoi(argv[1]) : 400000;
+  if (ticks < 1000) ticks = 1000;
+  int fails = 0;
+  const uint8_t SIZES[] = { 1, 2, 4, 8, 16 };
+  Cost c[5] = { measure<1>(ticks, fails), measure<2>(ticks, fails), measure<4>(ticks, fails),
+                measure<8>(ticks, fails), measure<16>(ticks, fails) };
+
+  printf("  motors  frame  tick@%drpm   tick@every-step   per motor   sched pass   /status bound\n", STEP_RPM);
+  const size_t bounds[5] = { Winder<1>::STATUS_JSON_MAX, Winder<2>::STATUS_JSON_MAX, Winder<4>::STATUS_JSON_MAX,
+                             Winder<8>::STATUS_JSON_MAX, Winder<16>::STATUS_JSON_MAX };
+  for (int i = 0; i < 5; i++)
+    printf("  %6u  %3u B  %8.1f ns  %12.1f ns  %7.2f ns  %8.1f ns  %8zu B\n",
+           SIZES[i], (SIZES[i] + 1) / 2, c[i].cruiseNs, c[i].busyNs, c[i].busyNs / SIZES[i], c[i].pollNs, bounds[i]);
+
+  // Linear: per-motor cost at 16 no worse than at 4 (fixed per-tick overhead only helps larger N)
+  double per4 = c[2].busyNs / 4, per16 = c[4].busyNs / 16;
+  printf("  per-motor cost 16 vs 4 motors: %.2fx\n", per16 / per4);
+  CHECK(per16 < 1.5 * per4);
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
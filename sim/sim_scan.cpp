@@ -0,0 +1,89 @@
+// Scan cache: dedup/sort/eviction checks, then the cost of folding a busy
+// scan (many BSSes sharing SSIDs) into the cache vs the old nested-loop dedup.
+//   winder_sim scan [records]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "scan_cache.h"
+#include "sim.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+static int checks(){
+  int fails = 0;
+  ScanCache c;
+  c.add("Home", -70, 1, 3);
+  c.add("  ", -40, 6, 0);                 // hidden
+  c.add(" Cafe ", -60, 6, 0);
+  c.add("Home", -50, 11, 4);              // stronger BSS of the same SSID
+  c.add("Cafe", -80, 1, 0);
+  c.add("Office", -90, 6, 3);
+  c.finish();
+  CHECK(c.size() == 3);
+  CHECK(!strcmp(c[0].ssid, "Home") && c[0].rssi == -50 && c[0].channel == 11 && c[0].auth == 4);
+  CHECK(!strcmp(c[1].ssid, "Cafe") && c[1].rssi == -60);
+  CHECK(!strcmp(c[2].ssid, "Office"));
+
+  // 32-byte SSID without a terminator inside the driver's field
+  char raw[33]; memset(raw, 'x', sizeof(raw));
+  c.clear(); c.add(raw, -50, 1, 0); c.finish();
+  CHECK(c.size() == 1 && strlen(c[0].ssid) == 32);
+
+  // Full cache: stronger newcomers evict the weakest, and stay findable
+  c.clear();
+  char name[16];
+  for (int i = 0; i < ScanCache::MAX_NETS; i++){ snprintf(name, sizeof(name), "n%02d", i); c.add(name, (int8_t)(-90 + i), 1, 0); }
+  c.add("weak", -95, 1, 0);
+  c.add("strong", -20, 1, 0);
+  c.add("strong", -10, 2, 0);
+  c.finish();
+  CHECK(c.size() == ScanCache::MAX_NETS);
+  CHECK(!strcmp(c[0].ssid, "strong") && c[0].rssi == -10 && c[0].channel == 2);
+  bool weak = false, n00 = false;
+  for (uint8_t i = 0; i < c.size(); i++){ weak |= !strcmp(c[i].ssid, "weak"); n00 |= !strcmp(c[i].ssid, "n00"); }
+  CHECK(!weak && !n00);
+  return fails;
+}
+
+struct Rec { char ssid[33]; int8_t rssi; };
+
+int simScan(int argc, char** argv){
+  int fails = checks();
+  int n = argc > 1 ? atoi(argv[1]) : 60;
+  if (n < 1) n = 1;
+  Rec* recs = new Rec[n];
+  for (int i = 0; i < n; i++){ snprintf(recs[i].ssid, sizeof(recs[i].ssid), "Network-%02d", i % 20); recs[i].rssi = (int8_t)(-30 - (i * 37) % 60); }
+
+  const int REPS = 2000;
+  ScanCache c;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < REPS; r++){
+    c.clear();
+    for (int i = 0; i < n; i++) c.add(recs[i].ssid, recs[i].rssi, 1, 3);
+    c.finish();
+  }
+  double cacheNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / REPS;
+
+  // Old /scan: linear search of the names collected so far, no RSSI, no sort
+  static char seen[256][33];
+  int kept = 0;
+  t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < REPS; r++){
+    kept = 0;
+    for (int i = 0; i < n; i++){
+      bool dup = false;
+      for (int k = 0; k < kept && !dup; k++) dup = !strcmp(seen[k], recs[i].ssid);
+      if (!dup && kept < 256) strcpy(seen[kept++], recs[i].ssid);
+    }
+  }
+  double nestedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / REPS;
+  delete[] recs;
+
+  CHECK(c.size() == (kept < ScanCache::MAX_NETS ? kept : ScanCache::MAX_NETS));
+  printf("  %d records -> %u networks: hash-set cache %.2f us (dedup + best RSSI + sort), nested loop %.2f us (dedup only)\n",
+         n, c.size(), cacheNs / 1e3, nestedNs / 1e3);
+  printf("  /scan itself now answers from the cache; the radio scan runs in the background\n");
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
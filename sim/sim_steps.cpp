@@ -0,0 +1,87 @@
+// Step engine on a virtual hardware timer.
+// Runs one rotation per motor at the configured RPM, checks every cruise-phase
+// step lands within one timer tick of the planned interval, and compares with
+// the old model where loop() polled AccelStepper::run() between a 2 ms delay()
+// and a blocking HTTP handler.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "config.h"
+#include "sim.h"
+#include "winder.h"
+
+static uint64_t simNowUs = 0;
+typedef Winder<MOTOR_COUNT> W;
+static std::vector<uint64_t> stepTimes[MOTOR_COUNT];
+
+static void recordCoils(MotorMask changed, const uint8_t*){
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) if (changed & (1u << m)) stepTimes[m].push_back(simNowUs);
+}
+
+struct Stats { double mean, sd, minv, maxv, maxErr; size_t n; };
+
+static Stats intervalStats(const std::vector<uint64_t>& t, size_t from, size_t to, double ideal){
+  Stats s{0, 0, 1e18, 0, 0, 0};
+  for (size_t i = from + 1; i < to; i++){
+    double d = (double)(t[i] - t[i - 1]);
+    s.mean += d; s.sd += d * d; s.n++;
+    if (d < s.minv) s.minv = d;
+    if (d > s.maxv) s.maxv = d;
+    if (fabs(d - ideal) > s.maxErr) s.maxErr = fabs(d - ideal);
+  }
+  if (s.n){ s.mean /= s.n; s.sd = sqrt(s.sd / s.n - s.mean * s.mean); }
+  return s;
+}
+
+// Old path: AccelStepper::run() steps at most once per call, loop() runs every
+// ~2 ms, and one handler blocks for blockMs in the middle of the rotation.
+static Stats polledModel(double sps, uint32_t blockMs, double& seconds){
+  std::vector<uint64_t> t;
+  double interval = 1e6 / sps;
+  uint64_t now = 0, last = 0;
+  bool blocked = false;
+  while ((long)t.size() < STEPS_PER_REV){
+    if (now - last >= (uint64_t)interval || t.empty()){ t.push_back(now); last = now; }
+    now += 2000 + 60;                                   // delay(2) + handleClient()
+    if (!blocked && t.size() > (size_t)STEPS_PER_REV / 2){ now += blockMs * 1000ULL; blocked = true; }
+  }
+  seconds = t.back() / 1e6;
+  return intervalStats(t, 0, t.size(), interval);
+}
+
+int simSteps(int argc, char** argv){
+  int rpm = argc > 1 ? atoi(argv[1]) : STEP_RPM;
+  uint32_t blockMs = argc > 2 ? (uint32_t)atoi(argv[2]) : 300;
+  uint32_t sps = (uint32_t)(rpm * STEPS_PER_REV / 60);
+  if (sps > 1200) sps = 1200;
+  if (sps < 50) sps = 50;
+  uint32_t ramp = (uint32_t)(sps / 2.4);
+
+  W::Engine engine(recordCoils);
+  engine.setSpeed(sps, 100, ramp);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) engine.move(m, (m & 1) ? -STEPS_PER_REV : STEPS_PER_REV);
+  for (bool busy = true; busy; simNowUs += STEP_TICK_US){
+    engine.tick();
+    busy = false;
+    for (uint8_t m = 0; m < MOTOR_COUNT; m++) busy |= engine.isRunning(m);
+  }
+
+  double ideal = 1e6 / sps;
+  int fails = 0;
+  printf("engine: %u sps (%d rpm), tick %u us, ramp %u steps\n", sps, rpm, STEP_TICK_US, ramp);
+  for (int m = 0; m < MOTOR_COUNT; m++){
+    const std::vector<uint64_t>& t = stepTimes[m];
+    if ((long)t.size() != STEPS_PER_REV){ printf("  M%d: FAIL %zu steps\n", m + 1, t.size()); fails++; continue; }
+    Stats c = intervalStats(t, ramp + 1, t.size() - ramp - 1, ideal);
+    printf("  M%d: rev %.3f s  cruise interval mean %.2f sd %.2f min %.0f max %.0f us, max err %.1f us (ideal %.2f)\n",
+           m + 1, t.back() / 1e6, c.mean, c.sd, c.minv, c.maxv, c.maxErr, ideal);
+    if (c.maxErr > STEP_TICK_US || fabs(c.mean - ideal) > 1.0){ printf("  M%d: FAIL jitter above one tick\n", m + 1); fails++; }
+  }
+
+  double secs;
+  Stats p = polledModel(sps, blockMs, secs);
+  printf("polled loop(): rev %.3f s, achieved %.0f sps, interval mean %.0f max %.0f us, max err %.0f us (%u ms handler)\n",
+         secs, STEPS_PER_REV / secs, p.mean, p.maxv, p.maxErr, blockMs);
+  return fails;
+}
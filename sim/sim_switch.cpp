@@ -0,0 +1,191 @@
+// Mode switch: edge-driven debounce and apply-once presets, on bouncy traces.
+//   winder_sim switch [moves] [seed]
+// Scripts lever moves between the three positions with contact bounce on
+// each pin, a pass through the middle position on 0 <-> 2, and short
+// glitches that return to where they were. The edges are fed to the
+// scheduler as the GPIO interrupt does (switchEdge(), then a pass), with
+// the clock jumping to the next edge or event. Checks each move is
+// delivered once, exactly the debounce time after its last edge, that
+// bounce, the middle position and glitches never are, and that the preset
+// lands on every motor. Then: a /config save on a preset position holds
+// until the switch moves, preset edits, and the boot rules.
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include "config.h"
+#include "mock_hal.h"
+#include "sim.h"
+#include "winder.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+typedef Winder<MOTOR_COUNT> W;
+static const uint32_t OLD_POLL_MS = 50;    // what the scheduler sampled at before
+
+struct Edge { uint64_t at; int pin, level; };
+struct Move { uint64_t lastEdge; int to; };
+
+static uint32_t rng;
+static uint32_t rnd(uint32_t n){ rng = rng * 1664525u + 1013904223u; return (rng >> 8) % n; }
+
+// Pin levels of a position (INPUT_PULLUP, closed = 0), as readModeRaw() decodes them
+static int levelA(int pos){ return pos == 0 ? 0 : 1; }
+static int levelB(int pos){ return pos == 2 ? 0 : 1; }
+
+// A pin settling to `level` from t: 0..6 bounces of 1..3 ms each; returns the last edge
+static uint64_t bounce(std::vector<Edge>& e, int pin, int level, uint64_t t){
+  int n = (int)rnd(7);
+  for (int i = 0; i < n; i++){
+    e.push_back({ t, pin, level });
+    t += 1 + rnd(3);
+    e.push_back({ t, pin, !level });
+    t += 1 + rnd(3);
+  }
+  e.push_back({ t, pin, level });
+  return t;
+}
+
+static void setPos(MockGpio& io, int pos){ io.level[MODE_PIN_A] = levelA(pos); io.level[MODE_PIN_B] = levelB(pos); }
+
+static W::Cmd presetCmd(uint8_t pos, bool manual, int tpd, int dir){
+  W::Cmd c{}; c.op = CMD_PRESET; c.preset = pos; c.manual = manual;
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){ c.tpd[m] = (int16_t)tpd; c.dir[m] = (int8_t)dir; }
+  return c;
+}
+
+static bool planIs(W::Scheduler& s, const SwitchPreset<MOTOR_COUNT>& p){
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) if (s.tpd(m) != p.tpd[m] || s.dirPlan(m) != p.dir[m]) return false;
+  return true;
+}
+
+static int traceRun(int moves){
+  int fails = 0;
+  MockClock clk; MockGpio io; MockStepper mot(clk, 680, 830);
+  W::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  W::Cmd edit = presetCmd(0, false, 650, DIR_ALT);             // position 0 edited away from the default
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) sched.setPlan(m, 300, DIR_CW);
+  setPos(io, 1);
+  clk.nowMs = 1000;
+  sched.begin();
+  sched.apply(edit);
+  CHECK(sched.mode() == 1 && sched.tpd(0) == 300);              // manual: settings kept
+
+  // Script: moves and glitches a few seconds apart
+  std::vector<Edge> edges;
+  std::vector<Move> want;
+  int pos = 1, glitches = 0, middles = 0;
+  uint64_t t = clk.nowMs + 5000;
+  for (int i = 0; i < moves; i++){
+    if (rnd(4) == 0){                                          // glitch: one pin flickers and returns
+      int pin = rnd(2) ? MODE_PIN_A : MODE_PIN_B, lvl = pin == MODE_PIN_A ? levelA(pos) : levelB(pos);
+      uint64_t end = t + 1 + rnd((uint32_t)MODE_DEBOUNCE_MS / 2);
+      edges.push_back({ t, pin, !lvl });
+      bounce(edges, pin, lvl, end);
+      glitches++;
+    } else {
+      int to = (pos + 1 + (int)rnd(2)) % 3;
+      uint64_t last = t;
+      if ((pos == 0 && to == 2) || (pos == 2 && to == 0)){       // through the middle, faster than the debounce
+        int open = pos == 0 ? MODE_PIN_A : MODE_PIN_B, close = to == 0 ? MODE_PIN_A : MODE_PIN_B;
+        last = bounce(edges, open, 1, t);
+        last = bounce(edges, close, 0, last + 2 + rnd((uint32_t)MODE_DEBOUNCE_MS / 2));
+        middles++;
+      } else {
+        if (levelA(pos) != levelA(to)) last = std::max(last, bounce(edges, MODE_PIN_A, levelA(to), t));
+        if (levelB(pos) != levelB(to)) last = std::max(last, bounce(edges, MODE_PIN_B, levelB(to), t));
+      }
+      want.push_back({ last, to });
+      pos = to;
+    }
+    t += 2000 + rnd(60000);
+  }
+  std::stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b){ return a.at < b.at; });
+
+  // Motion task: wake on an edge (ISR notify) or the next event
+  const uint64_t end = t + 10000;
+  uint64_t wakes = 0, edgeWakes = 0, moving = 0;
+  size_t e = 0, delivered = 0;
+  int last = sched.mode();
+  bool early = false, late = false, wrongPlan = false, extra = false;
+  while (clk.nowMs < end){
+    bool edge = false;
+    while (e < edges.size() && edges[e].at <= clk.nowMs){ io.level[edges[e].pin] = edges[e].level; e++; edge = true; }
+    if (edge){ sched.switchEdge(); edgeWakes++; }
+    sched.poll();
+    wakes++;
+    if (sched.mode() != last){
+      last = sched.mode();
+      if (delivered >= want.size() || want[delivered].to != last) extra = true;
+      else {
+        uint64_t at = want[delivered].lastEdge + MODE_DEBOUNCE_MS;
+        if (clk.nowMs < at) early = true;
+        if (clk.nowMs > at) late = true;
+        if (!sched.preset((uint8_t)last).manual && !planIs(sched, sched.preset((uint8_t)last))) wrongPlan = true;
+        delivered++;
+      }
+    }
+    uint64_t next = sched.nextEventMs();
+    if (next <= clk.nowMs){ moving++; next = clk.nowMs + 2; }
+    if (e < edges.size() && edges[e].at < next) next = edges[e].at;
+    clk.nowMs = next;
+  }
+  CHECK(!extra && !early && !late && !wrongPlan);
+  CHECK(delivered == want.size());
+  uint64_t span = end - 6000;
+  printf("  %zu moves (%d through the middle), %d glitches, %zu edges: %zu deliveries, each %lu ms after its last edge\n",
+         want.size(), middles, glitches, edges.size(), delivered, (unsigned long)MODE_DEBOUNCE_MS);
+  printf("  idle motion-task wakeups over %.1f h: %llu (%llu on edges) vs %llu sampling the pins every %u ms\n",
+         span / 3600000.0, (unsigned long long)(wakes - moving), (unsigned long long)edgeWakes,
+         (unsigned long long)(span / OLD_POLL_MS), OLD_POLL_MS);
+  return fails;
+}
+
+// A /config save on a preset position holds; edits; what boot applies
+static int ruleChecks(){
+  int fails = 0;
+  MockClock clk; MockGpio io; MockStepper mot(clk, 680, 830);
+  W::Scheduler s(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) s.setPlan(m, 300, DIR_CW);
+  setPos(io, 0);
+  clk.nowMs = 1000;
+  s.begin();                                                   // nothing applied yet: preset 0 lands
+  CHECK(s.mode() == 0 && planIs(s, switchPresetsDefault<MOTOR_COUNT>().pos[0]));
+
+  W::Cmd c{}; c.op = CMD_CONFIG; c.program = s.program();
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){ c.tpd[m] = 720; c.dir[m] = DIR_CCW; }
+  s.apply(c);
+  for (int i = 0; i < 1800; i++){ clk.advance(2000); s.poll(); }   // an hour of passes
+  CHECK(s.tpd(0) == 720 && s.dirPlan(0) == DIR_CCW);
+
+  s.apply(presetCmd(2, false, 444, DIR_CW));                   // another position: stored only
+  CHECK(s.tpd(0) == 720 && s.preset(2).tpd[0] == 444);
+  s.apply(presetCmd(0, false, 555, DIR_CW));                   // the selected one: applies now
+  CHECK(s.tpd(0) == 555 && s.dirPlan(0) == DIR_CW);
+  s.apply(presetCmd(0, true, 0, 0));                           // made manual: settings stay
+  CHECK(s.tpd(0) == 555);
+
+  // Boot: the position the saved settings came from isn't re-applied; a new one is
+  MockStepper mot2(clk, 680, 830);
+  W::Scheduler b(clk, io, mot2, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) b.setPlan(m, 720, DIR_CCW);
+  b.setSwitchApplied(0);
+  b.begin();
+  CHECK(b.tpd(0) == 720);
+  setPos(io, 2);
+  W::Scheduler b2(clk, io, mot2, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) b2.setPlan(m, 720, DIR_CCW);
+  b2.setSwitchApplied(0);
+  b2.begin();                                                  // moved while off
+  CHECK(b2.mode() == 2 && planIs(b2, switchPresetsDefault<MOTOR_COUNT>().pos[2]));
+  return fails;
+}
+
+int simSwitch(int argc, char** argv){
+  int moves = argc > 1 ? atoi(argv[1]) : 400;
+  rng = argc > 2 ? (uint32_t)atoi(argv[2]) : 7;
+  int fails = ruleChecks();
+  fails += traceRun(moves);
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
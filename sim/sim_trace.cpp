@@ -0,0 +1,161 @@
+// Trace ring: integrity under concurrent writers, and what a record costs
+// against the Serial.printf line it replaces.
+//   winder_sim trace [records] [dump.bin]
+// Three writer threads add records (a stand-in for the two cores and an
+// ISR) while a reader follows them with a cursor, as the serial console
+// does. Every record read must be whole (fields derived from one counter
+// agree), appear once, and keep each writer's order; afterwards the ring
+// must hold exactly the newest records. Then times add() against a modelled
+// blocking printf at 115200 baud once the UART FIFO is full. With a file
+// name, writes a /trace body for tools/trace_decode.py.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "sim.h"
+#include "trace_ring.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+static const uint16_t RING = 256;
+static const int WRITERS = 3;
+static TraceRing<RING> ring;
+
+// Writer w's k-th record: id w+1, a = k & 255, b = k, at k ms + w us.
+// Some work between records, so the reader keeps up most of the time and
+// its reads overlap the writes.
+static void writer(int w, uint32_t n){
+  for (uint32_t k = 0; k < n; k++){
+    ring.add((uint8_t)(w + 1), (uint8_t)k, k, (uint64_t)k * 1000 + (uint64_t)w);
+    for (volatile int spin = 0; spin < 300; spin++) {}
+  }
+}
+static bool whole(const TraceRec& r){
+  return r.id >= 1 && r.id <= WRITERS && r.us == r.id - 1 && r.a == (uint8_t)r.b && r.ms == r.b;
+}
+
+static int concurrent(uint32_t n, uint64_t& readCount, uint64_t& dropped){
+  int fails = 0;
+  std::atomic<bool> done{false};
+  uint64_t got = 0, skipped = 0;
+  bool torn = false, dup = false, order = false;
+  std::thread reader([&]{
+    uint32_t at = 0, lastSeq = 0;
+    int64_t last[WRITERS + 1];
+    for (int64_t& v : last) v = -1;
+    TraceRec buf[32];
+    for (;;){
+      bool fin = done.load();
+      uint32_t was = at;
+      size_t k = ring.read(at, buf, 32);
+      for (size_t i = 0; i < k; i++){
+        const TraceRec& r = buf[i];
+        if (!whole(r)){ torn = true; continue; }
+        if (r.seq <= lastSeq) dup = true;
+        skipped += r.seq - lastSeq - 1;
+        lastSeq = r.seq;
+        if ((int64_t)r.b <= last[r.id]) order = true;
+        last[r.id] = r.b;
+        got++;
+      }
+      if (fin && !k && at == ring.head()) break;
+      if (!k && at == was) std::this_thread::yield();
+    }
+  });
+  std::thread ws[WRITERS];
+  for (int w = 0; w < WRITERS; w++) ws[w] = std::thread(writer, w, n);
+  for (std::thread& t : ws) t.join();
+  done = true;
+  reader.join();
+  CHECK(!torn && !dup && !order);
+  CHECK(ring.head() == (uint32_t)WRITERS * n);
+  CHECK(got + skipped == (uint64_t)WRITERS * n);
+
+  // Quiet now: the ring is exactly the newest RING records
+  uint32_t at = 0;
+  TraceRec all[RING];
+  size_t k = ring.read(at, all, RING);
+  CHECK(k == RING && at == ring.head() && ring.oldest() == ring.head() - RING);
+  for (size_t i = 0; i < k; i++) CHECK(whole(all[i]) && all[i].seq == ring.oldest() + 1 + i);
+  readCount = got; dropped = skipped;
+  return fails;
+}
+
+static int formatChecks(){
+  int fails = 0;
+  char s[96];
+  TraceRec r{ 7, 12345, 678, TR_ROTATE, 0x81, 3 };
+  traceFormat(r, s, sizeof(s));
+  CHECK(!strcmp(s, "   12.345 rotate m2 CCW, 3 ms late"));
+  r.id = TR_STA_IP; r.a = 2; r.b = 192 | 168u << 8 | 4u << 16 | 2u << 24;
+  traceFormat(r, s, sizeof(s));
+  CHECK(!strcmp(s, "   12.345 STA: IP 192.168.4.2, attempt 2"));
+  r.id = TR_BOOT; r.a = 2; r.b = 812;
+  traceFormat(r, s, sizeof(s));
+  CHECK(!strcmp(s, "   12.345 boot warm, restored in 812 us"));
+  r.id = 200;
+  size_t n = traceFormat(r, s, 12);                            // truncated, still terminated
+  CHECK(n == 11 && strlen(s) == 11);
+  for (uint8_t id = 1; id < TR_EVENT_COUNT; id++){            // every event has its own wording
+    r.id = id; traceFormat(r, s, sizeof(s));
+    CHECK(!strstr(s, "event ") || id == TR_WIFI_EVENT);
+  }
+  return fails;
+}
+
+// A /trace body as main.cpp's sendTrace() writes it
+static bool dump(const char* path){
+  static TraceRing<32> t;
+  uint64_t us = 1500;
+  t.add(TR_BOOT, 2, 812, us);
+  t.add(TR_AP_UP, 6, 0, us += 40000);
+  t.add(TR_STA_JOIN, 1, 0, us += 2000);
+  t.add(TR_STA_IP, 1, 192 | 168u << 8 | 1u << 16 | 37u << 24, us += 2100000);
+  t.add(TR_MDNS, 0, 0x1a2b3c, us += 300);
+  for (int i = 0; i < 8; i++) t.add(TR_ROTATE, (uint8_t)((i & 1) | (i & 2 ? 0x80 : 0)), (uint32_t)i % 3, us += 180000);
+  t.add(TR_HTTP, 1, 2480, us += 5000);
+  t.add(TR_PREFS, 1, 19000, us += 3000000);
+  TraceDumpHeader hd{ {'W','T','R','1'}, 1, (uint8_t)sizeof(TraceRec), 32, t.head(), (uint32_t)(us / 1000) + 250 };
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  fwrite(&hd, sizeof(hd), 1, f);
+  TraceRec r[32];
+  uint32_t at = t.oldest();
+  size_t n = t.read(at, r, 32);
+  fwrite(r, sizeof(TraceRec), n, f);
+  fclose(f);
+  printf("  wrote %s: %zu records (python3 tools/trace_decode.py %s)\n", path, n, path);
+  return true;
+}
+
+int simTrace(int argc, char** argv){
+  uint32_t n = argc > 1 ? (uint32_t)atoi(argv[1]) : 300000;
+  int fails = formatChecks();
+  uint64_t got, dropped;
+  fails += concurrent(n, got, dropped);
+
+  // add() alone, single writer
+  const int N = 10000000;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < N; i++) ring.add(TR_HTTP, (uint8_t)i, (uint32_t)i, (uint64_t)i);
+  double addNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / N;
+
+  // The line it replaces: once the 128-byte UART FIFO is full, printf
+  // returns only after the line is on the wire, 10 bits per byte
+  const double BYTE_US = 10 * 1e6 / 115200;
+  char line[96];
+  TraceRec r{ 1, 9000, 0, TR_PREFS, 1, 19000 };
+  size_t len = traceFormat(r, line, sizeof(line)) + 1;
+  double printfUs = len * BYTE_US;
+
+  printf("  %d writers x %lu records: %llu read by a concurrent reader, %llu overwritten before it got there, none torn\n",
+         WRITERS, (unsigned long)n, (unsigned long long)got, (unsigned long long)dropped);
+  printf("  add(): %.1f ns; the %zu-byte Serial line it replaces blocks %.0f us once the FIFO is full\n",
+         addNs, len, printfUs);
+  CHECK(addNs < 1000);
+  if (argc > 2 && !dump(argv[2])) CHECK(!"dump file");
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
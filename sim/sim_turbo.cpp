@@ -0,0 +1,65 @@
+// Turbo: a planned session of whole rotations against the requested time.
+//   winder_sim turbo
+// Runs turbo sessions on the real step engine, tick by tick, for a few
+// speeds, both ramp profiles and 1..15 minutes, and prints when each
+// session ends against its deadline and how far turbo_left_ms was off;
+// also a start in the middle of a scheduled rotation, a second request
+// replacing a running session and a budget-held start. The old
+// implementation (pre-queued span, two-turn top-ups, drain after the
+// deadline) runs on the same engine for comparison. The end/rotation
+// checks are test/test_turbo.
+#include <stdio.h>
+#include <stdlib.h>
+#include "replay.h"
+#include "sim.h"
+
+typedef ReplayWinder W;
+
+// The replaced implementation, on the same engine
+static int64_t legacy(int rpm, uint8_t profile, uint32_t minutes){
+  MockClock clk;
+  W::Engine engine(replayNoCoils);
+  replaySetup(engine, rpm, profile, 0);
+  long span = 6L * STEPS_PER_REV * (long)minutes;
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) engine.move(m, span);
+  uint64_t deadline = minutes * 60000ULL;
+  for (;;){
+    bool idle = true;
+    for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+      if (engine.distanceToGo(m) != 0){ idle = false; continue; }
+      if (clk.nowMs < deadline) engine.move(m, 2L * STEPS_PER_REV);
+    }
+    if (idle && clk.nowMs >= deadline) break;
+    replayRunMs(engine, clk);
+  }
+  return (int64_t)clk.nowMs - (int64_t)deadline;
+}
+
+int simTurbo(int argc, char** argv){
+  (void)argc; (void)argv;
+  struct Case { int rpm; uint8_t profile; };
+  const Case cases[] = { { STEP_RPM, RAMP_TRAPEZOID }, { STEP_RPM, RAMP_SCURVE }, { 10, RAMP_TRAPEZOID } };
+  const uint32_t mins[] = { 1, 5, 15 };
+  int64_t worst = 0, worstOld = 0;
+  for (const Case& k : cases){
+    for (uint32_t min : mins){
+      TurboSession s = turboSession(k.rpm, k.profile, min, false, false, 0);
+      int64_t old = k.profile == RAMP_TRAPEZOID ? legacy(k.rpm, k.profile, min) : 0;
+      printf("  %2d rpm %-9s %2u min: %4u turns, ends %+6lld ms (half rotation %4.0f ms), left_ms off %+4lld ms",
+             k.rpm, rampProfileName(k.profile), min, s.turns / MOTOR_COUNT, (long long)s.errMs, s.revMs / 2, (long long)s.leftErrMs);
+      if (k.profile == RAMP_TRAPEZOID) printf("; old code %+6lld ms", (long long)old);
+      printf("\n");
+      if ((s.errMs < 0 ? -s.errMs : s.errMs) > worst) worst = s.errMs < 0 ? -s.errMs : s.errMs;
+      if ((old < 0 ? -old : old) > worstOld) worstOld = old < 0 ? -old : old;
+    }
+  }
+  // Pressed mid-rotation; replaced part-way; with the budget staggering the starts
+  TurboSession mid = turboSession(STEP_RPM, RAMP_TRAPEZOID, 5, true, false, 0);
+  TurboSession rep = turboSession(STEP_RPM, RAMP_TRAPEZOID, 5, false, true, 0);
+  TurboSession held = turboSession(STEP_RPM, RAMP_TRAPEZOID, 5, false, false, POWER_BUDGET_MA);
+  double ramp = replayRampMs(STEP_RPM, RAMP_TRAPEZOID);
+  printf("  mid-rotation start: ends %+lld ms; replaced after 1 min by 2 min: ends %+lld ms; budget %u mA: ends %+lld ms (ramp %.0f ms)\n",
+         (long long)mid.errMs, (long long)rep.errMs, POWER_BUDGET_MA, (long long)held.errMs, ramp);
+  printf("  worst end error %lld ms, old code %lld ms\n", (long long)worst, (long long)worstOld);
+  return 0;
+}
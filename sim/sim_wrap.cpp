@@ -0,0 +1,150 @@
+// Tickless scheduling across the 32-bit millis() wrap (49.7 days of uptime).
+//   winder_sim wrap [days]
+// Starts the 64-bit clock 20 minutes before 2^32 ms and replays the motion
+// task as the firmware runs it: sleep until nextEventMs(), 2 ms passes only
+// while a motor moves. Checks every rotation starts exactly on its grid, a
+// turbo straddling the wrap ends on time, status countdowns age correctly
+// over a 32-bit wrap, and the event heap against a linear scan. Reports
+// wakeups per day against the old fixed 2 ms pass.
+#include <stdio.h>
+#include <stdlib.h>
+#include "config.h"
+#include "mock_hal.h"
+#include "sim.h"
+#include "winder.h"
+
+#define CHECK(c) do { if (!(c)){ printf("  FAIL %s:%d %s\n", __FILE__, __LINE__, #c); fails++; } } while (0)
+
+typedef Winder<MOTOR_COUNT> W;
+static const uint64_t WRAP = 1ULL << 32;
+static const uint64_t PASS_MS = 2;
+
+// One motion-task wake: a pass, then the wait the firmware computes
+template <class S>
+static void step(S& sched, MockClock& clk, uint64_t& wakes, uint64_t& moving){
+  sched.poll();
+  wakes++;
+  uint64_t next = sched.nextEventMs();
+  if (next <= clk.nowMs){ moving++; next = clk.nowMs + PASS_MS; }
+  clk.nowMs = next;
+}
+
+static int gridRun(int days){
+  int fails = 0;
+  uint32_t sps = (uint32_t)(STEP_RPM * STEPS_PER_REV / 60);
+  MockClock clk;
+  MockGpio io;
+  MockStepper mot(clk, sps, 830);
+  W::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) sched.setPlan(m, MOTOR_TABLE[m].tpd, DIR_ALT);
+  clk.nowMs = WRAP - 20 * 60000ULL;
+  const uint64_t t0 = clk.nowMs, end = t0 + (uint64_t)days * 86400000ULL;
+  sched.begin();
+
+  uint64_t wakes = 0, moving = 0;
+  while (clk.nowMs < end) step(sched, clk, wakes, moving);
+
+  uint64_t late = 0, early = 0, acrossWrap = 0;
+  uint32_t count[MOTOR_COUNT] = {0};
+  for (const MockStepper::MoveLog& l : mot.log){
+    uint64_t iv = W::Scheduler::intervalFromTPD(sched.tpd(l.motor));
+    uint64_t k = ++count[l.motor], due = t0 + k * iv;
+    if (l.atMs > due) late++;
+    if (l.atMs < due) early++;
+    if (due > WRAP - iv && due <= WRAP + iv) acrossWrap++;
+  }
+  double perDay = (double)wakes / days;
+  printf("  %d days from 2^32 - 20 min: %zu rotations (%llu around the wrap), %llu late, %llu early\n",
+         days, mot.log.size(), (unsigned long long)acrossWrap, (unsigned long long)late, (unsigned long long)early);
+  printf("  motion-task wakeups/day: %.0f (%.0f idle, %.0f while stepping) vs %.0f at a fixed 2 ms pass\n",
+         perDay, (double)(wakes - moving) / days, (double)moving / days, 86400000.0 / PASS_MS);
+  CHECK(late == 0 && early == 0);
+  CHECK(acrossWrap >= MOTOR_COUNT);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++)
+    CHECK(count[m] == (uint32_t)((end - t0) / W::Scheduler::intervalFromTPD(sched.tpd(m))) || count[m] + 1 == (uint32_t)((end - t0) / W::Scheduler::intervalFromTPD(sched.tpd(m))));
+  CHECK(perDay < 86400000.0 / PASS_MS / 10);
+  return fails;
+}
+
+static int turboRun(){
+  int fails = 0;
+  uint32_t sps = (uint32_t)(STEP_RPM * STEPS_PER_REV / 60);
+  MockClock clk;
+  MockGpio io;
+  MockStepper mot(clk, sps, 830);
+  W::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) sched.setPlan(m, MOTOR_TABLE[m].tpd, DIR_ALT);
+  clk.nowMs = WRAP - 2 * 60000ULL;
+  sched.begin();
+  W::Cmd c{}; c.op = CMD_TURBO; c.minutes = 5; c.mask = 1;
+  sched.apply(c);
+  const uint64_t endAt = clk.nowMs + 5 * 60000ULL;
+
+  uint64_t wakes = 0, moving = 0, stoppedAt = 0;
+  int32_t lastLeft = INT32_MAX;
+  bool monotonic = true;
+  while (clk.nowMs < endAt + 60000 && !stoppedAt){
+    step(sched, clk, wakes, moving);
+    W::Status st{}; sched.fillStatus(st);
+    if (st.turboActive){ if (st.turboLeftMs > lastLeft) monotonic = false; lastLeft = st.turboLeftMs; }
+    else stoppedAt = clk.nowMs;
+  }
+  // Ends on a rotation boundary within half a rotation of the deadline
+  uint64_t rotMs = (uint64_t)STEPS_PER_REV * 1000 / sps;
+  int64_t err = (int64_t)stoppedAt - (int64_t)endAt;
+  printf("  turbo 5 min across the wrap: ended %+lld ms from its deadline (rotation %llu ms)\n",
+         (long long)err, (unsigned long long)rotMs);
+  CHECK(stoppedAt && (uint64_t)(err < 0 ? -err : err) <= rotMs / 2 + PASS_MS);
+  CHECK(monotonic);
+  return fails;
+}
+
+static int unitChecks(){
+  int fails = 0;
+  // Countdown aged across a 32-bit wrap of the stamp
+  W::Status st{};
+  st.stampMs = 0xFFFFFF00u; st.nextMs[0] = 1000; st.turboLeftMs = 100;
+  for (uint8_t m = 1; m < MOTOR_COUNT; m++) st.nextMs[m] = -1;
+  statusAge(st, 0x00000100u);
+  CHECK(st.nextMs[0] == 1000 - 512 && st.turboLeftMs == 0 && st.stampMs == 0x100u);
+  if (MOTOR_COUNT > 1) CHECK(st.nextMs[1] == -1);
+
+  // Event heap against a linear scan
+  EventHeap<24> h;
+  uint64_t ref[24];
+  for (uint64_t& r : ref) r = EventHeap<24>::NEVER;
+  uint32_t seed = 12345;
+  for (int i = 0; i < 20000; i++){
+    seed = seed * 1103515245u + 12345u;
+    uint8_t id = (uint8_t)((seed >> 16) % 24);
+    if ((seed >> 8) & 3){ uint64_t t = WRAP - 5000 + ((seed >> 4) % 10000); h.set(id, t); ref[id] = t; }
+    else { h.clear(id); ref[id] = EventHeap<24>::NEVER; }
+    uint64_t best = EventHeap<24>::NEVER;
+    for (uint64_t r : ref) if (r < best) best = r;
+    if (h.topAt() != best || (!h.empty() && ref[h.top()] != best)){ fails++; printf("  FAIL heap order at op %d\n", i); break; }
+  }
+
+  // Duty meter: 2 s stepping + 100 ms of passes in a 10 s window = 79% idle
+  DutyMeter d;
+  d.roll(0);
+  d.stepping(true, 1000000); d.stepping(false, 3000000);
+  d.busy(100000); d.wake(); d.wake();
+  d.roll(DUTY_WINDOW_MS * 1000ULL);
+  CHECK(d.idlePermille() == 790 && d.last().wakeups == 2);
+
+  // The old 32-bit form: a deadline computed just before the wrap wraps to a
+  // small number, and "now >= due" is true at once
+  uint32_t now32 = 0xFFFFFFFFu - 1000, due32 = now32 + 132923;
+  bool oldFires = !(now32 < due32);
+  printf("  32-bit 'now < due' replica, armed 1 s before the wrap: %s\n", oldFires ? "fires 131.9 s early" : "on time");
+  CHECK(oldFires);   // the failure mode the 64-bit clock removes
+  return fails;
+}
+
+int simWrap(int argc, char** argv){
+  int days = argc > 1 ? atoi(argv[1]) : 2;
+  if (days < 1) days = 1;
+  int fails = gridRun(days) + turboRun() + unitChecks();
+  printf("  %s\n", fails ? "FAILED" : "ok");
+  return fails;
+}
@@ -0,0 +1,192 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "web_host.h"
+
+uint64_t webNowUs(){
+  timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void nonBlocking(int fd){ fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK); }
+
+// Header end and Content-Length of an HTTP message in `s`; false until the header is complete
+static bool httpHead(const std::string& s, size_t& bodyAt, long& length){
+  size_t e = s.find("\r\n\r\n");
+  if (e == std::string::npos) return false;
+  bodyAt = e + 4; length = -1;
+  for (size_t p = s.find("\r\n"); p < e; p = s.find("\r\n", p + 2)){
+    if (!strncasecmp(s.c_str() + p + 2, "content-length:", 15)){ length = atol(s.c_str() + p + 17); break; }
+  }
+  return true;
+}
+
+// Value of header `name` (with the colon) up to the line end, or ""
+static std::string httpHeader(const std::string& s, size_t end, const char* name){
+  size_t k = strlen(name);
+  for (size_t p = s.find("\r\n"); p < end; p = s.find("\r\n", p + 2)){
+    if (strncasecmp(s.c_str() + p + 2, name, k)) continue;
+    size_t a = p + 2 + k, b = s.find("\r\n", a);
+    while (a < b && s[a] == ' ') a++;
+    return s.substr(a, b - a);
+  }
+  return "";
+}
+
+// ===================== Server =====================
+bool WebHost::listen(uint16_t port){
+  fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd_ < 0) return false;
+  int on = 1; setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in a{}; a.sin_family = AF_INET; a.sin_port = htons(port); a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(fd_, (sockaddr*)&a, sizeof(a)) < 0 || ::listen(fd_, 64) < 0){ ::close(fd_); fd_ = -1; return false; }
+  socklen_t l = sizeof(a); getsockname(fd_, (sockaddr*)&a, &l); port_ = ntohs(a.sin_port);
+  nonBlocking(fd_);
+  return true;
+}
+
+void WebHost::close(){ if (fd_ >= 0) ::close(fd_); fd_ = -1; }
+
+class SocketResp : public WebResp {
+public:
+  explicit SocketResp(int fd) : fd_(fd) {}
+  void header(const char* name, const char* value) override { extra_ += name; extra_ += ": "; extra_ += value; extra_ += "\r\n"; }
+  void send(int code, const char* type, const char* body, size_t n) override {
+    char head[160];
+    int h = snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n",
+                     code, code < 300 ? "OK" : code == 304 ? "Not Modified" : "Error", type, n);
+    std::string out(head, (size_t)h);
+    out += extra_; out += "Connection: close\r\n\r\n"; out.append(body, n);
+    for (size_t at = 0; at < out.size();){
+      ssize_t w = ::send(fd_, out.data() + at, out.size() - at, MSG_NOSIGNAL);
+      if (w <= 0) break;
+      at += (size_t)w;
+    }
+    sent = true;
+  }
+  bool sent = false;
+
+private:
+  int fd_;
+  std::string extra_;
+};
+
+bool WebHost::handleClient(int waitMs, WebDispatch fn, void* ctx){
+  if (waitMs){ pollfd p{ fd_, POLLIN, 0 }; if (::poll(&p, 1, waitMs) <= 0) return false; }
+  int c = accept(fd_, nullptr, nullptr);
+  if (c < 0) return false;
+  lastAtUs_ = webNowUs();
+  timeval tv{ 1, 0 }; setsockopt(c, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  int on = 1; setsockopt(c, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  std::string in;
+  size_t at = 0; long len = 0;
+  char buf[2048];
+  for (;;){
+    bool head = httpHead(in, at, len);
+    if (head && in.size() >= at + (size_t)(len < 0 ? 0 : len)) break;
+    ssize_t got = recv(c, buf, sizeof(buf), 0);
+    if (got <= 0){ ::close(c); lastUs_ = (uint32_t)(webNowUs() - lastAtUs_); return true; }   // gave up, as WebServer does
+    in.append(buf, (size_t)got);
+  }
+  char method[8] = "", path[128] = "";
+  sscanf(in.c_str(), "%7s %127s", method, path);
+  if (char* q = strchr(path, '?')) *q = 0;
+  std::string inm = httpHeader(in, at, "if-none-match:");
+  WebReq r{ (uint8_t)(strcmp(method, "POST") ? WEB_GET : WEB_POST), path, in.c_str() + at, in.size() - at, inm.c_str() };
+  SocketResp o(c);
+  if (!fn(r, o, ctx) && !o.sent) o.send(404, "text/plain", "not found", 9);
+  ::close(c);
+  lastUs_ = (uint32_t)(webNowUs() - lastAtUs_);
+  return true;
+}
+
+// ===================== Load =====================
+enum LoadState : uint8_t { L_CONNECTING, L_SENDING, L_READING };
+struct LoadConn { int fd = -1; LoadState st = L_CONNECTING; uint8_t req = 0; std::string out, in; size_t sent = 0; uint64_t t0 = 0; };
+
+static uint32_t nextRand(uint32_t& s){ s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; }
+
+static bool openConn(LoadConn& c, uint16_t port, const LoadReq* mix, size_t n, uint32_t total, uint32_t& seed){
+  uint32_t pick = nextRand(seed) % total;
+  uint8_t k = 0;
+  while ((size_t)k + 1 < n && pick >= mix[k].weight){ pick -= mix[k].weight; k++; }
+  const LoadReq& q = mix[k];
+  size_t blen = q.body ? strlen(q.body) : 0;
+  char head[256];
+  snprintf(head, sizeof(head), "%s %s HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: application/json\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+           q.method, q.path, blen);
+  c.out = head; if (blen) c.out.append(q.body, blen);
+  c.in.clear(); c.sent = 0; c.req = k; c.t0 = webNowUs();
+  c.fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (c.fd < 0) return false;
+  nonBlocking(c.fd);
+  sockaddr_in a{}; a.sin_family = AF_INET; a.sin_port = htons(port); a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(c.fd, (sockaddr*)&a, sizeof(a)) < 0 && errno != EINPROGRESS){ ::close(c.fd); c.fd = -1; return false; }
+  c.st = L_CONNECTING;
+  return true;
+}
+
+LoadResult webLoad(uint16_t port, const LoadReq* mix, size_t n, uint16_t clients, double seconds, uint32_t seed){
+  LoadResult res;
+  if (n > sizeof(res.us) / sizeof(res.us[0])) n = sizeof(res.us) / sizeof(res.us[0]);
+  uint32_t total = 0;
+  for (size_t i = 0; i < n; i++) total += mix[i].weight;
+  std::vector<LoadConn> conns(clients);
+  std::vector<pollfd> pfd(clients);
+  seed |= 1;
+  uint64_t start = webNowUs(), end = start + (uint64_t)(seconds * 1e6);
+  for (LoadConn& c : conns) if (!openConn(c, port, mix, n, total, seed)) res.failed++;
+  char buf[4096];
+  for (;;){
+    bool any = false;
+    for (uint16_t i = 0; i < clients; i++){
+      pfd[i].fd = conns[i].fd;
+      pfd[i].events = conns[i].st == L_READING ? POLLIN : POLLOUT;
+      pfd[i].revents = 0;
+      any |= conns[i].fd >= 0;
+    }
+    if (!any) break;
+    int k = ::poll(pfd.data(), clients, 100);
+    if (k < 0 && errno != EINTR) break;
+    for (uint16_t i = 0; i < clients && k > 0; i++){
+      LoadConn& c = conns[i];
+      if (!pfd[i].revents || c.fd < 0) continue;
+      if (c.st == L_CONNECTING){
+        int err = 0; socklen_t l = sizeof(err);
+        getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &l);
+        c.st = err ? L_READING : L_SENDING;       // a failed connect reads EOF below
+      }
+      if (c.st == L_SENDING){
+        ssize_t w = send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+        if (w > 0) c.sent += (size_t)w;
+        if (w < 0 && errno != EAGAIN) c.st = L_READING;
+        else if (c.sent == c.out.size()) c.st = L_READING;
+        continue;
+      }
+      ssize_t got = recv(c.fd, buf, sizeof(buf), 0);
+      if (got < 0 && errno == EAGAIN) continue;
+      if (got > 0) c.in.append(buf, (size_t)got);
+      size_t at; long len;
+      bool whole = httpHead(c.in, at, len) && len >= 0 && c.in.size() >= at + (size_t)len;
+      if (got > 0 && !whole) continue;
+      int status = c.in.compare(0, 5, "HTTP/") == 0 ? atoi(c.in.c_str() + 9) : -1;
+      ::close(c.fd); c.fd = -1;
+      if ((status >= 200 && status < 300) || status == 304){ res.ok++; res.us[c.req].push_back((uint32_t)(webNowUs() - c.t0)); }
+      else if (status == 503) res.busy++;
+      else res.failed++;
+      if (webNowUs() < end && !openConn(c, port, mix, n, total, seed)) res.failed++;
+    }
+  }
+  res.seconds = (webNowUs() - start) / 1e6;
+  return res;
+}
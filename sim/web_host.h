@@ -0,0 +1,47 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "web_routes.h"
+
+// ===================== Host HTTP stand-in =====================
+// WebHost serves web_routes.h handlers on a loopback socket the way the
+// firmware's WebServer does: one client at a time, the whole request read
+// before the handler runs, Connection: close after the answer. webLoad()
+// drives it from `clients` concurrent connections, each sending its next
+// request as soon as the last one is answered.
+
+typedef bool (*WebDispatch)(const WebReq& r, WebResp& o, void* ctx);
+
+class WebHost {
+public:
+  ~WebHost(){ close(); }
+  bool listen(uint16_t port = 0);                 // 127.0.0.1; 0: any free port
+  uint16_t port() const { return port_; }
+  // Serves one waiting client, waiting up to waitMs for one (0: just look).
+  // False when nobody came.
+  bool handleClient(int waitMs, WebDispatch fn, void* ctx);
+  void close();
+  // The last client served: accepted at (webNowUs()), accept to close
+  uint64_t lastAtUs() const { return lastAtUs_; }
+  uint32_t lastUs() const { return lastUs_; }
+
+private:
+  int fd_ = -1;
+  uint16_t port_ = 0;
+  uint64_t lastAtUs_ = 0;
+  uint32_t lastUs_ = 0;
+};
+
+struct LoadReq { const char* method; const char* path; const char* body; uint8_t weight; };
+struct LoadResult {
+  std::vector<uint32_t> us[8];     // latency per LoadReq, connect to the last byte
+  uint32_t ok = 0, busy = 0, failed = 0;   // 2xx/304, 503, anything else
+  double seconds = 0;
+};
+
+// Closed loop for `seconds`: each client picks a request by weight
+// (deterministically, from `seed`), waits for the answer, repeats.
+LoadResult webLoad(uint16_t port, const LoadReq* mix, size_t n, uint16_t clients, double seconds, uint32_t seed);
+
+uint64_t webNowUs();   // monotonic
@@ -1,593 +1,1213 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <WebServer.h>
-#include <ESPmDNS.h>
+#include <AsyncUDP.h>
 #include <Preferences.h>
-#include <ArduinoJson.h>
-#include <AccelStepper.h>
+#include <soc/gpio_struct.h>
+#include <esp32-hal-spi.h>
+#include <soc/spi_struct.h>
+#include <esp_timer.h>
+#include <esp_pm.h>
+#include <esp_system.h>
+#include <esp_attr.h>
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+#include <esp_rtc_time.h>
+#else
+#include <soc/rtc.h>
+#include <esp32/clk.h>
+#endif
 #include "config.h"
+#include "wifi_mgr.h"
+#include "winder.h"
+#include "coil_driver.h"
+#include "json_in.h"
+#include "metrics.h"
+#include "trace.h"
+#include "fleet_beacon.h"
+#include "web_routes.h"
+#include "ctl_server.h"
+#include "ws_frame.h"
+
+// ===================== Trace =====================
+static TraceRing<TRACE_RECORDS> traceRing;
+void IRAM_ATTR trace(TraceEvent id, uint8_t a, uint32_t b){ traceRing.add(id, a, b, (uint64_t)esp_timer_get_time()); }
 
 // ===================== Motion =====================
-AccelStepper s1(AccelStepper::HALF4WIRE, M1_IN1, M1_IN3, M1_IN2, M1_IN4);
-AccelStepper s2(AccelStepper::HALF4WIRE, M2_IN1, M2_IN3, M2_IN2, M2_IN4);
+// Everything per-motor is sized from config.h's MOTOR_TABLE.
+typedef Winder<MOTOR_COUNT> W;
+
+#if COILS_SHIFT_REGISTER
+// 74HC595 chain: the whole frame goes out in one SPI burst, then a latch pulse.
+// The HAL sets VSPI up; the ISR drives its registers directly because
+// spiWriteNL() takes a mutex.
+static_assert(SR_LATCH < 32, "latch pin must be in GPIO bank 0");
+static ShiftFrame<MOTOR_COUNT> coilFrame;
+static spi_t* coilSpi=nullptr;
+static void IRAM_ATTR writeCoils(MotorMask changed, const uint8_t* coils){
+  coilFrame.update(changed, coils);
+  uint32_t w[(coilFrame.BYTES + 3) / 4] = {};
+  memcpy(w, coilFrame.data(), coilFrame.BYTES);
+  SPI3.mosi_dlen.usr_mosi_dbitlen = coilFrame.BYTES * 8 - 1;
+  for (size_t i=0;i<sizeof(w)/4;i++) SPI3.data_buf[i] = w[i];
+  SPI3.cmd.usr = 1;
+  while (SPI3.cmd.usr);                          // 16 bits @ 10 MHz per two motors
+  GPIO.out_w1ts = 1u << SR_LATCH;
+  GPIO.out_w1tc = 1u << SR_LATCH;
+}
+static void initCoils(){
+  pinMode(SR_LATCH, OUTPUT); digitalWrite(SR_LATCH, LOW);
+  coilSpi = spiStartBus(VSPI, spiFrequencyToClockDiv(10000000), SPI_MODE0, SPI_MSBFIRST);
+  spiAttachSCK(coilSpi, SR_CLOCK); spiAttachMOSI(coilSpi, SR_DATA);
+  uint8_t off[MOTOR_COUNT]={0};
+  writeCoils(W::ALL, off);
+}
+#else
+// Built at compile time; a non-const global so it lands in DRAM for the ISR
+static CoilMap<MOTOR_COUNT> coilMap(MOTOR_TABLE);
+
+// Every motor that stepped this tick, in one set + one clear store per GPIO bank
+static void IRAM_ATTR writeCoils(MotorMask changed, const uint8_t* coils){
+  CoilMasks c = coilMap.combine(changed, coils);
+  if (c.set[0]) GPIO.out_w1ts = c.set[0];
+  if (c.clr[0]) GPIO.out_w1tc = c.clr[0];
+  if (c.set[1]) GPIO.out1_w1ts.val = c.set[1];
+  if (c.clr[1]) GPIO.out1_w1tc.val = c.clr[1];
+}
+static void initCoils(){
+  for (const MotorDesc& d : MOTOR_TABLE) for (int pin : d.in){ pinMode(pin, OUTPUT); digitalWrite(pin, LOW); }
+}
+#endif
+
+// Step timing for /metrics (metrics.h). The step timer holds the CPU at
+// full speed, so cycles convert at a fixed rate.
+static StepTiming<MOTOR_COUNT> stepTiming;
+static uint32_t cpuMhz=240;
+static void IRAM_ATTR onCoils(MotorMask changed, const uint8_t* coils);
+static W::Engine engine(onCoils);
+static void IRAM_ATTR onCoils(MotorMask changed, const uint8_t* coils){
+  writeCoils(changed, coils);
+  stepTiming.record(changed, ESP.getCycleCount(), cpuMhz, engine);
+}
 
-static float rpmToStepsPerSec(int rpm){
-  float sps = (float)rpm * (float)STEPS_PER_REV / 60.0f;
-  if (sps > 1200.0f) sps = 1200.0f;
-  if (sps < 50.0f)   sps = 50.0f;
-  return sps;
+// Steps are emitted from a hardware timer ISR; motionTask queues the moves
+// and webTask serves the network (loop() deletes itself).
+// The timer only runs while a motor is moving, holding a CPU-frequency lock
+// so DFS/light sleep can't stretch the step timing; idle, nothing ticks.
+static hw_timer_t* stepTimer=nullptr;
+static volatile bool stepTimerOn=false;
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t stepPmLock=nullptr;
+#endif
+static void IRAM_ATTR onStepTimer(){ engine.tick(); }
+static void startStepTimer(){
+  initCoils();
+#if CONFIG_PM_ENABLE
+  esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "step", &stepPmLock);
+#endif
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  stepTimer = timerBegin(1000000);
+  timerAttachInterrupt(stepTimer, &onStepTimer);
+  timerAlarm(stepTimer, STEP_TICK_US, true, 0);
+  timerStop(stepTimer);
+#else
+  stepTimer = timerBegin(0, 80, true);          // 80 MHz APB / 80 = 1 us
+  timerAttachInterrupt(stepTimer, &onStepTimer, true);
+  timerAlarmWrite(stepTimer, STEP_TICK_US, true);
+#endif
 }
-static void applyMotionParams(){
-  float sps = rpmToStepsPerSec(STEP_RPM);
-  s1.setMaxSpeed(sps); s2.setMaxSpeed(sps);
-  s1.setAcceleration(sps * 1.2f); s2.setAcceleration(sps * 1.2f);
-}
-
-static bool enabled = true;
-static unsigned long nextDue1=0, nextDue2=0;
-static int lastDir1=+1, lastDir2=+1;
-
-static unsigned long intervalFromTPD(int tpd){
-  if (tpd <= 0) return 0;
-  return 86400000UL / (unsigned long)tpd;
-}
-static int pickDir(int plan, int& lastDir){
-  if (plan==DIR_CW){ lastDir=+1; return +1; }
-  if (plan==DIR_CCW){ lastDir=-1; return -1; }
-  lastDir = (lastDir>0)?-1:+1; return lastDir;
-}
-
-// DPDT switch presets
-static int currentMode=0, stableMode=0; static unsigned long lastModeReadMs=0;
-static int readModeRaw(){
-  int a=digitalRead(MODE_PIN_A), b=digitalRead(MODE_PIN_B);
-  if (a==LOW && b==HIGH) return 0;
-  if (a==HIGH && b==HIGH) return 1;
-  if (a==HIGH && b==LOW) return 2;
-  return 1;
-}
-static void updateModeDebounced(){
-  int m=readModeRaw(); unsigned long now=millis();
-  if (m!=currentMode){ currentMode=m; lastModeReadMs=now; }
-  else if ((now-lastModeReadMs)>=MODE_DEBOUNCE_MS){ stableMode=m; }
-}
-static void applyModePreset(int mode){
-  if (mode==0){ TPD_M1=500; TPD_M2=500; DIRPLAN_M1=DIR_ALT; DIRPLAN_M2=DIR_ALT; }
-  else if (mode==2){ TPD_M1=800; TPD_M2=800; DIRPLAN_M1=DIR_CW; DIRPLAN_M2=DIR_CCW; }
-}
-
-// Turbo
-static bool turboActive=false; static unsigned long turboEndMs=0; static bool turboM1=false, turboM2=false;
-static bool turboStopping=false;  // flag to complete current rotation before stopping
-
-static void startTurbo(bool m1,bool m2,unsigned long minutes){
-  turboM1=m1; turboM2=m2; turboActive=true; turboStopping=false;
-  turboEndMs=millis()+minutes*60UL*1000UL;
-  long span=6L*STEPS_PER_REV*minutes;
-  if (turboM1) s1.move(s1.distanceToGo()+span);
-  if (turboM2) s2.move(s2.distanceToGo()+span);
-}
-
-static void updateTurbo(){
-  if (!turboActive) return;
-  
-  // Check if time has expired
-  if (millis()>=turboEndMs && !turboStopping){
-    turboStopping=true;  // Enter stopping phase - complete current rotations
+// Motion task only
+static void stepTimerRun(bool on){
+  if (on == stepTimerOn) return;
+  stepTimerOn = on;
+#if CONFIG_PM_ENABLE
+  if (stepPmLock){ if (on) esp_pm_lock_acquire(stepPmLock); else esp_pm_lock_release(stepPmLock); }
+#endif
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  if (on) timerStart(stepTimer); else timerStop(stepTimer);
+#else
+  if (on) timerAlarmEnable(stepTimer); else timerAlarmDisable(stepTimer);
+#endif
+}
+
+#if defined(WINDER_BENCH) && !COILS_SHIFT_REGISTER
+// ===================== Coil write bench (env:bench) =====================
+// Cycles per step on target: per-pin digitalWrite(), the batched register
+// write, a full engine tick, and AccelStepper::run() as the old loop used it.
+#include <AccelStepper.h>
+static void benchCoils(){
+  const int N = 4000;
+  initCoils();
+  uint8_t coils[MOTOR_COUNT];
+  uint32_t t0 = ESP.getCycleCount();
+  for (int i=0;i<N;i++)
+    for (const MotorDesc& d : MOTOR_TABLE) for (int k=0;k<4;k++) digitalWrite(d.in[k], (HALFSTEP_SEQ[i&7]>>k)&1);
+  uint32_t perPin = ESP.getCycleCount() - t0;
+
+  t0 = ESP.getCycleCount();
+  for (int i=0;i<N;i++){ for (int m=0;m<MOTOR_COUNT;m++) coils[m]=HALFSTEP_SEQ[i&7]; writeCoils(W::ALL, coils); }
+  uint32_t batched = ESP.getCycleCount() - t0;
+
+  W::Engine e(writeCoils);
+  e.setSpeed(STEP_TICK_HZ, STEP_TICK_HZ, 0);      // a step on every tick
+  for (int m=0;m<MOTOR_COUNT;m++) e.move(m, N + 1);
+  e.tick();
+  t0 = ESP.getCycleCount();
+  for (int i=0;i<N;i++) e.tick();
+  uint32_t ticks = ESP.getCycleCount() - t0;
+
+  const int* p = MOTOR_TABLE[0].in;
+  AccelStepper a(AccelStepper::HALF4WIRE, p[0], p[2], p[1], p[3]);
+  a.setMaxSpeed(1000); a.setAcceleration(1200); a.moveTo(1000000);
+  uint32_t stepCyc = 0, idleCyc = 0, idleCalls = 0;
+  for (long pos = 0; pos < 1000;){
+    t0 = ESP.getCycleCount();
+    a.run();
+    uint32_t c = ESP.getCycleCount() - t0;
+    if (a.currentPosition() != pos){ pos = a.currentPosition(); stepCyc += c; } else { idleCyc += c; idleCalls++; }
   }
-  
-  // If stopping, check if both motors have completed their current rotation
-  if (turboStopping){
-    bool m1Done = !turboM1 || (s1.distanceToGo()==0);
-    bool m2Done = !turboM2 || (s2.distanceToGo()==0);
-    
-    if (m1Done && m2Done){
-      // Both motors finished their rotations, fully stop turbo mode
-      turboActive=false; turboM1=turboM2=false; turboStopping=false;
+
+  Serial.printf("bench: digitalWrite x4/motor %lu cyc/step, batched %lu cyc/tick (%d motors), engine tick %lu cyc, "
+                "AccelStepper::run() %lu cyc/step + %lu cyc per idle call\n",
+                (unsigned long)(perPin / N / MOTOR_COUNT), (unsigned long)(batched / N), MOTOR_COUNT,
+                (unsigned long)(ticks / N), (unsigned long)(stepCyc / 1000), (unsigned long)(idleCalls ? idleCyc / idleCalls : 0));
+  initCoils();
+}
+#endif
+
+static constexpr uint32_t rpmToStepsPerSec(int rpm){
+  return rpm * STEPS_PER_REV / 60 > 1200 ? 1200 : rpm * STEPS_PER_REV / 60 < 50 ? 50 : (uint32_t)(rpm * STEPS_PER_REV / 60);
+}
+// Same ramp length AccelStepper used with accel = 1.2*sps: v^2/(2a) = sps/2.4 steps
+static constexpr uint32_t rampStepsFor(uint32_t sps){ return sps * 5 / 12; }
+
+// Boot-default ramp, built at compile time; a non-const global so it lands in DRAM for the ISR
+static RampTable rampBoot = rampTable(RAMP_TRAPEZOID, STEP_TICK_HZ, rpmToStepsPerSec(STEP_RPM), 100,
+                                      rampStepsFor(rpmToStepsPerSec(STEP_RPM)));
+static RampProfile rampProfile = RAMP_TRAPEZOID;
+// Runtime settings, one struct; loaded and saved under Persistence below
+static W::Settings cfg;
+
+static void applyMotionParams(){
+  uint32_t sps = rpmToStepsPerSec(cfg.rpm), ramp = rampStepsFor(sps);
+  if (rampProfile == rampBoot.profile && sps == rampBoot.maxSps && ramp == rampBoot.steps) engine.setRamp(rampBoot);
+  else engine.setSpeed(sps, 100, ramp, rampProfile);   // other settings: table built here, once
+}
+
+// ===================== Scheduler =====================
+// Arduino-backed HAL for the portable WinderScheduler (lib/WinderCore).
+class ArduinoClock : public Clock {
+public:
+  uint64_t millis() override { return (uint64_t)esp_timer_get_time() / 1000; }   // 64-bit, never wraps
+};
+class ArduinoGpio : public Gpio {
+public:
+  int  read(int pin) override { return digitalRead(pin); }
+  void write(int pin, int level) override { digitalWrite(pin, level); }
+};
+class EngineMotors : public MotorDriver {
+public:
+  void    move(uint8_t m, int32_t steps) override { engine.move(m, steps); stepTimerRun(true); }
+  void    stop(uint8_t m) override { engine.stop(m); }
+  int32_t distanceToGo(uint8_t m) override { return engine.distanceToGo(m); }
+  uint32_t moveMs(uint32_t steps) override { return (uint32_t)(engine.moveUs(steps) / 1000); }
+  uint32_t stepsMade(uint8_t m) override { return engine.stepCount(m); }
+};
+static ArduinoClock hwClock;
+static ArduinoGpio  hwGpio;
+static EngineMotors hwMotors;
+static W::Scheduler sched(hwClock, hwGpio, hwMotors, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, LED_PIN },
+                          STEPS_PER_REV, MODE_DEBOUNCE_MS);
+
+// ===================== Warm resume =====================
+// The scheduler's live state and each motor's unfinished move are mirrored
+// into RTC slow memory, which survives watchdog, panic and software
+// resets, under a CRC. A warm boot resumes from it without NVS;
+// the RTC timer keeps counting through the reset and says how long the
+// chip was down, so deadlines keep their grid. The same record goes to NVS
+// at most hourly as a cold-start checkpoint: after a power cut it brings
+// back the turn counters and the Alternate direction pattern.
+struct MotionMirror {
+  uint32_t magic;
+  uint8_t  motors, pad[3];
+  uint64_t clockMs, rtcUs;               // scheduler clock and RTC time when written
+  ResumeState<MOTOR_COUNT> sched;
+  int32_t  remaining[MOTOR_COUNT];       // steps left of the move in flight
+  uint8_t  phase[MOTOR_COUNT];
+  uint32_t crc;                          // over everything above
+};
+static const uint32_t MIRROR_MAGIC = 0x334D5257;   // "WRM3"
+static const uint32_t MIRROR_MOVING_MS = 100;      // in-flight steps lost at most this much motion
+static const uint32_t CKPT_PERIOD_MS = 3600000;
+RTC_NOINIT_ATTR static MotionMirror rtcMotion;
+static MotionMirror mirrorStage;
+static uint64_t mirrorAt=0, ckptAt=0;
+static bool mirrored=false;             // rtcMotion holds this boot's image
+static uint32_t ckptCrc=0;
+static Preferences ckptPrefs;            // motion task (and setup, before it starts)
+static const char* const BOOT_KINDS[] = { "cold", "checkpoint", "warm" };
+static uint8_t bootKind=0;               // BOOT_KINDS index
+static uint32_t bootResumeUs=0;
+
+static uint64_t rtcNowUs(){
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  return esp_rtc_get_time_us();
+#else
+  return rtc_time_slowclk_to_us(rtc_time_get(), esp_clk_slowclk_cal_get());
+#endif
+}
+static uint32_t mirrorCrc(const MotionMirror& b){ return settingsCrc((const uint8_t*)&b, offsetof(MotionMirror, crc)); }
+static bool mirrorValid(const MotionMirror& b){ return b.magic == MIRROR_MAGIC && b.motors == MOTOR_COUNT && mirrorCrc(b) == b.crc; }
+
+// Schedule equality without the counters that move with every step (the
+// odometer, turbo progress); those alone don't need an immediate rewrite
+static bool mirrorPlanSame(const ResumeState<MOTOR_COUNT>& a, const ResumeState<MOTOR_COUNT>& b){
+  ResumeState<MOTOR_COUNT> t;
+  memcpy(&t, &a, sizeof(t));
+  memcpy(t.odo, b.odo, sizeof(t.odo)); memcpy(t.turboSteps, b.turboSteps, sizeof(t.turboSteps));
+  return !memcmp(&t, &b, sizeof(t));
+}
+
+// After each pass: rewrite when anything changed. While a move is in flight
+// its step counts change all the time, so unless the plan moved too (a
+// rotation starting, a command, turbo) that waits up to 100 ms
+static void motionMirror(){
+  uint64_t now = hwClock.millis();
+  MotionMirror& s = mirrorStage;
+  memset(&s, 0, sizeof(s));
+  s.magic = MIRROR_MAGIC; s.motors = MOTOR_COUNT;
+  sched.capture(s.sched);
+  bool moving = false;
+  for (uint8_t m=0;m<MOTOR_COUNT;m++){ s.remaining[m] = engine.distanceToGo(m); s.phase[m] = engine.phase(m); moving |= s.remaining[m] != 0; }
+  size_t from = offsetof(MotionMirror, sched), len = offsetof(MotionMirror, crc) - from;
+  bool same = mirrored && !memcmp((const uint8_t*)&s + from, (const uint8_t*)&rtcMotion + from, len);
+  if (same) return;
+  if (moving && now - mirrorAt < MIRROR_MOVING_MS && mirrorPlanSame(s.sched, rtcMotion.sched)) return;
+  s.clockMs = now; s.rtcUs = rtcNowUs();
+  memcpy(&rtcMotion, &s, sizeof(s));
+  rtcMotion.crc = mirrorCrc(rtcMotion);
+  mirrorAt = now; mirrored = true;
+
+  // Cold-start checkpoint: idle, changed, and an hour since the last one
+  if (moving || rtcMotion.crc == ckptCrc || (ckptAt && now - ckptAt < CKPT_PERIOD_MS)) return;
+  if (ckptPrefs.begin("winder", false)){ ckptPrefs.putBytes("ckpt", &rtcMotion, sizeof(rtcMotion)); ckptPrefs.end(); }
+  ckptAt = now ? now : 1; ckptCrc = rtcMotion.crc;
+}
+
+// Replaces sched.begin() at boot. After startStepTimer().
+static void motionResume(bool warm){
+  if (warm && mirrorValid(rtcMotion)){
+    const MotionMirror& b = rtcMotion;
+    uint64_t rtc = rtcNowUs(), now = hwClock.millis();
+    uint64_t downMs = rtc >= b.rtcUs ? (rtc - b.rtcUs) / 1000 : 0;   // RTC reset too: assume no gap
+    sched.resume(b.sched, (int64_t)now - (int64_t)downMs - (int64_t)b.clockMs);   // old clock -> new
+    bool moving = false;
+    for (uint8_t m=0;m<MOTOR_COUNT;m++){
+      engine.setPhase(m, b.phase[m]);
+      if (b.remaining[m]){ engine.move(m, b.remaining[m]); moving = true; }   // finish the interrupted rotation
     }
-    // Don't queue new rotations while stopping
+    if (moving) stepTimerRun(true);
+    bootKind = 2;
     return;
   }
-  
-  // Normal operation - queue next rotation if motor completed current one
-  if (turboM1 && s1.distanceToGo()==0) s1.move(2L*STEPS_PER_REV);
-  if (turboM2 && s2.distanceToGo()==0) s2.move(2L*STEPS_PER_REV);
+  sched.begin();
+  MotionMirror ck;
+  bool ok = false;
+  if (ckptPrefs.begin("winder", true)){ ok = ckptPrefs.getBytes("ckpt", &ck, sizeof(ck)) == sizeof(ck) && mirrorValid(ck); ckptPrefs.end(); }
+  if (!ok) return;
+  // Only what doesn't depend on the time the chip was off
+  ResumeState<MOTOR_COUNT> r = ck.sched;
+  for (uint8_t m=0;m<MOTOR_COUNT;m++){ r.nextDue[m] = r.slotDue[m] = 0; r.burstLeft[m] = 0; r.slot[m] = 0; }
+  r.turboActive = 0; r.turboMask = 0; r.turboEndMs = 0; r.clockSet = 0; r.todOffsetMs = 0;
+  r.turboCount = 0; memset(r.turboSteps, 0, sizeof(r.turboSteps));
+  sched.resume(r, 0);
+  ckptCrc = ck.crc;
+  bootKind = 1;
+}
+
+// ===================== Motion task =====================
+// Owns the scheduler; the web side talks to it only through motionCmds and
+// reads motionStatus.
+static W::CmdRing motionCmds;
+static W::StatusLock motionStatus;
+
+static DutyMeter duty;
+static Histogram motionPassUs, rotLateMs[MOTOR_COUNT];   // /metrics
+static uint32_t turnsSeen[MOTOR_COUNT];
+static bool tracedTurbo=false;
+static int tracedMode=-1;
+static bool pmLightSleep=false;      // automatic light sleep accepted by esp_pm_configure
+static TaskHandle_t motionTaskHandle=nullptr;
+
+// Selector pins interrupt on every edge; the scheduler restarts its debounce
+// expiry for each one, so the task sleeps until the contacts have settled
+static volatile uint32_t modeEdges=0;
+static uint32_t modeEdgesSeen=0;
+static void IRAM_ATTR onModeEdge(){
+  modeEdges++;
+  BaseType_t woken = pdFALSE;
+  if (motionTaskHandle) vTaskNotifyGiveFromISR(motionTaskHandle, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+static void publishStatus(){
+  W::Status st{};
+  sched.fillStatus(st);
+  st.profile = rampProfile;
+  st.idlePermille = duty.idlePermille();
+  st.wakeupsPerSec = duty.wakeupsPerSec();
+  st.currentMa = duty.currentMa(pmLightSleep ? DUTY_MA_LIGHT_SLEEP : DUTY_MA_IDLE);
+  st.lightSleep = pmLightSleep;
+  motionStatus.publish(st);
+}
+
+// Boot timing, ms since reset (0 until reached); read by /status
+static volatile uint32_t bootMotionMs=0, bootStepMs=0;
+
+static void motionPass(){
+  uint64_t t0 = esp_timer_get_time();
+  if (!bootMotionMs) bootMotionMs=millis();
+  if (!bootStepMs) for (uint8_t m=0;m<MOTOR_COUNT;m++) if (engine.stepCount(m)){ bootStepMs=millis(); break; }
+  W::Cmd c;
+  while (motionCmds.pop(c)){
+    trace(TR_CMD, c.op);
+    sched.apply(c);
+    if (c.op == CMD_CONFIG && c.profile != rampProfile){ rampProfile = (RampProfile)c.profile; applyMotionParams(); }
+  }
+  uint32_t edges = modeEdges;
+  if (edges != modeEdgesSeen){ modeEdgesSeen = edges; sched.switchEdge(); }
+  sched.poll();
+  for (uint8_t m=0;m<MOTOR_COUNT;m++)
+    if (sched.turns(m) != turnsSeen[m]){
+      turnsSeen[m] = sched.turns(m); rotLateMs[m].record(sched.lateMs(m));
+      trace(TR_ROTATE, m | (sched.lastDir(m) < 0 ? 0x80 : 0), sched.lateMs(m));
+    }
+  if (sched.turboActive() != tracedTurbo){ tracedTurbo = sched.turboActive(); trace(tracedTurbo ? TR_TURBO_ON : TR_TURBO_OFF, sched.turboMask()); }
+  if (sched.mode() != tracedMode){ tracedMode = sched.mode(); trace(TR_MODE, (uint8_t)tracedMode); }
+  if (engine.settled()) stepTimerRun(false);
+  uint64_t t1 = esp_timer_get_time();
+  duty.wake();
+  duty.busy((uint32_t)(t1 - t0));
+  duty.stepping(stepTimerOn, t1);
+  duty.roll(t1);
+  publishStatus();
+  motionMirror();
+  motionPassUs.record((uint32_t)(esp_timer_get_time() - t0));
+}
+
+// Let the CPU drop to 80 MHz when idle and, if the core was built with
+// tickless idle, light-sleep between events. Falls back to DFS only.
+static void powerBegin(){
+#if CONFIG_PM_ENABLE
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  esp_pm_config_t pm{};
+#else
+  esp_pm_config_esp32_t pm{};
+#endif
+  pm.max_freq_mhz = 240; pm.min_freq_mhz = 80; pm.light_sleep_enable = true;
+  if (esp_pm_configure(&pm) == ESP_OK){ pmLightSleep = true; return; }
+  pm.light_sleep_enable = false;
+  esp_pm_configure(&pm);
+#endif
 }
 
 // ===================== Wi-Fi / Web =====================
 WebServer server(80);
 Preferences prefs;
 
-String wifiSsid=WIFI_SSID;
-String wifiPass=WIFI_PASS;
+// ========== Persistence ==========
+// Every setting lives in `cfg` (web task once running) and reaches flash as
+// one CRC-checked blob (settings_blob.h). Saving only marks it dirty;
+// prefsPoll() writes it once changes have been quiet for PREFS_QUIET_MS
+// (or PREFS_MAX_DELAY_MS into a burst of them), and again at esp_restart().
+// A device still on the old one-key-per-setting layout migrates on its
+// first flush.
+static const uint32_t PREFS_QUIET_MS = 2000, PREFS_MAX_DELAY_MS = 15000;
+static WriteBehind prefsWb(PREFS_QUIET_MS, PREFS_MAX_DELAY_MS);
+static bool prefsLegacy=false;          // old keys present; removed after the blob is written
+static uint32_t prefsWrites=0, prefsFlushUs=0;
+
+// RTC copy of cfg for warm boots, with whether it still needed a flush
+struct SettingsMirror { uint32_t magic; uint8_t dirty; W::Settings cfg; uint32_t crc; };
+RTC_NOINIT_ATTR static SettingsMirror rtcCfg;
+static void cfgMirror(){
+  rtcCfg.magic = MIRROR_MAGIC; rtcCfg.dirty = prefsWb.dirty(); rtcCfg.cfg = cfg;
+  rtcCfg.crc = settingsCrc((const uint8_t*)&rtcCfg, offsetof(SettingsMirror, crc));
+}
+static bool cfgMirrorValid(){
+  return rtcCfg.magic == MIRROR_MAGIC && rtcCfg.crc == settingsCrc((const uint8_t*)&rtcCfg, offsetof(SettingsMirror, crc));
+}
 
-String ipToStr(const IPAddress& ip){ return String(ip[0])+"."+ip[1]+"."+ip[2]+"."+ip[3]; }
-void indicate(bool on){ if (LED_PIN>=0){ pinMode(LED_PIN,OUTPUT); digitalWrite(LED_PIN,on?HIGH:LOW);} }
+static void prefsChanged(){ prefsWb.touch(millis()); cfgMirror(); }
 
-// Track HTTP server state and (re)start it only when Wi-Fi is ready.
-static bool httpStarted = false;
+static void saveWifiCreds(const char* ssid, const char* pass){
+  strlcpy(cfg.ssid, ssid, sizeof(cfg.ssid)); strlcpy(cfg.pass, pass, sizeof(cfg.pass));
+  prefsChanged();
+}
 
-static void startHttpServerIfNeeded() {
-  if (!httpStarted) {
-    delay(300);                 // give netif a moment after AP/STA up
-    server.begin();
-    httpStarted = true;
-    Serial.println("HTTP: server started on port 80");
+// Layout before the blob: one NVS key per setting
+static const char* const LEGACY_KEYS[] = { "rpm", "profile", "every", "wstart", "wend", "ssid", "wpass" };
+static void loadLegacyPrefs(){
+  cfg.rpm = prefs.getInt("rpm", cfg.rpm);
+  cfg.profile = prefs.getUChar("profile", cfg.profile);
+  cfg.program = WindProgram{ prefs.getUShort("every", cfg.program.everyMin), prefs.getUShort("wstart", cfg.program.startMin),
+                             prefs.getUShort("wend", cfg.program.endMin) };
+  for (uint8_t m=0;m<MOTOR_COUNT;m++){
+    char kt[8], kd[8]; snprintf(kt, sizeof(kt), "tpd%u", m+1); snprintf(kd, sizeof(kd), "dir%u", m+1);
+    cfg.tpd[m] = prefs.getInt(kt, cfg.tpd[m]); cfg.dir[m] = prefs.getInt(kd, cfg.dir[m]);
   }
+  prefs.getString("ssid", cfg.ssid, sizeof(cfg.ssid));    // left as-is when unset
+  prefs.getString("wpass", cfg.pass, sizeof(cfg.pass));
 }
 
-static void saveWifiCreds(const String& ssid, const String& pass){
-  if (!prefs.begin("winder", false)) return;
-  prefs.putString("ssid", ssid);
-  prefs.putString("wpass", pass);
-  prefs.end();
-  wifiSsid=ssid; wifiPass=pass;
-}
-
-// Event logging (helps diagnose join problems)
-static void onWiFiEvent(WiFiEvent_t e){
-  switch(e){
-    case ARDUINO_EVENT_WIFI_STA_CONNECTED: Serial.println("STA: connected"); break;
-    case ARDUINO_EVENT_WIFI_STA_GOT_IP: Serial.printf("STA: IP %s\n", ipToStr(WiFi.localIP()).c_str()); break;
-    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED: Serial.println("STA: disconnected"); break;
-    case ARDUINO_EVENT_WIFI_AP_START: Serial.println("AP: started"); break;
-    case ARDUINO_EVENT_WIFI_AP_STOP: Serial.println("AP: stopped"); break;
-    case ARDUINO_EVENT_WIFI_AP_STACONNECTED: Serial.println("AP: station joined"); break;
-    case ARDUINO_EVENT_WIFI_AP_STADISCONNECTED: Serial.println("AP: station left"); break;
-    default: break;
+static void loadNvsPrefs(){
+  cfg.rpm = STEP_RPM; cfg.profile = rampProfile; cfg.program = sched.program();
+  strlcpy(cfg.ssid, WIFI_SSID, sizeof(cfg.ssid)); strlcpy(cfg.pass, WIFI_PASS, sizeof(cfg.pass));
+  for (uint8_t m=0;m<MOTOR_COUNT;m++){ cfg.tpd[m] = sched.tpd(m); cfg.dir[m] = sched.dirPlan(m); }
+  cfg.switchPos = SWITCH_UNKNOWN; cfg.presets = switchPresetsDefault<MOTOR_COUNT>();
+  if (prefs.begin("winder", true)){
+    uint8_t blob[settingsBlobMax<WINDER_MAX_MOTORS>()];   // fits a blob from any motor count
+    size_t n = prefs.getBytesLength("cfg");
+    bool ok = n && n <= sizeof(blob) && prefs.getBytes("cfg", blob, n) == n && settingsDecode(blob, n, cfg);
+    if (!ok && (prefs.isKey("tpd1") || prefs.isKey("ssid"))){ loadLegacyPrefs(); prefsLegacy = true; prefsChanged(); }
+    prefs.end();
   }
 }
 
-// Strong AP bring-up: AP-only, country, tx power, channel sweep
-static bool startAP(){
-  Serial.println("Starting SoftAP (AP-only) …");
-  WiFi.persistent(false);
-  WiFi.disconnect(true, true); // drop STA state
-  delay(100);
 
-  WiFi.mode(WIFI_OFF);
-  delay(50);
+static void loadPrefs(bool warm){
+  if (warm && cfgMirrorValid()){          // no NVS read on a warm boot
+    cfg = rtcCfg.cfg;
+    if (rtcCfg.dirty) prefsChanged();
+  } else {
+    loadNvsPrefs();
+    cfgMirror();
+  }
+  rampProfile = (RampProfile)(cfg.profile % RAMP_PROFILES);
+  for (uint8_t m=0;m<MOTOR_COUNT;m++) sched.setPlan(m, cfg.tpd[m], cfg.dir[m]);
+  sched.setProgram(cfg.program);   // ignored if invalid
+  sched.setPresets(cfg.presets);
+  sched.setSwitchApplied(cfg.switchPos);   // a position moved to while off applies at begin()
+}
 
-  WiFi.setSleep(false);
-  WiFi.setTxPower(WIFI_POWER_19_5dBm);
+static void savePrefs(const W::Cmd& c){
+  cfg.profile = c.profile; cfg.program = c.program;
+  for (uint8_t m=0;m<MOTOR_COUNT;m++){ cfg.tpd[m] = c.tpd[m]; cfg.dir[m] = c.dir[m]; }
+  prefsChanged();
+}
 
-  WiFi.mode(WIFI_AP);
-  delay(50);
+// The switch moved and the motion task applied its preset: the saved plan
+// follows, with the position, so the next boot doesn't apply it again
+static void switchSync(){
+  W::Status st; motionStatus.read(st);
+  if (st.switchMode == cfg.switchPos) return;
+  cfg.switchPos = st.switchMode;
+  if (!cfg.presets.pos[st.switchMode].manual)
+    for (uint8_t m=0;m<MOTOR_COUNT;m++){ cfg.tpd[m] = st.tpd[m]; cfg.dir[m] = st.dir[m]; }
+  prefsChanged();
+}
 
-  IPAddress ip(192,168,4,1), gw(192,168,4,1), mask(255,255,255,0);
-  if (!WiFi.softAPConfig(ip, gw, mask)){
-    Serial.println("softAPConfig failed");
+static void prefsFlush(){
+  if (!prefsWb.dirty()) return;
+  uint8_t blob[W::SETTINGS_BLOB_MAX];
+  size_t n = settingsEncode(cfg, blob, sizeof(blob));
+  uint32_t t0 = micros();
+  bool ok = prefs.begin("winder", false) && prefs.putBytes("cfg", blob, n) == n;
+  if (ok && prefsLegacy){
+    for (const char* k : LEGACY_KEYS) prefs.remove(k);
+    for (uint8_t m=0;m<MOTOR_COUNT;m++){
+      char k[8]; snprintf(k, sizeof(k), "tpd%u", m+1); prefs.remove(k); snprintf(k, sizeof(k), "dir%u", m+1); prefs.remove(k);
+    }
+    prefsLegacy = false;
   }
+  prefs.end();
+  prefsFlushUs = micros() - t0;
+  if (!ok){ prefsChanged(); return; }      // retry after another quiet period
+  prefsWrites++;
+  uint32_t folded = prefsWb.flushed();
+  cfgMirror();
+  trace(TR_PREFS, folded > 255 ? 255 : (uint8_t)folded, prefsFlushUs);
+}
+static void prefsPoll(){ if (prefsWb.due(millis())) prefsFlush(); }
+
+// ===================== UI (HTML) =====================
+// Source is ui/index.html; tools/build_ui.py minifies and gzips it into
+// ui_index.h at build time.
+#include "ui_index.h"
+
+// ===================== Odometer history =====================
+// Hourly buckets of the motion task's odometer (odometer.h), closed by the
+// web task from the status snapshot. In RTC memory under a CRC: a warm
+// reset keeps it (the hour in progress goes into the next bucket), a cold
+// boot or totals that went backwards start it over.
+typedef OdoHistory<MOTOR_COUNT, HISTORY_BYTES> History;
+struct HistoryMirror { uint32_t magic; History h; uint32_t crc; };
+RTC_NOINIT_ATTR static HistoryMirror rtcHist;
+static const uint32_t HISTORY_HOUR_MS = 3600000;
+static uint64_t histCloseAt = 0;
+static uint32_t histCrc(){ return settingsCrc((const uint8_t*)&rtcHist, offsetof(HistoryMirror, crc)); }
+static void histSeal(){ rtcHist.magic = MIRROR_MAGIC; rtcHist.crc = histCrc(); }
+
+// After publishStatus() in setup()
+static void historyBegin(bool warm){
+  W::Status st; motionStatus.read(st);
+  bool keep = warm && rtcHist.magic == MIRROR_MAGIC && rtcHist.crc == histCrc() && rtcHist.h.follows(st.odo);
+  if (!keep){ rtcHist.h.reset(st.odo, STEPS_PER_REV); histSeal(); }
+  histCloseAt = hwClock.millis() + HISTORY_HOUR_MS;
+}
+static void historyPoll(){
+  uint64_t now = hwClock.millis();
+  if (now < histCloseAt) return;
+  histCloseAt += HISTORY_HOUR_MS;
+  if (histCloseAt <= now) histCloseAt = now + HISTORY_HOUR_MS;
+  W::Status st; motionStatus.read(st);
+  rtcHist.h.close(st.odo);
+  histSeal();
+}
 
-  const char* ap_ssid = AP_SSID;
-  const char* ap_pass = (strlen(AP_PASS) ? AP_PASS : "winder1234"); // default WPA2 pass
-  bool ok=false;
-  int channels[3]={1,6,11};
-  for (int i=0;i<3 && !ok;i++){
-    int ch=channels[i];
-    Serial.printf("softAP SSID=%s ch=%d …\n", ap_ssid, ch);
-    ok = WiFi.softAP(ap_ssid, ap_pass, ch, /*hidden*/false, /*max_conn*/4);
-    delay(300);
+// ===================== Routes =====================
+// Every response is serialized into respBuf (web task only) and sent with an
+// explicit length, so handlers allocate nothing per request. The asserts
+// below keep the buffer large enough for the worst case of each route.
+// The motion-facing routes live in web_routes.h; the rest are here.
+
+static const size_t SSE_FRAME = 6 + 2;   // "data: " ... "\n\n"
+static const size_t RESP_BUF_SIZE = (W::STATUS_JSON_MAX + SSE_FRAME > 1024) ? W::STATUS_JSON_MAX + SSE_FRAME : 1024;
+alignas(4) static char respBuf[RESP_BUF_SIZE];
+
+constexpr size_t WIFI_JSON_MAX = 2 + 1
+  + jsonFieldMax("state", jsonQuotedMax(10)) + jsonFieldMax("ssid", jsonQuotedMax(32))
+  + jsonFieldMax("ip", jsonQuotedMax(15)) + jsonFieldMax("elapsed_ms", JSON_U32_MAX)
+  + jsonFieldMax("attempts", JSON_U32_MAX) + jsonFieldMax("reason", JSON_U32_MAX)
+  + jsonFieldMax("ap", JSON_BOOL_MAX) + jsonFieldMax("mdns", jsonQuotedMax(FLEET_NAME_MAX + 13));
+constexpr size_t SCAN_ITEM_MAX = 1 + 2 + jsonFieldMax("ssid", jsonQuotedMax(32)) + jsonFieldMax("rssi", JSON_I32_MAX)
+  + jsonFieldMax("ch", JSON_U32_MAX) + jsonFieldMax("auth", JSON_U32_MAX);   // streamed one network per chunk
+static_assert(W::STATUS_JSON_MAX + SSE_FRAME <= RESP_BUF_SIZE, "/status and /events must fit respBuf");
+static_assert(WebRoutes<MOTOR_COUNT>::BUF_MIN <= RESP_BUF_SIZE, "web_routes.h bodies must fit respBuf");
+static_assert(WIFI_JSON_MAX <= RESP_BUF_SIZE, "GET /wifi must fit respBuf");
+constexpr size_t PRESET_ITEM_MAX = 1 + 2 + jsonFieldMax("manual", JSON_BOOL_MAX)
+  + MOTOR_COUNT * (jsonFieldMax(jsonLen("tpd") + 2, JSON_I32_MAX) + jsonFieldMax(jsonLen("dir") + 2, JSON_I32_MAX));   // one position per chunk
+static_assert(SCAN_ITEM_MAX <= RESP_BUF_SIZE, "/scan item must fit respBuf");
+static_assert(PRESET_ITEM_MAX <= RESP_BUF_SIZE, "/presets item must fit respBuf");
+
+static void sendJson(int code, const JsonOut& j){ server.send_P(code, "application/json", j.c_str(), j.length()); }
+static void sendConst(int code, PGM_P body){ server.send_P(code, "application/json", body); }
+
+static void trimInPlace(char* s){
+  size_t n = strlen(s), a = 0;
+  while (n && isspace((unsigned char)s[n-1])) n--;
+  while (a < n && isspace((unsigned char)s[a])) a++;
+  memmove(s, s + a, n - a); s[n - a] = 0;
+}
+
+// ---------- Metrics ----------
+// Fixed-bucket histograms (metrics.h): handler time per route and the web
+// loop, recorded here; motion pass time, rotation start delay and step
+// timing error, recorded on the motion side. GET /metrics is Prometheus
+// text, /metrics?format=json the same as JSON; both are streamed out in
+// respBuf-sized chunks.
+enum Route : uint8_t { RT_STATUS, RT_CONFIG, RT_TURBO, RT_WIFI, RT_SCAN, RT_PRESETS, RT_HISTORY, RT_CTL, RT_COUNT };
+static const char* const ROUTE_NAMES[RT_COUNT] = { "/status", "/config", "/turbo", "/wifi", "/scan", "/presets", "/history", "ctl" };
+static Histogram routeUs[RT_COUNT], webLoopUs, httpUs;
+static TaskHandle_t webTaskHandle=nullptr;
+
+// Times a handler from here to the end of its scope
+struct RouteTimer {
+  Route r; uint32_t t0;
+  explicit RouteTimer(Route r) : r(r), t0(micros()) {}
+  ~RouteTimer(){ uint32_t us = micros() - t0; routeUs[r].record(us); trace(TR_HTTP, r, us); }
+};
+
+struct MetricHist { const char* name; const char* help; const Histogram* h; uint8_t n; const char* label; };
+static const MetricHist METRIC_HISTS[] = {
+  { "web_loop_us",      "Web task loop iteration",                       &webLoopUs,       1,           nullptr },
+  { "http_client_us",   "server.handleClient() call",                    &httpUs,          1,           nullptr },
+  { "motion_pass_us",   "Motion task pass",                              &motionPassUs,    1,           nullptr },
+  { "route_us",         "HTTP handler time",                             routeUs,          RT_COUNT,    "route" },
+  { "step_error_us",    "Step interval vs planned, absolute difference", stepTiming.errUs, MOTOR_COUNT, "motor" },
+  { "rotation_late_ms", "Rotation start after its due time",             rotLateMs,        MOTOR_COUNT, "motor" },
+};
+static_assert(jsonHistogramMax(24) + 16 <= RESP_BUF_SIZE, "a /metrics JSON histogram must fit respBuf");
+
+static void labelValue(const MetricHist& d, uint8_t i, char* out, size_t n){
+  if (d.h == routeUs) strlcpy(out, ROUTE_NAMES[i], n); else snprintf(out, n, "%u", i + 1);
+}
+static void sendChunk(const char* p, size_t n, void*){ server.sendContent(p, n); }
+
+static void metricsProm(){
+  ChunkOut o(respBuf, sizeof(respBuf), sendChunk, nullptr);
+  char name[40], lab[32], v[12];
+  for (const MetricHist& d : METRIC_HISTS){
+    snprintf(name, sizeof(name), "winder_%s", d.name);
+    promType(o, name, "histogram", d.help);
+    for (uint8_t i=0;i<d.n;i++){
+      lab[0] = 0;
+      if (d.label){ labelValue(d, i, v, sizeof(v)); snprintf(lab, sizeof(lab), "%s=\"%s\"", d.label, v); }
+      promHistogram(o, name, lab, d.h[i]);
+    }
   }
-  IPAddress apIP = WiFi.softAPIP();
-  Serial.printf("AP %s %s at %s (pass: %s)\n", ap_ssid, ok?"UP":"FAILED", ipToStr(apIP).c_str(), ap_pass);
-
-  // >>> start HTTP AFTER AP is up <<<
-  httpStarted = false;         // force a clean (re)bind
-  startHttpServerIfNeeded();
-
-  return ok;
-}
-
-static bool startSTA(unsigned long timeout_ms=10000){
-  if (wifiSsid.length()==0) return false;
-  WiFi.persistent(false);
-  WiFi.disconnect(true, true);
-  delay(100);
-  WiFi.mode(WIFI_STA);
-  WiFi.setSleep(false);
-  WiFi.setTxPower(WIFI_POWER_19_5dBm);
-  WiFi.begin(wifiSsid.c_str(), wifiPass.c_str());
-  Serial.printf("STA: connecting to %s …\n", wifiSsid.c_str());
-  unsigned long t0=millis();
-  while (WiFi.status()!=WL_CONNECTED && millis()-t0<timeout_ms){ delay(200); Serial.print("."); }
-  if (WiFi.status()==WL_CONNECTED){
-    Serial.printf("\nSTA: connected, IP %s\n", ipToStr(WiFi.localIP()).c_str());
-    if (MDNS.begin("winder")){ MDNS.addService("http","tcp",80); Serial.println("mDNS: http://winder.local"); }
-
-    // >>> start HTTP AFTER STA is up <<<
-    httpStarted = false;        // force a clean (re)bind if we were in AP before
-    startHttpServerIfNeeded();
-
-    return true;
+  promType(o, "winder_rotations_total", "counter", "Scheduled rotations started");
+  for (uint8_t m=0;m<MOTOR_COUNT;m++){ snprintf(lab, sizeof(lab), "motor=\"%u\"", m+1); promValue(o, "winder_rotations_total", lab, turnsSeen[m]); }
+  W::Status st; motionStatus.read(st);
+  promType(o, "winder_odometer_total", "counter", "Odometer: rotations by direction, turbo rotations, skipped and late slots, steps");
+  for (uint8_t m=0;m<MOTOR_COUNT;m++)
+    for (uint8_t f=0;f<ODO_TPD;f++){
+      snprintf(lab, sizeof(lab), "motor=\"%u\",kind=\"%s\"", m+1, ODO_NAMES[f]);
+      promValue(o, "winder_odometer_total", lab, st.odo[m].v[f]);
+    }
+  promType(o, "winder_power_holds_total", "counter", "Motor starts held back by the coil-current budget");
+  promValue(o, "winder_power_holds_total", "", engine.powerHolds());
+  promType(o, "winder_heap_bytes", "gauge", "Heap free now, lowest free since boot, largest free block");
+  promValue(o, "winder_heap_bytes", "kind=\"free\"", ESP.getFreeHeap());
+  promValue(o, "winder_heap_bytes", "kind=\"min_free\"", ESP.getMinFreeHeap());
+  promValue(o, "winder_heap_bytes", "kind=\"max_block\"", ESP.getMaxAllocHeap());
+  promType(o, "winder_stack_unused_bytes", "gauge", "Task stack never touched since boot");
+  promValue(o, "winder_stack_unused_bytes", "task=\"motion\"", uxTaskGetStackHighWaterMark(motionTaskHandle));
+  promValue(o, "winder_stack_unused_bytes", "task=\"web\"", uxTaskGetStackHighWaterMark(webTaskHandle));
+  promType(o, "winder_uptime_seconds", "counter", "Seconds since boot");
+  promValue(o, "winder_uptime_seconds", "", millis() / 1000);
+  o.flush();
+}
+
+static void metricsJson(){
+  JsonOut h(respBuf, sizeof(respBuf));
+  h.begin().unum("uptime_ms", millis()).unum("heap_free", ESP.getFreeHeap()).unum("heap_min_free", ESP.getMinFreeHeap())
+   .unum("heap_max_block", ESP.getMaxAllocHeap()).unum("stack_motion", uxTaskGetStackHighWaterMark(motionTaskHandle))
+   .unum("stack_web", uxTaskGetStackHighWaterMark(webTaskHandle));
+  h.key("rotations").raw("[");
+  for (uint8_t m=0;m<MOTOR_COUNT;m++) h.fmt(m ? ",%lu" : "%lu", (unsigned long)turnsSeen[m]);
+  h.raw("]").unum("power_holds", engine.powerHolds());
+  server.sendContent(h.c_str(), h.length());
+  char v[12];
+  for (const MetricHist& d : METRIC_HISTS){
+    for (uint8_t i=0;i<d.n;i++){
+      JsonOut j(respBuf, sizeof(respBuf));
+      if (!d.label) j.raw(",");
+      else if (i == 0) j.raw(",\"").raw(d.name).raw("\":{");
+      else j.raw(",");
+      if (d.label) labelValue(d, i, v, sizeof(v));
+      jsonHistogram(j, d.label ? v : d.name, d.h[i]);
+      if (d.label && i + 1 == d.n) j.raw("}");
+      server.sendContent(j.c_str(), j.length());
+    }
   }
-  Serial.println("\nSTA: timeout");
-  return false;
+  server.sendContent_P(PSTR("}"));
+}
+
+static StatusExtra statusExtra(const char* net){
+  return StatusExtra{ net, bootMotionMs, bootStepMs, netHttpReadyMs(),
+                      ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap(), BOOT_KINDS[bootKind], bootResumeUs };
 }
 
+// ---------- Trace ----------
+// GET /trace: TraceDumpHeader, then every record still in the ring, oldest
+// first, copied out in respBuf-sized batches up to the head at the request.
+// tools/trace_decode.py prints it as a timeline.
+static void sendTrace(){
+  TraceDumpHeader hd{ {'W','T','R','1'}, 1, (uint8_t)sizeof(TraceRec), TRACE_RECORDS, traceRing.head(), (uint32_t)millis() };
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/octet-stream", "");
+  server.sendContent((const char*)&hd, sizeof(hd));
+  TraceRec* out = (TraceRec*)respBuf;
+  const size_t batch = sizeof(respBuf) / sizeof(TraceRec);
+  uint32_t at = traceRing.oldest();
+  while ((int32_t)(hd.head - at) > 0){
+    size_t left = hd.head - at;
+    size_t n = traceRing.read(at, out, left < batch ? left : batch);
+    if (!n) break;
+    server.sendContent((const char*)out, n * sizeof(TraceRec));
+  }
+  server.sendContent("", 0);
+}
 
-static void startWiFi(){
-  WiFi.onEvent(onWiFiEvent);
-  bool staOK = startSTA(8000);
-  if (!staOK){
-    Serial.println("Falling back to AP");
-    if (!startAP()){
-      Serial.println("AP failed; retrying once …");
-      delay(500);
-      startAP();
-    }
+// Serial console: the same records as text, written only while the UART
+// TX buffer has room for a whole line, so a slow console drops lines
+// (and says how many) instead of blocking the web task.
+static uint32_t consoleAt=0;
+static void traceConsole(){
+  char line[96];
+  TraceRec r;
+  while ((size_t)Serial.availableForWrite() >= sizeof(line)){
+    uint32_t was = consoleAt;
+    if (!traceRing.read(consoleAt, &r, 1)) return;
+    size_t n = 0;
+    if (r.seq - 1 != was) n = snprintf(line, sizeof(line), "(%lu dropped)\n", (unsigned long)(r.seq - 1 - was));
+    n += traceFormat(r, line + n, sizeof(line) - n - 1);
+    line[n++] = '\n';
+    Serial.write((const uint8_t*)line, n);
   }
 }
 
-// ========== Persistence ==========
-static void loadPrefs(){
-  if (!prefs.begin("winder", true)) return;
-  STEP_RPM   = prefs.getInt("rpm", STEP_RPM);
-  TPD_M1     = prefs.getInt("tpd1", TPD_M1);
-  TPD_M2     = prefs.getInt("tpd2", TPD_M2);
-  DIRPLAN_M1 = prefs.getInt("dir1", DIRPLAN_M1);
-  DIRPLAN_M2 = prefs.getInt("dir2", DIRPLAN_M2);
-  wifiSsid   = prefs.getString("ssid", WIFI_SSID);
-  wifiPass   = prefs.getString("wpass", WIFI_PASS);
-  prefs.end();
+// ===================== Live events (SSE) =====================
+// /events keeps the socket and pushes only changed status fields. The
+// socket is written directly, outside WebServer, from the web task.
+static const int SSE_MAX_CLIENTS = 4;
+static const unsigned long SSE_TICK_MS = 250, SSE_KEEPALIVE_MS = 15000;
+
+struct SseClient { WiFiClient c; W::Sent sent; unsigned long lastTx; bool used; };
+static SseClient sseClients[SSE_MAX_CLIENTS];
+static unsigned long sseLastTick = 0;
+
+static void sseDrop(SseClient& s){ s.c.stop(); s.c = WiFiClient(); s.used = false; }
+
+static void ssePush(SseClient& s, const W::Status& st, const char* net, bool full){
+  char* buf = respBuf;
+  JsonOut j(buf + 6, RESP_BUF_SIZE - SSE_FRAME);   // room for "data: " and "\n\n"
+  unsigned long now = millis();
+  if (full) statusJsonFull(j, st, statusExtra(net), s.sent, now);
+  else if (!statusJsonDiff(j, s.sent, st, net, now)){
+    if (now - s.lastTx < SSE_KEEPALIVE_MS) return;
+    if (s.c.write((const uint8_t*)":\n\n", 3) != 3) sseDrop(s); else s.lastTx = now;
+    return;
+  }
+  memcpy(buf, "data: ", 6);
+  size_t n = 6 + j.length();
+  buf[n++] = '\n'; buf[n++] = '\n';
+  if (s.c.write((const uint8_t*)buf, n) != n) sseDrop(s); else s.lastTx = now;
 }
-static void savePrefs(){
-  if (!prefs.begin("winder", false)) return;
-  prefs.putInt("rpm", STEP_RPM);
-  prefs.putInt("tpd1", TPD_M1);
-  prefs.putInt("tpd2", TPD_M2);
-  prefs.putInt("dir1", DIRPLAN_M1);
-  prefs.putInt("dir2", DIRPLAN_M2);
-  // Wi-Fi creds saved via saveWifiCreds()
-  prefs.end();
+
+static void handleEvents(){
+  SseClient* slot = nullptr;
+  for (SseClient& s : sseClients) if (!s.used){ slot = &s; break; }
+  if (!slot){ server.send_P(503,"text/plain",PSTR("too many streams")); return; }
+  slot->c = server.client();
+  slot->c.setNoDelay(true);
+  static const char HDR[] = "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                            "Cache-Control: no-cache\r\nConnection: keep-alive\r\n\r\nretry: 5000\n\n";
+  slot->c.write((const uint8_t*)HDR, sizeof(HDR) - 1);
+  slot->used = true; slot->sent.valid = false;
+  W::Status st; motionStatus.read(st); statusAge(st, millis());
+  char net[STATUS_NET_MAX]; netDescribe(net, sizeof(net));
+  ssePush(*slot, st, net, true);
+  server.client().stop();   // detach: the socket lives on in the slot, and the server skips its 2 s HC_WAIT_CLOSE
 }
 
-// ===================== UI (HTML) =====================
-static const char PAGE_INDEX[] PROGMEM = R"HTML(
-<!doctype html><meta charset="utf-8"><meta name="viewport" content="width=device-width,initial-scale=1">
-<title>Winder</title>
-<style>
-*{box-sizing:border-box}
-:root{ --gap:12px; --rad:12px; --bg:#ffffff; --fg:#111; --card:#f7f7f7; --pill:#efefef; --border:#ddd; --muted:#666; }
-:root[data-theme="dark"]{ --bg:#0f1115; --fg:#e9eef7; --card:#1a1f28; --pill:#232a34; --border:#2b3440; --muted:#9aa6b2; }
-@media (prefers-color-scheme: dark){
-  :root:not([data-theme="light"]){ --bg:#0f1115; --fg:#e9eef7; --card:#1a1f28; --pill:#232a34; --border:#2b3440; --muted:#9aa6b2; }
-}
-html,body{background:var(--bg); color:var(--fg)}
-body{font-family:system-ui,Segoe UI,Roboto,sans-serif;margin:20px;max-width:820px}
-h2{margin:0 0 10px}
-fieldset{border:1px solid var(--border);border-radius:var(--rad);margin:14px 0;padding:12px;background:var(--card)}
-legend{padding:0 6px;font-weight:600}
-label{font-weight:600;display:block;margin:4px 0}
-small.helper{display:block;color:var(--muted)}
-input,select,button{ width:100%; padding:8px 10px;border-radius:8px;border:1px solid var(--border);background:var(--bg);color:var(--fg);font:inherit }
-button{cursor:pointer}button:active{transform:translateY(1px)}
-.row{display:flex;gap:var(--gap);flex-wrap:wrap;align-items:center}
-.right{display:flex;gap:var(--gap);justify-content:flex-end;flex-wrap:wrap}
-.pill{display:inline-block;padding:6px 10px;border-radius:999px;background:var(--pill);margin-right:8px}
-.ok{background:#1b8f3a20}.warn{background:#f5a52426}
-.note{font-size:.92rem;color:var(--muted)}
-.pair{ display:grid; grid-template-columns: repeat(2, minmax(160px, 1fr)); gap:var(--gap) }
-.pair.wide{ grid-template-columns: repeat(2, minmax(240px, 1fr)); }
-.cell{ min-width:0 }
-.pair-2{ display:grid; grid-template-columns: 220px 1fr; gap:var(--gap); align-items:end }
-@media (max-width:560px){ .pair-2{ grid-template-columns: 1fr } }
-.btnrow{ display:flex; gap:8px; flex-wrap:nowrap; }
-@media (max-width:560px){ .btnrow{ flex-wrap:wrap } }
-.btnrow button{ flex:1 1 0 }
-@media (max-width:360px){ .pair{ grid-template-columns: 1fr } .pair.wide{ grid-template-columns: 1fr } }
-</style>
-
-<h2>Dual Watch Winder</h2>
-<div class="row" style="margin-bottom:6px">
-  <div id="net" class="pill">Loading…</div>
-  <div id="runstate" class="pill">—</div>
-  <span>Switch mode: <b id="swmode">—</b></span>
-  <div class="right" style="margin-left:auto"><button id="themeToggle" title="Toggle dark mode">🌙</button></div>
-</div>
-
-<fieldset><legend>Controls</legend>
-  <div class="row" style="gap:12px;align-items:center">
-    <button id="start" style="max-width:180px">Start</button>
-    <button id="stop"  style="max-width:180px">Stop</button>
-  </div>
-</fieldset>
-
-<fieldset><legend>Parameters</legend>
-  <div class="note" style="margin-bottom:8px">Tip: <b>typical automatic watches are ~650–800 TPD</b>.</div>
-
-  <div class="pair">
-    <div class="cell">
-      <label for="tpd1">Motor 1 – TPD</label>
-      <input type="number" id="tpd1" min="0" max="1200" step="50"/>
-      <small class="helper">0 = disabled</small>
-    </div>
-    <div class="cell">
-      <label for="dir1">Motor 1 – Direction</label>
-      <select id="dir1"><option value="1">CW</option><option value="-1">CCW</option><option value="0">Alternate</option></select>
-    </div>
-  </div>
-
-  <div class="pair" style="margin-top:10px">
-    <div class="cell">
-      <label for="tpd2">Motor 2 – TPD</label>
-      <input type="number" id="tpd2" min="0" max="1200" step="50"/>
-      <small class="helper">0 = disabled</small>
-    </div>
-    <div class="cell">
-      <label for="dir2">Motor 2 – Direction</label>
-      <select id="dir2"><option value="1">CW</option><option value="-1">CCW</option><option value="0">Alternate</option></select>
-    </div>
-  </div>
-
-  <div class="right" style="margin-top:10px"><button id="save" style="max-width:160px">Save</button></div>
-</fieldset>
-
-<fieldset><legend>Turbo Mode</legend>
-  <div class="pair-2">
-    <div class="cell">
-      <label for="tdur">Duration</label>
-      <select id="tdur"><option value="5">5 min</option><option value="10">10 min</option></select>
-    </div>
-    <div class="cell">
-      <label style="font-weight:700;margin-bottom:4px">Winder Select</label>
-      <div class="btnrow">
-        <button id="t1">Motor 1</button>
-        <button id="t2">Motor 2</button>
-        <button id="tboth">Both</button>
-      </div>
-    </div>
-  </div>
-  <div class="note" id="tstatus" style="margin-top:8px">—</div>
-</fieldset>
-
-<fieldset><legend>Status</legend>
-  <div class="pair">
-    <div class="cell">Next M1 in: <b id="n1">—</b></div>
-    <div class="cell">Next M2 in: <b id="n2">—</b></div>
-  </div>
-</fieldset>
-
-<fieldset><legend>Wi-Fi Setup</legend>
-  <div class="note" style="margin-bottom:6px">Connect to <b>Winder-Setup</b>, then choose your home Wi-Fi and tap <b>Connect</b>.</div>
-  <div class="pair wide">
-    <div class="cell">
-      <label for="wssid">Wi-Fi SSID</label>
-      <select id="wssid">
-        <option value="">(Scanning…)</option>
-        <option value="__other__">Other…</option>
-      </select>
-      <input id="wssid_other" placeholder="Enter SSID" style="display:none;margin-top:8px"/>
-    </div>
-    <div class="cell">
-      <label for="wpass">Password</label>
-      <input id="wpass" type="password" placeholder="Password"/>
-    </div>
-  </div>
-  <div class="right" style="margin-top:8px"><button id="wconnect" style="max-width:180px">Connect</button></div>
-  <div class="note" id="wstatus" style="margin-top:8px">—</div>
-</fieldset>
-
-<script>
-const $=s=>document.querySelector(s);
-async function api(p,o={}){const r=await fetch(p,Object.assign({headers:{'Content-Type':'application/json'}},o));return r.json().catch(()=>({}))}
-function fmt(ms){if(ms<0)return'—';const s=Math.round(ms/1000);const m=Math.floor(s/60),ss=s%60;return(m>0?m+'m ':'')+ss+'s'}
-
-(function initTheme(){
-  const saved=localStorage.getItem('theme');
-  if(saved==='dark'||saved==='light') document.documentElement.setAttribute('data-theme',saved);
-  $('#themeToggle').onclick=()=>{
-    const cur=document.documentElement.getAttribute('data-theme');
-    const next = cur==='dark' ? 'light' : 'dark';
-    document.documentElement.setAttribute('data-theme', next);
-    localStorage.setItem('theme', next);
-  };
-})();
-
-async function refresh(){
-  const s=await api('/status');
-  $('#net').textContent=s.network||'—';$('#net').className='pill '+(s.network?.includes('AP')?'warn':'ok');
-  $('#runstate').textContent=s.enabled?'Running':'Stopped';$('#runstate').className='pill '+(s.enabled?'ok':'');
-  $('#tpd1').value=s.tpd1;$('#tpd2').value=s.tpd2;$('#dir1').value=s.dir1;$('#dir2').value=s.dir2;
-  $('#swmode').textContent=s.switch_mode;
-  $('#n1').textContent=fmt(s.next1_ms);$('#n2').textContent=fmt(s.next2_ms);
-  $('#tstatus').textContent=s.turbo_active?('Turbo '+(s.turbo_m1&&s.turbo_m2?'Both':(s.turbo_m1?'M1':'M2'))+' '+fmt(s.turbo_left_ms)):'—';
-}
-
-async function loadSSIDs(){
-  const sel=$('#wssid'); sel.innerHTML='<option value="">(Scanning…)</option><option value="__other__">Other…</option>';
-  try{
-    const res=await api('/scan');
-    const list=(res && Array.isArray(res.ssids))?res.ssids:[];
-    let html='';
-    for(const s of list){ const esc=String(s).replace(/"/g,'&quot;'); html+=`<option value="${esc}">${esc}</option>`; }
-    html+='<option value="__other__">Other…</option>';
-    sel.innerHTML=html||'<option value="">(No networks found)</option><option value="__other__">Other…</option>';
-  }catch(e){
-    sel.innerHTML='<option value="">(Scan failed)</option><option value="__other__">Other…</option>';
+static void ssePoll(){
+  unsigned long now = millis();
+  if (now - sseLastTick < SSE_TICK_MS) return;
+  sseLastTick = now;
+  bool any = false;
+  for (SseClient& s : sseClients){
+    if (s.used && !s.c.connected()) sseDrop(s);
+    any |= s.used;
   }
+  if (!any) return;
+  W::Status st; motionStatus.read(st); statusAge(st, millis());
+  char net[STATUS_NET_MAX]; netDescribe(net, sizeof(net));
+  for (SseClient& s : sseClients) if (s.used) ssePush(s, st, net, false);
+}
+
+// Fleet beacon: every FLEET_BEACON_MS, or on the next check after anything
+// an operator would see changes (checked once a second, same snapshot as SSE).
+static const uint32_t FLEET_CHECK_MS = 1000;
+static uint32_t fleetCheckAt = 0, fleetSentAt = 0;
+static FleetBeacon fleetLast;
+static bool fleetSent = false;
+static void fleetPoll(){
+  if (!FLEET_BEACON_MS) return;
+  uint32_t now = millis();
+  if (now - fleetCheckAt < FLEET_CHECK_MS) return;
+  fleetCheckAt = now;
+  W::Status st; motionStatus.read(st); statusAge(st, now);
+  FleetBeacon b{};
+  b.node = netNodeId(); b.httpPort = 80; b.uptimeS = now / 1000;
+  fleetFromStatus(st, b);
+  if (fleetSent && now - fleetSentAt < FLEET_BEACON_MS && !fleetChanged(b, fleetLast)) return;
+  b.seq = (uint16_t)(fleetLast.seq + 1);
+  uint8_t pkt[fleetBeaconSize(MOTOR_COUNT)];
+  size_t n = fleetEncode(b, pkt, sizeof(pkt));
+  if (!netBeacon(pkt, n)) return;                  // STA down: try again next check
+  fleetLast = b; fleetSentAt = now; fleetSent = true;
+}
+
+// Queue a command for the motion task; a new config is saved once queued.
+static bool queueCmd(const W::Cmd& c){
+  if (!motionCmds.push(c)) return false;
+  if (motionTaskHandle) xTaskNotifyGive(motionTaskHandle);   // wake it now, not at its next event
+  if (c.op == CMD_CONFIG) savePrefs(c);
+  return true;
+}
+// ... and answer the request
+static bool sendCmd(const W::Cmd& c){
+  if (!queueCmd(c)){ sendConst(503, RESP_BUSY); return false; }
+  sendConst(200, RESP_OK);
+  return true;
+}
+// Hands the motion task the time of day once SNTP has it, and again when
+// it moves (DST, drift): offset from the scheduler clock, mod 24 h.
+static const uint32_t CLOCK_CHECK_MS = 60000;
+static uint32_t clockCheckAt=0, clockSentOffset=0;
+static bool clockSent=false;
+static void clockPoll(){
+  uint32_t now = millis();
+  if (clockSent && now - clockCheckAt < CLOCK_CHECK_MS) return;
+  time_t t = time(nullptr);
+  if (t < 1600000000) return;              // not synced yet
+  clockCheckAt = now;
+  struct tm lt; localtime_r(&t, &lt);
+  uint32_t tod = ((uint32_t)lt.tm_hour * 3600 + lt.tm_min * 60 + lt.tm_sec) * 1000UL;
+  uint64_t clk = hwClock.millis();
+  uint32_t off = (uint32_t)((tod + PROGRAM_DAY_MS - clk % PROGRAM_DAY_MS) % PROGRAM_DAY_MS);
+  int32_t d = (int32_t)((off + PROGRAM_DAY_MS - clockSentOffset) % PROGRAM_DAY_MS);
+  if (d > (int32_t)(PROGRAM_DAY_MS / 2)) d -= PROGRAM_DAY_MS;
+  if (clockSent && d > -2000 && d < 2000) return;   // second resolution; ignore jitter
+  W::Cmd c{}; c.op=CMD_CLOCK; c.todOffsetMs=off;
+  if (!motionCmds.push(c)) return;
+  if (motionTaskHandle) xTaskNotifyGive(motionTaskHandle);
+  clockSent = true; clockSentOffset = off;
 }
-$('#wssid').addEventListener('change', ()=>{
-  const other=$('#wssid').value==='__other__';
-  $('#wssid_other').style.display=other?'block':'none';
-});
-
-$('#start').onclick=async()=>{await api('/start',{method:'POST',body:'{}'});refresh();}
-$('#stop').onclick=async()=>{await api('/stop',{method:'POST',body:'{}'});refresh();}
-$('#save').onclick=async()=>{const b={tpd1:+$('#tpd1').value,tpd2:+$('#tpd2').value,dir1:+$('#dir1').value,dir2:+$('#dir2').value};await api('/config',{method:'POST',body:JSON.stringify(b)});refresh();}
-$('#t1').onclick=async()=>{await api('/turbo',{method:'POST',body:JSON.stringify({m1:true,m2:false,min:+$('#tdur').value})});refresh();}
-$('#t2').onclick=async()=>{await api('/turbo',{method:'POST',body:JSON.stringify({m1:false,m2:true,min:+$('#tdur').value})});refresh();}
-$('#tboth').onclick=async()=>{await api('/turbo',{method:'POST',body:JSON.stringify({m1:true,m2:true,min:+$('#tdur').value})});refresh();}
-$('#wconnect').onclick=async()=>{
-  let ssid=$('#wssid').value; if(ssid==='__other__') ssid=$('#wssid_other').value.trim();
-  const pass=$('#wpass').value;
-  if(!ssid){$('#wstatus').textContent='Please select or enter an SSID';return;}
-  $('#wstatus').textContent='Connecting…';
-  const res=await api('/wifi',{method:'POST',body:JSON.stringify({ssid,pass})});
-  if(res.ok){$('#wstatus').innerHTML='Connected to <b>'+ssid+'</b><br>Open '+(res.mdns||'')+' or '+(res.ip||'');}
-  else{$('#wstatus').textContent='Connection failed. Check SSID/password and try again.';}
+
+// ---------- WebServer side of web_routes.h ----------
+typedef WebRoutes<MOTOR_COUNT> Routes;
+static const WebHooks<MOTOR_COUNT> routeHooks = {
+  queueCmd,
+  [](char* net){ netDescribe(net, STATUS_NET_MAX); return statusExtra(net); },
+  [](){ return (uint32_t)millis(); },
+  UI_INDEX_GZ, UI_INDEX_GZ_LEN, UI_INDEX_ETAG,
 };
+static Routes webRoutes(motionStatus, routeHooks, respBuf, sizeof(respBuf));
 
-refresh(); setInterval(refresh,3000); loadSSIDs();
-</script>
-)HTML";
+class ServerResp : public WebResp {
+public:
+  void header(const char* name, const char* value) override { server.sendHeader(name, value); }
+  void send(int code, const char* type, const char* body, size_t n) override {
+    if (n) server.send_P(code, type, body, n); else server.send(code);
+  }
+};
+static void serveRoute(Routes::Handler h){
+  const String& body = server.arg("plain");
+  String uri = server.uri(), inm = server.header("If-None-Match");
+  WebReq r{ (uint8_t)(server.method() == HTTP_POST ? WEB_POST : WEB_GET), uri.c_str(), body.c_str(), body.length(), inm.c_str() };
+  ServerResp o;
+  (webRoutes.*h)(r, o);
+}
+
+// ---------- Binary control: ctl_frame.h over UDP and WebSocket ----------
+// Datagrams on CTL_PORT arrive in the AsyncUDP task and are handed to the
+// web task (the command ring has one producer), waking it at once. GET /ctl
+// upgrades to a WebSocket that stays open, one binary message per request.
+// Both answer through CtlServer, on the same hooks as the JSON routes.
+static CtlServer<MOTOR_COUNT> ctl(motionStatus, routeHooks);
+struct CtlDatagram { uint32_t ip; uint16_t port; uint8_t len; uint8_t data[CTL_FRAME_MAX]; };
+static SpscRing<CtlDatagram, 8> ctlInbox;
+static AsyncUDP ctlUdp;
+struct CtlSocket { WiFiClient c; uint8_t in[WS_HEAD_MAX + CTL_FRAME_MAX]; size_t have; uint32_t peer; bool used; };
+static CtlSocket ctlSockets[CTL_WS_MAX];
+static uint32_t ctlPeers = 0;
+
+static void ctlBegin(){
+  if (!ctlUdp.listen(CTL_PORT)) return;
+  ctlUdp.onPacket([](AsyncUDPPacket& p){
+    CtlDatagram d;
+    if (p.length() > sizeof(d.data)) return;
+    d.ip = (uint32_t)p.remoteIP(); d.port = p.remotePort(); d.len = (uint8_t)p.length();
+    memcpy(d.data, p.data(), d.len);
+    if (ctlInbox.push(d) && webTaskHandle) xTaskNotifyGive(webTaskHandle);
+  });
+}
+
+static void ctlDrop(CtlSocket& s){ s.c.stop(); s.c = WiFiClient(); s.used = false; }
+static void ctlSend(CtlSocket& s, uint8_t op, const uint8_t* p, size_t n){
+  uint8_t out[WS_HEAD_MAX + CTL_FRAME_MAX];
+  size_t h = wsHead(out, op, n, nullptr);
+  memcpy(out + h, p, n);
+  if (s.c.write(out, h + n) != h + n) ctlDrop(s);
+}
+
+static void handleCtlUpgrade(){
+  String key = server.header("Sec-WebSocket-Key");
+  if (!key.length() || !server.header("Upgrade").equalsIgnoreCase("websocket")){ server.send_P(400,"text/plain",PSTR("websocket only")); return; }
+  CtlSocket* slot = nullptr;
+  for (CtlSocket& s : ctlSockets) if (!s.used){ slot = &s; break; }
+  if (!slot){ server.send_P(503,"text/plain",PSTR("too many sockets")); return; }
+  char accept[WS_ACCEPT_LEN + 1], hdr[160];
+  wsAccept(key.c_str(), accept);
+  int n = snprintf(hdr, sizeof(hdr), "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                   "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n", accept);
+  slot->c = server.client();
+  slot->c.setNoDelay(true);
+  slot->c.write((const uint8_t*)hdr, (size_t)n);
+  slot->have = 0; slot->peer = ++ctlPeers; slot->used = true;
+  server.client().stop();   // detach, as for /events
+}
+
+static bool ctlPoll(){
+  uint8_t out[CTL_FRAME_MAX];
+  bool open = false;
+  for (CtlDatagram d; ctlInbox.pop(d);){
+    RouteTimer rt(RT_CTL);
+    size_t n = ctl.handle((uint64_t)d.ip << 16 | d.port, d.data, d.len, out, sizeof(out));
+    if (n) ctlUdp.writeTo(out, n, IPAddress(d.ip), d.port);
+  }
+  for (CtlSocket& s : ctlSockets){
+    if (s.used && !s.c.connected()) ctlDrop(s);
+    if (!s.used) continue;
+    while (s.c.available() && s.have < sizeof(s.in)){
+      int k = s.c.read(s.in + s.have, sizeof(s.in) - s.have);
+      if (k <= 0) break;
+      s.have += (size_t)k;
+    }
+    while (s.used){
+      WsFrame f;
+      int h = wsParse(s.in, s.have, f);
+      if (h < 0 || (h > 0 && (!f.masked || f.head + f.len > sizeof(s.in)))){ ctlDrop(s); break; }   // clients must mask
+      if (h == 0 || s.have < f.head + f.len) break;
+      uint8_t* p = s.in + f.head;
+      wsMask(p, f.len, f.mask);
+      if (f.op == WS_CLOSE){ ctlSend(s, WS_CLOSE, p, f.len < 2 ? f.len : 2); ctlDrop(s); break; }
+      if (f.op == WS_PING) ctlSend(s, WS_PONG, p, f.len);
+      else if (f.op == WS_BINARY){
+        RouteTimer rt(RT_CTL);
+        size_t n = ctl.handle((uint64_t)1 << 48 | s.peer, p, f.len, out, sizeof(out));
+        if (n) ctlSend(s, WS_BINARY, out, n);
+      }
+      size_t used = f.head + f.len;
+      memmove(s.in, s.in + used, s.have - used); s.have -= used;
+    }
+    open |= s.used;
+  }
+  return open;
+}
 
-// ===================== Routes =====================
-static const char RESP_OK[] PROGMEM = "{\"ok\":true}";
 void setupRoutes(){
-  server.on("/", HTTP_GET, [](){ server.send_P(200,"text/html",PAGE_INDEX); });
+  static const char* HEADERS[] = { "If-None-Match", "Upgrade", "Sec-WebSocket-Key" };
+  server.collectHeaders(HEADERS, 3);
+
+  server.on("/", HTTP_GET, [](){ serveRoute(&Routes::index); });
 
   // Connectivity checks some OSes do
   server.on("/generate_204", HTTP_GET, [](){ server.send(204); });
-  server.on("/hotspot-detect.html", HTTP_GET, [](){ server.send(200,"text/html","<meta http-equiv='refresh' content='0; url=/'/>"); });
-  server.on("/connecttest.txt", HTTP_GET, [](){ server.send(200,"text/plain","OK"); });
-
-  server.on("/status", HTTP_GET, [](){
-    JsonDocument doc;
-    String net = (WiFi.getMode()==WIFI_AP || WiFi.getMode()==WIFI_MODE_APSTA)
-      ? ("AP: "+String(AP_SSID)+" ("+String(WiFi.softAPgetStationNum())+" client(s)) @ "+String(WiFi.softAPIP().toString().c_str()))
-      : ("WiFi: "+WiFi.SSID()+" ("+String(WiFi.localIP().toString().c_str())+") / mDNS: http://winder.local");
-    doc["network"]=net; doc["enabled"]=enabled; doc["switch_mode"]=stableMode;
-    doc["tpd1"]=TPD_M1; doc["tpd2"]=TPD_M2; doc["dir1"]=DIRPLAN_M1; doc["dir2"]=DIRPLAN_M2;
-    long now = (long)millis();
-
-    long rem1 = (TPD_M1>0 && nextDue1>0) ? ((long)nextDue1 - now) : -1;
-    if (rem1 < 0 && rem1 != -1) rem1 = 0;
-
-    long rem2 = (TPD_M2>0 && nextDue2>0) ? ((long)nextDue2 - now) : -1;
-    if (rem2 < 0 && rem2 != -1) rem2 = 0;
-
-    long tleft = turboActive ? ((long)turboEndMs - (long)millis()) : 0;
-    if (tleft < 0) tleft = 0;
-
-    doc["next1_ms"] = rem1;
-    doc["next2_ms"] = rem2;
-    doc["turbo_active"] = turboActive;
-    doc["turbo_m1"] = turboM1;
-    doc["turbo_m2"] = turboM2;
-    doc["turbo_left_ms"] = tleft;
-    String out; serializeJson(doc,out); server.send(200,"application/json",out);
-  });
+  server.on("/hotspot-detect.html", HTTP_GET, [](){ server.send_P(200,"text/html",PSTR("<meta http-equiv='refresh' content='0; url=/'/>")); });
+  server.on("/connecttest.txt", HTTP_GET, [](){ server.send_P(200,"text/plain",PSTR("OK")); });
 
-  server.on("/start", HTTP_POST, [](){ enabled=true; server.send_P(200,"application/json",RESP_OK); });
-  server.on("/stop",  HTTP_POST, [](){ enabled=false; server.send_P(200,"application/json",RESP_OK); });
-
-  server.on("/config", HTTP_POST, [](){
-    if (!server.hasArg("plain")){ server.send(400,"application/json","{\"ok\":false}"); return; }
-    JsonDocument doc;
-    if (deserializeJson(doc, server.arg("plain"))){ server.send(400,"application/json","{\"ok\":false}"); return; }
-    int t1=doc["tpd1"]|TPD_M1, t2=doc["tpd2"]|TPD_M2;
-    int d1=doc["dir1"]|DIRPLAN_M1, d2=doc["dir2"]|DIRPLAN_M2;
-    t1=constrain(t1,0,1200); t2=constrain(t2,0,1200);
-    if (!(d1==-1||d1==0||d1==+1)) d1=0; if (!(d2==-1||d2==0||d2==+1)) d2=0;
-    TPD_M1=t1; TPD_M2=t2; DIRPLAN_M1=d1; DIRPLAN_M2=d2;
-    savePrefs();
-    unsigned long now=millis();
-    nextDue1 = (TPD_M1>0)? now+intervalFromTPD(TPD_M1) : 0;
-    nextDue2 = (TPD_M2>0)? now+intervalFromTPD(TPD_M2) : 0;
-    server.send_P(200,"application/json",RESP_OK);
-  });
+  server.on("/status", HTTP_GET, [](){ RouteTimer rt(RT_STATUS); serveRoute(&Routes::status); });
 
-  server.on("/turbo", HTTP_POST, [](){
-    if (!server.hasArg("plain")){ server.send(400,"application/json","{\"ok\":false}"); return; }
-    JsonDocument doc;
-    if (deserializeJson(doc, server.arg("plain"))){ server.send(400,"application/json","{\"ok\":false}"); return; }
-    bool m1 = doc["m1"] | false, m2 = doc["m2"] | false;
-    int minutes = constrain((int)(doc["min"]|5), 1, 15);
-    startTurbo(m1,m2,(unsigned long)minutes);
-    server.send_P(200,"application/json",RESP_OK);
-  });
+  server.on("/events", HTTP_GET, handleEvents);
+  server.on("/ctl", HTTP_GET, handleCtlUpgrade);
+
+  server.on("/start", HTTP_POST, [](){ serveRoute(&Routes::start); });
+  server.on("/stop",  HTTP_POST, [](){ serveRoute(&Routes::stop); });
+  server.on("/config", HTTP_POST, [](){ RouteTimer rt(RT_CONFIG); serveRoute(&Routes::config); });
+  server.on("/turbo", HTTP_POST, [](){ RouteTimer rt(RT_TURBO); serveRoute(&Routes::turbo); });
 
   server.on("/wifi", HTTP_POST, [](){
-    if (!server.hasArg("plain")){ server.send(400,"application/json","{\"ok\":false}"); return; }
-    JsonDocument doc;
-    if (deserializeJson(doc, server.arg("plain"))){ server.send(400,"application/json","{\"ok\":false}"); return; }
-    String ssid=String((const char*)doc["ssid"]); String pass=String((const char*)doc["pass"]);
-    ssid.trim(); pass.trim();
-    if (ssid.length()==0){ server.send(400,"application/json","{\"ok\":false,\"err\":\"empty ssid\"}"); return; }
+    RouteTimer rt(RT_WIFI);
+    const String& body=server.arg("plain");
+    JsonIn in(body.c_str(), body.length());
+    if (!in.ok()){ sendConst(400, RESP_BAD); return; }
+    char ssid[33]="", pass[65]="";
+    if (in.has("ssid") && !in.str("ssid", ssid, sizeof(ssid))){ sendConst(400, PSTR("{\"ok\":false,\"err\":\"ssid too long\"}")); return; }
+    if (in.has("pass") && !in.str("pass", pass, sizeof(pass))){ sendConst(400, PSTR("{\"ok\":false,\"err\":\"pass too long\"}")); return; }
+    trimInPlace(ssid); trimInPlace(pass);
+    if (!ssid[0]){ sendConst(400, PSTR("{\"ok\":false,\"err\":\"empty ssid\"}")); return; }
     saveWifiCreds(ssid, pass);
+    netConnect(ssid, pass);   // returns at once; poll GET /wifi for progress
+    sendConst(200, PSTR("{\"ok\":true,\"state\":\"connecting\"}"));
+  });
 
-    // Try STA; on failure ensure AP is up (AP-only)
-    if (startSTA(12000)){
-      String ip = ipToStr(WiFi.localIP());
-      if (MDNS.begin("winder")) MDNS.addService("http","tcp",80);
-      String out=String("{\"ok\":true,\"ip\":\"")+ip+"\",\"mdns\":\"http://winder.local\"}";
-      server.send(200,"application/json",out);
-    } else {
-      startAP();               // bring AP back
-      httpStarted = false;     // <<< add this
-      startHttpServerIfNeeded(); // <<< and this
-      server.send(200,"application/json","{\"ok\":false,\"err\":\"connect_failed\"}");
-    }
+  server.on("/wifi", HTTP_GET, [](){
+    RouteTimer rt(RT_WIFI);
+    NetProgress p=netProgress();
+    char ip[16]; netIp(ip, sizeof(ip));
+    JsonOut j(respBuf, sizeof(respBuf));
+    j.begin().str("state", netStateName(p.state)).str("ssid", netSsid()).str("ip", ip);
+    j.unum("elapsed_ms", p.elapsedMs).unum("attempts", p.attempts).unum("reason", p.reason).boolean("ap", p.apUp);
+    char mdns[FLEET_NAME_MAX + 14]; snprintf(mdns, sizeof(mdns), "http://%s.local", netHostname());
+    if (p.state==NET_STA_UP) j.str("mdns", mdns);
+    sendJson(200, j.end());
   });
 
+  // Cached background scan, answered at once; ?refresh=1 queues a new scan
+  // (poll again while "scanning" is true). Streamed one network per chunk.
   server.on("/scan", HTTP_GET, [](){
-    JsonDocument doc;
-    JsonArray arr = doc["ssids"].to<JsonArray>();
-    int n = WiFi.scanNetworks(false, true);
-    for (int i=0;i<n;i++){
-      String s=WiFi.SSID(i); s.trim(); if (s.isEmpty()) continue;
-      bool dup=false;
-      for (JsonVariantConst v:arr){ const char* e=v.as<const char*>(); if (e && s.equals(e)){ dup=true; break; } }
-      if (!dup) arr.add(s);
+    RouteTimer rt(RT_SCAN);
+    if (server.hasArg("refresh")) netScanRequest();
+    const ScanCache& nets = netScanResults();
+    JsonOut h(respBuf, sizeof(respBuf));
+    h.begin().num("age_ms", netScanAgeMs()).boolean("scanning", netScanning()).key("nets").raw("[");
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+    server.sendContent(h.c_str(), h.length());
+    for (uint8_t i=0;i<nets.size();i++){
+      const ScanNet& n = nets[i];
+      JsonOut j(respBuf, sizeof(respBuf));
+      if (i) j.raw(",");
+      j.begin().str("ssid", n.ssid).num("rssi", n.rssi).unum("ch", n.channel).unum("auth", n.auth).end();
+      server.sendContent(j.c_str(), j.length());
     }
-    String out; serializeJson(doc,out);
-    server.send(200,"application/json",out);
+    server.sendContent_P(PSTR("]}"));
+    server.sendContent("", 0);   // end of chunked body
+  });
+
+  // Switch presets: what each selector position applies when moved to.
+  // POST {"pos":0..2,"manual":bool,"tpdN":..,"dirN":..}, omitted keys keep
+  // their value; an edit to the selected position applies at once.
+  server.on("/presets", HTTP_GET, [](){
+    RouteTimer rt(RT_PRESETS);
+    W::Status st; motionStatus.read(st);
+    JsonOut h(respBuf, sizeof(respBuf));
+    h.begin().num("switch", st.switchMode).key("presets").raw("[");
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+    server.sendContent(h.c_str(), h.length());
+    for (uint8_t i=0;i<SWITCH_POSITIONS;i++){
+      const SwitchPreset<MOTOR_COUNT>& p = cfg.presets.pos[i];
+      JsonOut j(respBuf, sizeof(respBuf));
+      if (i) j.raw(",");
+      j.begin().boolean("manual", p.manual);
+      for (uint8_t m=0;m<MOTOR_COUNT;m++) j.numN("tpd", m+1, nullptr, p.tpd[m]).numN("dir", m+1, nullptr, p.dir[m]);
+      server.sendContent(j.end().c_str(), j.length());
+    }
+    server.sendContent_P(PSTR("]}"));
+    server.sendContent("", 0);
+  });
+  server.on("/presets", HTTP_POST, [](){
+    RouteTimer rt(RT_PRESETS);
+    const String& body=server.arg("plain");
+    JsonIn in(body.c_str(), body.length());
+    long pos = in.ok() ? in.num("pos", -1) : -1;
+    if (pos < 0 || pos >= SWITCH_POSITIONS){ sendConst(400, RESP_BAD); return; }
+    SwitchPreset<MOTOR_COUNT> p = cfg.presets.pos[pos];
+    p.manual = in.boolean("manual", p.manual);
+    bool ok = true;
+    for (uint8_t m=0;m<MOTOR_COUNT;m++){
+      char kt[8], kd[8]; snprintf(kt, sizeof(kt), "tpd%u", m+1); snprintf(kd, sizeof(kd), "dir%u", m+1);
+      long t = in.num(kt, p.tpd[m]), d = in.num(kd, p.dir[m]);
+      ok &= t >= 0 && t <= 1200 && d >= -1 && d <= 1;
+      p.tpd[m] = (int16_t)t; p.dir[m] = (int8_t)d;
+    }
+    if (!ok){ sendConst(400, PSTR("{\"ok\":false,\"err\":\"preset\"}")); return; }
+    W::Cmd c{}; c.op=CMD_PRESET; c.preset=(uint8_t)pos; c.manual=p.manual;
+    for (uint8_t m=0;m<MOTOR_COUNT;m++){ c.tpd[m]=p.tpd[m]; c.dir[m]=p.dir[m]; }
+    if (!sendCmd(c)) return;
+    cfg.presets.pos[pos] = p;
+    if (pos == cfg.switchPos && !p.manual)
+      for (uint8_t m=0;m<MOTOR_COUNT;m++){ cfg.tpd[m] = p.tpd[m]; cfg.dir[m] = p.dir[m]; }
+    prefsChanged();
+  });
+
+  // Odometer history, oldest hour first: each bucket is one [cw,ccw,turbo,
+  // missed,late,steps,tpd] row per motor (counts in that hour, TPD at its
+  // end); "open" is the hour in progress. ?hours=N keeps the newest N.
+  server.on("/history", HTTP_GET, [](){
+    RouteTimer rt(RT_HISTORY);
+    const History& h = rtcHist.h;
+    W::Status st; motionStatus.read(st);
+    uint16_t skip = 0;
+    if (server.hasArg("hours")){ long n = server.arg("hours").toInt(); if (n >= 0 && n < h.hours()) skip = (uint16_t)(h.hours() - n); }
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+    ChunkOut o(respBuf, sizeof(respBuf), sendChunk, nullptr);
+    o.line("{\"hour_ms\":%lu,\"hours\":%u,\"bytes\":%u,\"capacity\":%u,\"close_in_ms\":%lu,\"fields\":[",
+           (unsigned long)HISTORY_HOUR_MS, (unsigned)(h.hours() - skip), h.bytes(), History::capacity(), (unsigned long)(histCloseAt - hwClock.millis()));
+    for (uint8_t f=0;f<ODO_FIELDS;f++) o.line(f ? ",\"%s\"" : "\"%s\"", ODO_NAMES[f]);
+    auto row = [&o](const uint32_t* v, bool first){
+      o.line("%s[%lu,%lu,%lu,%lu,%lu,%lu,%lu]", first ? "" : ",", (unsigned long)v[0], (unsigned long)v[1], (unsigned long)v[2],
+             (unsigned long)v[3], (unsigned long)v[4], (unsigned long)v[5], (unsigned long)v[6]);
+    };
+    static_assert(ODO_FIELDS == 7, "row() prints seven fields");
+    o.line("],\"totals\":[");
+    for (uint8_t m=0;m<MOTOR_COUNT;m++) row(st.odo[m].v, m == 0);
+    History::Bucket open; h.open(st.odo, open);
+    o.line("],\"open\":[");
+    for (uint8_t m=0;m<MOTOR_COUNT;m++) row(open[m], m == 0);
+    o.line("],\"buckets\":[");
+    h.each([&](uint16_t i, const History::Bucket& b){
+      if (i < skip) return;
+      o.line(i > skip ? ",[" : "[");
+      for (uint8_t m=0;m<MOTOR_COUNT;m++) row(b[m], m == 0);
+      o.line("]");
+    });
+    o.line("]}");
+    o.flush();
+    server.sendContent("", 0);
+  });
+
+  server.on("/metrics", HTTP_GET, [](){
+    bool json = server.arg("format") == "json";
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, json ? "application/json" : "text/plain; version=0.0.4", "");
+    if (json) metricsJson(); else metricsProm();
+    server.sendContent("", 0);
   });
+  server.on("/trace", HTTP_GET, sendTrace);
+}
+
+// ===================== Setup / Tasks =====================
+// Sleeps until the scheduler's next event (or a command notification);
+// 2 ms passes only while the step timer runs (a move or a coil release).
+// Ticks are 1 ms, so a wait ends on the due millisecond.
+static void motionTask(void*){
+  for (;;){
+    motionPass();
+    uint64_t now = hwClock.millis(), next = sched.nextEventMs();
+    uint64_t waitMs = next > now && !stepTimerOn ? next - now : 2;
+    if (waitMs > 60000) waitMs = 60000;
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS((uint32_t)waitMs));
+  }
+}
+// 2 ms passes for a second after the last request (or while a control
+// socket is open), otherwise a slower poll so the core can sleep between
+// them (SSE frames go out every 250 ms anyway). A control datagram wakes
+// the task early.
+static const uint32_t WEB_ACTIVE_MS = 1000, WEB_IDLE_POLL_MS = 20;
+static void webTask(void*){
+  uint32_t lastBusy = 0;
+  for (;;){
+    uint32_t t0 = micros();
+    server.handleClient();
+    uint32_t t1 = micros();
+    bool ctlOpen = ctlPoll();
+    netPoll(); ssePoll(); clockPoll(); switchSync(); prefsPoll(); historyPoll(); fleetPoll(); traceConsole();
+    httpUs.record(t1 - t0); webLoopUs.record(micros() - t0);
+    if (server.client().connected() || ctlOpen) lastBusy = millis();
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(millis() - lastBusy < WEB_ACTIVE_MS ? 2 : WEB_IDLE_POLL_MS));
+  }
 }
 
-// ===================== Setup / Loop =====================
 void setup(){
   Serial.begin(115200);
   pinMode(MODE_PIN_A, INPUT_PULLUP); pinMode(MODE_PIN_B, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(MODE_PIN_A), onModeEdge, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(MODE_PIN_B), onModeEdge, CHANGE);
   if (LED_PIN>=0){ pinMode(LED_PIN, OUTPUT); digitalWrite(LED_PIN, LOW); }
 
-  loadPrefs();
+  for (uint8_t m=0;m<MOTOR_COUNT;m++) sched.setPlan(m, MOTOR_TABLE[m].tpd, MOTOR_TABLE[m].dirPlan);
+  sched.setProgram(WindProgram{ PROGRAM_EVERY_MIN, PROGRAM_START_MIN, PROGRAM_END_MIN });
+  engine.setRelease(COILS_RELEASE_IDLE);
+  engine.setPowerBudget(POWER_BUDGET_MA, COIL_MA, COIL_TAU_US);
+  // Warm boot (anything but power-on): settings and schedule come back from RTC memory
+  bool warm = esp_reset_reason() != ESP_RST_POWERON;
+  uint64_t r0 = esp_timer_get_time();
+  loadPrefs(warm);
+  uint32_t loadUs = (uint32_t)(esp_timer_get_time() - r0);
+  esp_register_shutdown_handler(prefsFlush);   // unsaved changes survive esp_restart()
   applyMotionParams();
-  s1.setCurrentPosition(0); s2.setCurrentPosition(0);
-
-  unsigned long now=millis();
-  nextDue1 = (TPD_M1>0)? now+intervalFromTPD(TPD_M1) : 0;
-  nextDue2 = (TPD_M2>0)? now+intervalFromTPD(TPD_M2) : 0;
-
-  for (int i=0;i<5;i++){ updateModeDebounced(); delay(10); }
-
-  startWiFi();
+#if defined(WINDER_BENCH) && !COILS_SHIFT_REGISTER
+  benchCoils();
+#endif
+  cpuMhz = ESP.getCpuFreqMHz();
+  startStepTimer();
+  powerBegin();
+
+  r0 = esp_timer_get_time();
+  motionResume(warm);
+  for (uint8_t m=0;m<MOTOR_COUNT;m++) turnsSeen[m] = sched.turns(m);
+  bootResumeUs = loadUs + (uint32_t)(esp_timer_get_time() - r0);
+  trace(TR_BOOT, bootKind, bootResumeUs);
+  publishStatus();
+  historyBegin(warm);
+
+  // Motion/scheduler on core 1, HTTP + Wi-Fi on core 0 (where the Wi-Fi stack lives)
+  xTaskCreatePinnedToCore(motionTask, "motion", 4096, nullptr, 3, &motionTaskHandle, 1);
+
+  // Wi-Fi comes up in the background (AP + STA join together); nothing here waits on it
+  netBegin(cfg.ssid, cfg.pass);
+  ctlBegin();
   setupRoutes();
+  server.begin();
+  xTaskCreatePinnedToCore(webTask, "web", 8192, nullptr, 1, &webTaskHandle, 0);
 }
 
 void loop(){
-  server.handleClient();
-
-  updateModeDebounced();
-  if (stableMode!=1) applyModePreset(stableMode);
-
-  updateTurbo();
-
-  if (!enabled){
-    indicate(false);
-    if (s1.distanceToGo()!=0) s1.stop();
-    if (s2.distanceToGo()!=0) s2.stop();
-    s1.run(); s2.run();
-    delay(2);
-    return;
-  }
-  indicate(true);
-
-  s1.run(); s2.run();
-
-  unsigned long now=millis();
-  if (!turboActive && TPD_M1>0 && nextDue1>0 && now>=nextDue1 && s1.distanceToGo()==0){
-    int dir=pickDir(DIRPLAN_M1,lastDir1);
-    s1.move((long)dir*STEPS_PER_REV);
-    nextDue1 += intervalFromTPD(TPD_M1);
-    if ((long)(nextDue1-now) > (long)(2*intervalFromTPD(TPD_M1))) nextDue1 = now+intervalFromTPD(TPD_M1);
-  }
-  if (!turboActive && TPD_M2>0 && nextDue2>0 && now>=nextDue2 && s2.distanceToGo()==0){
-    int dir=pickDir(DIRPLAN_M2,lastDir2);
-    s2.move((long)dir*STEPS_PER_REV);
-    nextDue2 += intervalFromTPD(TPD_M2);
-    if ((long)(nextDue2-now) > (long)(2*intervalFromTPD(TPD_M2))) nextDue2 = now+intervalFromTPD(TPD_M2);
-  }
-  delay(2);
+  vTaskDelete(nullptr);   // all work runs in motionTask / webTask
 }
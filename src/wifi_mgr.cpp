@@ -0,0 +1,228 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <ESPmDNS.h>
+#include "config.h"
+#include "fleet_beacon.h"
+#include "wifi_mgr.h"
+#include "trace.h"
+
+static const unsigned long STA_TIMEOUT_MS = 12000;   // give up on a join after this
+static const unsigned long AP_LINGER_MS   = 30000;   // keep setup AP after STA is up
+static const unsigned long AP_RETURN_MS   = 30000;   // STA lost this long -> AP back
+static const unsigned long AP_RETRY_MS    = 1000;    // softAP() failed -> next channel
+static const unsigned long SCAN_PERIOD_MS  = 60000;  // background rescan while setup AP is up, STA down
+static const unsigned long SCAN_RETRY_MS   = 2000;   // driver refused to start a scan
+static const unsigned long SCAN_TIMEOUT_MS = 15000;  // abandon a scan that never reports done
+
+// Event bits set on the Wi-Fi event task, consumed by netPoll() on the web task
+enum : uint32_t { EV_STA_CONN = 1, EV_GOT_IP = 2, EV_STA_DISC = 4, EV_AP_START = 8 };
+static volatile uint32_t evBits = 0;
+static volatile uint8_t  evReason = 0;
+static portMUX_TYPE evMux = portMUX_INITIALIZER_UNLOCKED;
+
+static NetState state = NET_OFF;
+static char staSsid[33] = "", staPass[65] = "";
+static uint8_t attempts = 0;
+static unsigned long attemptStart = 0, apDropAt = 0, staLostAt = 0, apRetryAt = 0;
+static bool apUp = false, mdnsUp = false, sntpUp = false, linked = false;   // linked: joined once with these creds
+static uint8_t apChannelIdx = 0;
+static uint32_t httpReadyMs = 0;
+static uint32_t nodeId = 0;
+static char hostName[FLEET_NAME_MAX] = "winder";
+static WiFiUDP beaconUdp;
+
+// Background scan; filled and read on the web task only
+static ScanCache scanCache;
+static unsigned long scanAt = 0, scanStartAt = 0, scanRetryAt = 0;   // scanAt: last fill, 0 = never
+static bool scanRunning = false, scanWanted = true;                  // first scan as soon as allowed
+
+static void onWiFiEvent(WiFiEvent_t e, WiFiEventInfo_t info){
+  uint32_t b;
+  switch (e){
+    case ARDUINO_EVENT_WIFI_STA_CONNECTED:    b = EV_STA_CONN; break;
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:       b = EV_GOT_IP; break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED: b = EV_STA_DISC; evReason = info.wifi_sta_disconnected.reason; break;
+    case ARDUINO_EVENT_WIFI_AP_START:         b = EV_AP_START; break;
+    default: return;
+  }
+  trace(TR_WIFI_EVENT, (uint8_t)e, b == EV_STA_DISC ? evReason : 0);
+  portENTER_CRITICAL(&evMux); evBits |= b; portEXIT_CRITICAL(&evMux);
+}
+
+static void startSoftAP(){
+  static const int channels[3] = { 1, 6, 11 };
+  const char* pass = strlen(AP_PASS) ? AP_PASS : "winder1234";   // default WPA2 pass
+  IPAddress ip(192,168,4,1), mask(255,255,255,0);
+  WiFi.softAPConfig(ip, ip, mask);
+  int ch = channels[apChannelIdx % 3];
+  if (WiFi.softAP(AP_SSID, pass, ch, /*hidden*/false, /*max_conn*/4)){
+    trace(TR_AP_UP, (uint8_t)ch);
+  } else {
+    trace(TR_AP_FAIL, (uint8_t)ch);
+    apChannelIdx++; apRetryAt = millis() + AP_RETRY_MS;
+  }
+}
+
+static void ensureAP(){
+  if (apUp || apRetryAt) return;
+  WiFi.mode(WIFI_AP_STA);
+  startSoftAP();
+}
+
+static void beginJoin(){
+  attempts++; attemptStart = millis();
+  state = NET_STA_CONNECTING;
+  WiFi.begin(staSsid, staPass);
+  trace(TR_STA_JOIN, attempts);
+}
+
+void netBegin(const char* ssid, const char* pass){
+  strlcpy(staSsid, ssid ? ssid : "", sizeof(staSsid));
+  strlcpy(staPass, pass ? pass : "", sizeof(staPass));
+  uint64_t mac = ESP.getEfuseMac();                  // bytes in transmission order, low byte first
+  nodeId = (uint32_t)((mac >> 24 & 0xFF) << 16 | (mac >> 32 & 0xFF) << 8 | (mac >> 40 & 0xFF));
+  fleetName(nodeId, hostName, sizeof(hostName));
+  WiFi.persistent(false);
+  WiFi.setHostname(hostName);                        // DHCP name too, before the interface comes up
+  WiFi.onEvent(onWiFiEvent);
+  WiFi.mode(WIFI_AP_STA);
+  WiFi.setSleep(WIFI_MODEM_SLEEP);   // WIFI_PS_MIN_MODEM when true
+  WiFi.setTxPower(WIFI_POWER_19_5dBm);
+  startSoftAP();
+  if (staSsid[0]) beginJoin(); else state = NET_AP_ONLY;
+}
+
+// ----- Background scan -----
+static void scanCollect(int n, unsigned long now){
+  scanCache.clear();
+  for (int i = 0; i < n; i++){
+    const wifi_ap_record_t* r = (const wifi_ap_record_t*)WiFi.getScanInfoByIndex(i);
+    if (r) scanCache.add((const char*)r->ssid, r->rssi, r->primary, (uint8_t)r->authmode);
+  }
+  scanCache.finish();
+  scanAt = now ? now : 1;
+}
+
+static void scanPoll(unsigned long now){
+  if (scanRunning){
+    int n = WiFi.scanComplete();
+    if (n == WIFI_SCAN_RUNNING && now - scanStartAt < SCAN_TIMEOUT_MS) return;
+    if (n >= 0) scanCollect(n, now);
+    WiFi.scanDelete();
+    scanRunning = false;
+    return;
+  }
+  // Only rescan on a timer while someone may be picking a network on the setup AP
+  bool due = apUp && state != NET_STA_UP && (!scanAt || now - scanAt >= SCAN_PERIOD_MS);
+  if (!scanWanted && !due) return;
+  if (scanRetryAt && (long)(now - scanRetryAt) < 0) return;
+  if (state == NET_STA_CONNECTING && !linked) return;   // the driver refuses scans mid-join
+  if (WiFi.scanNetworks(/*async*/true, /*hidden*/true) == WIFI_SCAN_FAILED){ scanRetryAt = now + SCAN_RETRY_MS; return; }
+  scanRunning = true; scanWanted = false; scanRetryAt = 0; scanStartAt = now;
+}
+
+void netScanRequest(){ if (!scanRunning) scanWanted = true; }
+bool netScanning(){ return scanRunning || scanWanted; }
+const ScanCache& netScanResults(){ return scanCache; }
+int32_t netScanAgeMs(){ return scanAt ? (int32_t)(millis() - scanAt) : -1; }
+
+void netConnect(const char* ssid, const char* pass){
+  strlcpy(staSsid, ssid, sizeof(staSsid));
+  strlcpy(staPass, pass, sizeof(staPass));
+  attempts = 0; apDropAt = 0; linked = false; staLostAt = 0;
+  ensureAP();                       // the client asking may be on the setup AP
+  WiFi.disconnect(false);
+  beginJoin();
+}
+
+void netPoll(){
+  uint32_t ev;
+  portENTER_CRITICAL(&evMux); ev = evBits; evBits = 0; portEXIT_CRITICAL(&evMux);
+  unsigned long now = millis();
+
+  if (ev & EV_AP_START){
+    apUp = true; apRetryAt = 0;
+    if (!httpReadyMs) httpReadyMs = now;
+  }
+  if (ev & EV_STA_CONN) trace(TR_STA_ASSOC);
+  if (ev & EV_GOT_IP){
+    state = NET_STA_UP; staLostAt = 0; linked = true;
+    if (!httpReadyMs) httpReadyMs = now;
+    trace(TR_STA_IP, attempts, (uint32_t)WiFi.localIP());
+    if (!sntpUp){ configTzTime(TIME_ZONE, NTP_SERVER); sntpUp = true; }   // wall clock for burst windows
+    if (!mdnsUp && MDNS.begin(hostName)){ MDNS.addService("http","tcp",80); mdnsUp = true; trace(TR_MDNS, 0, nodeId); }
+    if (apUp) apDropAt = now + AP_LINGER_MS;
+  }
+  if ((ev & EV_STA_DISC) && state == NET_STA_UP){
+    trace(TR_STA_LOST, evReason);
+    state = NET_STA_CONNECTING; attemptStart = now; staLostAt = now;   // driver auto-reconnects
+  }
+
+  if (apRetryAt && (long)(now - apRetryAt) >= 0){ apRetryAt = 0; startSoftAP(); }
+
+  // Join timed out: stop retrying so the AP channel stays put for setup clients
+  if (state == NET_STA_CONNECTING && !linked && now - attemptStart >= STA_TIMEOUT_MS){
+    trace(TR_STA_FAIL, evReason);
+    WiFi.disconnect(false);
+    state = NET_STA_FAILED;
+  }
+  // Lost an established link for too long: bring the setup AP back (driver keeps rejoining)
+  if (staLostAt && state != NET_STA_UP && now - staLostAt >= AP_RETURN_MS){ staLostAt = 0; ensureAP(); }
+
+  if (apDropAt && state == NET_STA_UP && (long)(now - apDropAt) >= 0){
+    apDropAt = 0; apUp = false;
+    WiFi.softAPdisconnect(true);
+    WiFi.mode(WIFI_STA);
+    trace(TR_AP_DOWN);
+  }
+
+  scanPoll(now);
+}
+
+NetProgress netProgress(){
+  NetProgress p;
+  p.state = state; p.reason = evReason; p.attempts = attempts; p.apUp = apUp;
+  p.elapsedMs = attemptStart ? (uint32_t)(millis() - attemptStart) : 0;
+  return p;
+}
+
+const char* netStateName(NetState s){
+  switch (s){
+    case NET_STA_CONNECTING: return "connecting";
+    case NET_STA_UP:         return "up";
+    case NET_STA_FAILED:     return "failed";
+    case NET_AP_ONLY:        return "ap";
+    default:                 return "off";
+  }
+}
+
+const char* netSsid(){ return staSsid; }
+
+void netIp(char* out, size_t n){
+  IPAddress ip = (state == NET_STA_UP) ? WiFi.localIP() : WiFi.softAPIP();
+  snprintf(out, n, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+}
+
+void netDescribe(char* out, size_t n){
+  char ip[16]; netIp(ip, sizeof(ip));
+  if (state == NET_STA_UP)
+    snprintf(out, n, "WiFi: %s (%s) / mDNS: http://%s.local", staSsid, ip, hostName);
+  else if (state == NET_STA_CONNECTING && !apUp)
+    snprintf(out, n, "WiFi: rejoining %s", staSsid);
+  else if (state == NET_STA_CONNECTING)
+    snprintf(out, n, "AP: %s (%d client(s)) @ %s, joining %s", AP_SSID, WiFi.softAPgetStationNum(), ip, staSsid);
+  else
+    snprintf(out, n, "AP: %s (%d client(s)) @ %s", AP_SSID, WiFi.softAPgetStationNum(), ip);
+}
+
+uint32_t netHttpReadyMs(){ return httpReadyMs; }
+
+const char* netHostname(){ return hostName; }
+uint32_t netNodeId(){ return nodeId; }
+
+bool netBeacon(const uint8_t* p, size_t n){
+  if (state != NET_STA_UP) return false;             // the setup AP has nobody to tell
+  if (!beaconUdp.beginPacket(IPAddress(FLEET_GROUP[0], FLEET_GROUP[1], FLEET_GROUP[2], FLEET_GROUP[3]), FLEET_PORT)) return false;
+  beaconUdp.write(p, n);
+  return beaconUdp.endPacket() == 1;
+}
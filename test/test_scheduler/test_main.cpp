@@ -0,0 +1,96 @@
+// WinderScheduler over weeks of virtual time (sim/replay.h): every switch
+// position delivers its TPD and starts stay on the ideal grid, also after
+// slots were missed.
+//   pio test -e native -f test_scheduler
+#include <stdio.h>
+#include <vector>
+#include <unity.h>
+#include "replay.h"
+
+static const int DAYS = 30;
+
+void setUp(){}
+void tearDown(){}
+
+// Every start of the run, on every motor: at most one turn short of
+// tpd * days (the run ends just before the last one is due), never over,
+// and no start further than one pass from its grid slot.
+static void expectKept(const DayReplay& r, int days){
+  char msg[64];
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++){
+    const DayMotor& d = r.m[m];
+    snprintf(msg, sizeof(msg), "M%u, %d TPD", m + 1, d.tpd);
+    TEST_ASSERT_TRUE_MESSAGE(d.tpd > 0, msg);
+    TEST_ASSERT_TRUE_MESSAGE(d.turns <= (uint64_t)d.tpd * days && d.turns + 1 >= (uint64_t)d.tpd * days, msg);
+    TEST_ASSERT_TRUE_MESSAGE(d.steps == d.turns * STEPS_PER_REV, msg);
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(REPLAY_PASS_MS, d.maxDrift < 0 ? -d.maxDrift : d.maxDrift, msg);
+  }
+}
+
+static void test_tpd_switch_low(){ expectKept(replayDays(DAYS, 0, nullptr), DAYS); }
+static void test_tpd_switch_plan(){ expectKept(replayDays(DAYS, 1, nullptr), DAYS); }
+static void test_tpd_switch_high(){ expectKept(replayDays(DAYS, 2, nullptr), DAYS); }
+
+static void test_tpd_custom_plans(){
+  int tpd[MOTOR_COUNT];
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) tpd[m] = m % 2 ? 960 : 300;
+  expectKept(replayDays(DAYS, 1, tpd), DAYS);
+}
+
+// One a minute: back-to-back rotations with little idle between them
+static void test_tpd_dense_plan(){
+  int tpd[MOTOR_COUNT];
+  for (uint8_t m = 0; m < MOTOR_COUNT; m++) tpd[m] = 1440;
+  expectKept(replayDays(2, 1, tpd), 2);
+}
+
+// A 5 h stop skips slots: the first rotation after the start is late, the
+// ones after it land back on the original grid and every skipped slot is
+// counted as missed
+static void test_missed_slots_keep_grid(){
+  typedef ReplayWinder W;
+  MockClock clk; MockGpio io;
+  MockStepper mot(clk, replaySps(STEP_RPM), 830);
+  W::Scheduler sched(clk, io, mot, SchedulerPins{ MODE_PIN_A, MODE_PIN_B, -1 }, STEPS_PER_REV, MODE_DEBOUNCE_MS);
+  sched.setPlan(0, 650, DIR_ALT);
+  for (uint8_t m = 1; m < MOTOR_COUNT; m++) sched.setPlan(m, 0, DIR_ALT);
+  clk.nowMs = 1000;
+  sched.begin();
+  const uint64_t iv = W::Scheduler::intervalFromTPD(650), grid = 1000 + iv;
+  auto runTo = [&](uint64_t until){
+    while (clk.nowMs < until){
+      sched.poll();
+      uint64_t next = sched.nextEventMs();
+      if (next <= clk.nowMs) next = mot.busyUntil(0) > clk.nowMs ? mot.busyUntil(0) : clk.nowMs + REPLAY_PASS_MS;
+      clk.nowMs = next < until ? next : until;
+    }
+  };
+  runTo(grid + 3 * iv + 10);
+  W::Cmd c{}; c.op = CMD_STOP; sched.apply(c);
+  runTo(clk.nowMs + 5 * 3600000ULL + iv / 3);
+  c.op = CMD_START; sched.apply(c);
+  uint64_t started = clk.nowMs;
+  runTo(started + 4 * iv);
+
+  std::vector<uint64_t> at;
+  for (const MockStepper::MoveLog& l : mot.log) if (l.motor == 0) at.push_back(l.atMs);
+  TEST_ASSERT_TRUE(at.size() >= 8);
+  size_t late = 0;
+  while (late < at.size() && at[late] < started) late++;
+  TEST_ASSERT_EQUAL_UINT32(4, late);                      // before the stop, on the grid
+  TEST_ASSERT_TRUE(at[late] - started <= REPLAY_PASS_MS);  // owed rotation at once
+  for (size_t i = late + 1; i < at.size(); i++) TEST_ASSERT_EQUAL_UINT32(0, (at[i] - grid) % iv);
+  uint64_t skipped = (at[late + 1] - grid) / iv - late - 1;
+  TEST_ASSERT_EQUAL_UINT32(skipped, sched.odometer(0).v[ODO_MISSED]);
+}
+
+int main(int, char**){
+  UNITY_BEGIN();
+  RUN_TEST(test_tpd_switch_low);
+  RUN_TEST(test_tpd_switch_plan);
+  RUN_TEST(test_tpd_switch_high);
+  RUN_TEST(test_tpd_custom_plans);
+  RUN_TEST(test_tpd_dense_plan);
+  RUN_TEST(test_missed_slots_keep_grid);
+  return UNITY_END();
+}
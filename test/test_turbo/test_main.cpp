@@ -0,0 +1,58 @@
+// Turbo sessions on the real step engine (sim/replay.h): a session ends
+// within half a rotation of its deadline (plus one ramp when the power
+// budget holds a start), every motor makes exactly its planned whole
+// rotations, turbo_left_ms agrees with the actual end, and done/planned
+// counts only go up.
+//   pio test -e native -f test_turbo
+#include <stdio.h>
+#include <unity.h>
+#include "replay.h"
+
+void setUp(){}
+void tearDown(){}
+
+static void expectSession(const TurboSession& s, double slackMs, const char* what){
+  TEST_ASSERT_TRUE_MESSAGE((s.errMs < 0 ? -s.errMs : s.errMs) <= s.revMs / 2 + slackMs + 1, what);
+  TEST_ASSERT_TRUE_MESSAGE(s.exact, what);
+  TEST_ASSERT_TRUE_MESSAGE(s.monotonic, what);
+  TEST_ASSERT_TRUE_MESSAGE(s.turns > 0, what);
+}
+
+static void sessions(int rpm, uint8_t profile){
+  const uint32_t mins[] = { 1, 5, 15 };
+  char what[48];
+  for (uint32_t min : mins){
+    snprintf(what, sizeof(what), "%d rpm %s %u min", rpm, rampProfileName(profile), min);
+    TurboSession s = turboSession(rpm, profile, min, false, false, 0);
+    expectSession(s, 0, what);
+    TEST_ASSERT_INT_WITHIN_MESSAGE(2, 0, s.leftErrMs, what);
+  }
+}
+
+static void test_trapezoid(){ sessions(STEP_RPM, RAMP_TRAPEZOID); }
+static void test_scurve(){ sessions(STEP_RPM, RAMP_SCURVE); }
+static void test_slow(){ sessions(10, RAMP_TRAPEZOID); }
+
+static void test_mid_rotation_start(){
+  expectSession(turboSession(STEP_RPM, RAMP_TRAPEZOID, 5, true, false, 0), 0, "pressed mid-rotation");
+}
+
+static void test_replaced_session(){
+  expectSession(turboSession(STEP_RPM, RAMP_TRAPEZOID, 5, false, true, 0), 0, "replaced after 1 min by 2 min");
+}
+
+static void test_budget_held_start(){
+  expectSession(turboSession(STEP_RPM, RAMP_TRAPEZOID, 5, false, false, POWER_BUDGET_MA),
+                replayRampMs(STEP_RPM, RAMP_TRAPEZOID), "starts staggered by the power budget");
+}
+
+int main(int, char**){
+  UNITY_BEGIN();
+  RUN_TEST(test_trapezoid);
+  RUN_TEST(test_scurve);
+  RUN_TEST(test_slow);
+  RUN_TEST(test_mid_rotation_start);
+  RUN_TEST(test_replaced_session);
+  RUN_TEST(test_budget_held_start);
+  return UNITY_END();
+}
@@ -0,0 +1,226 @@
+"""Minify + gzip ui/index.html into include/ui_index.h (PROGMEM byte array).
+
+Runs as a PlatformIO pre-build script (extra_scripts = pre:tools/build_ui.py)
+and can also be run by hand:  python3 tools/build_ui.py
+The header is only rewritten when its content changes, so it doesn't force
+a rebuild of main.cpp on every build.
+
+The minified script is checked before the header is written: it must
+tokenize to exactly the source's tokens, and when node is on PATH it must
+pass `node --check`. Either failure stops the build.
+"""
+import gzip
+import hashlib
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+try:
+    Import("env")  # noqa: F821  (PlatformIO / SCons)
+    ROOT = env["PROJECT_DIR"]  # noqa: F821
+except NameError:
+    ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SRC = os.path.join(ROOT, "ui", "index.html")
+OUT = os.path.join(ROOT, "include", "ui_index.h")
+
+
+def minify_css(css):
+    css = re.sub(r"/\*.*?\*/", "", css, flags=re.S)
+    css = re.sub(r"\s+", " ", css)
+    css = re.sub(r"\s*([{};:,>])\s*", r"\1", css)
+    return css.replace(";}", "}").strip()
+
+
+# ---------- JS ----------
+# A small tokenizer, enough for this page: comments and whitespace go, tokens
+# are copied verbatim. Punctuators are matched longest first, so the output
+# tokenizes back to the same stream.
+PUNCT = sorted(""">>>= ... === !== **= <<= >>= >>> ??= &&= ||= => == != <= >= && || ?? ?. ++ -- += -= *= /= %=
+                 &= |= ^= ** << >>""".split(), key=len, reverse=True)
+WORD = re.compile(r"[A-Za-z_$\u0080-\uffff][\w$\u0080-\uffff]*")
+NUM = re.compile(r"0[xXbBoO][0-9a-fA-F_]+|(?:\d[\d_]*\.?\d*|\.\d+)(?:[eE][+-]?\d+)?")
+# After these words a "/" starts a regex, not a division
+REGEX_AFTER_WORD = {"return", "typeof", "case", "do", "else", "in", "of", "new", "delete", "void", "throw", "instanceof"}
+
+
+def _quoted(js, i):
+    """End of the string literal starting at js[i]; templates include their ${...}."""
+    q, j, n = js[i], i + 1, len(js)
+    while j < n and js[j] != q:
+        if js[j] == "\\":
+            j += 2
+        elif q == "`" and js.startswith("${", j):
+            j, depth = j + 2, 1
+            while j < n and depth:
+                if js[j] in "'\"`":
+                    j = _quoted(js, j)
+                    continue
+                depth += {"{": 1, "}": -1}.get(js[j], 0)
+                j += 1
+        else:
+            j += 1
+    if j >= n:
+        raise ValueError("unterminated %s literal at offset %d" % (q, i))
+    return j + 1
+
+
+def js_tokens(js):
+    """[(kind, text, newline_before)]; kind is str, re, word, num or punct."""
+    out, i, n, nl = [], 0, len(js), False
+    while i < n:
+        c = js[i]
+        if c in " \t\r\n":
+            nl |= c == "\n"
+            i += 1
+            continue
+        if js.startswith("//", i):
+            j = js.find("\n", i)
+            i = n if j < 0 else j
+            continue
+        if js.startswith("/*", i):
+            j = js.index("*/", i + 2) + 2
+            nl |= "\n" in js[i:j]
+            i = j
+            continue
+        prev = out[-1] if out else None
+        if c in "'\"`":
+            kind, j = "str", _quoted(js, i)
+        elif c == "/" and (prev is None or (prev[0] == "punct" and prev[1] not in (")", "]"))
+                           or (prev[0] == "word" and prev[1] in REGEX_AFTER_WORD)):
+            j, cls = i + 1, False
+            while j < n and (cls or js[j] != "/"):
+                if js[j] == "\\":
+                    j += 1
+                elif js[j] == "[":
+                    cls = True
+                elif js[j] == "]":
+                    cls = False
+                elif js[j] == "\n":
+                    raise ValueError("unterminated regex at offset %d" % i)
+                j += 1
+            j += 1
+            while j < n and (js[j].isalnum() or js[j] in "_$"):
+                j += 1
+            kind = "re"
+        elif NUM.match(js, i) and (c.isdigit() or js[i + 1:i + 2].isdigit()):
+            kind, j = "num", NUM.match(js, i).end()
+        elif WORD.match(js, i):
+            kind, j = "word", WORD.match(js, i).end()
+        else:
+            p = next((p for p in PUNCT if js.startswith(p, i)), c)
+            kind, j = "punct", i + len(p)
+        out.append((kind, js[i:j], nl))
+        nl = False
+        i = j
+    return out
+
+
+def _wordy(ch):
+    return ch.isalnum() or ch in "_$" or ord(ch) > 0x7f
+
+
+def minify_js(js):
+    """Drops comments and whitespace. A space stays where two tokens would
+    otherwise merge (`a + +b`, `x - -1`, `return x`, `1 .5`); a line break
+    stays where automatic semicolon insertion could depend on it, unless the
+    line plainly continues (ends in `{ ; , ( [ = : ? & | ! < > * % ^ ~`, or
+    the next line starts with `) ] } , ; . : ?`)."""
+    out, prev = [], None
+    for kind, text, nl in js_tokens(js):
+        if prev:
+            pk, pt = prev
+            merge = ((_wordy(pt[-1]) and _wordy(text[0])) or (pt[-1] in "+-/" and text[0] == pt[-1])
+                     or (pk == "num" and text[0] == "."))
+            keep_nl = nl and not (pk == "punct" and pt[-1] in "{;,([=:?&|!<>*%^~") \
+                and not (kind == "punct" and text[0] in ")]},;.:?")
+            if keep_nl:
+                out.append("\n")
+            elif merge:
+                out.append(" ")
+        out.append(text)
+        prev = (kind, text)
+    return "".join(out)
+
+
+def check_js(src, mini):
+    """None when the minified script is the same program, else what is wrong."""
+    a, b = [t[1] for t in js_tokens(src)], [t[1] for t in js_tokens(mini)]
+    if a != b:
+        i = next((i for i, (x, y) in enumerate(zip(a, b)) if x != y), min(len(a), len(b)))
+        return "minified script differs from the source at token %d: %r -> %r" % (
+            i, " ".join(a[max(0, i - 3):i + 3]), " ".join(b[max(0, i - 3):i + 3]))
+    node = shutil.which("node")
+    if not node:
+        return None
+    with tempfile.NamedTemporaryFile("w", suffix=".js", delete=False) as f:
+        f.write(mini)
+    try:
+        r = subprocess.run([node, "--check", f.name], capture_output=True, text=True)
+    finally:
+        os.unlink(f.name)
+    if r.returncode == 0:
+        return None
+    lines = r.stderr.strip().splitlines()
+    return "node --check: " + next((l for l in lines if "Error" in l), lines[0] if lines else "failed")
+
+
+def scripts(html):
+    return re.findall(r"<script>(.*?)</script>", html, flags=re.S)
+
+
+def minify(html):
+    out = []
+    for part in re.split(r"(<style>.*?</style>|<script>.*?</script>)", html, flags=re.S):
+        if part.startswith("<style>"):
+            out.append("<style>" + minify_css(part[7:-8]) + "</style>")
+        elif part.startswith("<script>"):
+            out.append("<script>" + minify_js(part[8:-9]) + "</script>")
+        else:
+            part = re.sub(r"<!--.*?-->", "", part, flags=re.S)
+            part = re.sub(r">\s+<", "><", part)
+            part = re.sub(r"\s*/>", ">", part)                            # void elements need no "/>"
+            part = re.sub(r'=\"([A-Za-z0-9_.:#-]+)\"', r"=\1", part)   # unquote simple attribute values
+            part = re.sub(r"\s+", " ", part).strip()
+            out.append(re.sub(r"\s*(style=\"[^\"]*\")", lambda m: " " + re.sub(r"\s*([;:,])\s*", r"\1", m.group(1)), part))
+    return "".join(out)
+
+
+def build():
+    raw = open(SRC, "rb").read()
+    html = raw.decode("utf-8")
+    mini = minify(html).encode("utf-8")
+    for src, out in zip(scripts(html), scripts(mini.decode("utf-8"))):
+        err = check_js(src, out)
+        if err:
+            sys.stderr.write("UI: %s\n" % err)
+            sys.exit(1)
+    gz = gzip.compress(mini, compresslevel=9, mtime=0)
+    etag = hashlib.sha256(gz).hexdigest()[:16]
+
+    rows = []
+    for i in range(0, len(gz), 20):
+        rows.append("  " + ",".join("0x%02x" % b for b in gz[i:i + 20]) + ",")
+    text = (
+        "// Generated by tools/build_ui.py from ui/index.html -- do not edit.\n"
+        "#pragma once\n"
+        "#include <stddef.h>\n"
+        "#include <stdint.h>\n\n"
+        "inline constexpr char    UI_INDEX_ETAG[]  = \"\\\"%s\\\"\";\n"
+        "constexpr size_t         UI_INDEX_RAW_LEN = %d;   // source bytes\n"
+        "constexpr size_t         UI_INDEX_MIN_LEN = %d;   // minified\n"
+        "constexpr size_t         UI_INDEX_GZ_LEN  = %d;   // on the wire\n"
+        "inline constexpr uint8_t UI_INDEX_GZ[] PROGMEM = {\n%s\n};\n"
+    ) % (etag, len(raw), len(mini), len(gz), "\n".join(rows))
+
+    if not os.path.exists(OUT) or open(OUT).read() != text:
+        with open(OUT, "w") as f:
+            f.write(text)
+    print("UI: %d B raw -> %d B minified -> %d B gzip (-%.0f%%), etag %s"
+          % (len(raw), len(mini), len(gz), 100.0 * (1 - len(gz) / len(raw)), etag))
+
+
+build()
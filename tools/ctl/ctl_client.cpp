@@ -0,0 +1,168 @@
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "ctl_client.h"
+#include "ws_frame.h"
+
+static uint64_t nowMs(){
+  timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static bool resolve(const char* host, uint16_t port, sockaddr_in& a){
+  a = sockaddr_in{}; a.sin_family = AF_INET; a.sin_port = htons(port);
+  if (inet_pton(AF_INET, host, &a.sin_addr) == 1) return true;
+  addrinfo hints{}, *res = nullptr;
+  hints.ai_family = AF_INET;
+  if (getaddrinfo(host, nullptr, &hints, &res) || !res) return false;
+  a.sin_addr = ((sockaddr_in*)res->ai_addr)->sin_addr;
+  freeaddrinfo(res);
+  return true;
+}
+
+bool CtlClient::udp(const char* host, uint16_t port){
+  close();
+  sockaddr_in a;
+  if (!resolve(host, port, a)) return false;
+  fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd_ < 0) return false;
+  if (connect(fd_, (sockaddr*)&a, sizeof(a)) < 0){ close(); return false; }   // replies from elsewhere are filtered out
+  ws_ = false;
+  return true;
+}
+
+bool CtlClient::ws(const char* host, uint16_t port, const char* path){
+  close();
+  sockaddr_in a;
+  if (!resolve(host, port, a)) return false;
+  fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd_ < 0) return false;
+  if (connect(fd_, (sockaddr*)&a, sizeof(a)) < 0){ close(); return false; }
+  int on = 1; setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  // The key only has to be unique per connection; base64 of 16 random-ish bytes
+  char key[25];
+  static const char B64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  uint32_t r = (uint32_t)nowMs() * 2654435761u ^ (uint32_t)getpid();
+  for (int i = 0; i < 21; i++){ r ^= r << 13; r ^= r >> 17; r ^= r << 5; key[i] = B64[r & 63]; }
+  key[21] = B64[(r >> 8) & 48]; key[22] = '='; key[23] = '='; key[24] = 0;
+  char req[256];
+  int n = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                   "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n", path, host, key);
+  if (send(fd_, req, (size_t)n, MSG_NOSIGNAL) != n){ close(); return false; }
+  char resp[512]; size_t got = 0;
+  uint64_t end = nowMs() + 2000;
+  while (got < sizeof(resp) - 1){
+    pollfd p{ fd_, POLLIN, 0 };
+    int left = (int)(int64_t)(end - nowMs());
+    if (left <= 0 || poll(&p, 1, left) <= 0){ close(); return false; }
+    ssize_t k = recv(fd_, resp + got, 1, 0);       // byte by byte: frames may follow the header
+    if (k <= 0){ close(); return false; }
+    got += (size_t)k; resp[got] = 0;
+    if (got >= 4 && !memcmp(resp + got - 4, "\r\n\r\n", 4)) break;
+  }
+  char accept[WS_ACCEPT_LEN + 1];
+  wsAccept(key, accept);
+  if (strncmp(resp, "HTTP/1.1 101", 12) || !strstr(resp, accept)){ close(); return false; }
+  ws_ = true; have_ = 0;
+  return true;
+}
+
+void CtlClient::close(){ if (fd_ >= 0) ::close(fd_); fd_ = -1; have_ = 0; }
+
+bool CtlClient::sendFrame(const uint8_t* p, size_t n){
+  if (!ws_){
+    sentBytes += n;
+    return send(fd_, p, n, 0) == (ssize_t)n;
+  }
+  uint8_t buf[WS_HEAD_MAX + CTL_FRAME_MAX], mask[4];
+  uint32_t r = (uint32_t)(nowMs() * 2654435761u) ^ seq;
+  memcpy(mask, &r, 4);
+  size_t h = wsHead(buf, WS_BINARY, n, mask);
+  memcpy(buf + h, p, n); wsMask(buf + h, n, mask);
+  sentBytes += h + n;
+  return send(fd_, buf, h + n, MSG_NOSIGNAL) == (ssize_t)(h + n);
+}
+
+int CtlClient::recvFrame(uint8_t* p, size_t cap, int waitMs){
+  uint64_t end = nowMs() + (uint64_t)waitMs;
+  for (;;){
+    if (ws_ && have_){
+      WsFrame f;
+      int h = wsParse(in_, have_, f);
+      if (h < 0) return -1;
+      if (h > 0 && have_ >= f.head + f.len){
+        size_t n = f.len;
+        uint8_t* body = in_ + f.head;
+        if (f.masked) wsMask(body, n, f.mask);
+        int out = 0;
+        if (f.op == WS_CLOSE) return -1;
+        if (f.op == WS_BINARY && n <= cap){ memcpy(p, body, n); out = (int)n; recvBytes += f.head + n; }
+        memmove(in_, in_ + f.head + n, have_ - f.head - n); have_ -= f.head + n;
+        if (out) return out;
+        continue;                                     // pings, text: not ours
+      }
+      if (have_ == sizeof(in_)) return -1;            // bigger than any reply
+    }
+    int left = (int)(int64_t)(end - nowMs());
+    if (left <= 0) return 0;
+    pollfd q{ fd_, POLLIN, 0 };
+    if (poll(&q, 1, left) <= 0) return 0;
+    if (!ws_){
+      ssize_t k = recv(fd_, p, cap, 0);
+      if (k < 0 && errno == ECONNREFUSED) continue;   // ICMP from an earlier send
+      if (k <= 0) return k < 0 ? 0 : -1;
+      recvBytes += (size_t)k;
+      return (int)k;
+    }
+    ssize_t k = recv(fd_, in_ + have_, sizeof(in_) - have_, 0);
+    if (k <= 0) return -1;
+    have_ += (size_t)k;
+  }
+}
+
+int CtlClient::request(uint8_t op, uint16_t mask, const uint8_t* payload, uint8_t len, uint8_t* reply, size_t* replyLen){
+  if (fd_ < 0) return CTL_NO_ANSWER;
+  uint8_t out[CTL_FRAME_MAX], in[CTL_FRAME_MAX];
+  uint16_t s = seq++;
+  size_t n = ctlEncode(op, s, mask, payload, len, out, sizeof(out));
+  if (!n) return CTL_NO_ANSWER;
+  for (uint8_t t = 0; t < (ws_ ? 1 : tries); t++){
+    if (t) resends++;
+    if (!sendFrame(out, n)) return CTL_NO_ANSWER;
+    uint64_t end = nowMs() + (ws_ ? (uint64_t)timeoutMs * tries : timeoutMs);
+    for (;;){
+      int left = (int)(int64_t)(end - nowMs());
+      if (left <= 0) break;
+      int k = recvFrame(in, sizeof(in), left);
+      if (k < 0) return CTL_NO_ANSWER;
+      if (k == 0) break;
+      CtlFrame f;
+      if (!ctlDecode(in, (size_t)k, f) || f.seq != s || f.op != (op | CTL_REPLY) || !f.len) continue;   // a late answer to an older try
+      if (reply){ memcpy(reply, f.payload, f.len); *replyLen = f.len; }
+      return f.payload[0];
+    }
+  }
+  return CTL_NO_ANSWER;
+}
+
+int CtlClient::status(CtlStatus& st){
+  uint8_t p[CTL_FRAME_MAX]; size_t n = 0;
+  int r = request(CTL_STATUS, 0, nullptr, 0, p, &n);
+  if (r != CTL_OK) return r;
+  return ctlStatusGet(p + 1, n - 1, st) ? CTL_OK : CTL_BAD;
+}
+
+int CtlClient::config(const CtlConfig& c, uint16_t mask){
+  uint8_t p[CTL_CONFIG_FIXED + 3 * CTL_MAX_MOTORS];
+  size_t n = ctlConfigPut(c, mask, p, sizeof(p));
+  return n ? request(CTL_CONFIG, mask, p, (uint8_t)n) : CTL_BAD;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "ctl_frame.h"
+
+/********** Control client (host side, POSIX) **********
+  Reference client for the binary control protocol (ctl_frame.h), over UDP
+  (CTL_PORT) or a WebSocket kept open on GET /ctl. Each call sends one frame
+  and waits for the reply with the same seq. Over UDP a frame with no reply
+  within timeoutMs is sent again unchanged, up to `tries` times; the node
+  answers a repeat of a command it already took without applying it again,
+  so a lost reply never doubles a command. Blocking; one call at a time.   */
+
+static const int CTL_NO_ANSWER = -1;
+
+class CtlClient {
+public:
+  ~CtlClient(){ close(); }
+  bool udp(const char* host, uint16_t port = CTL_PORT);
+  bool ws(const char* host, uint16_t port = 80, const char* path = "/ctl");
+  void close();
+
+  // CtlResult, or CTL_NO_ANSWER
+  int status(CtlStatus& s);
+  int start(){ return request(CTL_START, 0, nullptr, 0); }
+  int stop(){ return request(CTL_STOP, 0, nullptr, 0); }
+  int config(const CtlConfig& c, uint16_t mask);
+  int turbo(uint16_t mask, uint8_t minutes){ return request(CTL_TURBO, mask, &minutes, 1); }
+  // Any request; the reply's payload (result byte first) is copied to reply
+  int request(uint8_t op, uint16_t mask, const uint8_t* payload, uint8_t len,
+              uint8_t* reply = nullptr, size_t* replyLen = nullptr);
+
+  uint32_t timeoutMs = 250;
+  uint8_t  tries = 4;
+  uint16_t seq = 1;
+  uint64_t sentBytes = 0, recvBytes = 0;   // frames as sent (WebSocket framing included)
+  uint32_t resends = 0;
+
+private:
+  bool sendFrame(const uint8_t* p, size_t n);
+  int  recvFrame(uint8_t* p, size_t cap, int waitMs);    // frame length, 0 on timeout, -1 closed
+
+  int  fd_ = -1;
+  bool ws_ = false;
+  uint8_t in_[CTL_FRAME_MAX + 8];
+  size_t  have_ = 0;
+};
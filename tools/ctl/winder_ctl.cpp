@@ -0,0 +1,64 @@
+// Binary control client for one winder (ctl_frame.h), over UDP or a WebSocket.
+//   winder_ctl <udp|ws> <host> status
+//   winder_ctl <udp|ws> <host> start | stop
+//   winder_ctl <udp|ws> <host> turbo <min> [mask]      mask: bit per motor, default all
+//   winder_ctl <udp|ws> <host> config <tpd>[:<dir>] …  one per motor from motor 1; dir -1, 0 (alt), 1
+// Build: pio run -e ctl  (binary: .pio/build/ctl/program)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ctl_client.h"
+
+static const char* const RESULTS[] = { "ok", "busy", "bad request", "version mismatch" };
+
+static int report(const char* what, int r, const CtlClient& c){
+  if (r == CTL_NO_ANSWER) printf("%s: no answer\n", what);
+  else printf("%s: %s\n", what, r < 4 ? RESULTS[r] : "?");
+  if (c.resends) printf("  %u resend(s)\n", c.resends);
+  return r == CTL_OK ? 0 : 1;
+}
+
+int main(int argc, char** argv){
+  if (argc < 4 || (strcmp(argv[1], "udp") && strcmp(argv[1], "ws"))){
+    printf("usage: %s <udp|ws> <host> status | start | stop | turbo <min> [mask] | config <tpd>[:<dir>] ...\n", argv[0]);
+    return 2;
+  }
+  CtlClient c;
+  bool ok = strcmp(argv[1], "ws") ? c.udp(argv[2]) : c.ws(argv[2]);
+  if (!ok) return perror(argv[2]), 1;
+  const char* cmd = argv[3];
+  if (!strcmp(cmd, "status")){
+    CtlStatus s;
+    int r = c.status(s);
+    if (r != CTL_OK) return report("status", r, c);
+    printf("%s%s%s switch %u, profile %u, turbo left %u s\n", s.flags & CTL_F_ENABLED ? "on" : "off",
+           s.flags & CTL_F_TURBO ? " turbo" : "", s.flags & CTL_F_CLOCK_SET ? " clock" : "", s.switchMode, s.profile, s.turboLeftS);
+    for (uint8_t m = 0; m < s.motors; m++){
+      const CtlMotor& e = s.m[m];
+      printf("  M%u: tpd %d dir %d%s turns %u next ", m + 1, e.tpd, e.dir, e.turbo ? " turbo" : "", e.turns);
+      if (e.nextS == 0xFFFF) printf("-\n"); else printf("%u s\n", e.nextS);
+    }
+    return 0;
+  }
+  if (!strcmp(cmd, "start")) return report(cmd, c.start(), c);
+  if (!strcmp(cmd, "stop")) return report(cmd, c.stop(), c);
+  if (!strcmp(cmd, "turbo") && argc > 4){
+    uint16_t mask = argc > 5 ? (uint16_t)strtoul(argv[5], nullptr, 0) : 0xFFFF;
+    if (mask == 0xFFFF){ CtlStatus s; if (c.status(s) != CTL_OK) return report("status", CTL_NO_ANSWER, c); mask = (uint16_t)((1u << s.motors) - 1); }
+    return report(cmd, c.turbo(mask, (uint8_t)atoi(argv[4])), c);
+  }
+  if (!strcmp(cmd, "config") && argc > 4){
+    CtlConfig cfg{};
+    uint16_t mask = 0;
+    for (int i = 4; i < argc && i - 4 < CTL_MAX_MOTORS; i++){
+      uint8_t m = (uint8_t)(i - 4);
+      char* end;
+      cfg.tpd[m] = (int16_t)strtol(argv[i], &end, 10);
+      cfg.dir[m] = *end == ':' ? (int8_t)atoi(end + 1) : 0;
+      mask |= (uint16_t)(1u << m);
+    }
+    return report(cmd, c.config(cfg, mask), c);
+  }
+  printf("unknown command %s\n", cmd);
+  return 2;
+}
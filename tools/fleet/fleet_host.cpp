@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "json_out.h"
+#include "fleet_host.h"
+
+static const char* const FLEET_CMDS[] = { "config", "start", "stop", "turbo" };
+
+uint64_t fleetNowUs(){
+  timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+uint64_t fleetNowMs(){ return fleetNowUs() / 1000; }
+
+void fleetIpStr(uint32_t ip, char* out, size_t n){
+  const uint8_t* b = (const uint8_t*)&ip;
+  snprintf(out, n, "%u.%u.%u.%u", b[0], b[1], b[2], b[3]);
+}
+
+static void nonBlocking(int fd){ fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK); }
+
+// Header end and Content-Length of an HTTP message in `s`; false until the header is complete
+static bool httpHead(const std::string& s, size_t& bodyAt, long& length){
+  size_t e = s.find("\r\n\r\n");
+  if (e == std::string::npos) return false;
+  bodyAt = e + 4; length = -1;
+  for (size_t p = s.find("\r\n"); p < e; p = s.find("\r\n", p + 2)){
+    if (!strncasecmp(s.c_str() + p + 2, "content-length:", 15)){ length = atol(s.c_str() + p + 17); break; }
+  }
+  return true;
+}
+
+// ===================== Fan-out =====================
+enum ConnState : uint8_t { C_CONNECTING, C_SENDING, C_READING, C_DONE };
+struct Conn { int fd = -1; ConnState st = C_DONE; std::string out, in; size_t sent = 0; };
+
+static void finish(Conn& c, FanResult& r, int status, uint64_t t0){
+  if (c.fd >= 0){ ::close(c.fd); c.fd = -1; }
+  c.st = C_DONE; r.status = status; r.us = (uint32_t)(fleetNowUs() - t0);
+}
+
+// Response complete (or the peer closed): status line and, if asked for, the body
+static void parse(Conn& c, FanResult& r, uint64_t t0){
+  int status = -1;
+  if (c.in.compare(0, 5, "HTTP/") == 0){ size_t sp = c.in.find(' '); if (sp != std::string::npos) status = atoi(c.in.c_str() + sp + 1); }
+  if (r.resp && r.respCap){
+    size_t at = 0; long len = 0;
+    size_t n = httpHead(c.in, at, len) ? c.in.size() - at : 0;
+    if (n >= r.respCap) n = r.respCap - 1;
+    memcpy(r.resp, c.in.data() + at, n); r.resp[n] = 0;
+  }
+  finish(c, r, status, t0);
+}
+
+FanStats fleetFanOut(const FanTarget* targets, size_t n, const char* method, const char* path,
+                     const char* body, FanResult* results, uint32_t timeoutMs){
+  FanStats s{};
+  s.nodes = (uint16_t)n;
+  std::vector<Conn> conns(n);
+  std::vector<pollfd> pfd(n);
+  size_t blen = body ? strlen(body) : 0;
+  uint64_t t0 = fleetNowUs(), deadline = t0 + (uint64_t)timeoutMs * 1000;
+  size_t open = 0;
+  for (size_t i = 0; i < n; i++){
+    FanResult& r = results[i];
+    r.node = targets[i].node; r.status = -1; r.us = 0;
+    Conn& c = conns[i];
+    char ip[16]; fleetIpStr(targets[i].ip, ip, sizeof(ip));
+    char head[256];
+    snprintf(head, sizeof(head), "%s %s HTTP/1.1\r\nHost: %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+             method, path, ip, blen);
+    c.out = head; if (blen) c.out.append(body, blen);
+    c.fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (c.fd < 0){ finish(c, r, -1, t0); continue; }
+    nonBlocking(c.fd);
+    sockaddr_in a{}; a.sin_family = AF_INET; a.sin_port = htons(targets[i].port); a.sin_addr.s_addr = targets[i].ip;
+    if (connect(c.fd, (sockaddr*)&a, sizeof(a)) < 0 && errno != EINPROGRESS){ finish(c, r, -1, t0); continue; }
+    c.st = C_CONNECTING; open++;
+  }
+  char buf[4096];
+  while (open){
+    uint64_t now = fleetNowUs();
+    if (now >= deadline) break;
+    for (size_t i = 0; i < n; i++){
+      pfd[i].fd = conns[i].st == C_DONE ? -1 : conns[i].fd;
+      pfd[i].events = conns[i].st == C_READING ? POLLIN : POLLOUT;
+      pfd[i].revents = 0;
+    }
+    int k = ::poll(pfd.data(), n, (int)((deadline - now + 999) / 1000));
+    if (k < 0 && errno != EINTR) break;
+    for (size_t i = 0; i < n && k > 0; i++){
+      Conn& c = conns[i];
+      if (!pfd[i].revents || c.st == C_DONE) continue;
+      if (c.st == C_CONNECTING){
+        int err = 0; socklen_t l = sizeof(err);
+        getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &l);
+        if (err){ finish(c, results[i], -1, t0); open--; continue; }
+        c.st = C_SENDING;
+      }
+      if (c.st == C_SENDING){
+        ssize_t w = send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+        if (w < 0 && errno != EAGAIN){ finish(c, results[i], -1, t0); open--; continue; }
+        if (w > 0) c.sent += (size_t)w;
+        if (c.sent == c.out.size()) c.st = C_READING;
+        continue;
+      }
+      ssize_t got = recv(c.fd, buf, sizeof(buf), 0);
+      if (got < 0 && errno == EAGAIN) continue;
+      if (got > 0) c.in.append(buf, (size_t)got);
+      size_t at; long len;
+      bool whole = httpHead(c.in, at, len) && len >= 0 && c.in.size() >= at + (size_t)len;
+      if (got <= 0 || whole){ parse(c, results[i], t0); open--; }
+    }
+  }
+  for (size_t i = 0; i < n; i++) if (conns[i].st != C_DONE) finish(conns[i], results[i], -2, t0);
+
+  std::vector<uint32_t> lat;
+  for (size_t i = 0; i < n; i++) if (results[i].status >= 200 && results[i].status < 300) lat.push_back(results[i].us);
+  s.totalUs = (uint32_t)(fleetNowUs() - t0);
+  s.ok = (uint16_t)lat.size();
+  if (!lat.empty()){
+    std::sort(lat.begin(), lat.end());
+    s.p50Us = lat[(lat.size() - 1) * 50 / 100]; s.p99Us = lat[(lat.size() - 1) * 99 / 100]; s.maxUs = lat.back();
+  }
+  return s;
+}
+
+// ===================== FleetHost =====================
+bool FleetHost::listen(uint16_t port, bool joinGroup){
+  beaconFd_ = socket(AF_INET, SOCK_DGRAM, 0);
+  if (beaconFd_ < 0) return false;
+  int on = 1; setsockopt(beaconFd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in a{}; a.sin_family = AF_INET; a.sin_port = htons(port); a.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(beaconFd_, (sockaddr*)&a, sizeof(a)) < 0){ ::close(beaconFd_); beaconFd_ = -1; return false; }
+  socklen_t l = sizeof(a); getsockname(beaconFd_, (sockaddr*)&a, &l); beaconPort_ = ntohs(a.sin_port);
+  if (joinGroup){
+    ip_mreq mr{}; memcpy(&mr.imr_multiaddr.s_addr, FLEET_GROUP, 4); mr.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (setsockopt(beaconFd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mr, sizeof(mr)) < 0)
+      fprintf(stderr, "fleet: multicast join failed (%s), unicast beacons only\n", strerror(errno));
+  }
+  nonBlocking(beaconFd_);
+  return true;
+}
+
+bool FleetHost::serve(uint16_t port){
+  httpFd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (httpFd_ < 0) return false;
+  int on = 1; setsockopt(httpFd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in a{}; a.sin_family = AF_INET; a.sin_port = htons(port); a.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(httpFd_, (sockaddr*)&a, sizeof(a)) < 0 || ::listen(httpFd_, 16) < 0){ ::close(httpFd_); httpFd_ = -1; return false; }
+  socklen_t l = sizeof(a); getsockname(httpFd_, (sockaddr*)&a, &l); httpPort_ = ntohs(a.sin_port);
+  nonBlocking(httpFd_);
+  return true;
+}
+
+void FleetHost::close(){
+  if (beaconFd_ >= 0) ::close(beaconFd_);
+  if (httpFd_ >= 0) ::close(httpFd_);
+  beaconFd_ = httpFd_ = -1;
+}
+
+int FleetHost::drain(){
+  int taken = 0;
+  uint8_t pkt[FLEET_BEACON_MAX + 1];
+  for (;;){
+    sockaddr_in from{}; socklen_t l = sizeof(from);
+    ssize_t n = recvfrom(beaconFd_, pkt, sizeof(pkt), 0, (sockaddr*)&from, &l);
+    if (n < 0) break;
+    FleetBeacon b;
+    if (!fleetDecode(pkt, (size_t)n, b)){ bad_++; continue; }
+    if (table_.update(b, from.sin_addr.s_addr, fleetNowMs()) >= 0) taken++;
+  }
+  return taken;
+}
+
+int FleetHost::poll(int timeoutMs){
+  pollfd p[2] = { { beaconFd_, POLLIN, 0 }, { httpFd_, POLLIN, 0 } };
+  ::poll(p, 2, timeoutMs);
+  int taken = beaconFd_ >= 0 ? drain() : 0;
+  if (httpFd_ >= 0 && (p[1].revents & POLLIN)){
+    int fd = accept(httpFd_, nullptr, nullptr);
+    if (fd >= 0){ answer(fd); ::close(fd); }
+  }
+  table_.expire(fleetNowMs(), FLEET_STALE_MS);
+  return taken;
+}
+
+size_t FleetHost::targets(FanTarget* out, size_t cap) const {
+  size_t n = 0;
+  for (uint16_t i = 0; i < table_.size() && n < cap; i++)
+    out[n++] = FanTarget{ table_[i].ip, table_[i].b.httpPort, table_[i].b.node };
+  return n;
+}
+
+FanStats FleetHost::command(const char* cmd, const char* body, char* out, size_t cap){
+  static FanTarget t[FLEET_HOST_NODES];
+  static FanResult r[FLEET_HOST_NODES];
+  size_t n = targets(t, FLEET_HOST_NODES);
+  char path[16]; snprintf(path, sizeof(path), "/%s", cmd);
+  FanStats s = fleetFanOut(t, n, "POST", path, body, r);
+  JsonOut j(out, cap);
+  j.begin().str("cmd", cmd).unum("nodes", s.nodes).unum("ok", s.ok).unum("total_us", s.totalUs)
+   .unum("p50_us", s.p50Us).unum("p99_us", s.p99Us).unum("max_us", s.maxUs).key("results").raw("[");
+  for (size_t i = 0; i < n; i++){
+    char name[FLEET_NAME_MAX], ip[16];
+    fleetName(r[i].node, name, sizeof(name)); fleetIpStr(t[i].ip, ip, sizeof(ip));
+    if (i) j.raw(",");
+    j.begin().str("node", name).str("ip", ip).num("status", r[i].status).unum("us", r[i].us).end();
+  }
+  j.raw("]").end();
+  return s;
+}
+
+size_t FleetHost::tableJson(char* out, size_t cap) const {
+  uint64_t now = fleetNowMs();
+  JsonOut j(out, cap);
+  j.begin().unum("nodes", table_.size()).key("fleet").raw("[");
+  for (uint16_t i = 0; i < table_.size(); i++){
+    const FleetNode& e = table_[i];
+    const FleetBeacon& b = e.b;
+    char name[FLEET_NAME_MAX], ip[16];
+    fleetName(b.node, name, sizeof(name)); fleetIpStr(e.ip, ip, sizeof(ip));
+    if (i) j.raw(",");
+    j.begin().str("node", name).str("ip", ip).unum("port", b.httpPort).unum("age_ms", (unsigned long)(now - e.seenMs))
+     .unum("uptime_s", b.uptimeS).boolean("enabled", b.flags & FLEET_ENABLED).boolean("turbo", b.flags & FLEET_TURBO)
+     .boolean("clock_set", b.flags & FLEET_CLOCK_SET).unum("switch", b.switchMode).unum("turbo_left_s", b.turboLeftS);
+    j.key("tpd").raw("[");
+    for (uint8_t m = 0; m < b.motors; m++) j.fmt(m ? ",%d" : "%d", b.m[m].tpd);
+    j.raw("]").key("dir").raw("[");
+    for (uint8_t m = 0; m < b.motors; m++) j.fmt(m ? ",%d" : "%d", b.m[m].dir);
+    j.raw("]").key("next_s").raw("[");
+    for (uint8_t m = 0; m < b.motors; m++) j.fmt(m ? ",%ld" : "%ld", b.m[m].nextS == 0xFFFF ? -1L : (long)b.m[m].nextS);
+    j.raw("]").end();
+  }
+  j.raw("]").end();
+  return j.ok() ? j.length() : 0;
+}
+
+// One request, answered and closed. The fan-out it may trigger is bounded by
+// FLEET_HTTP_TIMEOUT_MS, so beacons queue in the socket meanwhile.
+void FleetHost::answer(int fd){
+  static char resp[1 << 18];
+  timeval tv{ 2, 0 }; setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  std::string req;
+  char buf[2048];
+  size_t at = 0; long len = -1;
+  for (;;){
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0) break;
+    req.append(buf, (size_t)n);
+    if (httpHead(req, at, len) && req.size() >= at + (size_t)(len < 0 ? 0 : len)) break;
+    if (req.size() > 65536) return;
+  }
+  if (!at) return;
+  std::string body = req.substr(at, len < 0 ? 0 : (size_t)len);
+  char method[8] = "", path[64] = "";
+  sscanf(req.c_str(), "%7s %63s", method, path);
+  int status = 404;
+  strcpy(resp, "{\"ok\":false,\"err\":\"not found\"}");
+  if (!strcmp(method, "GET") && !strcmp(path, "/fleet")){
+    status = tableJson(resp, sizeof(resp)) ? 200 : 500;
+  } else if (!strcmp(method, "POST") && !strncmp(path, "/fleet/", 7)){
+    for (const char* c : FLEET_CMDS){
+      if (strcmp(path + 7, c)) continue;
+      command(c, body.c_str(), resp, sizeof(resp));
+      status = 200;
+    }
+  }
+  char head[160];
+  int h = snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                   status, status == 200 ? "OK" : status == 404 ? "Not Found" : "Error", strlen(resp));
+  send(fd, head, (size_t)h, MSG_NOSIGNAL);
+  send(fd, resp, strlen(resp), MSG_NOSIGNAL);
+}
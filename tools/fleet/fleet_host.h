@@ -0,0 +1,70 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "fleet_beacon.h"
+#include "fleet_table.h"
+
+/********** Fleet aggregator (host side, POSIX) **********
+  Keeps a live table of every winder from their UDP beacons and fans one
+  command out to all of them at once: every node gets its own non-blocking
+  connection, all driven by one poll() loop, so a rack answers in about the
+  time of its slowest node rather than the sum of all of them. serve() puts
+  the same thing behind HTTP:
+    GET  /fleet                             live table
+    POST /fleet/{config,start,stop,turbo}   body goes to every node's /<cmd>
+  Single-threaded: call poll() from one loop.                                 */
+
+static const uint16_t FLEET_HOST_NODES = 256;
+static const uint32_t FLEET_STALE_MS   = 16000;   // three beacons missed
+static const uint32_t FLEET_HTTP_TIMEOUT_MS = 3000;
+
+typedef FleetTable<FLEET_HOST_NODES> HostFleet;
+
+struct FanTarget { uint32_t ip; uint16_t port; uint32_t node; };   // ip in network byte order
+struct FanResult {
+  uint32_t node;
+  int      status;       // HTTP status, or -1 connect/send failed, -2 timed out
+  uint32_t us;           // from the start of the fan-out to the complete answer
+  char*    resp;         // optional: response body is copied here (NUL-terminated)
+  size_t   respCap;
+};
+struct FanStats { uint16_t nodes, ok; uint32_t totalUs, p50Us, p99Us, maxUs; };
+
+uint64_t fleetNowMs();                                  // monotonic
+uint64_t fleetNowUs();
+void     fleetIpStr(uint32_t ip, char* out, size_t n);
+
+// One request to every target concurrently; results[i] belongs to targets[i]
+FanStats fleetFanOut(const FanTarget* targets, size_t n, const char* method, const char* path,
+                     const char* body, FanResult* results, uint32_t timeoutMs = FLEET_HTTP_TIMEOUT_MS);
+
+class FleetHost {
+public:
+  ~FleetHost(){ close(); }
+  // Beacons on `port` (0: any free port); joins the multicast group when asked
+  // (a failed join still leaves unicast and loopback beacons working)
+  bool listen(uint16_t port = FLEET_PORT, bool joinGroup = true);
+  bool serve(uint16_t port);                            // aggregator HTTP (0: any free port)
+  uint16_t beaconPort() const { return beaconPort_; }
+  uint16_t httpPort() const { return httpPort_; }
+  // Waits up to timeoutMs for traffic, drains beacons, answers one HTTP
+  // request if one is waiting, drops stale nodes. Returns beacons taken.
+  int poll(int timeoutMs);
+  void close();
+
+  const HostFleet& table() const { return table_; }
+  size_t targets(FanTarget* out, size_t cap) const;
+  // Fan `body` out to /<cmd> of every node in the table; JSON report into out
+  FanStats command(const char* cmd, const char* body, char* out, size_t cap);
+  size_t tableJson(char* out, size_t cap) const;
+  uint32_t badBeacons() const { return bad_; }
+
+private:
+  int drain();
+  void answer(int fd);
+
+  HostFleet table_;
+  int beaconFd_ = -1, httpFd_ = -1;
+  uint16_t beaconPort_ = 0, httpPort_ = 0;
+  uint32_t bad_ = 0;
+};
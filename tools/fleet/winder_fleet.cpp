@@ -0,0 +1,61 @@
+// Fleet aggregator for a rack of winders.
+//   winder_fleet watch                     live table from the nodes' beacons
+//   winder_fleet send <cmd> [json] [wait]  collect beacons for `wait` s (default 6), then
+//                                          POST json to /<cmd> (config|start|stop|turbo) on every node
+//   winder_fleet serve [port]              GET /fleet, POST /fleet/<cmd> on port (default 8077)
+// Build: pio run -e fleet  (binary: .pio/build/fleet/program)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fleet_host.h"
+
+static FleetHost host;
+static char out[1 << 18];
+
+static void printTable(){
+  const HostFleet& t = host.table();
+  uint64_t now = fleetNowMs();
+  printf("%u node(s)\n", t.size());
+  for (uint16_t i = 0; i < t.size(); i++){
+    const FleetNode& e = t[i];
+    char name[FLEET_NAME_MAX], ip[16];
+    fleetName(e.b.node, name, sizeof(name)); fleetIpStr(e.ip, ip, sizeof(ip));
+    printf("  %-14s %-15s %5.1fs ago  %s%s switch %u  tpd", name, ip, (now - e.seenMs) / 1000.0,
+           e.b.flags & FLEET_ENABLED ? "on " : "off", e.b.flags & FLEET_TURBO ? " turbo" : "", e.b.switchMode);
+    for (uint8_t m = 0; m < e.b.motors; m++) printf(" %d%s", e.b.m[m].tpd, e.b.m[m].dir < 0 ? "ccw" : e.b.m[m].dir > 0 ? "cw" : "");
+    printf("\n");
+  }
+}
+
+static bool isCmd(const char* c){ return !strcmp(c, "config") || !strcmp(c, "start") || !strcmp(c, "stop") || !strcmp(c, "turbo"); }
+
+int main(int argc, char** argv){
+  const char* mode = argc > 1 ? argv[1] : "";
+  if (!strcmp(mode, "watch")){
+    if (!host.listen()) return perror("beacon port"), 1;
+    for (uint64_t next = 0;;){
+      host.poll(500);
+      if (fleetNowMs() >= next){ printTable(); next = fleetNowMs() + 2000; }
+    }
+  }
+  if (!strcmp(mode, "send") && argc > 2 && isCmd(argv[2])){
+    const char* body = argc > 3 ? argv[3] : "";
+    uint32_t wait = argc > 4 ? (uint32_t)atoi(argv[4]) : 6;
+    if (!host.listen()) return perror("beacon port"), 1;
+    for (uint64_t end = fleetNowMs() + wait * 1000; fleetNowMs() < end;) host.poll(100);
+    printTable();
+    FanStats s = host.command(argv[2], body, out, sizeof(out));
+    printf("%s\n/%s: %u of %u ok in %.1f ms (p50 %.1f ms, p99 %.1f ms)\n", out, argv[2], s.ok, s.nodes,
+           s.totalUs / 1000.0, s.p50Us / 1000.0, s.p99Us / 1000.0);
+    return s.nodes && s.ok == s.nodes ? 0 : 1;
+  }
+  if (!strcmp(mode, "serve")){
+    uint16_t port = argc > 2 ? (uint16_t)atoi(argv[2]) : 8077;
+    if (!host.listen()) return perror("beacon port"), 1;
+    if (!host.serve(port)) return perror("http port"), 1;
+    printf("fleet: beacons on udp %u, http on %u\n", host.beaconPort(), host.httpPort());
+    for (;;) host.poll(500);
+  }
+  printf("usage: %s watch | send <config|start|stop|turbo> [json] [wait_s] | serve [port]\n", argv[0]);
+  return 2;
+}
@@ -0,0 +1,185 @@
+"""Per-component IRAM / DRAM / flash / RTC usage from the linker map, with budgets.
+
+Runs as a PlatformIO post script (extra_scripts = post:tools/size_budget.py):
+adds -Map to the link, prints a short summary after every firmware link and
+fails the build when a region is over its budget (custom_budget_* in
+platformio.ini). `pio run -t budget` prints the full per-component table.
+Also runs by hand on any GNU ld map:
+  python3 tools/size_budget.py .pio/build/esp32dev/firmware.map [--top 30] [--iram N ...]
+
+A component is the archive an input section came from (libfreertos.a ->
+freertos, libWinderCore.a -> WinderCore) or the object file for sources
+linked directly (main.cpp, wifi_mgr.cpp). The flash column is what the
+component adds to the app image: code, rodata and the initial values of
+IRAM/DRAM/RTC data, but not bss.
+"""
+import argparse
+import os
+import re
+import sys
+
+REGIONS = ("iram", "dram", "flash", "rtc")
+DEFAULT_BUDGET = {"iram": 114688, "dram": 102400, "flash": 1205862, "rtc": 7680}
+
+INPUT = re.compile(r"^\s(\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)?$")
+OUTPUT = re.compile(r"^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?")
+
+
+def region(sec):
+    """Runtime memory an output section occupies, or None."""
+    if sec.startswith(".iram0"):
+        return "iram"
+    if sec.startswith(".dram0") or sec == ".noinit":
+        return "dram"
+    if sec.startswith(".flash"):
+        return "flash"
+    if sec.startswith(".rtc"):
+        return "rtc"
+    return None
+
+
+def in_image(sec):
+    """Whether the section's bytes are stored in the app image (loaded or mapped)."""
+    return region(sec) is not None and not re.search(r"bss|noinit|noload", sec)
+
+
+def component(path):
+    if not path:
+        return "(fill)"
+    m = re.search(r"lib([^/\\]+)\.a\(", path)
+    if m:
+        return m.group(1)
+    name = os.path.basename(path.strip())
+    return name[:-2] if name.endswith(".o") else name
+
+
+def parse(lines):
+    """{component: {region: bytes}} plus the flash-image total per component."""
+    usage = {}
+    started = False
+    out_sec = None
+    pending = None            # input section name whose address/size wrapped to the next line
+    for line in lines:
+        line = line.rstrip("\n")
+        if not started:
+            started = line.startswith("Linker script and memory map")
+            continue
+        if not line.strip():
+            continue
+        if not line[0].isspace():
+            m = OUTPUT.match(line)
+            out_sec = m.group(1) if m else None
+            pending = None
+            continue
+        m = INPUT.match(line)
+        if not m:
+            s = line.strip()
+            pending = s if line.startswith(" ") and not line.startswith("  ") and " " not in s else None
+            continue
+        name = m.group(1) or pending
+        pending = None
+        if not name or not out_sec:
+            continue
+        size = int(m.group(3), 16)
+        reg = region(out_sec)
+        if not size or not reg:
+            continue
+        fill = name == "*fill*"
+        comp = usage.setdefault(component(None if fill else m.group(4)), dict.fromkeys(REGIONS + ("image",), 0))
+        comp[reg] += size
+        if in_image(out_sec):
+            comp["image"] += size
+    return usage
+
+
+def totals(usage):
+    t = dict.fromkeys(REGIONS + ("image",), 0)
+    for c in usage.values():
+        for k in t:
+            t[k] += c[k]
+    return t
+
+
+def report(usage, top, out=sys.stdout):
+    rows = sorted(usage.items(), key=lambda kv: -(kv[1]["iram"] + kv[1]["dram"] + kv[1]["image"]))
+    out.write("  %-28s %9s %9s %9s %7s\n" % ("component", "iram", "dram", "flash", "rtc"))
+    for name, c in rows[:top] if top else rows:
+        out.write("  %-28s %9d %9d %9d %7d\n" % (name[:28], c["iram"], c["dram"], c["image"], c["rtc"]))
+    if top and len(rows) > top:
+        rest = totals(dict(rows[top:]))
+        out.write("  %-28s %9d %9d %9d %7d\n" % ("(%d more)" % (len(rows) - top), rest["iram"], rest["dram"], rest["image"], rest["rtc"]))
+
+
+def check(usage, budget, out=sys.stdout):
+    """Prints one line per region; returns the regions over budget."""
+    t = totals(usage)
+    used = {"iram": t["iram"], "dram": t["dram"], "flash": t["image"], "rtc": t["rtc"]}
+    over = []
+    for r in REGIONS:
+        b = budget.get(r) or 0
+        flag = ""
+        if b and used[r] > b:
+            over.append(r)
+            flag = "  OVER by %d B" % (used[r] - b)
+        pct = " (%3.0f%%)" % (100.0 * used[r] / b) if b else ""
+        out.write("  %-6s %9d / %-9s%s%s\n" % (r, used[r], b or "-", pct, flag))
+    return over
+
+
+def main(argv):
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("map")
+    ap.add_argument("--top", type=int, default=20, help="components to list, 0 = all")
+    for r in REGIONS:
+        ap.add_argument("--" + r, type=int, default=DEFAULT_BUDGET[r], help="budget in bytes, 0 = none")
+    a = ap.parse_args(argv)
+    with open(a.map, errors="replace") as f:
+        usage = parse(f)
+    report(usage, a.top)
+    over = check(usage, {r: getattr(a, r) for r in REGIONS})
+    if over:
+        sys.stderr.write("size budget exceeded: %s\n" % ", ".join(over))
+    return 1 if over else 0
+
+
+def pio(env):
+    map_path = os.path.join(env.subst("$BUILD_DIR"), "firmware.map")
+    env.Append(LINKFLAGS=["-Wl,-Map," + map_path])
+
+    def budget():
+        b = {}
+        for r in REGIONS:
+            v = env.GetProjectOption("custom_budget_" + r, str(DEFAULT_BUDGET[r]))
+            b[r] = int(v, 0)
+        return b
+
+    def load():
+        with open(map_path, errors="replace") as f:
+            return parse(f)
+
+    def after_link(source, target, env):
+        usage = load()
+        print("Size budget (%s):" % os.path.relpath(map_path, env.subst("$PROJECT_DIR")))
+        report(usage, 8)
+        over = check(usage, budget())
+        if over:
+            sys.stderr.write("size budget exceeded: %s (raise custom_budget_* or trim; pio run -t budget)\n" % ", ".join(over))
+            return 1
+        return 0
+
+    def full(source, target, env):
+        usage = load()
+        report(usage, 0)
+        return 1 if check(usage, budget()) else 0
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", after_link)
+    env.AddCustomTarget("budget", "$BUILD_DIR/${PROGNAME}.elf", full,
+                        title="Size budget", description="Per-component IRAM/DRAM/flash/RTC use against custom_budget_*")
+
+
+try:
+    Import("env")  # noqa: F821  (PlatformIO / SCons)
+    pio(env)  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        sys.exit(main(sys.argv[1:]))
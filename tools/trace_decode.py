@@ -0,0 +1,88 @@
+"""Decode a /trace download into a timeline.
+
+    python3 tools/trace_decode.py http://winder-1a2b3c.local/trace
+    python3 tools/trace_decode.py trace.bin
+
+The body is a 16-byte header (lib/WinderCore/src/trace_ring.h,
+TraceDumpHeader) followed by 16-byte records, oldest first. Times are
+printed as seconds since boot and as seconds before the download.
+Event ids and wording mirror trace_ring.h / trace_ring.cpp; HTTP route
+numbers are resolved to paths here.
+"""
+import struct
+import sys
+import urllib.request
+
+HEADER = struct.Struct("<4sBBHII")
+RECORD = struct.Struct("<IIHBBI")
+
+BOOT = ["cold", "checkpoint", "warm"]
+ROUTES = ["/status", "/config", "/turbo", "/wifi", "/scan", "/presets", "/history", "/ctl"]   # main.cpp Route
+
+
+def ip(b):
+    return ".".join(str((b >> s) & 255) for s in (0, 8, 16, 24))
+
+
+def route(a):
+    return ROUTES[a] if a < len(ROUTES) else "route %d" % a
+
+
+EVENTS = {
+    1: lambda a, b: "boot %s, restored in %d us" % (BOOT[a] if a < 3 else "?", b),
+    2: lambda a, b: "rotate m%d %s, %d ms late" % ((a & 0x7F) + 1, "CCW" if a & 0x80 else "CW", b),
+    3: lambda a, b: "turbo on, mask 0x%02x" % a,
+    4: lambda a, b: "turbo off",
+    5: lambda a, b: "switch position %d" % a,
+    6: lambda a, b: "command %d" % a,
+    7: lambda a, b: "wifi event %d (reason %d)" % (a, b),
+    8: lambda a, b: "AP: up on ch %d" % a,
+    9: lambda a, b: "AP: softAP ch %d failed, retrying" % a,
+    10: lambda a, b: "AP: stopped (STA up)",
+    11: lambda a, b: "STA: joining, attempt %d" % a,
+    12: lambda a, b: "STA: associated",
+    13: lambda a, b: "STA: IP %s, attempt %d" % (ip(b), a),
+    14: lambda a, b: "STA: disconnected (reason %d)" % a,
+    15: lambda a, b: "STA: join failed (reason %d), AP stays up" % a,
+    16: lambda a, b: "mDNS: http://winder-%06x.local" % (b & 0xFFFFFF),
+    17: lambda a, b: "http %s, %d us" % (route(a), b),
+    18: lambda a, b: "prefs: saved, %d change(s), %d us" % (a, b),
+}
+
+
+def decode(data):
+    if len(data) < HEADER.size:
+        raise ValueError("short body: %d bytes" % len(data))
+    magic, version, rec_size, capacity, head, now_ms = HEADER.unpack_from(data)
+    if magic != b"WTR1" or version != 1 or rec_size != RECORD.size:
+        raise ValueError("not a trace dump (magic %r, version %d, record %d B)" % (magic, version, rec_size))
+    recs = [RECORD.unpack_from(data, o) for o in range(HEADER.size, len(data) - RECORD.size + 1, RECORD.size)]
+    return capacity, head, now_ms, recs
+
+
+def main(argv):
+    if len(argv) != 2:
+        print(__doc__.strip())
+        return 2
+    src = argv[1]
+    if src.startswith("http://") or src.startswith("https://"):
+        with urllib.request.urlopen(src, timeout=10) as r:
+            data = r.read()
+    else:
+        with open(src, "rb") as f:
+            data = f.read()
+    capacity, head, now_ms, recs = decode(data)
+    print("%d record(s) of %d written since boot, ring holds %d" % (len(recs), head, capacity))
+    prev = recs[0][0] - 1 if recs else 0
+    for seq, ms, us, ev, a, b in recs:
+        if seq != prev + 1:
+            print("  ... %d record(s) missing" % (seq - prev - 1))
+        prev = seq
+        ago = ((now_ms - ms) & 0xFFFFFFFF) / 1000.0   # millis() wraps after 49 days
+        text = EVENTS[ev](a, b) if ev in EVENTS else "event %d a=%d b=%d" % (ev, a, b)
+        print("%6d %9d.%03d%03d  -%8.3fs  %s" % (seq, ms // 1000, ms % 1000, us, ago, text))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))